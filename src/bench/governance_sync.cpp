@@ -0,0 +1,215 @@
+// Copyright (c) 2019 Cryptroxcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chainparams.h>
+#include <governance.h>
+#include <governance-object.h>
+#include <governance-vote.h>
+#include <governance-votedb.h>
+#include <key.h>
+#include <masternode.h>
+#include <masternode-sync.h>
+#include <masternodeman.h>
+#include <net.h>
+#include <protocol.h>
+#include <pubkey.h>
+#include <random.h>
+#include <streams.h>
+#include <util.h>
+#include <utilstrencodings.h>
+#include <version.h>
+
+#include <cassert>
+#include <memory>
+#include <set>
+#include <vector>
+
+//! N objects x M votes, the requesting node is missing one vote in ten.
+static const size_t OBJECT_COUNT = 10;
+static const size_t VOTES_PER_OBJECT = 2000;
+static const size_t MISSING_ONE_IN = 10;
+
+/**
+ * Two nodes that know the same objects and masternodes and only differ in their
+ * vote stores, so the global governance manager serves both sides of the sync and
+ * pGovernanceVoteDB is switched to the store of the side that is running.
+ */
+class GovernanceSyncSetup
+{
+public:
+    ECCVerifyHandle verifyHandle;
+    CConnman connman;
+    std::unique_ptr<CGovernanceVoteDB> pvotedbRequester;
+    std::unique_ptr<CGovernanceVoteDB> pvotedbResponder;
+    //! Our peer as seen by the requester and by the responder
+    std::unique_ptr<CNode> pnodeResponder;
+    std::unique_ptr<CNode> pnodeRequester;
+    std::vector<uint256> vecObjects;
+    std::set<uint256> setMissing;
+
+    explicit GovernanceSyncSetup(int nVersion) : connman(0x1337, 0x1337)
+    {
+        // mainnet sizes the bloom filter of the vote request
+        SelectParams(CBaseChainParams::MAIN);
+        masternodeSync.Reset();
+        while (!masternodeSync.IsSynced()) {
+            masternodeSync.SwitchToNextAsset(connman);
+        }
+
+        pvotedbRequester.reset(new CGovernanceVoteDB(1 << 22, true));
+        pvotedbResponder.reset(new CGovernanceVoteDB(1 << 22, true));
+        pnodeResponder = MakeNode(0, nVersion);
+        pnodeRequester = MakeNode(1, nVersion);
+
+        CKey keyMasternode;
+        keyMasternode.MakeNewKey(true);
+        CPubKey pubKeyMasternode = keyMasternode.GetPubKey();
+        FastRandomContext rng(true);
+        std::vector<COutPoint> vecMasternodes;
+        for (size_t i = 0; i < VOTES_PER_OBJECT; i++) {
+            CMasternode mn(CService(), COutPoint(rng.rand256(), 0), pubKeyMasternode, pubKeyMasternode, PROTOCOL_VERSION);
+            mn.fUnitTest = true;
+            bool fAdded = mnodeman.Add(mn);
+            assert(fAdded);
+            vecMasternodes.push_back(mn.vin.prevout);
+        }
+
+        for (size_t n = 0; n < OBJECT_COUNT; n++) {
+            std::string strData = strprintf("[[\"trigger\",{\"type\":%d,\"event_block_height\":%u}]]", GOVERNANCE_OBJECT_TRIGGER, n);
+            CGovernanceObject govobj(uint256(), 1, GetAdjustedTime(), uint256(), HexStr(strData.begin(), strData.end()));
+            govobj.SetMasternodeVin(vecMasternodes[0]);
+            bool fSigned = govobj.Sign(keyMasternode, pubKeyMasternode);
+            assert(fSigned);
+            governance.AddGovernanceObject(govobj, connman);
+            assert(governance.HaveObjectForHash(govobj.GetHash()));
+            vecObjects.push_back(govobj.GetHash());
+
+            for (size_t i = 0; i < VOTES_PER_OBJECT; i++) {
+                CGovernanceVote vote(vecMasternodes[i], govobj.GetHash(), VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_YES);
+                fSigned = vote.Sign(keyMasternode, pubKeyMasternode);
+                assert(fSigned);
+                AddVote(pvotedbResponder, vote);
+                if (i % MISSING_ONE_IN == 0) {
+                    setMissing.insert(vote.GetHash());
+                } else {
+                    AddVote(pvotedbRequester, vote);
+                }
+            }
+        }
+    }
+
+    ~GovernanceSyncSetup()
+    {
+        governance.Clear();
+        mnodeman.Clear();
+        masternodeSync.Reset();
+        pGovernanceVoteDB.reset();
+    }
+
+    static std::unique_ptr<CNode> MakeNode(NodeId id, int nVersion)
+    {
+        std::unique_ptr<CNode> pnode(new CNode(id, NODE_NETWORK, 0, INVALID_SOCKET, CAddress(), 0, 0, CAddress(), "", false));
+        pnode->nVersion = nVersion;
+        pnode->SetSendVersion(nVersion);
+        return pnode;
+    }
+
+    void AddVote(std::unique_ptr<CGovernanceVoteDB>& pvotedb, const CGovernanceVote& vote)
+    {
+        pGovernanceVoteDB.swap(pvotedb);
+        {
+            LOCK(governance.cs);
+            governance.FindGovernanceObject(vote.GetParentHash())->GetVoteFile().AddVote(vote);
+        }
+        pGovernanceVoteDB.swap(pvotedb);
+    }
+
+    static size_t TakeSentBytes(CNode* pnode, std::vector<unsigned char>& vchHeaderRet, std::vector<unsigned char>& vchPayloadRet)
+    {
+        LOCK(pnode->cs_vSend);
+        size_t nBytes = 0;
+        for (const auto& vch : pnode->vSendMsg) {
+            nBytes += vch.size();
+        }
+        if (pnode->vSendMsg.size() >= 2) {
+            vchHeaderRet = pnode->vSendMsg[0];
+            vchPayloadRet = pnode->vSendMsg[1];
+        }
+        pnode->vSendMsg.clear();
+        pnode->nSendSize = 0;
+        return nBytes;
+    }
+
+    /** One request for the votes of nHash and the response to it, through the message handlers of both sides */
+    void SyncObject(const uint256& nHash, size_t& nBytesRet, size_t& nAnnouncedRet, size_t& nMissedRet)
+    {
+        std::vector<unsigned char> vchHeader, vchPayload, vchUnused;
+
+        pGovernanceVoteDB.swap(pvotedbRequester);
+        governance.RequestGovernanceObject(pnodeResponder.get(), nHash, connman, true);
+        pGovernanceVoteDB.swap(pvotedbRequester);
+        nBytesRet += TakeSentBytes(pnodeResponder.get(), vchHeader, vchPayload);
+
+        CMessageHeader hdr(Params().MessageStart());
+        CDataStream ssHeader(vchHeader, SER_NETWORK, INIT_PROTO_VERSION);
+        ssHeader >> hdr;
+        CDataStream vRecv(vchPayload, SER_NETWORK, pnodeRequester->GetRecvVersion());
+
+        pGovernanceVoteDB.swap(pvotedbResponder);
+        governance.ProcessMessage(pnodeRequester.get(), hdr.GetCommand(), vRecv, connman);
+        pGovernanceVoteDB.swap(pvotedbResponder);
+        nBytesRet += TakeSentBytes(pnodeRequester.get(), vchHeader, vchUnused);
+
+        size_t nAnnounced = 0;
+        {
+            LOCK(pnodeRequester->cs_inventory);
+            for (const auto& inv : pnodeRequester->vInventoryToSend) {
+                if (inv.type == MSG_GOVERNANCE_OBJECT_VOTE) {
+                    ++nAnnounced;
+                    if (setMissing.count(inv.hash)) --nMissedRet;
+                }
+            }
+            nBytesRet += GetSerializeSize(pnodeRequester->vInventoryToSend, SER_NETWORK, PROTOCOL_VERSION);
+            pnodeRequester->vInventoryToSend.clear();
+        }
+        nAnnouncedRet += nAnnounced;
+    }
+
+    void Run(benchmark::State& state, const char* pszName)
+    {
+        bool fLogged = false;
+        while (state.KeepRunning()) {
+            size_t nBytes = 0, nAnnounced = 0, nMissed = setMissing.size();
+            for (const auto& nHash : vecObjects) {
+                SyncObject(nHash, nBytes, nAnnounced, nMissed);
+            }
+            assert(nAnnounced > 0);
+            if (!fLogged) {
+                LogPrint(BCLog::BENCH, "%s: %u objects x %u votes, %u bytes sent, %u votes announced, %u missing votes not announced\n",
+                    pszName, OBJECT_COUNT, VOTES_PER_OBJECT, nBytes, nAnnounced, nMissed);
+                fLogged = true;
+            }
+        }
+    }
+};
+
+// One govsync request per object carrying a bloom filter of the votes we have,
+// the peer announces every vote not in the filter.
+static void GovernanceSync_BloomFilter(benchmark::State& state)
+{
+    GovernanceSyncSetup setup(GOVERNANCE_FILTER_PROTO_VERSION);
+    setup.Run(state, "GovernanceSync_BloomFilter");
+}
+
+// One govvotesum request per object, the peer announces the votes of the
+// buckets that differ from its own summary.
+static void GovernanceSync_VoteSummary(benchmark::State& state)
+{
+    GovernanceSyncSetup setup(GOVERNANCE_VOTE_SUMMARY_PROTO_VERSION);
+    setup.Run(state, "GovernanceSync_VoteSummary");
+}
+
+BENCHMARK(GovernanceSync_BloomFilter, 5);
+BENCHMARK(GovernanceSync_VoteSummary, 5);
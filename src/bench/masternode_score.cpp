@@ -0,0 +1,73 @@
+// Copyright (c) 2019 Cryptroxcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <arith_uint256.h>
+#include <bench/bench.h>
+#include <masternode.h>
+#include <random.h>
+#include <uint256.h>
+
+#include <cassert>
+#include <vector>
+
+//! Roughly the size of a mature masternode list.
+static const size_t MASTERNODE_COUNT = 3000;
+
+static std::vector<CMasternode> CreateMasternodes()
+{
+    FastRandomContext rng(true);
+    std::vector<CMasternode> vMasternodes(MASTERNODE_COUNT);
+    for (auto& mn : vMasternodes) {
+        mn.vin = CTxIn(COutPoint(rng.rand256(), rng.randrange(16)));
+        mn.nCollateralMinConfBlockHash = rng.rand256();
+    }
+    return vMasternodes;
+}
+
+static void MasternodeScore_Serial(benchmark::State& state)
+{
+    std::vector<CMasternode> vMasternodes = CreateMasternodes();
+    uint256 blockHash;
+    while (state.KeepRunning()) {
+        for (auto& mn : vMasternodes) {
+            *blockHash.begin() ^= *ArithToUint256(mn.CalculateScore(blockHash)).begin();
+        }
+    }
+}
+
+static void MasternodeScoreBatch(benchmark::State& state, int nThreads)
+{
+    std::vector<CMasternode> vMasternodes = CreateMasternodes();
+    std::vector<CMasternodeScoreHasher> vHashers;
+    for (auto& mn : vMasternodes) {
+        vHashers.emplace_back(mn.vin.prevout, mn.nCollateralMinConfBlockHash);
+    }
+
+    uint256 blockHash;
+    std::vector<arith_uint256> vScores;
+    CalculateMasternodeScores(vHashers, blockHash, vScores, nThreads);
+    for (size_t i = 0; i < vMasternodes.size(); i++) {
+        assert(vScores[i] == vMasternodes[i].CalculateScore(blockHash));
+    }
+
+    // every iteration starts and joins its worker threads, as a node does
+    while (state.KeepRunning()) {
+        CalculateMasternodeScores(vHashers, blockHash, vScores, nThreads);
+        *blockHash.begin() ^= *ArithToUint256(vScores[0]).begin();
+    }
+}
+
+static void MasternodeScore_Batch(benchmark::State& state)
+{
+    MasternodeScoreBatch(state, 1);
+}
+
+static void MasternodeScore_Batch4Threads(benchmark::State& state)
+{
+    MasternodeScoreBatch(state, 4);
+}
+
+BENCHMARK(MasternodeScore_Serial, 5);
+BENCHMARK(MasternodeScore_Batch, 10);
+BENCHMARK(MasternodeScore_Batch4Threads, 10);
@@ -0,0 +1,165 @@
+// Copyright (c) 2019 Cryptroxcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chainparams.h>
+#include <compat.h>
+#include <hash.h>
+#include <net.h>
+#include <netbase.h>
+#include <netmessagemaker.h>
+#include <streams.h>
+#include <util.h>
+#include <version.h>
+
+#ifndef WIN32
+#include <cassert>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+/**
+ * Runs the real CConnman::ThreadSocketHandler over nPeers socketpair connections.
+ * Each iteration one peer sends a ping, the socket handler reads it and hands it to the
+ * message handler, which is the bench thread. The time per iteration is the wakeup latency,
+ * the CPU time of the socket handler thread is printed per message.
+ */
+struct CConnmanSocketBench
+{
+    CConnman connman;
+    std::vector<CNode*> vNodes;
+    std::vector<SOCKET> vPeerSockets;
+    std::thread threadSocketHandler;
+
+    CConnmanSocketBench(CConnman::SocketEventsMode mode, size_t nPeers) : connman(0x1337, 0x1337)
+    {
+        // The peer ends go above FD_SETSIZE so that select() can watch all of our ends
+        RaiseFileDescriptorLimit(FD_SETSIZE + nPeers + 64);
+        connman.socketEventsMode = mode;
+        connman.nReceiveFloodSize = 5 * 1000 * 1000;
+        bool fInit = connman.InitSocketEvents();
+        assert(fInit);
+
+        CAddress addr(CService(), NODE_NONE);
+        for (size_t i = 0; i < nPeers; i++) {
+            int sv[2];
+            int nRet = socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+            assert(nRet == 0);
+            int fdPeer = fcntl(sv[1], F_DUPFD, FD_SETSIZE);
+            assert(fdPeer >= 0);
+            close(sv[1]);
+            vPeerSockets.push_back(fdPeer);
+
+            CNode* pnode = new CNode(i, NODE_NETWORK, 0, sv[0], addr, 0, 0, CAddress(), "", true);
+            pnode->fSuccessfullyConnected = true;
+            pnode->AddRef();
+            vNodes.push_back(pnode);
+            {
+                LOCK(connman.cs_vNodes);
+                connman.vNodes.push_back(pnode);
+                connman.mapNodesById.emplace(pnode->GetId(), pnode);
+            }
+            connman.AddSocketEvents(pnode);
+        }
+        threadSocketHandler = std::thread(&CConnman::ThreadSocketHandler, &connman);
+    }
+
+    ~CConnmanSocketBench()
+    {
+        connman.interruptNet();
+        threadSocketHandler.join();
+        {
+            LOCK(connman.cs_vNodes);
+            connman.vNodes.clear();
+            connman.mapNodesById.clear();
+        }
+        for (CNode* pnode : vNodes) {
+            delete pnode;
+        }
+        for (SOCKET hSocket : vPeerSockets) {
+            CloseSocket(hSocket);
+        }
+    }
+
+    int64_t GetSocketHandlerCPUTime()
+    {
+        clockid_t clockId;
+        struct timespec ts;
+        if (pthread_getcpuclockid(threadSocketHandler.native_handle(), &clockId) != 0 || clock_gettime(clockId, &ts) != 0)
+            return 0;
+        return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    }
+
+    /** Wait until the socket handler passed a message of pnode to the message handler and consume it */
+    void ReceiveMessage(CNode* pnode)
+    {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(connman.mutexMsgProc);
+                connman.condMsgProc.wait(lock, [this] { return connman.fMsgProcWake; });
+                connman.fMsgProcWake = false;
+            }
+            LOCK(pnode->cs_vProcessMsg);
+            if (pnode->vProcessMsg.empty())
+                continue;
+            pnode->vProcessMsg.clear();
+            pnode->nProcessQueueSize = 0;
+            pnode->fPauseRecv = false;
+            return;
+        }
+    }
+};
+
+static std::vector<unsigned char> SerializePing()
+{
+    CSerializedNetMsg msg = CNetMsgMaker(INIT_PROTO_VERSION).Make(NetMsgType::PING, (uint64_t)0);
+    CMessageHeader hdr(Params().MessageStart(), msg.command.c_str(), msg.data.size());
+    uint256 hash = Hash(msg.data.data(), msg.data.data() + msg.data.size());
+    memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
+
+    std::vector<unsigned char> vBytes;
+    CVectorWriter{SER_NETWORK, INIT_PROTO_VERSION, vBytes, 0, hdr};
+    vBytes.insert(vBytes.end(), msg.data.begin(), msg.data.end());
+    return vBytes;
+}
+
+static void SocketHandler(benchmark::State& state, CConnman::SocketEventsMode mode, size_t nPeers)
+{
+    SelectParams(CBaseChainParams::MAIN);
+    const std::vector<unsigned char> vPing = SerializePing();
+
+    CConnmanSocketBench bench(mode, nPeers);
+    int64_t nCPUStart = bench.GetSocketHandlerCPUTime();
+    uint64_t nMessages = 0;
+    while (state.KeepRunning()) {
+        size_t nPeer = nMessages++ % nPeers;
+        ssize_t nBytes = send(bench.vPeerSockets[nPeer], vPing.data(), vPing.size(), MSG_NOSIGNAL);
+        assert(nBytes == (ssize_t)vPing.size());
+        bench.ReceiveMessage(bench.vNodes[nPeer]);
+    }
+    int64_t nCPU = bench.GetSocketHandlerCPUTime() - nCPUStart;
+    fprintf(stderr, "%s: socket handler CPU %.2f us/message over %u peers\n", state.m_name.c_str(), (double)nCPU / std::max<uint64_t>(nMessages, 1), (unsigned int)nPeers);
+}
+
+static void SocketHandlerSelect_100(benchmark::State& state) { SocketHandler(state, CConnman::SOCKETEVENTS_SELECT, 100); }
+static void SocketHandlerSelect_500(benchmark::State& state) { SocketHandler(state, CConnman::SOCKETEVENTS_SELECT, 500); }
+static void SocketHandlerSelect_1000(benchmark::State& state) { SocketHandler(state, CConnman::SOCKETEVENTS_SELECT, 1000); }
+
+BENCHMARK(SocketHandlerSelect_100, 50000);
+BENCHMARK(SocketHandlerSelect_500, 10000);
+BENCHMARK(SocketHandlerSelect_1000, 5000);
+
+#ifdef USE_EPOLL
+static void SocketHandlerEpoll_100(benchmark::State& state) { SocketHandler(state, CConnman::SOCKETEVENTS_EPOLL, 100); }
+static void SocketHandlerEpoll_500(benchmark::State& state) { SocketHandler(state, CConnman::SOCKETEVENTS_EPOLL, 500); }
+static void SocketHandlerEpoll_1000(benchmark::State& state) { SocketHandler(state, CConnman::SOCKETEVENTS_EPOLL, 1000); }
+
+BENCHMARK(SocketHandlerEpoll_100, 100000);
+BENCHMARK(SocketHandlerEpoll_500, 100000);
+BENCHMARK(SocketHandlerEpoll_1000, 100000);
+#endif // USE_EPOLL
+#endif // WIN32
@@ -0,0 +1,157 @@
+// Copyright (c) 2016-2018 The Bitcoin Core developers
+// Copyright (c) 2019 Cryptroxcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <crypto/x16r.h>
+#include <primitives/block.h>
+#include <uint256.h>
+#include <utilstrencodings.h>
+
+#include <string.h>
+#include <vector>
+
+//! Cheapest and most expensive X16R primitives for short inputs (skein and cubehash).
+static const int X16R_BEST_ALGO = 5;
+static const int X16R_WORST_ALGO = 7;
+
+static void HashAlgo(benchmark::State& state, int hashSelection, size_t len)
+{
+    std::vector<uint8_t> in(X16R_HEADER_SIZE, 0);
+    uint8_t hash[64];
+    while (state.KeepRunning()) {
+        HashX16RAlgo(hashSelection, in.data(), len, hash);
+        in[0] = hash[0];
+    }
+}
+
+#define X16R_ALGO_BENCH(name, algo) \
+    static void X16R_##name##_64b(benchmark::State& state) { HashAlgo(state, algo, 64); } \
+    static void X16R_##name##_80b(benchmark::State& state) { HashAlgo(state, algo, X16R_HEADER_SIZE); }
+
+X16R_ALGO_BENCH(Blake, 0)
+X16R_ALGO_BENCH(BMW, 1)
+X16R_ALGO_BENCH(Groestl, 2)
+X16R_ALGO_BENCH(JH, 3)
+X16R_ALGO_BENCH(Keccak, 4)
+X16R_ALGO_BENCH(Skein, 5)
+X16R_ALGO_BENCH(Luffa, 6)
+X16R_ALGO_BENCH(CubeHash, 7)
+X16R_ALGO_BENCH(SHAvite, 8)
+X16R_ALGO_BENCH(SIMD, 9)
+X16R_ALGO_BENCH(Echo, 10)
+X16R_ALGO_BENCH(Hamsi, 11)
+X16R_ALGO_BENCH(Fugue, 12)
+X16R_ALGO_BENCH(Shabal, 13)
+X16R_ALGO_BENCH(Whirlpool, 14)
+X16R_ALGO_BENCH(SHA512, 15)
+
+/** Header whose previous block hash selects hashSelection for all 16 rounds. */
+static std::vector<uint8_t> SameAlgoHeader(int hashSelection)
+{
+    std::vector<uint8_t> header(X16R_HEADER_SIZE, 0);
+    // The algorithm order is taken from the last 16 nibbles of hashPrevBlock.
+    memset(header.data() + 4, hashSelection * 0x11, 8);
+    return header;
+}
+
+static void HashX16RSameAlgo(benchmark::State& state, int hashSelection)
+{
+    std::vector<uint8_t> header = SameAlgoHeader(hashSelection);
+    uint256 hashPrevBlock;
+    memcpy(hashPrevBlock.begin(), header.data() + 4, 32);
+    while (state.KeepRunning()) {
+        uint256 hash = HashX16R(header.begin(), header.end(), hashPrevBlock);
+        header[X16R_HEADER_SIZE - 4] = *hash.begin();
+    }
+}
+
+static void X16R_BestCase(benchmark::State& state)
+{
+    HashX16RSameAlgo(state, X16R_BEST_ALGO);
+}
+
+static void X16R_WorstCase(benchmark::State& state)
+{
+    HashX16RSameAlgo(state, X16R_WORST_ALGO);
+}
+
+//! Previous block hash that selects each of the 16 primitives once.
+static const uint256 hashPrevBlockMixed = uint256S("0x0000000000000000000000000000000000000000000000000123456789abcdef");
+
+static void X16R_GetPoWHash(benchmark::State& state)
+{
+    CBlockHeader header;
+    header.hashPrevBlock = hashPrevBlockMixed;
+    while (state.KeepRunning()) {
+        header.GetPoWHash();
+        ++header.nNonce;
+    }
+}
+
+static void X16R_PreparedHeader(benchmark::State& state)
+{
+    CBlockHeader header;
+    header.hashPrevBlock = hashPrevBlockMixed;
+    CX16RPreparedHeader prepared(UBEGIN(header.nVersion));
+    while (state.KeepRunning()) {
+        prepared.Hash(header.nNonce);
+        ++header.nNonce;
+    }
+}
+
+static void X16R_Batch_16(benchmark::State& state)
+{
+    // Sixteen nonces of the same block, as scanned by a miner.
+    CBlockHeader header;
+    header.hashPrevBlock = hashPrevBlockMixed;
+    std::vector<uint8_t> headers;
+    for (int i = 0; i < 16; i++) {
+        header.nNonce = i;
+        headers.insert(headers.end(), UBEGIN(header.nVersion), UEND(header.nNonce));
+    }
+    uint256 hashes[16];
+    while (state.KeepRunning()) {
+        HashX16RBatch(hashes, headers.data(), 16);
+    }
+}
+
+BENCHMARK(X16R_Blake_64b, 1600 * 1000);
+BENCHMARK(X16R_Blake_80b, 1200 * 1000);
+BENCHMARK(X16R_BMW_64b, 1200 * 1000);
+BENCHMARK(X16R_BMW_80b, 1100 * 1000);
+BENCHMARK(X16R_Groestl_64b, 250 * 1000);
+BENCHMARK(X16R_Groestl_80b, 250 * 1000);
+BENCHMARK(X16R_JH_64b, 220 * 1000);
+BENCHMARK(X16R_JH_80b, 150 * 1000);
+BENCHMARK(X16R_Keccak_64b, 900 * 1000);
+BENCHMARK(X16R_Keccak_80b, 550 * 1000);
+BENCHMARK(X16R_Skein_64b, 2000 * 1000);
+BENCHMARK(X16R_Skein_80b, 1300 * 1000);
+BENCHMARK(X16R_Luffa_64b, 250 * 1000);
+BENCHMARK(X16R_Luffa_80b, 300 * 1000);
+BENCHMARK(X16R_CubeHash_64b, 120 * 1000);
+BENCHMARK(X16R_CubeHash_80b, 130 * 1000);
+BENCHMARK(X16R_SHAvite_64b, 450 * 1000);
+BENCHMARK(X16R_SHAvite_80b, 500 * 1000);
+BENCHMARK(X16R_SIMD_64b, 180 * 1000);
+BENCHMARK(X16R_SIMD_80b, 130 * 1000);
+BENCHMARK(X16R_Echo_64b, 300 * 1000);
+BENCHMARK(X16R_Echo_80b, 300 * 1000);
+BENCHMARK(X16R_Hamsi_64b, 130 * 1000);
+BENCHMARK(X16R_Hamsi_80b, 130 * 1000);
+BENCHMARK(X16R_Fugue_64b, 140 * 1000);
+BENCHMARK(X16R_Fugue_80b, 130 * 1000);
+BENCHMARK(X16R_Shabal_64b, 700 * 1000);
+BENCHMARK(X16R_Shabal_80b, 650 * 1000);
+BENCHMARK(X16R_Whirlpool_64b, 600 * 1000);
+BENCHMARK(X16R_Whirlpool_80b, 400 * 1000);
+BENCHMARK(X16R_SHA512_64b, 1100 * 1000);
+BENCHMARK(X16R_SHA512_80b, 1400 * 1000);
+
+BENCHMARK(X16R_BestCase, 120 * 1000);
+BENCHMARK(X16R_WorstCase, 8 * 1000);
+BENCHMARK(X16R_GetPoWHash, 20 * 1000);
+BENCHMARK(X16R_PreparedHeader, 20 * 1000);
+BENCHMARK(X16R_Batch_16, 1200);
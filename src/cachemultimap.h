@@ -61,7 +61,7 @@ public:
           mapIndex()
     {}
 
-    CacheMultiMap(const CacheMap<K,V>& other)
+    CacheMultiMap(const CacheMultiMap<K,V,Size>& other)
         : nMaxSize(other.nMaxSize),
           nCurrentSize(other.nCurrentSize),
           listItems(other.listItems),
@@ -196,7 +196,7 @@ public:
         return listItems;
     }
 
-    CacheMap<K,V>& operator=(const CacheMap<K,V>& other)
+    CacheMultiMap<K,V,Size>& operator=(const CacheMultiMap<K,V,Size>& other)
     {
         nMaxSize = other.nMaxSize;
         nCurrentSize = other.nCurrentSize;
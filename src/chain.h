@@ -302,9 +302,9 @@ public:
         return *phashBlock;
     }
 
-    uint256 GetBlockPoWHash() const
+    uint256 GetBlockPoWHash(X16RCaller caller = X16RCaller::OTHER) const
     {
-        return GetBlockHeader().GetPoWHash();
+        return GetBlockHeader().GetPoWHash(caller);
     }
 
     int64_t GetBlockTime() const
@@ -102,8 +102,17 @@ typedef void* sockopt_arg_type;
 typedef char* sockopt_arg_type;
 #endif
 
+// CRYPTROX BEGIN
+// Use epoll for the socket handler and poll for single sockets, neither is bound by FD_SETSIZE
+#ifdef __linux__
+#define USE_EPOLL
+#endif
+// CRYPTROX END
+
 bool static inline IsSelectableSocket(const SOCKET& s) {
-#ifdef WIN32
+// CRYPTROX BEGIN
+#if defined(WIN32) || defined(USE_EPOLL)
+// CRYPTROX END
     return true;
 #else
     return (s < FD_SETSIZE);
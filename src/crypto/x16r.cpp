@@ -0,0 +1,426 @@
+// Copyright (c) 2014-2018 The Bitcoin Core developers
+// Copyright (c) 2019 Cryptroxcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <crypto/x16r.h>
+
+#include <crypto/common.h>
+#include <crypto/sph_blake.h>
+#include <crypto/sph_bmw.h>
+#include <crypto/sph_groestl.h>
+#include <crypto/sph_jh.h>
+#include <crypto/sph_keccak.h>
+#include <crypto/sph_skein.h>
+#include <crypto/sph_luffa.h>
+#include <crypto/sph_cubehash.h>
+#include <crypto/sph_shavite.h>
+#include <crypto/sph_simd.h>
+#include <crypto/sph_echo.h>
+#include <crypto/sph_hamsi.h>
+#include <crypto/sph_fugue.h>
+#include <crypto/sph_shabal.h>
+#include <crypto/sph_whirlpool.h>
+extern "C"{
+#include <crypto/sph_sha2.h>
+}
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <string.h>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__amd64__) || defined(__i386__)
+#if defined(USE_ASM)
+#include <cpuid.h>
+#endif
+#endif
+
+namespace x16r_avx2
+{
+void Keccak512_4way(unsigned char* out, const unsigned char* in, size_t len);
+}
+
+namespace
+{
+
+/** Context of any of the X16R primitives. */
+union X16RContext {
+    sph_blake512_context     blake;      //0
+    sph_bmw512_context       bmw;        //1
+    sph_groestl512_context   groestl;    //2
+    sph_jh512_context        jh;         //3
+    sph_keccak512_context    keccak;     //4
+    sph_skein512_context     skein;      //5
+    sph_luffa512_context     luffa;      //6
+    sph_cubehash512_context  cubehash;   //7
+    sph_shavite512_context   shavite;    //8
+    sph_simd512_context      simd;       //9
+    sph_echo512_context      echo;       //A
+    sph_hamsi512_context     hamsi;      //B
+    sph_fugue512_context     fugue;      //C
+    sph_shabal512_context    shabal;     //D
+    sph_whirlpool_context    whirlpool;  //E
+    sph_sha512_context       sha512;     //F
+};
+
+struct X16RAlgo {
+    void (*init)(void*);
+    void (*write)(void*, const void*, size_t);
+    void (*close)(void*, void*);
+};
+
+/** The X16R primitives, indexed by hash selection. */
+const X16RAlgo X16R_ALGOS[16] = {
+    {sph_blake512_init,     sph_blake512,     sph_blake512_close},
+    {sph_bmw512_init,       sph_bmw512,       sph_bmw512_close},
+    {sph_groestl512_init,   sph_groestl512,   sph_groestl512_close},
+    {sph_jh512_init,        sph_jh512,        sph_jh512_close},
+    {sph_keccak512_init,    sph_keccak512,    sph_keccak512_close},
+    {sph_skein512_init,     sph_skein512,     sph_skein512_close},
+    {sph_luffa512_init,     sph_luffa512,     sph_luffa512_close},
+    {sph_cubehash512_init,  sph_cubehash512,  sph_cubehash512_close},
+    {sph_shavite512_init,   sph_shavite512,   sph_shavite512_close},
+    {sph_simd512_init,      sph_simd512,      sph_simd512_close},
+    {sph_echo512_init,      sph_echo512,      sph_echo512_close},
+    {sph_hamsi512_init,     sph_hamsi512,     sph_hamsi512_close},
+    {sph_fugue512_init,     sph_fugue512,     sph_fugue512_close},
+    {sph_shabal512_init,    sph_shabal512,    sph_shabal512_close},
+    {sph_whirlpool_init,    sph_whirlpool,    sph_whirlpool_close},
+    {sph_sha512_init,       sph_sha512,       sph_sha512_close},
+};
+
+const char* const X16R_ALGO_NAMES[16] = {
+    "blake", "bmw", "groestl", "jh", "keccak", "skein", "luffa", "cubehash",
+    "shavite", "simd", "echo", "hamsi", "fugue", "shabal", "whirlpool", "sha512"
+};
+
+const char* const X16R_CALLER_NAMES[X16R_CALLER_COUNT] = {
+    "other", "header_sync", "block_check", "block_read", "index_load", "mining"
+};
+
+/**
+ * Hashing statistics of one thread. Only the owning thread writes its
+ * counters, so a relaxed load and store is enough to update them and
+ * readers merging all threads never hold up the hashing.
+ */
+struct ThreadStats {
+    std::atomic<uint64_t> algoHits[16];
+    std::atomic<uint64_t> algoNanos[16];
+    std::atomic<uint64_t> callerHashes[X16R_CALLER_COUNT];
+
+    ThreadStats();
+    ~ThreadStats();
+};
+
+std::mutex& StatsMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+//! Statistics of all running threads that have hashed. Guarded by StatsMutex().
+std::set<ThreadStats*>& LiveStats()
+{
+    static std::set<ThreadStats*> live;
+    return live;
+}
+
+//! Statistics of threads that have exited. Guarded by StatsMutex().
+X16RStats& RetiredStats()
+{
+    static X16RStats retired = {};
+    return retired;
+}
+
+ThreadStats::ThreadStats()
+{
+    for (int i = 0; i < 16; i++) {
+        algoHits[i] = 0;
+        algoNanos[i] = 0;
+    }
+    for (int i = 0; i < X16R_CALLER_COUNT; i++) {
+        callerHashes[i] = 0;
+    }
+    std::lock_guard<std::mutex> lock(StatsMutex());
+    LiveStats().insert(this);
+}
+
+ThreadStats::~ThreadStats()
+{
+    std::lock_guard<std::mutex> lock(StatsMutex());
+    X16RStats& retired = RetiredStats();
+    for (int i = 0; i < 16; i++) {
+        retired.algoHits[i] += algoHits[i];
+        retired.algoNanos[i] += algoNanos[i];
+    }
+    for (int i = 0; i < X16R_CALLER_COUNT; i++) {
+        retired.callerHashes[i] += callerHashes[i];
+    }
+    LiveStats().erase(this);
+}
+
+ThreadStats& LocalStats()
+{
+    static thread_local ThreadStats stats;
+    return stats;
+}
+
+void inline Increment(std::atomic<uint64_t>& counter, uint64_t n)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+//! Reading the clock around every primitive costs about as much as a small one, so it is opt-in
+std::atomic<bool> fAlgoTiming{false};
+
+/** Start timing a primitive, a default time point when timing is disabled. */
+std::chrono::steady_clock::time_point AlgoStart()
+{
+    if (!fAlgoTiming.load(std::memory_order_relaxed))
+        return std::chrono::steady_clock::time_point();
+    return std::chrono::steady_clock::now();
+}
+
+/** Account lanes digests of hashSelection computed since start. */
+void RecordAlgo(int hashSelection, uint64_t lanes, std::chrono::steady_clock::time_point start)
+{
+    ThreadStats& stats = LocalStats();
+    Increment(stats.algoHits[hashSelection], lanes);
+    if (start != std::chrono::steady_clock::time_point())
+        Increment(stats.algoNanos[hashSelection], std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+} // namespace
+
+const char* X16RAlgoName(int hashSelection)
+{
+    assert(hashSelection >= 0 && hashSelection < 16);
+    return X16R_ALGO_NAMES[hashSelection];
+}
+
+const char* X16RCallerName(X16RCaller caller)
+{
+    return X16R_CALLER_NAMES[static_cast<int>(caller)];
+}
+
+void X16RCountHash(X16RCaller caller)
+{
+    Increment(LocalStats().callerHashes[static_cast<int>(caller)], 1);
+}
+
+void X16RSetTiming(bool fEnable)
+{
+    fAlgoTiming.store(fEnable, std::memory_order_relaxed);
+}
+
+bool X16RTimingEnabled()
+{
+    return fAlgoTiming.load(std::memory_order_relaxed);
+}
+
+X16RStats GetX16RStats()
+{
+    std::lock_guard<std::mutex> lock(StatsMutex());
+    X16RStats ret = RetiredStats();
+    for (const ThreadStats* stats : LiveStats()) {
+        for (int i = 0; i < 16; i++) {
+            ret.algoHits[i] += stats->algoHits[i].load(std::memory_order_relaxed);
+            ret.algoNanos[i] += stats->algoNanos[i].load(std::memory_order_relaxed);
+        }
+        for (int i = 0; i < X16R_CALLER_COUNT; i++) {
+            ret.callerHashes[i] += stats->callerHashes[i].load(std::memory_order_relaxed);
+        }
+    }
+    return ret;
+}
+
+void HashX16RAlgo(int hashSelection, const void* pin, size_t len, void* pout)
+{
+    assert(hashSelection >= 0 && hashSelection < 16);
+    const auto start = AlgoStart();
+    const X16RAlgo& algo = X16R_ALGOS[hashSelection];
+    X16RContext ctx;
+    algo.init(&ctx);
+    algo.write(&ctx, pin, len);
+    algo.close(&ctx, pout);
+    RecordAlgo(hashSelection, 1, start);
+}
+
+struct CX16RPreparedHeader::Midstate {
+    //! First round context after absorbing everything but the nonce
+    X16RContext ctx;
+};
+
+CX16RPreparedHeader::CX16RPreparedHeader(const unsigned char* header) : midstate(new Midstate())
+{
+    uint256 hashPrevBlock;
+    memcpy(hashPrevBlock.begin(), header + 4, 32);
+    for (int i = 0; i < 16; i++) {
+        hashSelection[i] = GetHashSelection(hashPrevBlock, i);
+    }
+
+    const X16RAlgo& algo = X16R_ALGOS[hashSelection[0]];
+    algo.init(&midstate->ctx);
+    algo.write(&midstate->ctx, header, X16R_HEADER_SIZE - 4);
+}
+
+CX16RPreparedHeader::~CX16RPreparedHeader() {}
+
+uint256 CX16RPreparedHeader::Hash(uint32_t nNonce) const
+{
+    uint512 hash[2];
+    unsigned char nonce[4];
+    WriteLE32(nonce, nNonce);
+
+    X16RCountHash(X16RCaller::MINING);
+    const auto start = AlgoStart();
+    X16RContext ctx = midstate->ctx;
+    const X16RAlgo& algo = X16R_ALGOS[hashSelection[0]];
+    algo.write(&ctx, nonce, sizeof(nonce));
+    algo.close(&ctx, hash[0].begin());
+    RecordAlgo(hashSelection[0], 1, start);
+
+    for (int i = 1; i < 16; i++) {
+        HashX16RAlgo(hashSelection[i], hash[(i - 1) & 1].begin(), 64, hash[i & 1].begin());
+    }
+    return hash[1].trim256();
+}
+
+namespace
+{
+
+/** Hash 4 lanes of len bytes each (laid out back to back) into 4 64-byte digests. */
+typedef void (*HashAlgo4wayType)(unsigned char*, const unsigned char*, size_t);
+
+/** Multi-lane implementations of the X16R primitives, indexed by hash selection. nullptr if none is available. */
+HashAlgo4wayType HashAlgo4way[16] = {};
+
+void HashAlgoLanes(int hashSelection, unsigned char* out, const unsigned char* in, size_t len, size_t lanes)
+{
+    if (lanes == 4 && HashAlgo4way[hashSelection]) {
+        const auto start = AlgoStart();
+        HashAlgo4way[hashSelection](out, in, len);
+        RecordAlgo(hashSelection, 4, start);
+        return;
+    }
+    for (size_t i = 0; i < lanes; i++) {
+        HashX16RAlgo(hashSelection, in + i * len, len, out + i * 64);
+    }
+}
+
+bool SelfTest() {
+    // Every multi-lane primitive must agree with the scalar one on both input sizes used by X16R.
+    unsigned char in[4 * X16R_HEADER_SIZE];
+    for (size_t i = 0; i < sizeof(in); i++) {
+        in[i] = (unsigned char)(i * 7 + 1);
+    }
+    for (int algo = 0; algo < 16; algo++) {
+        if (!HashAlgo4way[algo]) continue;
+        for (size_t len : {X16R_HEADER_SIZE, (size_t)64}) {
+            unsigned char out[4 * 64], expected[4 * 64];
+            HashAlgo4way[algo](out, in, len);
+            for (size_t i = 0; i < 4; i++) {
+                HashX16RAlgo(algo, in + i * len, len, expected + i * 64);
+            }
+            if (!std::equal(out, out + sizeof(out), expected)) return false;
+        }
+    }
+    return true;
+}
+
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__) || defined(__i386__)) && defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+// We can't use cpuid.h's __get_cpuid as it does not support subleafs.
+void inline cpuid(uint32_t leaf, uint32_t subleaf, uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d)
+{
+#ifdef __GNUC__
+    __cpuid_count(leaf, subleaf, a, b, c, d);
+#else
+  __asm__ ("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "0"(leaf), "2"(subleaf));
+#endif
+}
+
+/** Check whether the OS has enabled AVX registers. */
+bool AVXEnabled()
+{
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (a & 6) == 6;
+}
+#endif
+} // namespace
+
+std::string X16RAutoDetect()
+{
+    std::string ret = "standard";
+    // Only Keccak has a multi-lane (AVX2) implementation so far, there is no SSE4.1 path.
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__) || defined(__i386__)) && defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+    bool have_avx2 = false;
+    bool enabled_avx = false;
+
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, 0, eax, ebx, ecx, edx);
+    bool have_sse4 = (ecx >> 19) & 1;
+    bool have_xsave = (ecx >> 27) & 1;
+    bool have_avx = (ecx >> 28) & 1;
+    if (have_xsave && have_avx) {
+        enabled_avx = AVXEnabled();
+    }
+    if (have_sse4) {
+        cpuid(7, 0, eax, ebx, ecx, edx);
+        have_avx2 = (ebx >> 5) & 1;
+    }
+
+    if (have_avx2 && have_avx && enabled_avx) {
+        HashAlgo4way[4] = x16r_avx2::Keccak512_4way;
+        ret = "avx2(keccak 4way)";
+    }
+#endif
+
+    return ret;
+}
+
+bool X16R_InitSanityCheck()
+{
+    return SelfTest();
+}
+
+void HashX16RBatch(uint256* output, const unsigned char* input, size_t n)
+{
+    // Group the headers by previous block hash, which decides the algorithm order.
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [input](size_t a, size_t b) {
+        return memcmp(input + a * X16R_HEADER_SIZE + 4, input + b * X16R_HEADER_SIZE + 4, 32) < 0;
+    });
+
+    unsigned char in[4 * X16R_HEADER_SIZE];
+    unsigned char out[4 * 64];
+    size_t pos = 0;
+    while (pos < n) {
+        const unsigned char* prev = input + order[pos] * X16R_HEADER_SIZE + 4;
+        size_t lanes = 1;
+        while (lanes < 4 && pos + lanes < n && memcmp(input + order[pos + lanes] * X16R_HEADER_SIZE + 4, prev, 32) == 0) {
+            lanes++;
+        }
+
+        uint256 hashPrevBlock;
+        memcpy(hashPrevBlock.begin(), prev, 32);
+        for (size_t i = 0; i < lanes; i++) {
+            memcpy(in + i * X16R_HEADER_SIZE, input + order[pos + i] * X16R_HEADER_SIZE, X16R_HEADER_SIZE);
+        }
+        HashAlgoLanes(GetHashSelection(hashPrevBlock, 0), out, in, X16R_HEADER_SIZE, lanes);
+        for (int round = 1; round < 16; round++) {
+            memcpy(in, out, lanes * 64);
+            HashAlgoLanes(GetHashSelection(hashPrevBlock, round), out, in, 64, lanes);
+        }
+        for (size_t i = 0; i < lanes; i++) {
+            memcpy(output[order[pos + i]].begin(), out + i * 64, 32);
+        }
+        pos += lanes;
+    }
+}
@@ -10,24 +10,11 @@
 
 #include <uint256.h>
 
-#include <crypto/sph_blake.h>
-#include <crypto/sph_bmw.h>
-#include <crypto/sph_groestl.h>
-#include <crypto/sph_jh.h>
-#include <crypto/sph_keccak.h>
-#include <crypto/sph_skein.h>
-#include <crypto/sph_luffa.h>
-#include <crypto/sph_cubehash.h>
-#include <crypto/sph_shavite.h>
-#include <crypto/sph_simd.h>
-#include <crypto/sph_echo.h>
-#include <crypto/sph_hamsi.h>
-#include <crypto/sph_fugue.h>
-#include <crypto/sph_shabal.h>
-#include <crypto/sph_whirlpool.h>
-extern "C"{
-#include <crypto/sph_sha2.h>
-}
+#include <assert.h>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
 
 inline int GetHashSelection(const uint256 PrevBlockHash, int index) {
     assert(index >= 0);
@@ -38,33 +25,99 @@ inline int GetHashSelection(const uint256 PrevBlockHash, int index) {
     return(hashSelection);
 }
 
-extern double algoHashTotal[16];
-extern int algoHashHits[16];
+/** Where an X16R proof of work hash was requested from. */
+enum class X16RCaller {
+    OTHER,
+    HEADER_SYNC,    //!< accepting block headers
+    BLOCK_CHECK,    //!< context-free checks of a full block
+    BLOCK_READ,     //!< reading a block back from disk
+    INDEX_LOAD,     //!< loading the block index at startup
+    MINING,         //!< nonce scanning
+};
+static const int X16R_CALLER_COUNT = 6;
+
+/** Process wide X16R hashing statistics. */
+struct X16RStats {
+    //! Number of digests computed by each primitive, indexed by hash selection
+    uint64_t algoHits[16];
+    //! Nanoseconds spent in each primitive while timing was enabled, indexed by hash selection
+    uint64_t algoNanos[16];
+    //! Number of proof of work hashes computed for each X16RCaller
+    uint64_t callerHashes[X16R_CALLER_COUNT];
+};
+
+/** Name of the X16R primitive hashSelection (0-15). */
+const char* X16RAlgoName(int hashSelection);
+
+/** Name of an X16RCaller. */
+const char* X16RCallerName(X16RCaller caller);
+
+/** Count one proof of work hash on behalf of caller. */
+void X16RCountHash(X16RCaller caller);
+
+/** Default for -powstatstiming. */
+static const bool DEFAULT_X16R_TIMING = false;
+
+/** Enable or disable timing each primitive, the hash counts are always kept. Off by default. */
+void X16RSetTiming(bool fEnable);
+
+/** Whether the primitives are timed. */
+bool X16RTimingEnabled();
+
+/** Sum the statistics of all threads that have hashed. */
+X16RStats GetX16RStats();
+
+/** Size of a serialized block header, the input of the first X16R round. */
+static const size_t X16R_HEADER_SIZE = 80;
+
+/** Hash len bytes at pin with the X16R primitive hashSelection (0-15),
+ *  writing the 64-byte digest to pout. */
+void HashX16RAlgo(int hashSelection, const void* pin, size_t len, void* pout);
+
+/** Autodetect the best available multi-lane X16R primitives.
+ *  Returns the name of the implementation.
+ */
+std::string X16RAutoDetect();
+
+/** Check that the multi-lane primitives picked by X16RAutoDetect() agree
+ *  with the scalar ones. Returns false if any of them is broken.
+ */
+bool X16R_InitSanityCheck();
+
+/** Compute the X16R hashes of multiple serialized block headers.
+ *  Headers sharing a previous block hash share an algorithm order, so
+ *  they are hashed side by side through the multi-lane primitives where
+ *  the CPU has them.
+ *  output:  pointer to an array of n hashes
+ *  input:   pointer to n*X16R_HEADER_SIZE bytes of serialized headers
+ *  n:       the number of headers
+ */
+void HashX16RBatch(uint256* output, const unsigned char* input, size_t n);
+
+/** A block header prepared for scanning nonces. The algorithm order is
+ *  derived once, and the first round has already absorbed the 76 bytes
+ *  in front of the nonce, so hashing a nonce only finishes that round.
+ */
+class CX16RPreparedHeader
+{
+private:
+    struct Midstate;
+    std::unique_ptr<Midstate> midstate;
+    int hashSelection[16];
+
+public:
+    //! header: the X16R_HEADER_SIZE byte serialized header; its nonce is ignored.
+    explicit CX16RPreparedHeader(const unsigned char* header);
+    ~CX16RPreparedHeader();
 
+    //! Return the X16R hash of the header with its nonce set to nNonce.
+    //! Counted as X16RCaller::MINING.
+    uint256 Hash(uint32_t nNonce) const;
+};
 
 template<typename T1>
 inline uint256 HashX16R(const T1 pbegin, const T1 pend, const uint256 PrevBlockHash)
 {
-//	static std::chrono::duration<double>[16];
-    int hashSelection;
-
-    sph_blake512_context     ctx_blake;      //0
-    sph_bmw512_context       ctx_bmw;        //1
-    sph_groestl512_context   ctx_groestl;    //2
-    sph_jh512_context        ctx_jh;         //3
-    sph_keccak512_context    ctx_keccak;     //4
-    sph_skein512_context     ctx_skein;      //5
-    sph_luffa512_context     ctx_luffa;      //6
-    sph_cubehash512_context  ctx_cubehash;   //7
-    sph_shavite512_context   ctx_shavite;    //8
-    sph_simd512_context      ctx_simd;       //9
-    sph_echo512_context      ctx_echo;       //A
-    sph_hamsi512_context     ctx_hamsi;      //B
-    sph_fugue512_context     ctx_fugue;      //C
-    sph_shabal512_context    ctx_shabal;     //D
-    sph_whirlpool_context    ctx_whirlpool;  //E
-    sph_sha512_context       ctx_sha512;     //F
-
     static unsigned char pblank[1];
 
     uint512 hash[16];
@@ -81,90 +134,7 @@ inline uint256 HashX16R(const T1 pbegin, const T1 pend, const uint256 PrevBlockH
             lenToHash = 64;
         }
 
-        hashSelection = GetHashSelection(PrevBlockHash, i);
-
-        switch(hashSelection) {
-            case 0:
-                sph_blake512_init(&ctx_blake);
-                sph_blake512 (&ctx_blake, toHash, lenToHash);
-                sph_blake512_close(&ctx_blake, static_cast<void*>(&hash[i]));
-                break;
-            case 1:
-                sph_bmw512_init(&ctx_bmw);
-                sph_bmw512 (&ctx_bmw, toHash, lenToHash);
-                sph_bmw512_close(&ctx_bmw, static_cast<void*>(&hash[i]));
-                break;
-            case 2:
-                sph_groestl512_init(&ctx_groestl);
-                sph_groestl512 (&ctx_groestl, toHash, lenToHash);
-                sph_groestl512_close(&ctx_groestl, static_cast<void*>(&hash[i]));
-                break;
-            case 3:
-                sph_jh512_init(&ctx_jh);
-                sph_jh512 (&ctx_jh, toHash, lenToHash);
-                sph_jh512_close(&ctx_jh, static_cast<void*>(&hash[i]));
-                break;
-            case 4:
-                sph_keccak512_init(&ctx_keccak);
-                sph_keccak512 (&ctx_keccak, toHash, lenToHash);
-                sph_keccak512_close(&ctx_keccak, static_cast<void*>(&hash[i]));
-                break;
-            case 5:
-                sph_skein512_init(&ctx_skein);
-                sph_skein512 (&ctx_skein, toHash, lenToHash);
-                sph_skein512_close(&ctx_skein, static_cast<void*>(&hash[i]));
-                break;
-            case 6:
-                sph_luffa512_init(&ctx_luffa);
-                sph_luffa512 (&ctx_luffa, toHash, lenToHash);
-                sph_luffa512_close(&ctx_luffa, static_cast<void*>(&hash[i]));
-                break;
-            case 7:
-                sph_cubehash512_init(&ctx_cubehash);
-                sph_cubehash512 (&ctx_cubehash, toHash, lenToHash);
-                sph_cubehash512_close(&ctx_cubehash, static_cast<void*>(&hash[i]));
-                break;
-            case 8:
-                sph_shavite512_init(&ctx_shavite);
-                sph_shavite512(&ctx_shavite, toHash, lenToHash);
-                sph_shavite512_close(&ctx_shavite, static_cast<void*>(&hash[i]));
-                break;
-            case 9:
-                sph_simd512_init(&ctx_simd);
-                sph_simd512 (&ctx_simd, toHash, lenToHash);
-                sph_simd512_close(&ctx_simd, static_cast<void*>(&hash[i]));
-                break;
-            case 10:
-                sph_echo512_init(&ctx_echo);
-                sph_echo512 (&ctx_echo, toHash, lenToHash);
-                sph_echo512_close(&ctx_echo, static_cast<void*>(&hash[i]));
-                break;
-           case 11:
-                sph_hamsi512_init(&ctx_hamsi);
-                sph_hamsi512 (&ctx_hamsi, toHash, lenToHash);
-                sph_hamsi512_close(&ctx_hamsi, static_cast<void*>(&hash[i]));
-                break;
-           case 12:
-                sph_fugue512_init(&ctx_fugue);
-                sph_fugue512 (&ctx_fugue, toHash, lenToHash);
-                sph_fugue512_close(&ctx_fugue, static_cast<void*>(&hash[i]));
-                break;
-           case 13:
-                sph_shabal512_init(&ctx_shabal);
-                sph_shabal512 (&ctx_shabal, toHash, lenToHash);
-                sph_shabal512_close(&ctx_shabal, static_cast<void*>(&hash[i]));
-                break;
-           case 14:
-                sph_whirlpool_init(&ctx_whirlpool);
-                sph_whirlpool(&ctx_whirlpool, toHash, lenToHash);
-                sph_whirlpool_close(&ctx_whirlpool, static_cast<void*>(&hash[i]));
-                break;
-           case 15:
-                sph_sha512_init(&ctx_sha512);
-                sph_sha512 (&ctx_sha512, toHash, lenToHash);
-                sph_sha512_close(&ctx_sha512, static_cast<void*>(&hash[i]));
-                break;
-        }
+        HashX16RAlgo(GetHashSelection(PrevBlockHash, i), toHash, lenToHash, static_cast<void*>(&hash[i]));
     }
 
     return hash[15].trim256();
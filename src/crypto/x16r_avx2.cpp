@@ -0,0 +1,118 @@
+// Copyright (c) 2019 Cryptroxcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_AVX2
+
+#include <stdint.h>
+#include <string.h>
+#include <immintrin.h>
+
+#include <crypto/common.h>
+
+namespace x16r_avx2 {
+namespace {
+
+static const uint64_t KECCAK_RC[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808AULL, 0x8000000080008000ULL,
+    0x000000000000808BULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x000000000000008AULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000AULL,
+    0x000000008000808BULL, 0x800000000000008BULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800AULL, 0x800000008000000AULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+//! Rotation offsets, indexed by x + 5 * y.
+static const int KECCAK_ROT[25] = {
+     0,  1, 62, 28, 27,
+    36, 44,  6, 55, 20,
+     3, 10, 43, 25, 39,
+    41, 45, 15, 21,  8,
+    18,  2, 61, 56, 14
+};
+
+//! Keccak-512 rate in bytes.
+static const size_t KECCAK512_RATE = 72;
+
+__m256i inline Xor(__m256i x, __m256i y) { return _mm256_xor_si256(x, y); }
+__m256i inline AndNot(__m256i x, __m256i y) { return _mm256_andnot_si256(x, y); }
+__m256i inline RotL(__m256i x, int n) { return n ? _mm256_or_si256(_mm256_slli_epi64(x, n), _mm256_srli_epi64(x, 64 - n)) : x; }
+
+/** Keccak-f[1600] over 4 states, one per 64-bit lane. */
+void KeccakF(__m256i* a)
+{
+    __m256i b[25], c[5], d[5];
+    for (int round = 0; round < 24; round++) {
+        // theta
+        for (int x = 0; x < 5; x++) {
+            c[x] = Xor(Xor(Xor(a[x], a[x + 5]), Xor(a[x + 10], a[x + 15])), a[x + 20]);
+        }
+        for (int x = 0; x < 5; x++) {
+            d[x] = Xor(c[(x + 4) % 5], RotL(c[(x + 1) % 5], 1));
+        }
+        for (int i = 0; i < 25; i++) {
+            a[i] = Xor(a[i], d[i % 5]);
+        }
+        // rho and pi
+        for (int x = 0; x < 5; x++) {
+            for (int y = 0; y < 5; y++) {
+                b[y + 5 * ((2 * x + 3 * y) % 5)] = RotL(a[x + 5 * y], KECCAK_ROT[x + 5 * y]);
+            }
+        }
+        // chi
+        for (int y = 0; y < 25; y += 5) {
+            for (int x = 0; x < 5; x++) {
+                a[y + x] = Xor(b[y + x], AndNot(b[y + (x + 1) % 5], b[y + (x + 2) % 5]));
+            }
+        }
+        // iota
+        a[0] = Xor(a[0], _mm256_set1_epi64x(KECCAK_RC[round]));
+    }
+}
+
+void inline Absorb(__m256i* a, const unsigned char* lane0, const unsigned char* lane1, const unsigned char* lane2, const unsigned char* lane3)
+{
+    for (size_t i = 0; i < KECCAK512_RATE / 8; i++) {
+        a[i] = Xor(a[i], _mm256_set_epi64x(ReadLE64(lane3 + i * 8), ReadLE64(lane2 + i * 8), ReadLE64(lane1 + i * 8), ReadLE64(lane0 + i * 8)));
+    }
+    KeccakF(a);
+}
+
+}
+
+void Keccak512_4way(unsigned char* out, const unsigned char* in, size_t len)
+{
+    __m256i a[25];
+    for (int i = 0; i < 25; i++) {
+        a[i] = _mm256_setzero_si256();
+    }
+
+    const size_t nFull = len / KECCAK512_RATE;
+    for (size_t block = 0; block < nFull; block++) {
+        const unsigned char* p = in + block * KECCAK512_RATE;
+        Absorb(a, p, p + len, p + 2 * len, p + 3 * len);
+    }
+
+    // Pad the remainder of each lane the same way sph_keccak512 does.
+    const size_t nRemainder = len - nFull * KECCAK512_RATE;
+    unsigned char tail[4][KECCAK512_RATE];
+    for (int lane = 0; lane < 4; lane++) {
+        memset(tail[lane], 0, KECCAK512_RATE);
+        memcpy(tail[lane], in + lane * len + nFull * KECCAK512_RATE, nRemainder);
+        tail[lane][nRemainder] ^= 0x01;
+        tail[lane][KECCAK512_RATE - 1] ^= 0x80;
+    }
+    Absorb(a, tail[0], tail[1], tail[2], tail[3]);
+
+    alignas(32) uint64_t words[4];
+    for (int i = 0; i < 8; i++) {
+        _mm256_store_si256((__m256i*)words, a[i]);
+        for (int lane = 0; lane < 4; lane++) {
+            WriteLE64(out + lane * 64 + i * 8, words[lane]);
+        }
+    }
+}
+
+}
+
+#endif
@@ -60,3 +60,15 @@ void CDSNotificationInterface::SyncTransaction(const CTransaction &tx, const CBl
     instantsend.SyncTransaction(tx, pblock);
     CPrivateSend::SyncTransaction(tx, pblock);
 }
+
+// CRYPTROX BEGIN
+void CDSNotificationInterface::BlockConnected(const std::shared_ptr<const CBlock> &block, const CBlockIndex *pindex, const std::vector<CTransactionRef> &txnConflicted)
+{
+    mnodeman.UpdateCollaterals(*block, true);
+}
+
+void CDSNotificationInterface::BlockDisconnected(const std::shared_ptr<const CBlock> &block)
+{
+    mnodeman.UpdateCollaterals(*block, false);
+}
+// CRYPTROX END
@@ -10,6 +10,7 @@
 #include <clientversion.h>
 #include <hash.h>
 #include <streams.h>
+#include <sync.h>
 #include <util.h>
 
 #include <boost/filesystem.hpp>
@@ -17,8 +18,94 @@
 /**
 *   Generic Dumping and Loading
 *   ---------------------------
+*   A file is a header (magic message, network magic, format version) followed by one
+*   checksummed snapshot. Dump takes a copy of the object under its locks and streams the
+*   copy into a new file without holding them, which is moved over the old one once it is
+*   on disk. An unclean exit mid-write leaves the previous snapshot in place. Load streams
+*   the snapshot straight into the object. Files written before the format version was
+*   added are still read, the next dump replaces them.
+*
+*   T provides CopyForDump(T&), which copies the state it serializes into an empty T.
 */
 
+static const uint32_t FLATDB_FORMAT_VERSION = 0x42444602; // "\x02FDB"
+/** Seconds between snapshots written while running */
+static const int64_t FLATDB_CHECKPOINT_INTERVAL = 15 * 60;
+
+/** A reader stream that takes a known number of bytes from a file while hashing them. */
+class CHashedFileReader
+{
+private:
+    CAutoFile& filein;
+    CHash256 ctx;
+    uint64_t nRemaining;
+
+public:
+    CHashedFileReader(CAutoFile& fileinIn, uint64_t nSizeIn) : filein(fileinIn), nRemaining(nSizeIn) {}
+
+    int GetType() const { return filein.GetType(); }
+    int GetVersion() const { return filein.GetVersion(); }
+
+    void read(char *pch, size_t size) {
+        if (size > nRemaining)
+            throw std::ios_base::failure("CHashedFileReader::read: end of data reached");
+        filein.read(pch, size);
+        ctx.Write((const unsigned char*)pch, size);
+        nRemaining -= size;
+    }
+
+    // bytes left, like CDataStream::size() for types with optional trailing fields
+    size_t size() const { return nRemaining; }
+
+    // invalidates the object
+    uint256 GetHash() {
+        uint256 result;
+        ctx.Finalize(result.begin());
+        return result;
+    }
+
+    template<typename T>
+    CHashedFileReader& operator>>(T&& obj) {
+        ::Unserialize(*this, obj);
+        return (*this);
+    }
+};
+
+/** A writer stream that passes everything on to a file while hashing it. */
+class CHashedFileWriter
+{
+private:
+    CAutoFile& fileout;
+    CHash256 ctx;
+
+public:
+    explicit CHashedFileWriter(CAutoFile& fileoutIn) : fileout(fileoutIn) {}
+
+    int GetType() const { return fileout.GetType(); }
+    int GetVersion() const { return fileout.GetVersion(); }
+
+    void write(const char *pch, size_t size) {
+        fileout.write(pch, size);
+        ctx.Write((const unsigned char*)pch, size);
+    }
+
+    // only asked by types with optional trailing fields, and only while reading
+    size_t size() const { return 0; }
+
+    // invalidates the object
+    uint256 GetHash() {
+        uint256 result;
+        ctx.Finalize(result.begin());
+        return result;
+    }
+
+    template<typename T>
+    CHashedFileWriter& operator<<(const T& obj) {
+        ::Serialize(*this, obj);
+        return (*this);
+    }
+};
+
 template<typename T>
 class CFlatDB
 {
@@ -31,49 +118,142 @@ private:
         IncorrectHash,
         IncorrectMagicMessage,
         IncorrectMagicNumber,
-        IncorrectFormat
+        IncorrectFormat,
+        LegacyFormat
     };
 
     boost::filesystem::path pathDB;
     std::string strFilename;
     std::string strMagicMessage;
 
-    bool Write(const T& objToSave)
+    // Returns LegacyFormat for a file written before the format version was added,
+    // the magic message and the network magic number of those are already checked.
+    ReadResult ReadHeader(CAutoFile& filein)
     {
-        // LOCK(objToSave.cs);
+        unsigned char pchMsgTmp[4];
+        std::string strMagicMessageTmp;
+        uint32_t nFormatVersion;
+        try {
+            // de-serialize file header (file specific magic message) and ..
+            filein >> strMagicMessageTmp;
 
-        int64_t nStart = GetTimeMillis();
+            // ... verify the message matches predefined one
+            if (strMagicMessage != strMagicMessageTmp)
+            {
+                error("%s: Invalid magic message", __func__);
+                return IncorrectMagicMessage;
+            }
+
+            // de-serialize file header (network specific magic number) and ..
+            filein >> pchMsgTmp;
+
+            // ... verify the network matches ours
+            if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp)))
+            {
+                error("%s: Invalid network magic number", __func__);
+                return IncorrectMagicNumber;
+            }
+
+            // legacy files continue with the object itself
+            filein >> nFormatVersion;
+            if (nFormatVersion != FLATDB_FORMAT_VERSION)
+                return LegacyFormat;
+        }
+        catch (std::exception &e) {
+            error("%s: Deserialize or I/O error - %s", __func__, e.what());
+            return IncorrectFormat;
+        }
+        return Ok;
+    }
 
-        // serialize, checksum data up to that point, then append checksum
-        CDataStream ssObj(SER_DISK, CLIENT_VERSION);
-        ssObj << strMagicMessage; // specific magic message for this type of object
-        ssObj << Params().MessageStart(); // network specific magic number
-        ssObj << objToSave;
-        uint256 hash = Hash(ssObj.begin(), ssObj.end());
-        ssObj << hash;
+    // Stream T from reader, then compare the checksum that follows it in filein
+    ReadResult ReadChecksummed(CHashedFileReader& reader, CAutoFile& filein, T& objToLoad)
+    {
+        uint256 hashIn;
+        uint256 hashTmp;
+        try {
+            reader >> objToLoad;
+            if (reader.size() != 0)
+                throw std::ios_base::failure("data size mismatch");
+            hashTmp = reader.GetHash();
+            filein >> hashIn;
+        }
+        catch (std::exception &e) {
+            objToLoad.Clear();
+            error("%s: Deserialize or I/O error - %s", __func__, e.what());
+            return IncorrectFormat;
+        }
 
-        // open output file, and associate with CAutoFile
-        FILE *file = fopen(pathDB.string().c_str(), "wb");
+        // verify stored checksum matches input data
+        if (hashIn != hashTmp)
+        {
+            objToLoad.Clear();
+            error("%s: Checksum mismatch, data corrupted", __func__);
+            return IncorrectHash;
+        }
+        return Ok;
+    }
+
+    // The checksum of a legacy file covers its header as well, read it once more through the hash
+    ReadResult ReadLegacy(CAutoFile& filein, long nFileSize, T& objToLoad)
+    {
+        if (nFileSize < (long)sizeof(uint256) || fseek(filein.Get(), 0, SEEK_SET))
+        {
+            error("%s: Failed to read legacy file %s", __func__, pathDB.string());
+            return HashReadError;
+        }
+        CHashedFileReader reader(filein, nFileSize - sizeof(uint256));
+        std::string strMagicMessageTmp;
+        unsigned char pchMsgTmp[4];
+        try {
+            reader >> strMagicMessageTmp;
+            reader >> pchMsgTmp;
+        }
+        catch (std::exception &e) {
+            error("%s: Deserialize or I/O error - %s", __func__, e.what());
+            return IncorrectFormat;
+        }
+        return ReadChecksummed(reader, filein, objToLoad);
+    }
+
+    bool Write(T& objToSave)
+    {
+        int64_t nStart = GetTimeMillis();
+
+        // write next to the current file and only replace it once everything is on disk
+        boost::filesystem::path pathNew = pathDB.string() + ".new";
+        FILE *file = fopen(pathNew.string().c_str(), "wb");
         CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
         if (fileout.IsNull())
-            return error("%s: Failed to open file %s", __func__, pathDB.string());
+            return error("%s: Failed to open file %s", __func__, pathNew.string());
 
-        // Write and commit header, data
+        // Write header, then stream the data and append its checksum
         try {
-            fileout << ssObj;
+            fileout << strMagicMessage; // specific magic message for this type of object
+            fileout << Params().MessageStart(); // network specific magic number
+            fileout << FLATDB_FORMAT_VERSION;
+
+            CHashedFileWriter writer(fileout);
+            writer << objToSave;
+            fileout << writer.GetHash();
+            if (!FileCommit(fileout.Get()))
+                throw std::ios_base::failure("failed to commit data");
         }
         catch (std::exception &e) {
             return error("%s: Serialize or I/O error - %s", __func__, e.what());
         }
         fileout.fclose();
 
+        if (!RenameOver(pathNew, pathDB))
+            return error("%s: Failed to move %s into place", __func__, pathNew.string());
+
         LogPrintf("Written info to %s  %dms\n", strFilename, GetTimeMillis() - nStart);
         LogPrintf("     %s\n", objToSave.ToString());
 
         return true;
     }
 
-    ReadResult Read(T& objToLoad, bool fDryRun = false)
+    ReadResult Read(T& objToLoad)
     {
         //LOCK(objToLoad.cs);
 
@@ -87,78 +267,29 @@ private:
             return FileError;
         }
 
-        // use file size to size memory buffer
-        int fileSize = boost::filesystem::file_size(pathDB);
-        int dataSize = fileSize - sizeof(uint256);
-        // Don't try to resize to a negative number if file is small
-        if (dataSize < 0)
-            dataSize = 0;
-        std::vector<unsigned char> vchData;
-        vchData.resize(dataSize);
-        uint256 hashIn;
-
-        // read data and checksum from file
-        try {
-            filein.read((char *)&vchData[0], dataSize);
-            filein >> hashIn;
-        }
-        catch (std::exception &e) {
-            error("%s: Deserialize or I/O error - %s", __func__, e.what());
-            return HashReadError;
-        }
-        filein.fclose();
-
-        CDataStream ssObj(vchData, SER_DISK, CLIENT_VERSION);
-
-        // verify stored checksum matches input data
-        uint256 hashTmp = Hash(ssObj.begin(), ssObj.end());
-        if (hashIn != hashTmp)
-        {
-            error("%s: Checksum mismatch, data corrupted", __func__);
-            return IncorrectHash;
-        }
-
-
-        unsigned char pchMsgTmp[4];
-        std::string strMagicMessageTmp;
-        try {
-            // de-serialize file header (file specific magic message) and ..
-            ssObj >> strMagicMessageTmp;
-
-            // ... verify the message matches predefined one
-            if (strMagicMessage != strMagicMessageTmp)
-            {
-                error("%s: Invalid magic message", __func__);
-                return IncorrectMagicMessage;
-            }
-
-
-            // de-serialize file header (network specific magic number) and ..
-            ssObj >> pchMsgTmp;
-
-            // ... verify the network matches ours
-            if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp)))
+        long nFileSize = boost::filesystem::file_size(pathDB);
+        ReadResult result = ReadHeader(filein);
+        if (result == LegacyFormat) {
+            LogPrintf("%s: Reading legacy format of %s, the next dump replaces it\n", __func__, strFilename);
+            result = ReadLegacy(filein, nFileSize, objToLoad);
+        } else if (result == Ok) {
+            long nDataSize = nFileSize - ftell(filein.Get()) - (long)sizeof(uint256);
+            if (nDataSize < 0)
             {
-                error("%s: Invalid network magic number", __func__);
-                return IncorrectMagicNumber;
+                error("%s: File %s is truncated", __func__, pathDB.string());
+                return IncorrectFormat;
             }
-
-            // de-serialize data into T object
-            ssObj >> objToLoad;
-        }
-        catch (std::exception &e) {
-            objToLoad.Clear();
-            error("%s: Deserialize or I/O error - %s", __func__, e.what());
-            return IncorrectFormat;
+            CHashedFileReader reader(filein, nDataSize);
+            result = ReadChecksummed(reader, filein, objToLoad);
         }
+        if (result != Ok)
+            return result;
 
         LogPrintf("Loaded info from %s  %dms\n", strFilename, GetTimeMillis() - nStart);
         LogPrintf("     %s\n", objToLoad.ToString());
-        if(!fDryRun) {
-            LogPrintf("%s: Cleaning....\n", __func__);
-            objToLoad.CheckAndRemove();
-            LogPrintf("     %s\n", objToLoad.ToString());
-        }
+        LogPrintf("%s: Cleaning....\n", __func__);
+        objToLoad.CheckAndRemove();
+        LogPrintf("     %s\n", objToLoad.ToString());
 
         return Ok;
     }
@@ -196,15 +327,26 @@ public:
 
     bool Dump(T& objToSave)
     {
+        // periodic checkpoints and the final dump on shutdown must not interleave
+        static CCriticalSection cs_dump;
+        LOCK(cs_dump);
+
         int64_t nStart = GetTimeMillis();
 
         LogPrintf("Verifying %s format...\n", strFilename);
-        T tmpObjToLoad;
-        ReadResult readResult = Read(tmpObjToLoad, true);
+        ReadResult readResult;
+        {
+            // only the header is checked, the data is replaced anyway
+            FILE *file = fopen(pathDB.string().c_str(), "rb");
+            CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
+            readResult = filein.IsNull() ? FileError : ReadHeader(filein);
+        }
 
         // there was an error and it was not an error on file opening => do not proceed
         if (readResult == FileError)
             LogPrintf("Missing file %s, will try to recreate\n", strFilename);
+        else if (readResult == LegacyFormat)
+            LogPrintf("Replacing legacy format of %s\n", strFilename);
         else if (readResult != Ok)
         {
             LogPrintf("Error reading %s: ", strFilename);
@@ -217,8 +359,12 @@ public:
             }
         }
 
+        // the object's locks are only held while it is copied, not while the copy is written
+        T objCopy;
+        objToSave.CopyForDump(objCopy);
+
         LogPrintf("Writing info to %s...\n", strFilename);
-        Write(objToSave);
+        Write(objCopy);
         LogPrintf("%s dump finished  %dms\n", strFilename, GetTimeMillis() - nStart);
 
         return true;
@@ -27,6 +27,7 @@ CGovernanceObject::CGovernanceObject()
   strData(),
   vinMasternode(),
   vchSig(),
+  hashSignatureMessage(),
   fCachedLocalValidity(false),
   strLocalValidityError(),
   fCachedFunding(false),
@@ -55,6 +56,7 @@ CGovernanceObject::CGovernanceObject(uint256 nHashParentIn, int nRevisionIn, int
   strData(strDataIn),
   vinMasternode(),
   vchSig(),
+  hashSignatureMessage(),
   fCachedLocalValidity(false),
   strLocalValidityError(),
   fCachedFunding(false),
@@ -83,6 +85,7 @@ CGovernanceObject::CGovernanceObject(const CGovernanceObject& other)
   strData(other.strData),
   vinMasternode(other.vinMasternode),
   vchSig(other.vchSig),
+  hashSignatureMessage(other.hashSignatureMessage),
   fCachedLocalValidity(other.fCachedLocalValidity),
   strLocalValidityError(other.strLocalValidityError),
   fCachedFunding(other.fCachedFunding),
@@ -100,7 +103,8 @@ CGovernanceObject::CGovernanceObject(const CGovernanceObject& other)
 bool CGovernanceObject::ProcessVote(CNode* pfrom,
                                     const CGovernanceVote& vote,
                                     CGovernanceException& exception,
-                                    CConnman& connman)
+                                    CConnman& connman,
+                                    SignatureState sigState)
 {
     if(!mnodeman.Has(vote.GetMasternodeOutpoint())) {
         std::ostringstream ostr;
@@ -170,7 +174,10 @@ bool CGovernanceObject::ProcessVote(CNode* pfrom,
         }
     }
     // Finally check that the vote is actually valid (done last because of cost of signature verification)
-    if(!vote.IsValid(true)) {
+    // CRYPTROX BEGIN
+    // unless the signature was already verified, see CMessageVerifyQueue
+    if(sigState == SignatureState::INVALID || !vote.IsValid(sigState == SignatureState::UNCHECKED)) {
+    // CRYPTROX END
         std::ostringstream ostr;
         ostr << "CGovernanceObject::ProcessVote -- Invalid vote"
                 << ", MN outpoint = " << vote.GetMasternodeOutpoint().ToStringShort()
@@ -212,37 +219,42 @@ void CGovernanceObject::ClearMasternodeVotes()
     }
 }
 
-std::string CGovernanceObject::GetSignatureMessage() const
+// CRYPTROX BEGIN
+uint256 CGovernanceObject::GetSignatureHash() const
 {
     LOCK(cs);
-    std::string strMessage = nHashParent.ToString() + "|" +
-        boost::lexical_cast<std::string>(nRevision) + "|" +
-        boost::lexical_cast<std::string>(nTime) + "|" +
-        strData + "|" +
-        vinMasternode.prevout.ToStringShort() + "|" +
-        nCollateralHash.ToString();
-
-    return strMessage;
+    // strData can be large and local validity is rechecked on every cache
+    // update, so the message is only built again after a signed field changes
+    if(hashSignatureMessage.IsNull()) {
+        CSignedPayload payload(strData.size() + 256);
+        payload << nHashParent << "|" << nRevision << "|" << nTime << "|" << strData << "|";
+        payload.WriteOutPointShort(vinMasternode.prevout) << "|" << nCollateralHash;
+        hashSignatureMessage = payload.GetHash();
+    }
+    return hashSignatureMessage;
 }
+// CRYPTROX END
 
 void CGovernanceObject::SetMasternodeVin(const COutPoint& outpoint)
 {
+    LOCK(cs); // CRYPTROX
     vinMasternode = CTxIn(outpoint);
+    hashSignatureMessage.SetNull(); // CRYPTROX
 }
 
 bool CGovernanceObject::Sign(CKey& keyMasternode, CPubKey& pubKeyMasternode)
 {
     std::string strError;
-    std::string strMessage = GetSignatureMessage();
+    uint256 hash = GetSignatureHash(); // CRYPTROX
 
     LOCK(cs);
 
-    if(!CMessageSigner::SignMessage(strMessage, vchSig, keyMasternode)) {
+    if(!CHashSigner::SignHash(hash, keyMasternode, vchSig)) {
         LogPrintf("CGovernanceObject::Sign -- SignMessage() failed\n");
         return false;
     }
 
-    if(!CMessageSigner::VerifyMessage(pubKeyMasternode, vchSig, strMessage, strError)) {
+    if(!CHashSigner::VerifyHash(hash, pubKeyMasternode, vchSig, strError)) {
         LogPrintf("CGovernanceObject::Sign -- VerifyMessage() failed, error: %s\n", strError);
         return false;
     }
@@ -258,10 +270,10 @@ bool CGovernanceObject::CheckSignature(CPubKey& pubKeyMasternode)
 {
     std::string strError;
 
-    std::string strMessage = GetSignatureMessage();
+    uint256 hash = GetSignatureHash(); // CRYPTROX
 
     LOCK(cs);
-    if(!CMessageSigner::VerifyMessage(pubKeyMasternode, vchSig, strMessage, strError)) {
+    if(!CHashSigner::VerifyHash(hash, pubKeyMasternode, vchSig, strError)) {
         LogPrintf("CGovernance::CheckSignature -- VerifyMessage() failed, error: %s\n", strError);
         return false;
     }
@@ -714,6 +726,11 @@ void CGovernanceObject::swap(CGovernanceObject& first, CGovernanceObject& second
     swap(first.nCollateralHash, second.nCollateralHash);
     swap(first.strData, second.strData);
     swap(first.nObjectType, second.nObjectType);
+    // CRYPTROX BEGIN
+    // vinMasternode is not swapped, so neither cached signature hash holds any more
+    first.hashSignatureMessage.SetNull();
+    second.hashSignatureMessage.SetNull();
+    // CRYPTROX END
 
     // swap all cached valid flags
     swap(first.fCachedFunding, second.fCachedFunding);
@@ -728,8 +745,20 @@ void CGovernanceObject::CheckOrphanVotes(CConnman& connman)
 {
     int64_t nNow = GetAdjustedTime();
     const vote_mcache_t::list_t& listVotes = mapOrphanVotes.GetItemList();
+
+    // CRYPTROX BEGIN
+    std::vector<CGovernanceVote> vecVotes;
+    vecVotes.reserve(listVotes.size());
+    for(const auto& item : listVotes) {
+        vecVotes.push_back(item.value.first);
+    }
+    std::vector<SignatureState> vSigStates = CGovernanceVote::CheckSignatures(vecVotes);
+    size_t nVote = 0;
+    // CRYPTROX END
+
     vote_mcache_t::list_cit it = listVotes.begin();
     while(it != listVotes.end()) {
+        SignatureState sigState = vSigStates[nVote++]; // CRYPTROX
         bool fRemove = false;
         const COutPoint& key = it->key;
         const vote_time_pair_t& pairVote = it->value;
@@ -742,7 +771,7 @@ void CGovernanceObject::CheckOrphanVotes(CConnman& connman)
             continue;
         }
         CGovernanceException exception;
-        if(!ProcessVote(NULL, vote, exception, connman)) {
+        if(!ProcessVote(NULL, vote, exception, connman, sigState)) { // CRYPTROX
             LogPrintf("CGovernanceObject::CheckOrphanVotes -- Failed to add orphan vote: %s\n", exception.what());
         }
         else {
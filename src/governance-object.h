@@ -27,6 +27,7 @@ class CGovernanceVote;
 static const int MAX_GOVERNANCE_OBJECT_DATA_SIZE = 16 * 1024;
 static const int MIN_GOVERNANCE_PEER_PROTO_VERSION = 70206;
 static const int GOVERNANCE_FILTER_PROTO_VERSION = 70206;
+static const int GOVERNANCE_VOTE_SUMMARY_PROTO_VERSION = 70209; // CRYPTROX
 
 static const double GOVERNANCE_FILTER_FP_RATE = 0.001;
 
@@ -154,6 +155,11 @@ private:
     CTxIn vinMasternode;
     std::vector<unsigned char> vchSig;
 
+    // CRYPTROX BEGIN
+    /// Hash of the signed message, built on first use and reset whenever a signed field changes
+    mutable uint256 hashSignatureMessage;
+    // CRYPTROX END
+
     /// is valid by blockchain
     bool fCachedLocalValidity;
     std::string strLocalValidityError;
@@ -259,7 +265,7 @@ public:
     bool Sign(CKey& keyMasternode, CPubKey& pubKeyMasternode);
     bool CheckSignature(CPubKey& pubKeyMasternode);
 
-    std::string GetSignatureMessage() const;
+    uint256 GetSignatureHash() const; // CRYPTROX
 
     // CORE OBJECT FUNCTIONS
 
@@ -318,6 +324,11 @@ public:
         READWRITE(nObjectType);
         READWRITE(vinMasternode);
         READWRITE(vchSig);
+        // CRYPTROX BEGIN
+        if(ser_action.ForRead()) {
+            hashSignatureMessage.SetNull();
+        }
+        // CRYPTROX END
         if(s.GetType() & SER_DISK) {
             // Only include these for the disk file format
             LogPrint(BCLog::GOBJECT, "CGovernanceObject::SerializationOp Reading/writing votes from/to disk\n");
@@ -345,7 +356,8 @@ private:
     bool ProcessVote(CNode* pfrom,
                      const CGovernanceVote& vote,
                      CGovernanceException& exception,
-                     CConnman& connman);
+                     CConnman& connman,
+                     SignatureState sigState = SignatureState::UNCHECKED); // CRYPTROX
 
     /// Called when MN's which have voted on this object have been removed
     void ClearMasternodeVotes();
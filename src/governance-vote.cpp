@@ -5,9 +5,11 @@
 
 #include <governance-vote.h>
 #include <governance-object.h>
+#include <hash.h>
 #include <masternode-sync.h>
 #include <masternodeman.h>
 #include <messagesigner.h>
+#include <random.h>
 #include <util.h>
 
 #include <boost/lexical_cast.hpp>
@@ -238,6 +240,35 @@ void CGovernanceVote::Relay(CConnman& connman) const
     connman.RelayInv(inv, MIN_GOVERNANCE_PEER_PROTO_VERSION);
 }
 
+// CRYPTROX BEGIN
+uint256 CGovernanceVote::GetSignatureHash() const
+{
+    CSignedPayload payload;
+    payload.WriteOutPointShort(vinMasternode.prevout) << "|" << nParentHash << "|"
+            << nVoteSignal << "|" << nVoteOutcome << "|" << nTime;
+    return payload.GetHash();
+}
+
+std::vector<SignatureState> CGovernanceVote::CheckSignatures(const std::vector<CGovernanceVote>& vecVotes)
+{
+    std::vector<SignatureState> vStates(vecVotes.size(), SignatureState::UNCHECKED);
+    std::vector<size_t> vBatchIndexes;
+    CSignatureBatch batch;
+    masternode_info_t infoMn;
+    for(size_t i = 0; i < vecVotes.size(); ++i) {
+        if(mnodeman.GetMasternodeInfo(vecVotes[i].vinMasternode.prevout, infoMn)) {
+            batch.AddHash(vecVotes[i].GetSignatureHash(), infoMn.pubKeyMasternode, vecVotes[i].vchSig);
+            vBatchIndexes.push_back(i);
+        }
+    }
+    std::vector<bool> vValid = batch.Verify();
+    for(size_t j = 0; j < vBatchIndexes.size(); ++j) {
+        vStates[vBatchIndexes[j]] = vValid[j] ? SignatureState::VALID : SignatureState::INVALID;
+    }
+    return vStates;
+}
+// CRYPTROX END
+
 bool CGovernanceVote::Sign(CKey& keyMasternode, CPubKey& pubKeyMasternode)
 {
     // Choose coins to use
@@ -245,15 +276,14 @@ bool CGovernanceVote::Sign(CKey& keyMasternode, CPubKey& pubKeyMasternode)
     CKey keyCollateralAddress;
 
     std::string strError;
-    std::string strMessage = vinMasternode.prevout.ToStringShort() + "|" + nParentHash.ToString() + "|" +
-        boost::lexical_cast<std::string>(nVoteSignal) + "|" + boost::lexical_cast<std::string>(nVoteOutcome) + "|" + boost::lexical_cast<std::string>(nTime);
+    uint256 hash = GetSignatureHash();
 
-    if(!CMessageSigner::SignMessage(strMessage, vchSig, keyMasternode)) {
+    if(!CHashSigner::SignHash(hash, keyMasternode, vchSig)) {
         LogPrintf("CGovernanceVote::Sign -- SignMessage() failed\n");
         return false;
     }
 
-    if(!CMessageSigner::VerifyMessage(pubKeyMasternode, vchSig, strMessage, strError)) {
+    if(!CHashSigner::VerifyHash(hash, pubKeyMasternode, vchSig, strError)) {
         LogPrintf("CGovernanceVote::Sign -- VerifyMessage() failed, error: %s\n", strError);
         return false;
     }
@@ -291,10 +321,7 @@ bool CGovernanceVote::IsValid(bool fSignatureCheck) const
     if(!fSignatureCheck) return true;
 
     std::string strError;
-    std::string strMessage = vinMasternode.prevout.ToStringShort() + "|" + nParentHash.ToString() + "|" +
-        boost::lexical_cast<std::string>(nVoteSignal) + "|" + boost::lexical_cast<std::string>(nVoteOutcome) + "|" + boost::lexical_cast<std::string>(nTime);
-
-    if(!CMessageSigner::VerifyMessage(infoMn.pubKeyMasternode, vchSig, strMessage, strError)) {
+    if(!CHashSigner::VerifyHash(GetSignatureHash(), infoMn.pubKeyMasternode, vchSig, strError)) {
         LogPrintf("CGovernanceVote::IsValid -- VerifyMessage() failed, error: %s\n", strError);
         return false;
     }
@@ -342,3 +369,33 @@ bool operator<(const CGovernanceVote& vote1, const CGovernanceVote& vote2)
 
     return fResult;
 }
+
+// CRYPTROX BEGIN
+CGovernanceVoteSummary CGovernanceVoteSummary::ForVoteCount(size_t nVotes)
+{
+    size_t nBuckets = std::min(std::max(nVotes / VOTES_PER_BUCKET, (size_t)1), MAX_BUCKETS);
+    return CGovernanceVoteSummary(GetRand(std::numeric_limits<uint64_t>::max()), GetRand(std::numeric_limits<uint64_t>::max()), nBuckets);
+}
+
+size_t CGovernanceVoteSummary::GetBucket(const uint256& nVoteHash, uint16_t& nFingerprintRet) const
+{
+    uint64_t nHash = SipHashUint256(k0, k1, nVoteHash);
+    nFingerprintRet = (uint16_t)nHash;
+    // map the high half onto [0, buckets) without a division
+    return ((nHash >> 32) * vBuckets.size()) >> 32;
+}
+
+void CGovernanceVoteSummary::Add(const uint256& nVoteHash)
+{
+    uint16_t nFingerprint;
+    size_t nBucket = GetBucket(nVoteHash, nFingerprint);
+    vBuckets[nBucket] ^= nFingerprint;
+}
+
+bool CGovernanceVoteSummary::Matches(const CGovernanceVoteSummary& other, const uint256& nVoteHash) const
+{
+    uint16_t nFingerprint;
+    size_t nBucket = GetBucket(nVoteHash, nFingerprint);
+    return vBuckets[nBucket] == other.vBuckets[nBucket];
+}
+// CRYPTROX END
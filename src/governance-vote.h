@@ -8,7 +8,9 @@
 #define CRYPTROX_GOVERNANCE_VOTE_H
 
 #include <key.h>
+#include <messagesigner.h>
 #include <primitives/transaction.h>
+#include <serialize.h>
 
 #include <boost/lexical_cast.hpp>
 
@@ -127,6 +129,18 @@ public:
     bool IsValid(bool fSignatureCheck) const;
     void Relay(CConnman& connman) const;
 
+    // CRYPTROX BEGIN
+    /// Hash of the message the masternode signs for this vote
+    uint256 GetSignatureHash() const;
+    const std::vector<unsigned char>& GetSignature() const { return vchSig; }
+
+    /**
+     * Verify the signatures of known masternodes' votes in one batch on the signature check threads.
+     * The votes of unknown masternodes stay UNCHECKED, the results are passed on to ProcessVote().
+     */
+    static std::vector<SignatureState> CheckSignatures(const std::vector<CGovernanceVote>& vecVotes);
+    // CRYPTROX END
+
     std::string GetVoteString() const {
         return CGovernanceVoting::ConvertOutcomeToString(GetOutcome());
     }
@@ -202,6 +216,58 @@ public:
 
 };
 
+// CRYPTROX BEGIN
+/**
+ * Compact summary of the set of votes a node has for one governance object,
+ * used to reconcile vote sets instead of sending a bloom filter.
+ * Vote hashes are spread over buckets by a SipHash keyed by the requester and
+ * each bucket holds the XOR of the low 16 bits of those SipHashes. The peer
+ * builds the same summary over its own votes and only announces the votes of
+ * buckets that differ. A fresh key per request means a rare fingerprint
+ * collision only delays a vote until the next request.
+ */
+class CGovernanceVoteSummary
+{
+public:
+    static const size_t VOTES_PER_BUCKET = 1;
+    static const size_t MAX_BUCKETS = 32768;
+
+private:
+    uint64_t k0;
+    uint64_t k1;
+    std::vector<uint16_t> vBuckets;
+
+    size_t GetBucket(const uint256& nVoteHash, uint16_t& nFingerprintRet) const;
+
+public:
+    CGovernanceVoteSummary() : k0(0), k1(0) {}
+    CGovernanceVoteSummary(uint64_t k0In, uint64_t k1In, size_t nBuckets) : k0(k0In), k1(k1In), vBuckets(nBuckets, 0) {}
+
+    /// Empty summary with a random key, sized for a set of about nVotes votes
+    static CGovernanceVoteSummary ForVoteCount(size_t nVotes);
+
+    /// Empty summary with the same key and bucket count, to summarize another set the same way
+    CGovernanceVoteSummary EmptyCopy() const { return CGovernanceVoteSummary(k0, k1, vBuckets.size()); }
+
+    void Add(const uint256& nVoteHash);
+
+    /// True if the bucket of nVoteHash holds the same votes in both summaries
+    bool Matches(const CGovernanceVoteSummary& other, const uint256& nVoteHash) const;
+
+    bool IsValid() const { return !vBuckets.empty() && vBuckets.size() <= MAX_BUCKETS; }
+    size_t GetBucketCount() const { return vBuckets.size(); }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(k0);
+        READWRITE(k1);
+        READWRITE(vBuckets);
+    }
+};
+// CRYPTROX END
+
 
 
 /**
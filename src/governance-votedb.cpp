@@ -5,93 +5,241 @@
 
 #include <governance-votedb.h>
 
-CGovernanceObjectVoteFile::CGovernanceObjectVoteFile()
-    : nMemoryVotes(0),
-      listVotes(),
-      mapVoteIndex()
-{}
+// CRYPTROX BEGIN
+static const char DB_VOTE = 'v';
+static const char DB_VOTE_INDEX = 'i';
+
+std::unique_ptr<CGovernanceVoteDB> pGovernanceVoteDB;
+
+namespace {
+
+typedef std::pair<uint256, std::pair<COutPoint, uint256> > vote_location_t;
+
+vote_location_t VoteLocation(const CGovernanceVote& vote)
+{
+    return std::make_pair(vote.GetParentHash(), std::make_pair(vote.GetMasternodeOutpoint(), vote.GetHash()));
+}
+
+template <typename K>
+std::string SerializeKey(const K& key)
+{
+    CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+    ssKey << key;
+    return std::string(ssKey.begin(), ssKey.end());
+}
+
+} // namespace
+
+CGovernanceVoteDB::CGovernanceVoteDB(size_t nCacheSize, bool fMemory, bool fWipe) : CLevelDBWrapper(GetDataDir() / "govvotes", nCacheSize, fMemory, fWipe) {}
+
+bool CGovernanceVoteDB::WriteVote(const CGovernanceVote& vote)
+{
+    vote_location_t location = VoteLocation(vote);
+    CLevelDBBatch batch;
+    batch.Write(std::make_pair(DB_VOTE, location), vote);
+    batch.Write(std::make_pair(DB_VOTE_INDEX, vote.GetHash()), location);
+    return WriteBatch(batch);
+}
 
-CGovernanceObjectVoteFile::CGovernanceObjectVoteFile(const CGovernanceObjectVoteFile& other)
-    : nMemoryVotes(other.nMemoryVotes),
-      listVotes(other.listVotes),
-      mapVoteIndex()
+bool CGovernanceVoteDB::ReadVote(const uint256& nHash, CGovernanceVote& vote)
 {
-    RebuildIndex();
+    vote_location_t location;
+    if (!Read(std::make_pair(DB_VOTE_INDEX, nHash), location)) {
+        return false;
+    }
+    return Read(std::make_pair(DB_VOTE, location), vote);
 }
 
+bool CGovernanceVoteDB::HasVote(const uint256& nHash)
+{
+    return Exists(std::make_pair(DB_VOTE_INDEX, nHash));
+}
+
+bool CGovernanceVoteDB::HasVote(const uint256& nParentHash, const uint256& nHash)
+{
+    vote_location_t location;
+    return Read(std::make_pair(DB_VOTE_INDEX, nHash), location) && location.first == nParentHash;
+}
+
+std::vector<CGovernanceVote> CGovernanceVoteDB::ReadVotes(const uint256& nParentHash)
+{
+    std::vector<CGovernanceVote> vecResult;
+    std::string strPrefix = SerializeKey(std::make_pair(DB_VOTE, nParentHash));
+
+    std::unique_ptr<leveldb::Iterator> pcursor(NewIterator());
+    for (pcursor->Seek(strPrefix); pcursor->Valid() && pcursor->key().starts_with(strPrefix); pcursor->Next()) {
+        leveldb::Slice slValue = pcursor->value();
+        try {
+            CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+            CGovernanceVote vote;
+            ssValue >> vote;
+            vecResult.push_back(vote);
+        } catch (const std::exception& e) {
+            LogPrintf("CGovernanceVoteDB::%s -- skipping unreadable vote: %s\n", __func__, e.what());
+        }
+    }
+    HandleError(pcursor->status());
+    return vecResult;
+}
+
+std::vector<uint256> CGovernanceVoteDB::ReadVoteHashes(const uint256& nParentHash)
+{
+    std::vector<uint256> vecResult;
+    std::string strPrefix = SerializeKey(std::make_pair(DB_VOTE, nParentHash));
+
+    std::unique_ptr<leveldb::Iterator> pcursor(NewIterator());
+    for (pcursor->Seek(strPrefix); pcursor->Valid() && pcursor->key().starts_with(strPrefix); pcursor->Next()) {
+        leveldb::Slice slKey = pcursor->key();
+        CDataStream ssKey(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
+        std::pair<char, vote_location_t> key;
+        ssKey >> key;
+        vecResult.push_back(key.second.second.second);
+    }
+    HandleError(pcursor->status());
+    return vecResult;
+}
+
+template <typename K>
+int CGovernanceVoteDB::EraseVotesWithPrefix(const K& prefix)
+{
+    std::string strPrefix = SerializeKey(std::make_pair(DB_VOTE, prefix));
+    CLevelDBBatch batch;
+    int nErased = 0;
+
+    std::unique_ptr<leveldb::Iterator> pcursor(NewIterator());
+    for (pcursor->Seek(strPrefix); pcursor->Valid() && pcursor->key().starts_with(strPrefix); pcursor->Next()) {
+        leveldb::Slice slKey = pcursor->key();
+        CDataStream ssKey(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
+        std::pair<char, vote_location_t> key;
+        ssKey >> key;
+        batch.Erase(key);
+        batch.Erase(std::make_pair(DB_VOTE_INDEX, key.second.second.second));
+        ++nErased;
+    }
+    HandleError(pcursor->status());
+
+    if (nErased > 0) {
+        WriteBatch(batch);
+    }
+    return nErased;
+}
+
+int CGovernanceVoteDB::EraseVotes(const uint256& nParentHash)
+{
+    return EraseVotesWithPrefix(nParentHash);
+}
+
+int CGovernanceVoteDB::EraseVotes(const uint256& nParentHash, const COutPoint& outpointMasternode)
+{
+    return EraseVotesWithPrefix(std::make_pair(nParentHash, outpointMasternode));
+}
+
+int CGovernanceVoteDB::EraseVotesIf(const std::function<bool(const uint256&)>& fKeepParent)
+{
+    std::vector<uint256> vecParents;
+    std::string strPrefix(1, DB_VOTE);
+
+    // votes are ordered by parent, so skip over each parent's range after looking at it
+    std::unique_ptr<leveldb::Iterator> pcursor(NewIterator());
+    pcursor->Seek(strPrefix);
+    while (pcursor->Valid() && pcursor->key().starts_with(strPrefix)) {
+        leveldb::Slice slKey = pcursor->key();
+        CDataStream ssKey(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
+        std::pair<char, vote_location_t> key;
+        ssKey >> key;
+        const uint256& nParentHash = key.second.first;
+        if (!fKeepParent(nParentHash)) {
+            vecParents.push_back(nParentHash);
+        }
+        // seek to the first key past this parent's prefix
+        std::string strNext = SerializeKey(std::make_pair(DB_VOTE, nParentHash));
+        while (!strNext.empty() && (unsigned char)strNext.back() == 0xff) {
+            strNext.pop_back();
+        }
+        if (strNext.empty()) break;
+        strNext.back()++;
+        pcursor->Seek(strNext);
+    }
+    HandleError(pcursor->status());
+
+    int nErased = 0;
+    for (const auto& nParentHash : vecParents) {
+        nErased += EraseVotes(nParentHash);
+    }
+    return nErased;
+}
+// CRYPTROX END
+
+CGovernanceObjectVoteFile::CGovernanceObjectVoteFile()
+    : nVoteCount(0),
+      nParentHash()
+{}
+
 void CGovernanceObjectVoteFile::AddVote(const CGovernanceVote& vote)
 {
-    listVotes.push_front(vote);
-    mapVoteIndex[vote.GetHash()] = listVotes.begin();
-    ++nMemoryVotes;
+    nParentHash = vote.GetParentHash();
+    // rewriting a stored vote must not count it twice
+    if(pGovernanceVoteDB->HasVote(nParentHash, vote.GetHash())) {
+        return;
+    }
+    if(pGovernanceVoteDB->WriteVote(vote)) {
+        ++nVoteCount;
+    }
 }
 
 bool CGovernanceObjectVoteFile::HasVote(const uint256& nHash) const
 {
-    vote_m_cit it = mapVoteIndex.find(nHash);
-    if(it == mapVoteIndex.end()) {
+    if(nParentHash.IsNull()) {
         return false;
     }
-    return true;
+    return pGovernanceVoteDB->HasVote(nParentHash, nHash);
 }
 
 bool CGovernanceObjectVoteFile::GetVote(const uint256& nHash, CGovernanceVote& vote) const
 {
-    vote_m_cit it = mapVoteIndex.find(nHash);
-    if(it == mapVoteIndex.end()) {
+    if(nParentHash.IsNull()) {
         return false;
     }
-    vote = *(it->second);
-    return true;
+    return pGovernanceVoteDB->ReadVote(nHash, vote) && vote.GetParentHash() == nParentHash;
 }
 
 std::vector<CGovernanceVote> CGovernanceObjectVoteFile::GetVotes() const
 {
-    std::vector<CGovernanceVote> vecResult;
-    for(vote_l_cit it = listVotes.begin(); it != listVotes.end(); ++it) {
-        vecResult.push_back(*it);
+    if(nParentHash.IsNull()) {
+        return std::vector<CGovernanceVote>();
     }
-    return vecResult;
+    return pGovernanceVoteDB->ReadVotes(nParentHash);
 }
 
-void CGovernanceObjectVoteFile::RemoveVotesFromMasternode(const COutPoint& outpointMasternode)
+// CRYPTROX BEGIN
+std::vector<uint256> CGovernanceObjectVoteFile::GetVoteHashes() const
 {
-    vote_l_it it = listVotes.begin();
-    while(it != listVotes.end()) {
-        if(it->GetMasternodeOutpoint() == outpointMasternode) {
-            --nMemoryVotes;
-            mapVoteIndex.erase(it->GetHash());
-            listVotes.erase(it++);
-        }
-        else {
-            ++it;
-        }
+    if(nParentHash.IsNull()) {
+        return std::vector<uint256>();
     }
+    return pGovernanceVoteDB->ReadVoteHashes(nParentHash);
 }
 
-CGovernanceObjectVoteFile& CGovernanceObjectVoteFile::operator=(const CGovernanceObjectVoteFile& other)
+void CGovernanceObjectVoteFile::LoadVoteCount(const uint256& nParentHashIn)
 {
-    nMemoryVotes = other.nMemoryVotes;
-    listVotes = other.listVotes;
-    RebuildIndex();
-    return *this;
+    nParentHash = nParentHashIn;
+    nVoteCount = pGovernanceVoteDB->ReadVoteHashes(nParentHash).size();
 }
+// CRYPTROX END
 
-void CGovernanceObjectVoteFile::RebuildIndex()
+void CGovernanceObjectVoteFile::RemoveVotesFromMasternode(const COutPoint& outpointMasternode)
 {
-    mapVoteIndex.clear();
-    nMemoryVotes = 0;
-    vote_l_it it = listVotes.begin();
-    while(it != listVotes.end()) {
-        CGovernanceVote& vote = *it;
-        uint256 nHash = vote.GetHash();
-        if(mapVoteIndex.find(nHash) == mapVoteIndex.end()) {
-            mapVoteIndex[nHash] = it;
-            ++nMemoryVotes;
-            ++it;
-        }
-        else {
-            listVotes.erase(it++);
-        }
+    if(nParentHash.IsNull()) {
+        return;
+    }
+    nVoteCount -= pGovernanceVoteDB->EraseVotes(nParentHash, outpointMasternode);
+}
+
+void CGovernanceObjectVoteFile::EraseVotes()
+{
+    if(nParentHash.IsNull()) {
+        return;
     }
+    pGovernanceVoteDB->EraseVotes(nParentHash);
+    nVoteCount = 0;
 }
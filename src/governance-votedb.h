@@ -6,89 +6,114 @@
 #ifndef CRYPTROX_GOVERNANCE_VOTEDB_H
 #define CRYPTROX_GOVERNANCE_VOTEDB_H
 
-#include <list>
-#include <map>
+#include <functional>
+#include <memory>
+#include <vector>
 
 #include <governance-vote.h>
+#include <leveldbwrapper.h>
 #include <serialize.h>
 #include <uint256.h>
 
+// CRYPTROX BEGIN
 /**
- * Represents the collection of votes associated with a given CGovernanceObject
- * Recently received votes are held in memory until a maximum size is reached after
- * which older votes a flushed to a disk file.
- *
- * Note: This is a stub implementation that doesn't limit the number of votes held
- * in memory and doesn't flush to disk.
+ * On-disk store for the votes of all governance objects.
+ * Votes are stored under (parent object, masternode outpoint, vote hash) so the votes
+ * of one object or of one masternode on an object are a single range scan, with a
+ * second key from the vote hash to that location for direct lookups.
  */
-class CGovernanceObjectVoteFile
+class CGovernanceVoteDB : public CLevelDBWrapper
 {
-public: // Types
-    typedef std::list<CGovernanceVote> vote_l_t;
-
-    typedef vote_l_t::iterator vote_l_it;
+public:
+    CGovernanceVoteDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
 
-    typedef vote_l_t::const_iterator vote_l_cit;
+private:
+    CGovernanceVoteDB(const CGovernanceVoteDB&);
+    void operator=(const CGovernanceVoteDB&);
 
-    typedef std::map<uint256,vote_l_it> vote_m_t;
+    /// Erase every vote whose index key starts with the serialized prefix, returns the number erased
+    template <typename K>
+    int EraseVotesWithPrefix(const K& prefix);
 
-    typedef vote_m_t::iterator vote_m_it;
+public:
+    bool WriteVote(const CGovernanceVote& vote);
+    bool ReadVote(const uint256& nHash, CGovernanceVote& vote);
+    bool HasVote(const uint256& nHash);
+    /// Whether the vote with this hash is stored as a vote on the object nParentHash
+    bool HasVote(const uint256& nParentHash, const uint256& nHash);
+    std::vector<CGovernanceVote> ReadVotes(const uint256& nParentHash);
+    /// Hashes of the votes of an object, read from the keys only
+    std::vector<uint256> ReadVoteHashes(const uint256& nParentHash);
+    int EraseVotes(const uint256& nParentHash);
+    int EraseVotes(const uint256& nParentHash, const COutPoint& outpointMasternode);
+    /// Erase the votes of every object for which fKeepParent returns false
+    int EraseVotesIf(const std::function<bool(const uint256&)>& fKeepParent);
+};
 
-    typedef vote_m_t::const_iterator vote_m_cit;
+extern std::unique_ptr<CGovernanceVoteDB> pGovernanceVoteDB;
+// CRYPTROX END
 
+/**
+ * Represents the collection of votes associated with a given CGovernanceObject
+ * The votes themselves live in pGovernanceVoteDB, only their count is kept in memory
+ * and serialized with the object.
+ */
+class CGovernanceObjectVoteFile
+{
 private:
-    static const int MAX_MEMORY_VOTES = -1;
+    int nVoteCount;
 
-    int nMemoryVotes;
-
-    vote_l_t listVotes;
-
-    vote_m_t mapVoteIndex;
+    uint256 nParentHash;
 
 public:
     CGovernanceObjectVoteFile();
 
-    CGovernanceObjectVoteFile(const CGovernanceObjectVoteFile& other);
-
     /**
      * Add a vote to the file
      */
     void AddVote(const CGovernanceVote& vote);
 
     /**
-     * Return true if the vote with this hash is currently cached in memory
+     * Return true if the vote with this hash is stored for this object
      */
     bool HasVote(const uint256& nHash) const;
 
     /**
-     * Retrieve a vote cached in memory
+     * Retrieve a stored vote
      */
     bool GetVote(const uint256& nHash, CGovernanceVote& vote) const;
 
     int GetVoteCount() {
-        return nMemoryVotes;
+        return nVoteCount;
     }
 
     std::vector<CGovernanceVote> GetVotes() const;
 
-    CGovernanceObjectVoteFile& operator=(const CGovernanceObjectVoteFile& other);
+    std::vector<uint256> GetVoteHashes() const; // CRYPTROX
+
+    // CRYPTROX BEGIN
+    /**
+     * Take the vote count of the object nParentHashIn from the store, the serialized
+     * count can be stale when the node did not shut down cleanly
+     */
+    void LoadVoteCount(const uint256& nParentHashIn);
+    // CRYPTROX END
 
     void RemoveVotesFromMasternode(const COutPoint& outpointMasternode);
 
+    /**
+     * Drop all votes of this object from disk, used once the object itself is erased
+     */
+    void EraseVotes();
+
     ADD_SERIALIZE_METHODS;
 
     template <typename Stream, typename Operation>
     inline void SerializationOp(Stream& s, Operation ser_action)
     {
-        READWRITE(nMemoryVotes);
-        READWRITE(listVotes);
-        if(ser_action.ForRead()) {
-            RebuildIndex();
-        }
+        READWRITE(nVoteCount);
+        READWRITE(nParentHash);
     }
-private:
-    void RebuildIndex();
-
 };
 
 #endif // CRYPTROX_GOVERNANCE_VOTEDB_H
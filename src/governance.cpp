@@ -20,7 +20,7 @@ CGovernanceManager governance;
 
 int nSubmittedFinalBudget;
 
-const std::string CGovernanceManager::SERIALIZATION_VERSION_STRING = "CGovernanceManager-Version-12";
+const std::string CGovernanceManager::SERIALIZATION_VERSION_STRING = "CGovernanceManager-Version-13";
 const int CGovernanceManager::MAX_TIME_FUTURE_DEVIATION = 60*60;
 const int CGovernanceManager::RELIABLE_PROPAGATION_TIME = 60;
 
@@ -146,6 +146,31 @@ void CGovernanceManager::ProcessMessage(CNode* pfrom, const std::string& strComm
 
     }
 
+    // CRYPTROX BEGIN
+    // ANOTHER USER SENT A SUMMARY OF THE VOTES IT HAS FOR ONE OBJECT
+    else if (strCommand == NetMsgType::MNGOVERNANCEVOTESUMMARY)
+    {
+        // same as a MNGOVERNANCESYNC request for a single object
+        if (!masternodeSync.IsSynced()) return;
+
+        uint256 nProp;
+        CGovernanceVoteSummary summary;
+        vRecv >> nProp >> summary;
+
+        if(nProp.IsNull() || !summary.IsValid()) {
+            LOCK(cs_main);
+            LogPrint(BCLog::GOBJECT, "MNGOVERNANCEVOTESUMMARY -- invalid summary, buckets=%d, peer=%d\n", summary.GetBucketCount(), pfrom->GetId());
+            Misbehaving(pfrom->GetId(), 20);
+            return;
+        }
+
+        CBloomFilter filter;
+        filter.clear();
+        Sync(pfrom, nProp, filter, connman, &summary);
+        LogPrint(BCLog::GOBJECT, "MNGOVERNANCEVOTESUMMARY -- syncing votes of %s to our peer at %s\n", nProp.ToString(), pfrom->addr.ToString());
+    }
+    // CRYPTROX END
+
     // A NEW GOVERNANCE OBJECT HAS ARRIVED
     else if (strCommand == NetMsgType::MNGOVERNANCEOBJECT)
     {
@@ -258,20 +283,18 @@ void CGovernanceManager::ProcessMessage(CNode* pfrom, const std::string& strComm
             return;
         }
 
-        CGovernanceException exception;
-        if(ProcessVote(pfrom, vote, exception, connman)) {
-            LogPrint(BCLog::GOBJECT, "MNGOVERNANCEOBJECTVOTE -- %s new\n", strHash);
-            masternodeSync.BumpAssetLastTime("MNGOVERNANCEOBJECTVOTE");
-            vote.Relay(connman);
-        }
-        else {
-            LogPrint(BCLog::GOBJECT, "MNGOVERNANCEOBJECTVOTE -- Rejected vote, error = %s\n", exception.what());
-            if((exception.GetNodePenalty() != 0) && masternodeSync.IsSynced()) {
-                LOCK(cs_main);
-                Misbehaving(pfrom->GetId(), exception.GetNodePenalty());
-            }
-            return;
+        // CRYPTROX BEGIN
+        // verify the signature off-thread, votes of unknown masternodes are left to ProcessVote
+        masternode_info_t infoMn;
+        if(mnodeman.GetMasternodeInfo(vote.GetMasternodeOutpoint(), infoMn)) {
+            messageVerifyQueue.Push(vote.GetSignatureHash(), infoMn.pubKeyMasternode, vote.GetSignature(), pfrom,
+                [this, vote, &connman](bool fValidSignature, CNode* pnode) {
+                    ProcessVerifiedVote(pnode, vote, fValidSignature ? SignatureState::VALID : SignatureState::INVALID, connman);
+                });
+        } else {
+            ProcessVerifiedVote(pfrom, vote, SignatureState::UNCHECKED, connman);
         }
+        // CRYPTROX END
 
     }
 }
@@ -282,6 +305,15 @@ void CGovernanceManager::CheckOrphanVotes(CGovernanceObject& govobj, CGovernance
     std::vector<vote_time_pair_t> vecVotePairs;
     mapOrphanVotes.GetAll(nHash, vecVotePairs);
 
+    // CRYPTROX BEGIN
+    std::vector<CGovernanceVote> vecVotes;
+    vecVotes.reserve(vecVotePairs.size());
+    for(const auto& pairVote : vecVotePairs) {
+        vecVotes.push_back(pairVote.first);
+    }
+    std::vector<SignatureState> vSigStates = CGovernanceVote::CheckSignatures(vecVotes);
+    // CRYPTROX END
+
     ScopedLockBool guard(cs, fRateChecksEnabled, false);
 
     int64_t nNow = GetAdjustedTime();
@@ -293,7 +325,7 @@ void CGovernanceManager::CheckOrphanVotes(CGovernanceObject& govobj, CGovernance
         if(pairVote.second < nNow) {
             fRemove = true;
         }
-        else if(govobj.ProcessVote(NULL, vote, exception, connman)) {
+        else if(govobj.ProcessVote(NULL, vote, exception, connman, vSigStates[i])) { // CRYPTROX
             vote.Relay(connman);
             fRemove = true;
         }
@@ -543,6 +575,9 @@ void CGovernanceManager::UpdateCachesAndClean()
             }
 
             mapErasedGovernanceObjects.insert(std::make_pair(nHash, nTimeExpired));
+            // CRYPTROX BEGIN
+            pObj->GetVoteFile().EraseVotes();
+            // CRYPTROX END
             mapObjects.erase(it++);
         } else {
             ++it;
@@ -595,32 +630,35 @@ std::vector<CGovernanceVote> CGovernanceManager::GetCurrentVotes(const uint256&
     if(it == mapObjects.end()) return vecResult;
     CGovernanceObject& govobj = it->second;
 
-    CMasternode mn;
-    std::map<COutPoint, CMasternode> mapMasternodes;
+    // CRYPTROX BEGIN
+    std::vector<COutPoint> vecOutpoints;
     if(mnCollateralOutpointFilter == COutPoint()) {
-        mapMasternodes = mnodeman.GetFullMasternodeMap();
-    } else if (mnodeman.Get(mnCollateralOutpointFilter, mn)) {
-        mapMasternodes[mnCollateralOutpointFilter] = mn;
+        for (const auto& mnpair : *mnodeman.GetSnapshot()) {
+            vecOutpoints.push_back(mnpair.first);
+        }
+    } else if (mnodeman.Has(mnCollateralOutpointFilter)) {
+        vecOutpoints.push_back(mnCollateralOutpointFilter);
     }
 
     // Loop thru each MN collateral outpoint and get the votes for the `nParentHash` governance object
-    for (auto& mnpair : mapMasternodes)
+    for (const auto& outpoint : vecOutpoints)
     {
         // get a vote_rec_t from the govobj
         vote_rec_t voteRecord;
-        if (!govobj.GetCurrentMNVotes(mnpair.first, voteRecord)) continue;
+        if (!govobj.GetCurrentMNVotes(outpoint, voteRecord)) continue;
 
         for (vote_instance_m_it it3 = voteRecord.mapInstances.begin(); it3 != voteRecord.mapInstances.end(); ++it3) {
             int signal = (it3->first);
             int outcome = ((it3->second).eOutcome);
             int64_t nCreationTime = ((it3->second).nCreationTime);
 
-            CGovernanceVote vote = CGovernanceVote(mnpair.first, nParentHash, (vote_signal_enum_t)signal, (vote_outcome_enum_t)outcome);
+            CGovernanceVote vote = CGovernanceVote(outpoint, nParentHash, (vote_signal_enum_t)signal, (vote_outcome_enum_t)outcome);
             vote.SetTime(nCreationTime);
 
             vecResult.push_back(vote);
         }
     }
+    // CRYPTROX END
 
     return vecResult;
 }
@@ -735,7 +773,7 @@ bool CGovernanceManager::ConfirmInventoryRequest(const CInv& inv)
     return true;
 }
 
-void CGovernanceManager::Sync(CNode* pfrom, const uint256& nProp, const CBloomFilter& filter, CConnman& connman)
+void CGovernanceManager::Sync(CNode* pfrom, const uint256& nProp, const CBloomFilter& filter, CConnman& connman, const CGovernanceVoteSummary* psummary)
 {
 
     /*
@@ -799,6 +837,21 @@ void CGovernanceManager::Sync(CNode* pfrom, const uint256& nProp, const CBloomFi
             ++nObjCount;
 
             std::vector<CGovernanceVote> vecVotes = govobj.GetVoteFile().GetVotes();
+
+            // CRYPTROX BEGIN
+            // summarize our votes the same way as the peer did, matching buckets hold the same votes
+            CGovernanceVoteSummary summaryOurs;
+            if(psummary) {
+                summaryOurs = psummary->EmptyCopy();
+                for(const auto& vote : vecVotes) {
+                    summaryOurs.Add(vote.GetHash());
+                }
+                vecVotes.erase(std::remove_if(vecVotes.begin(), vecVotes.end(), [&](const CGovernanceVote& vote) {
+                    return psummary->Matches(summaryOurs, vote.GetHash());
+                }), vecVotes.end());
+            }
+            // CRYPTROX END
+
             for(size_t i = 0; i < vecVotes.size(); ++i) {
                 if(filter.contains(vecVotes[i].GetHash())) {
                     continue;
@@ -931,7 +984,27 @@ bool CGovernanceManager::MasternodeRateCheck(const CGovernanceObject& govobj, bo
     return fRateOK;
 }
 
-bool CGovernanceManager::ProcessVote(CNode* pfrom, const CGovernanceVote& vote, CGovernanceException& exception, CConnman& connman)
+// CRYPTROX BEGIN
+void CGovernanceManager::ProcessVerifiedVote(CNode* pfrom, const CGovernanceVote& vote, SignatureState sigState, CConnman& connman)
+{
+    CGovernanceException exception;
+    if(ProcessVote(pfrom, vote, exception, connman, sigState)) {
+        LogPrint(BCLog::GOBJECT, "MNGOVERNANCEOBJECTVOTE -- %s new\n", vote.GetHash().ToString());
+        masternodeSync.BumpAssetLastTime("MNGOVERNANCEOBJECTVOTE");
+        vote.Relay(connman);
+    }
+    else {
+        LogPrint(BCLog::GOBJECT, "MNGOVERNANCEOBJECTVOTE -- Rejected vote, error = %s\n", exception.what());
+        if(pfrom && (exception.GetNodePenalty() != 0) && masternodeSync.IsSynced()) {
+            LOCK(cs_main);
+            Misbehaving(pfrom->GetId(), exception.GetNodePenalty());
+        }
+    }
+}
+// CRYPTROX END
+
+bool CGovernanceManager::ProcessVote(CNode* pfrom, const CGovernanceVote& vote, CGovernanceException& exception, CConnman& connman,
+                                     SignatureState sigState)
 {
     ENTER_CRITICAL_SECTION(cs);
     uint256 nHashVote = vote.GetHash();
@@ -974,7 +1047,7 @@ bool CGovernanceManager::ProcessVote(CNode* pfrom, const CGovernanceVote& vote,
         return false;
     }
 
-    bool fOk = govobj.ProcessVote(pfrom, vote, exception, connman);
+    bool fOk = govobj.ProcessVote(pfrom, vote, exception, connman, sigState); // CRYPTROX
     if(fOk) {
         mapVoteToObject.Insert(nHashVote, &govobj);
 
@@ -1115,6 +1188,30 @@ void CGovernanceManager::RequestGovernanceObject(CNode* pfrom, const uint256& nH
         return;
     }
 
+    // CRYPTROX BEGIN
+    // a summary of the votes we have is a fraction of the size of a bloom filter and
+    // never hides a vote from us permanently, use it with peers that understand it
+    if(fUseFilter && pfrom->nVersion >= GOVERNANCE_VOTE_SUMMARY_PROTO_VERSION) {
+        std::vector<uint256> vecVoteHashes;
+        {
+            LOCK(cs);
+            CGovernanceObject* pObj = FindGovernanceObject(nHash);
+            if(pObj) {
+                vecVoteHashes = pObj->GetVoteFile().GetVoteHashes();
+            }
+        }
+
+        CGovernanceVoteSummary summary = CGovernanceVoteSummary::ForVoteCount(vecVoteHashes.size());
+        for(const auto& nVoteHash : vecVoteHashes) {
+            summary.Add(nVoteHash);
+        }
+
+        LogPrint(BCLog::GOBJECT, "CGovernanceManager::RequestGovernanceObject -- nHash %s nVoteCount %d buckets %d peer=%d\n", nHash.ToString(), vecVoteHashes.size(), summary.GetBucketCount(), pfrom->GetId());
+        connman.PushMessage(pfrom, CNetMsgMaker(pfrom->GetSendVersion()).Make(NetMsgType::MNGOVERNANCEVOTESUMMARY, nHash, summary));
+        return;
+    }
+    // CRYPTROX END
+
     CBloomFilter filter;
     filter.clear();
 
@@ -1298,17 +1395,51 @@ void CGovernanceManager::AddCachedTriggers()
     }
 }
 
+// CRYPTROX BEGIN
+void CGovernanceManager::EraseStaleVotes()
+{
+    LOCK(cs);
+    // the vote store is written as votes arrive, so it can hold votes of objects
+    // that did not make it into (or were dropped from) the loaded governance cache
+    int nErased = pGovernanceVoteDB->EraseVotesIf([this](const uint256& nParentHash) {
+        return mapObjects.count(nParentHash) > 0;
+    });
+    LogPrintf("CGovernanceManager::EraseStaleVotes -- erased %d votes of unknown objects\n", nErased);
+}
+// CRYPTROX END
+
 void CGovernanceManager::InitOnLoad()
 {
     LOCK(cs);
     int64_t nStart = GetTimeMillis();
     LogPrintf("Preparing masternode indexes and governance triggers...\n");
+    // CRYPTROX BEGIN
+    EraseStaleVotes();
+    for (auto& item : mapObjects) {
+        item.second.GetVoteFile().LoadVoteCount(item.first);
+    }
+    // CRYPTROX END
     RebuildIndexes();
     AddCachedTriggers();
     LogPrintf("Masternode indexes and governance triggers prepared  %dms\n", GetTimeMillis() - nStart);
     LogPrintf("     %s\n", ToString());
 }
 
+// CRYPTROX BEGIN
+void CGovernanceManager::CopyForDump(CGovernanceManager& governanceCopy)
+{
+    LOCK(cs);
+    governanceCopy.mapErasedGovernanceObjects = mapErasedGovernanceObjects;
+    governanceCopy.mapInvalidVotes = mapInvalidVotes;
+    governanceCopy.mapOrphanVotes = mapOrphanVotes;
+    governanceCopy.mapObjects = mapObjects;
+    governanceCopy.mapWatchdogObjects = mapWatchdogObjects;
+    governanceCopy.nHashWatchdogCurrent = nHashWatchdogCurrent;
+    governanceCopy.nTimeWatchdogCurrent = nTimeWatchdogCurrent;
+    governanceCopy.mapLastMasternodeObject = mapLastMasternodeObject;
+}
+// CRYPTROX END
+
 std::string CGovernanceManager::ToString() const
 {
     LOCK(cs);
@@ -300,7 +300,8 @@ public:
      */
     bool ConfirmInventoryRequest(const CInv& inv);
 
-    void Sync(CNode* node, const uint256& nProp, const CBloomFilter& filter, CConnman& connman);
+    /// Announce objects, or one object and its votes the peer lacks according to filter or, if given, psummary
+    void Sync(CNode* node, const uint256& nProp, const CBloomFilter& filter, CConnman& connman, const CGovernanceVoteSummary* psummary = nullptr);
 
     void ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman);
 
@@ -339,6 +340,11 @@ public:
 
     std::string ToString() const;
 
+    // CRYPTROX BEGIN
+    /// Copy the state that is serialized into an empty manager, see CFlatDB::Dump
+    void CopyForDump(CGovernanceManager& governanceCopy);
+    // CRYPTROX END
+
     ADD_SERIALIZE_METHODS;
 
     template <typename Stream, typename Operation>
@@ -421,12 +427,21 @@ public:
 
     void InitOnLoad();
 
+    // CRYPTROX BEGIN
+    /// Drop votes from the on-disk vote store whose object is not in mapObjects
+    void EraseStaleVotes();
+    // CRYPTROX END
+
     int RequestGovernanceObjectVotes(CNode* pnode, CConnman& connman);
     int RequestGovernanceObjectVotes(const std::vector<CNode*>& vNodesCopy, CConnman& connman);
 
-private:
+    // CRYPTROX BEGIN
+    /// Ask pfrom for the object nHash and, with fUseFilter, for the votes on it that we lack
     void RequestGovernanceObject(CNode* pfrom, const uint256& nHash, CConnman& connman, bool fUseFilter = false);
 
+private:
+    // CRYPTROX END
+
     void AddInvalidVote(const CGovernanceVote& vote)
     {
         mapInvalidVotes.Insert(vote.GetHash(), vote);
@@ -437,7 +452,13 @@ private:
         mapOrphanVotes.Insert(vote.GetHash(), vote_time_pair_t(vote, GetAdjustedTime() + GOVERNANCE_ORPHAN_EXPIRATION_TIME));
     }
 
-    bool ProcessVote(CNode* pfrom, const CGovernanceVote& vote, CGovernanceException& exception, CConnman& connman);
+    // CRYPTROX BEGIN
+    bool ProcessVote(CNode* pfrom, const CGovernanceVote& vote, CGovernanceException& exception, CConnman& connman,
+                     SignatureState sigState = SignatureState::UNCHECKED);
+
+    /// Process a vote received from pfrom once its signature was checked, relay it or penalize the peer
+    void ProcessVerifiedVote(CNode* pfrom, const CGovernanceVote& vote, SignatureState sigState, CConnman& connman);
+    // CRYPTROX END
 
     /// Called to indicate a requested object has been received
     bool AcceptObjectMessage(const uint256& nHash);
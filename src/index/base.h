@@ -85,6 +85,16 @@ public:
     /// not block and immediately returns false.
     bool BlockUntilSyncedToCurrentChain();
 
+    // CRYPTROX BEGIN
+    /// Whether the index has caught up with the chain once and follows it
+    /// block by block since. Does not block and does not need cs_main.
+    bool IsSynced() const { return m_synced; }
+
+    /// The last block in the chain that the index is in sync with, null
+    /// before it has indexed any block. Does not need cs_main.
+    const CBlockIndex* GetBestBlockIndex() const { return m_best_block_index; }
+    // CRYPTROX END
+
     void Interrupt();
 
     /// Start initializes the sync state and registers the instance as a
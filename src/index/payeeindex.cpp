@@ -0,0 +1,165 @@
+// Copyright (c) 2019 Cryptroxcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/payeeindex.h>
+#include <util.h>
+#include <validation.h>
+
+#include <map>
+
+constexpr char DB_PAYEE = 'p';
+constexpr char DB_PAYEE_BLOCK = 'h';
+
+std::unique_ptr<PayeeIndex> g_payeeindex;
+
+/** A masternode payment as recorded in the index, nHeight is -1 if there is none */
+struct CPayeePayment
+{
+    int nHeight;
+    int64_t nTime;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(nHeight);
+        READWRITE(nTime);
+    }
+
+    CPayeePayment(int nHeightIn, int64_t nTimeIn) : nHeight(nHeightIn), nTime(nTimeIn) {}
+
+    CPayeePayment() : nHeight(-1), nTime(0) {}
+
+    bool IsNull() const { return nHeight < 0; }
+};
+
+/** Undo data of an indexed block: the last payments of its payees before it was connected */
+struct CPayeeBlockUndo
+{
+    uint256 hashBlock;
+    std::vector<std::pair<CScript, CPayeePayment>> vPrevPayments;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(hashBlock);
+        READWRITE(vPrevPayments);
+    }
+};
+
+/**
+ * Access to the payee index database (indexes/payeeindex/)
+ *
+ * Besides the last payment of every payee the database keeps the undo data
+ * of every indexed height. When a block is written at a height that already
+ * holds one, that block and everything above it belong to a stale branch and
+ * are rolled back first, all within the same batch.
+ */
+class PayeeIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Read the last payment of a payee. Returns false if it was never paid.
+    bool ReadPayment(const CScript& payee, CPayeePayment& payment) const;
+
+    /// Roll back the blocks indexed at the height of pindex and above, then record its payees.
+    bool WriteBlockPayees(const CBlockIndex* pindex, const std::vector<CScript>& vPayees);
+};
+
+PayeeIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "payeeindex", n_cache_size, f_memory, f_wipe)
+{}
+
+bool PayeeIndex::DB::ReadPayment(const CScript& payee, CPayeePayment& payment) const
+{
+    return Read(std::make_pair(DB_PAYEE, payee), payment);
+}
+
+bool PayeeIndex::DB::WriteBlockPayees(const CBlockIndex* pindex, const std::vector<CScript>& vPayees)
+{
+    // Last payments as they will be once the batch is written
+    std::map<CScript, CPayeePayment> mapPayments;
+    auto GetPayment = [&](const CScript& payee) {
+        auto it = mapPayments.find(payee);
+        if (it != mapPayments.end()) return it->second;
+        CPayeePayment payment;
+        ReadPayment(payee, payment);
+        return payment;
+    };
+
+    CDBBatch batch(*this);
+
+    std::vector<CPayeeBlockUndo> vStaleBlocks;
+    CPayeeBlockUndo undo;
+    while (Read(std::make_pair(DB_PAYEE_BLOCK, pindex->nHeight + (int)vStaleBlocks.size()), undo)) {
+        vStaleBlocks.push_back(undo);
+    }
+    for (int i = (int)vStaleBlocks.size() - 1; i >= 0; i--) {
+        for (const auto& prev : vStaleBlocks[i].vPrevPayments) {
+            mapPayments[prev.first] = prev.second;
+        }
+        batch.Erase(std::make_pair(DB_PAYEE_BLOCK, pindex->nHeight + i));
+    }
+    if (!vStaleBlocks.empty()) {
+        LogPrint(BCLog::MASTERNODE, "PayeeIndex::DB::%s -- rolled back %d blocks from height %d\n", __func__, vStaleBlocks.size(), pindex->nHeight);
+    }
+
+    CPayeeBlockUndo blockundo;
+    blockundo.hashBlock = pindex->GetBlockHash();
+    for (const auto& payee : vPayees) {
+        CPayeePayment prev = GetPayment(payee);
+        if (prev.nHeight == pindex->nHeight) continue; // paid twice by this block
+        blockundo.vPrevPayments.emplace_back(payee, prev);
+        mapPayments[payee] = CPayeePayment(pindex->nHeight, pindex->GetBlockTime());
+    }
+    batch.Write(std::make_pair(DB_PAYEE_BLOCK, pindex->nHeight), blockundo);
+
+    for (const auto& pair : mapPayments) {
+        if (pair.second.IsNull()) {
+            batch.Erase(std::make_pair(DB_PAYEE, pair.first));
+        } else {
+            batch.Write(std::make_pair(DB_PAYEE, pair.first), pair.second);
+        }
+    }
+    return WriteBatch(batch);
+}
+
+PayeeIndex::PayeeIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<PayeeIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+PayeeIndex::~PayeeIndex() {}
+
+bool PayeeIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    CAmount nMasternodePayment = GetMasternodePayment(pindex->nHeight, block.vtx[0]->GetValueOut());
+
+    std::vector<CScript> vPayees;
+    if (nMasternodePayment > 0) {
+        for (const auto& txout : block.vtx[0]->vout) {
+            if (txout.nValue == nMasternodePayment) {
+                vPayees.push_back(txout.scriptPubKey);
+            }
+        }
+    }
+    return m_db->WriteBlockPayees(pindex, vPayees);
+}
+
+BaseIndex::DB& PayeeIndex::GetDB() const { return *m_db; }
+
+bool PayeeIndex::FindLastPayment(const CScript& payee, const CBlockIndex*& pindexIndexedRet, int& nHeightRet, int64_t& nTimeRet) const
+{
+    // read before the payment, a block written in between can only make the payment newer
+    pindexIndexedRet = GetBestBlockIndex();
+    if (!pindexIndexedRet) {
+        return false;
+    }
+    CPayeePayment payment;
+    m_db->ReadPayment(payee, payment);
+    nHeightRet = payment.nHeight;
+    nTimeRet = payment.nTime;
+    return true;
+}
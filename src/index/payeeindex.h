@@ -0,0 +1,60 @@
+// Copyright (c) 2019 Cryptroxcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef CRYPTROX_INDEX_PAYEEINDEX_H
+#define CRYPTROX_INDEX_PAYEEINDEX_H
+
+#include <chain.h>
+#include <index/base.h>
+#include <script/script.h>
+
+//! -payeeindex default
+static const bool DEFAULT_PAYEEINDEX = true;
+//! max. -dbcache (MiB) used by the payee index
+static const int64_t nMaxPayeeIndexCache = 16;
+
+/**
+ * PayeeIndex records for every script the last block of the active chain whose
+ * coinbase paid it exactly the masternode payment. It only depends on the
+ * blocks, not on the payment votes this node happened to see, so a script
+ * without an entry was never paid up to the best block of the index. The index
+ * is written to a LevelDB database, together with per-height undo data so that
+ * blocks of a stale branch are rolled back when the chain reorganizes.
+ */
+class PayeeIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "payeeindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit PayeeIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~PayeeIndex() override;
+
+    /// Look up the last masternode payment to a script.
+    ///
+    /// @param[in]   payee  The script that was paid.
+    /// @param[out]  pindexIndexedRet  The last indexed block, the answer covers the chain up to it.
+    /// @param[out]  nHeightRet  The height of the block that paid it, -1 if it was not paid up to pindexIndexedRet.
+    /// @param[out]  nTimeRet  The time of the block that paid it.
+    /// @return  false if the index has not indexed any block yet, true otherwise
+    bool FindLastPayment(const CScript& payee, const CBlockIndex*& pindexIndexedRet, int& nHeightRet, int64_t& nTimeRet) const;
+};
+
+/// The global masternode payee index, used by CMasternode::UpdateLastPaid. May be null.
+extern std::unique_ptr<PayeeIndex> g_payeeindex;
+
+#endif // CRYPTROX_INDEX_PAYEEINDEX_H
@@ -18,10 +18,14 @@
 #include <checkpoints.h>
 #include <compat/sanity.h>
 #include <consensus/validation.h>
+#include <crypto/x16r.h>
 #include <fs.h>
 #include <httpserver.h>
 #include <httprpc.h>
 #include <index/txindex.h>
+// CRYPTROX BEGIN
+#include <index/payeeindex.h>
+// CRYPTROX END
 #include <key.h>
 #include <key_io.h>
 #include <validation.h>
@@ -63,6 +67,7 @@
 #include <keepass.h>
 #endif
 #include <masternode-payments.h>
+#include <masternode-paymentdb.h>
 #include <masternode-sync.h>
 #include <masternodeman.h>
 #include <masternodeconfig.h>
@@ -213,6 +218,25 @@ void Interrupt()
     if (g_txindex) {
         g_txindex->Interrupt();
     }
+    // CRYPTROX BEGIN
+    if (g_payeeindex) {
+        g_payeeindex->Interrupt();
+    }
+    // CRYPTROX END
+}
+
+// Dash
+static void DumpCaches()
+{
+    // STORE DATA CACHES INTO SERIALIZED DAT FILES
+    CFlatDB<CMasternodeMan> flatdb1("mncache.dat", "magicMasternodeCache");
+    flatdb1.Dump(mnodeman);
+    CFlatDB<CMasternodePayments> flatdb2("mnpayments.dat", "magicMasternodePaymentsCache");
+    flatdb2.Dump(mnpayments);
+    CFlatDB<CGovernanceManager> flatdb3("governance.dat", "magicGovernanceCache");
+    flatdb3.Dump(governance);
+    CFlatDB<CNetFulfilledRequestManager> flatdb4("netfulfilled.dat", "magicFulfilledCache");
+    flatdb4.Dump(netfulfilledman);
 }
 
 void Shutdown()
@@ -240,8 +264,15 @@ void Shutdown()
     // Because these depend on each-other, we make sure that neither can be
     // using the other before destroying them.
     if (peerLogic) UnregisterValidationInterface(peerLogic.get());
+    // CRYPTROX BEGIN
+    // pending messages hold references to their peers
+    messageVerifyQueue.Stop();
+    // CRYPTROX END
     if (g_connman) g_connman->Stop();
     if (g_txindex) g_txindex->Stop();
+    // CRYPTROX BEGIN
+    if (g_payeeindex) g_payeeindex->Stop();
+    // CRYPTROX END
 
     StopTorControl();
 
@@ -255,21 +286,16 @@ void Shutdown()
     peerLogic.reset();
     g_connman.reset();
     g_txindex.reset();
+    // CRYPTROX BEGIN
+    g_payeeindex.reset();
+    // CRYPTROX END
 
     if (g_is_mempool_loaded && gArgs.GetArg("-persistmempool", DEFAULT_PERSIST_MEMPOOL)) {
         DumpMempool();
     }
 
     // Dash
-    // STORE DATA CACHES INTO SERIALIZED DAT FILES
-    CFlatDB<CMasternodeMan> flatdb1("mncache.dat", "magicMasternodeCache");
-    flatdb1.Dump(mnodeman);
-    CFlatDB<CMasternodePayments> flatdb2("mnpayments.dat", "magicMasternodePaymentsCache");
-    flatdb2.Dump(mnpayments);
-    CFlatDB<CGovernanceManager> flatdb3("governance.dat", "magicGovernanceCache");
-    flatdb3.Dump(governance);
-    CFlatDB<CNetFulfilledRequestManager> flatdb4("netfulfilled.dat", "magicFulfilledCache");
-    flatdb4.Dump(netfulfilledman);
+    DumpCaches();
     //
 
     if (fFeeEstimatesInitialized)
@@ -310,6 +336,8 @@ void Shutdown()
         pblocktree.reset();
         // CRYPTROX START
         pSporkDB.reset();
+        pGovernanceVoteDB.reset();
+        pMasternodePaymentDB.reset();
         // CRYPTROX END
     }
     g_wallet_init_interface.Stop();
@@ -446,6 +474,9 @@ void SetupServerArgs()
     hidden_args.emplace_back("-sysperms");
 #endif
     gArgs.AddArg("-txindex", strprintf("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)", DEFAULT_TXINDEX), false, OptionsCategory::OPTIONS);
+    // CRYPTROX BEGIN
+    gArgs.AddArg("-payeeindex", strprintf("Maintain an index of the last masternode payment to each payee, so the last payment of a masternode is looked up instead of read from the last blocks. Not available in prune mode (default: %u)", DEFAULT_PAYEEINDEX), false, OptionsCategory::OPTIONS);
+    // CRYPTROX END
 
     gArgs.AddArg("-addnode=<ip>", "Add a node to connect to and attempt to keep the connection open (see the `addnode` RPC command help for more info). This option can be specified multiple times to add multiple nodes.", false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-banscore=<n>", strprintf("Threshold for disconnecting misbehaving peers (default: %u)", DEFAULT_BANSCORE_THRESHOLD), false, OptionsCategory::CONNECTION);
@@ -462,6 +493,13 @@ void SetupServerArgs()
     gArgs.AddArg("-listenonion", strprintf("Automatically create Tor hidden service (default: %d)", DEFAULT_LISTEN_ONION), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-maxconnections=<n>", strprintf("Maintain at most <n> connections to peers (default: %u)", DEFAULT_MAX_PEER_CONNECTIONS), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-maxreceivebuffer=<n>", strprintf("Maximum per-connection receive buffer, <n>*1000 bytes (default: %u)", DEFAULT_MAXRECEIVEBUFFER), false, OptionsCategory::CONNECTION);
+    // CRYPTROX BEGIN
+#ifdef USE_EPOLL
+    gArgs.AddArg("-socketevents=<mode>", "Socket events mode, which must be one of: 'select', 'epoll' (default: epoll)", false, OptionsCategory::CONNECTION);
+#else
+    gArgs.AddArg("-socketevents=<mode>", "Socket events mode, which must be one of: 'select' (default: select)", false, OptionsCategory::CONNECTION);
+#endif
+    // CRYPTROX END
     gArgs.AddArg("-maxsendbuffer=<n>", strprintf("Maximum per-connection send buffer, <n>*1000 bytes (default: %u)", DEFAULT_MAXSENDBUFFER), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-maxtimeadjustment", strprintf("Maximum allowed median peer time offset adjustment. Local perspective of time may be influenced by peers forward or backward by this amount. (default: %u seconds)", DEFAULT_MAX_TIME_ADJUSTMENT), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-maxuploadtarget=<n>", strprintf("Tries to keep outbound traffic under the given target (in MiB per 24h), 0 = no limit (default: %d)", DEFAULT_MAX_UPLOAD_TARGET), false, OptionsCategory::CONNECTION);
@@ -507,6 +545,8 @@ void SetupServerArgs()
     gArgs.AddArg("-checklevel=<n>", strprintf("How thorough the block verification of -checkblocks is (0-4, default: %u)", DEFAULT_CHECKLEVEL), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-checkblockindex", strprintf("Do a full consistency check for mapBlockIndex, setBlockIndexCandidates, chainActive and mapBlocksUnlinked occasionally. (default: %u)", defaultChainParams->DefaultConsistencyChecks()), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-checkmempool=<n>", strprintf("Run checks every <n> transactions (default: %u)", defaultChainParams->DefaultConsistencyChecks()), true, OptionsCategory::DEBUG_TEST);
+    gArgs.AddArg("-checkpowonload=<n>", strprintf("How many of the most recent block headers to re-verify proof of work for when loading the block index (default: %d, 0 = none, 1 = all)", DEFAULT_CHECKPOWONLOAD), true, OptionsCategory::DEBUG_TEST);
+    gArgs.AddArg("-powstatstiming", strprintf("Time every X16R primitive for getpowstats, which slows down hashing (default: %u)", DEFAULT_X16R_TIMING), true, OptionsCategory::DEBUG_TEST); // CRYPTROX
     gArgs.AddArg("-checkpoints", strprintf("Disable expensive verification for known chain history (default: %u)", DEFAULT_CHECKPOINTS_ENABLED), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-deprecatedrpc=<method>", "Allows deprecated RPC method(s) to be used", true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-dropmessagestest=<n>", "Randomly drop 1 of every <n> network messages", true, OptionsCategory::DEBUG_TEST);
@@ -778,6 +818,13 @@ static bool InitSanityCheck(void)
         return false;
     }
 
+    // CRYPTROX BEGIN
+    if (!X16R_InitSanityCheck()) {
+        InitError("X16R multi-lane hashing sanity check failure. Aborting.");
+        return false;
+    }
+    // CRYPTROX END
+
     return true;
 }
 
@@ -906,6 +953,7 @@ namespace { // Variables internal to initialization process only
 int nMaxConnections;
 int nUserMaxConnections;
 int nFD;
+CConnman::SocketEventsMode socketEventsMode = CConnman::DEFAULT_SOCKETEVENTS_MODE; // CRYPTROX
 ServiceFlags nLocalServices = ServiceFlags(NODE_NETWORK | NODE_NETWORK_LIMITED);
 
 } // namespace
@@ -997,13 +1045,28 @@ bool AppInitParameterInteraction()
     }
 
     // Make sure enough file descriptors are available
-    int nBind = std::max(nUserBind, size_t(1));
     nUserMaxConnections = gArgs.GetArg("-maxconnections", DEFAULT_MAX_PEER_CONNECTIONS);
     nMaxConnections = std::max(nUserMaxConnections, 0);
 
     // Trim requested connection counts, to fit into system limitations
     // <int> in std::min<int>(...) to work around FreeBSD compilation issue described in #2695
-    nMaxConnections = std::max(std::min<int>(nMaxConnections, FD_SETSIZE - nBind - MIN_CORE_FILEDESCRIPTORS - MAX_ADDNODE_CONNECTIONS), 0);
+    // CRYPTROX BEGIN
+    std::string strSocketEventsMode = gArgs.GetArg("-socketevents", CConnman::DEFAULT_SOCKETEVENTS_MODE == CConnman::SOCKETEVENTS_EPOLL ? "epoll" : "select");
+    if (strSocketEventsMode == "select") {
+        socketEventsMode = CConnman::SOCKETEVENTS_SELECT;
+#ifdef USE_EPOLL
+    } else if (strSocketEventsMode == "epoll") {
+        socketEventsMode = CConnman::SOCKETEVENTS_EPOLL;
+#endif
+    } else {
+        return InitError(strprintf(_("Invalid -socketevents ('%s') specified."), strSocketEventsMode));
+    }
+    // select() only handles descriptors below FD_SETSIZE
+    if (socketEventsMode == CConnman::SOCKETEVENTS_SELECT) {
+        int nBind = std::max(nUserBind, size_t(1));
+        nMaxConnections = std::max(std::min<int>(nMaxConnections, FD_SETSIZE - nBind - MIN_CORE_FILEDESCRIPTORS - MAX_ADDNODE_CONNECTIONS), 0);
+    }
+    // CRYPTROX END
     nFD = RaiseFileDescriptorLimit(nMaxConnections + MIN_CORE_FILEDESCRIPTORS + MAX_ADDNODE_CONNECTIONS);
     if (nFD < MIN_CORE_FILEDESCRIPTORS)
         return InitError(_("Not enough file descriptors available."));
@@ -1256,6 +1319,9 @@ bool AppInitSanityChecks()
     // Initialize elliptic curve code
     std::string sha256_algo = SHA256AutoDetect();
     LogPrintf("Using the '%s' SHA256 implementation\n", sha256_algo);
+    std::string x16r_algo = X16RAutoDetect();
+    LogPrintf("Using the '%s' X16R implementation\n", x16r_algo);
+    X16RSetTiming(gArgs.GetBoolArg("-powstatstiming", DEFAULT_X16R_TIMING)); // CRYPTROX
     RandomInit();
     ECC_Start();
     globalVerifyHandle.reset(new ECCVerifyHandle());
@@ -1324,6 +1390,10 @@ bool AppInitMain()
     if (nScriptCheckThreads) {
         for (int i=0; i<nScriptCheckThreads-1; i++)
             threadGroup.create_thread(&ThreadScriptCheck);
+        for (int i=0; i<nScriptCheckThreads-1; i++)
+            threadGroup.create_thread(&ThreadHeaderPoWCheck);
+        for (int i=0; i<nScriptCheckThreads-1; i++)
+            threadGroup.create_thread(&ThreadMessageSignatureCheck);
     }
 
     // Dash
@@ -1494,6 +1564,12 @@ bool AppInitMain()
     nTotalCache -= nBlockTreeDBCache;
     int64_t nTxIndexCache = std::min(nTotalCache / 8, gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX) ? nMaxTxIndexCache << 20 : 0);
     nTotalCache -= nTxIndexCache;
+    // CRYPTROX BEGIN
+    // the payee index reads every block on its initial sync, which pruned nodes cannot do
+    bool fPayeeIndex = !fPruneMode && gArgs.GetBoolArg("-payeeindex", DEFAULT_PAYEEINDEX);
+    int64_t nPayeeIndexCache = std::min(nTotalCache / 8, fPayeeIndex ? nMaxPayeeIndexCache << 20 : 0);
+    nTotalCache -= nPayeeIndexCache;
+    // CRYPTROX END
     int64_t nCoinDBCache = std::min(nTotalCache / 2, (nTotalCache / 4) + (1 << 23)); // use 25%-50% of the remainder for disk cache
     nCoinDBCache = std::min(nCoinDBCache, nMaxCoinsDBCache << 20); // cap total coins db cache
     nTotalCache -= nCoinDBCache;
@@ -1504,6 +1580,11 @@ bool AppInitMain()
     if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
         LogPrintf("* Using %.1fMiB for transaction index database\n", nTxIndexCache * (1.0 / 1024 / 1024));
     }
+    // CRYPTROX BEGIN
+    if (fPayeeIndex) {
+        LogPrintf("* Using %.1fMiB for masternode payee index database\n", nPayeeIndexCache * (1.0 / 1024 / 1024));
+    }
+    // CRYPTROX END
     LogPrintf("* Using %.1fMiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for in-memory UTXO set (plus up to %.1fMiB of unused mempool space)\n", nCoinCacheUsage * (1.0 / 1024 / 1024), nMempoolSizeMax * (1.0 / 1024 / 1024));
 
@@ -1530,6 +1611,10 @@ bool AppInitMain()
                 // CRYPTROX BEGIN
                 pSporkDB.reset();
                 pSporkDB.reset(new CSporkDB(0, false, false));
+                pGovernanceVoteDB.reset();
+                pGovernanceVoteDB.reset(new CGovernanceVoteDB(0, false, false));
+                pMasternodePaymentDB.reset();
+                pMasternodePaymentDB.reset(new CMasternodePaymentDB(0, false, false));
                 // CRYPTROX END
 
                 if (fReset) {
@@ -1693,6 +1778,12 @@ bool AppInitMain()
         g_txindex = MakeUnique<TxIndex>(nTxIndexCache, false, fReindex);
         g_txindex->Start();
     }
+    // CRYPTROX BEGIN
+    if (fPayeeIndex) {
+        g_payeeindex = MakeUnique<PayeeIndex>(nPayeeIndexCache, false, fReindex);
+        g_payeeindex->Start();
+    }
+    // CRYPTROX END
 
     // ********************************************************* Step 9: load wallet
     if (!g_wallet_init_interface.Open()) return false;
@@ -1869,6 +1960,9 @@ bool AppInitMain()
         governance.InitOnLoad();
     } else {
         uiInterface.InitMessage(_("Masternode cache is empty, skipping payments and governance cache..."));
+        // CRYPTROX BEGIN
+        governance.EraseStaleVotes();
+        // CRYPTROX END
     }
 
     strDBName = "netfulfilled.dat";
@@ -1878,6 +1972,11 @@ bool AppInitMain()
         return InitError(_("Failed to load fulfilled requests cache from") + "\n" + (pathDB / strDBName).string());
     }
 
+    // CRYPTROX BEGIN
+    // write a snapshot of the caches regularly so an unclean exit loses at most one interval
+    scheduler.scheduleEvery(DumpCaches, FLATDB_CHECKPOINT_INTERVAL * 1000);
+    // CRYPTROX END
+
     // ********************************************************* Step 11c: update block tip in Dash modules
 
     // force UpdatedBlockTip to initialize nCachedBlockHeight for DS, MN payments and budgets
@@ -1887,6 +1986,8 @@ bool AppInitMain()
 
     // ********************************************************* Step 11d: start dash-ps-<smth> threads
 
+    messageVerifyQueue.Start(); // CRYPTROX
+
     threadGroup.create_thread(boost::bind(&ThreadCheckPrivateSend, boost::ref(*g_connman)));
     if (fMasterNode)
         threadGroup.create_thread(boost::bind(&ThreadCheckPrivateSendServer, boost::ref(*g_connman)));
@@ -1928,6 +2029,7 @@ bool AppInitMain()
     connOptions.uiInterface = &uiInterface;
     connOptions.m_msgproc = peerLogic.get();
     connOptions.nSendBufferMaxSize = 1000*gArgs.GetArg("-maxsendbuffer", DEFAULT_MAXSENDBUFFER);
+    connOptions.socketEventsMode = socketEventsMode; // CRYPTROX
     connOptions.nReceiveFloodSize = 1000*gArgs.GetArg("-maxreceivebuffer", DEFAULT_MAXRECEIVEBUFFER);
     connOptions.m_added_nodes = gArgs.GetArgs("-addnode");
 
@@ -67,23 +67,51 @@ void CInstantSend::ProcessMessage(CNode* pfrom, const std::string& strCommand, C
         // Ignore any InstantSend messages until masternode list is synced
         if(!masternodeSync.IsMasternodeListSynced()) return;
 
-        LOCK(cs_main);
-#ifdef ENABLE_WALLET
-        std::vector<std::shared_ptr<CWallet>> wallets = GetWallets();
-        CWallet * const pwallet = (wallets.size() > 0) ? wallets[0].get() : nullptr;
-        if (pwallet)
-            LOCK(pwallet->cs_wallet);
-#endif
-        LOCK(cs_instantsend);
+        // CRYPTROX BEGIN
+        // Votes are relayed by many peers, drop the ones we already have before taking cs_main
+        {
+            LOCK(cs_instantsend);
+            if(!mapTxLockVotes.Insert(nVoteHash, vote)) return;
+        }
 
-        if(mapTxLockVotes.count(nVoteHash)) return;
-        mapTxLockVotes.insert(std::make_pair(nVoteHash, vote));
+        // verify the signature off-thread, votes of unknown masternodes are left to ProcessTxLockVote
+        masternode_info_t infoMn;
+        if(mnodeman.GetMasternodeInfo(vote.GetMasternodeOutpoint(), infoMn)) {
+            messageVerifyQueue.Push(vote.GetSignatureHash(), infoMn.pubKeyMasternode, vote.GetSignature(), pfrom,
+                [this, vote, &connman](bool fValidSignature, CNode* pnode) {
+                    ProcessVerifiedTxLockVote(pnode, vote, fValidSignature ? SignatureState::VALID : SignatureState::INVALID, connman);
+                });
+        } else {
+            ProcessVerifiedTxLockVote(pfrom, vote, SignatureState::UNCHECKED, connman);
+        }
+        // CRYPTROX END
 
-        ProcessTxLockVote(pfrom, vote, connman);
+        return;
+    }
+}
 
+// CRYPTROX BEGIN
+void CInstantSend::ProcessVerifiedTxLockVote(CNode* pfrom, CTxLockVote vote, SignatureState sigState, CConnman& connman)
+{
+    // the UTXO and masternode lookups take cs_main only for the time they need it
+    if(!vote.IsValid(pfrom, connman, sigState)) {
+        // could be because of missing MN
+        LogPrint(BCLog::INSTANTSEND, "CInstantSend::ProcessTxLockVote -- Vote is invalid, txid=%s\n", vote.GetTxHash().ToString());
         return;
     }
+
+    LOCK(cs_main);
+#ifdef ENABLE_WALLET
+    std::vector<std::shared_ptr<CWallet>> wallets = GetWallets();
+    CWallet * const pwallet = (wallets.size() > 0) ? wallets[0].get() : nullptr;
+    if (pwallet)
+        LOCK(pwallet->cs_wallet);
+#endif
+    LOCK(cs_instantsend);
+
+    ProcessTxLockVote(pfrom, vote, connman);
 }
+// CRYPTROX END
 
 bool CInstantSend::ProcessTxLockRequest(const CTxLockRequest& txLockRequest, CConnman& connman)
 {
@@ -93,12 +121,14 @@ bool CInstantSend::ProcessTxLockRequest(const CTxLockRequest& txLockRequest, CCo
 
     // Check to see if we conflict with existing completed lock
     for (const auto& txin : txLockRequest.vin) {
-        std::map<COutPoint, uint256>::iterator it = mapLockedOutpoints.find(txin.prevout);
-        if(it != mapLockedOutpoints.end() && it->second != txLockRequest.GetHash()) {
+        // CRYPTROX BEGIN
+        uint256 hashLocked;
+        if(mapLockedOutpoints.Get(txin.prevout, hashLocked) && hashLocked != txLockRequest.GetHash()) {
             // Conflicting with complete lock, proceed to see if we should cancel them both
             LogPrintf("CInstantSend::ProcessTxLockRequest -- WARNING: Found conflicting completed Transaction Lock, txid=%s, completed lock txid=%s\n",
-                    txLockRequest.GetHash().ToString(), it->second.ToString());
+                    txLockRequest.GetHash().ToString(), hashLocked.ToString());
         }
+        // CRYPTROX END
     }
 
     // Check to see if there are votes for conflicting request,
@@ -200,7 +230,9 @@ void CInstantSend::Vote(CTxLockCandidate& txLockCandidate, CConnman& connman)
 
     uint256 txHash = txLockCandidate.GetHash();
     // We should never vote on a Transaction Lock Request that was not (yet) accepted by the mempool
-    if(mapLockRequestAccepted.find(txHash) == mapLockRequestAccepted.end()) return;
+    // CRYPTROX BEGIN
+    if(!mapLockRequestAccepted.Contains(txHash)) return;
+    // CRYPTROX END
     // check if we need to vote on this candidate's outpoints,
     // it's possible that we need to vote for several of them
     std::map<COutPoint, COutPointLock>::iterator itOutpointLock = txLockCandidate.mapOutPointLocks.begin();
@@ -267,7 +299,9 @@ void CInstantSend::Vote(CTxLockCandidate& txLockCandidate, CConnman& connman)
 
         // vote constructed sucessfully, let's store and relay it
         uint256 nVoteHash = vote.GetHash();
-        mapTxLockVotes.insert(std::make_pair(nVoteHash, vote));
+        // CRYPTROX BEGIN
+        mapTxLockVotes.Insert(nVoteHash, vote);
+        // CRYPTROX END
         if(itOutpointLock->second.AddVote(vote)) {
             LogPrintf("CInstantSend::Vote -- Vote created successfully, relaying: txHash=%s, outpoint=%s, vote=%s\n",
                     txHash.ToString(), itOutpointLock->first.ToStringShort(), nVoteHash.ToString());
@@ -307,11 +341,7 @@ bool CInstantSend::ProcessTxLockVote(CNode* pfrom, CTxLockVote& vote, CConnman&
 
     uint256 txHash = vote.GetTxHash();
 
-    if(!vote.IsValid(pfrom, connman)) {
-        // could be because of missing MN
-        LogPrint(BCLog::INSTANTSEND, "CInstantSend::ProcessTxLockVote -- Vote is invalid, txid=%s\n", txHash.ToString());
-        return false;
-    }
+    // the vote was checked with IsValid by ProcessVerifiedTxLockVote // CRYPTROX
 
     // relay valid vote asap
     vote.Relay(connman);
@@ -321,50 +351,46 @@ bool CInstantSend::ProcessTxLockVote(CNode* pfrom, CTxLockVote& vote, CConnman&
 
     std::map<uint256, CTxLockCandidate>::iterator it = mapTxLockCandidates.find(txHash);
     if(it == mapTxLockCandidates.end() || !it->second.txLockRequest) {
-        if(!mapTxLockVotesOrphan.count(vote.GetHash())) {
+        // CRYPTROX BEGIN
+        if(!mapTxLockVotesOrphan.get<orphan_vote_hash>().count(vote.GetHash())) {
+        // CRYPTROX END
             // start timeout countdown after the very first vote
             CreateEmptyTxLockCandidate(txHash);
-            mapTxLockVotesOrphan[vote.GetHash()] = vote;
+            // CRYPTROX BEGIN
+            AddOrphanTxLockVote(vote);
+            // CRYPTROX END
             LogPrint(BCLog::INSTANTSEND, "CInstantSend::ProcessTxLockVote -- Orphan vote: txid=%s  masternode=%s new\n",
                     txHash.ToString(), vote.GetMasternodeOutpoint().ToStringShort());
             bool fReprocess = true;
-            std::map<uint256, CTxLockRequest>::iterator itLockRequest = mapLockRequestAccepted.find(txHash);
-            if(itLockRequest == mapLockRequestAccepted.end()) {
-                itLockRequest = mapLockRequestRejected.find(txHash);
-                if(itLockRequest == mapLockRequestRejected.end()) {
+            // CRYPTROX BEGIN
+            std::shared_ptr<const CTxLockRequest> txLockRequest;
+            if(!mapLockRequestAccepted.Get(txHash, txLockRequest)) {
+                if(!mapLockRequestRejected.Get(txHash, txLockRequest)) {
                     // still too early, wait for tx lock request
                     fReprocess = false;
                 }
             }
-            if(fReprocess && IsEnoughOrphanVotesForTx(itLockRequest->second)) {
+            if(fReprocess && IsEnoughOrphanVotesForTx(*txLockRequest)) {
                 // We have enough votes for corresponding lock to complete,
                 // tx lock request should already be received at this stage.
                 LogPrint(BCLog::INSTANTSEND, "CInstantSend::ProcessTxLockVote -- Found enough orphan votes, reprocessing Transaction Lock Request: txid=%s\n", txHash.ToString());
-                ProcessTxLockRequest(itLockRequest->second, connman);
+                ProcessTxLockRequest(*txLockRequest, connman);
                 return true;
             }
+            // CRYPTROX END
         } else {
             LogPrint(BCLog::INSTANTSEND, "CInstantSend::ProcessTxLockVote -- Orphan vote: txid=%s  masternode=%s seen\n",
                     txHash.ToString(), vote.GetMasternodeOutpoint().ToStringShort());
         }
 
-        // This tracks those messages and allows only the same rate as of the rest of the network
-        // TODO: make sure this works good enough for multi-quorum
-
-        int nMasternodeOrphanExpireTime = GetTime() + 60*10; // keep time data for 10 minutes
-        if(!mapMasternodeOrphanVotes.count(vote.GetMasternodeOutpoint())) {
-            mapMasternodeOrphanVotes[vote.GetMasternodeOutpoint()] = nMasternodeOrphanExpireTime;
-        } else {
-            int64_t nPrevOrphanVote = mapMasternodeOrphanVotes[vote.GetMasternodeOutpoint()];
-            if(nPrevOrphanVote > GetTime() && nPrevOrphanVote > GetAverageMasternodeOrphanVoteTime()) {
-                LogPrint(BCLog::INSTANTSEND, "CInstantSend::ProcessTxLockVote -- masternode is spamming orphan Transaction Lock Votes: txid=%s  masternode=%s\n",
-                        txHash.ToString(), vote.GetMasternodeOutpoint().ToStringShort());
-                // Misbehaving(pfrom->id, 1);
-                return false;
-            }
-            // not spamming, refresh
-            mapMasternodeOrphanVotes[vote.GetMasternodeOutpoint()] = nMasternodeOrphanExpireTime;
+        // CRYPTROX BEGIN
+        if(!UpdateMasternodeOrphanVoteTime(vote.GetMasternodeOutpoint())) {
+            LogPrint(BCLog::INSTANTSEND, "CInstantSend::ProcessTxLockVote -- masternode is spamming orphan Transaction Lock Votes: txid=%s  masternode=%s\n",
+                    txHash.ToString(), vote.GetMasternodeOutpoint().ToStringShort());
+            // Misbehaving(pfrom->id, 1);
+            return false;
         }
+        // CRYPTROX END
 
         return true;
     }
@@ -425,26 +451,43 @@ bool CInstantSend::ProcessTxLockVote(CNode* pfrom, CTxLockVote& vote, CConnman&
     return true;
 }
 
-void CInstantSend::ProcessOrphanTxLockVotes(CConnman& connman)
+// CRYPTROX BEGIN
+void CInstantSend::AddOrphanTxLockVote(const CTxLockVote& vote)
 {
-    LOCK(cs_main);
-#ifdef ENABLE_WALLET
-    std::vector<std::shared_ptr<CWallet>> wallets = GetWallets();
-    CWallet * const pwallet = (wallets.size() > 0) ? wallets[0].get() : nullptr;
-    if (pwallet)
-        LOCK(pwallet->cs_wallet);
-#endif
-    LOCK(cs_instantsend);
+    AssertLockHeld(cs_instantsend);
 
-    std::map<uint256, CTxLockVote>::iterator it = mapTxLockVotesOrphan.begin();
-    while(it != mapTxLockVotesOrphan.end()) {
-        if(ProcessTxLockVote(NULL, it->second, connman)) {
-            mapTxLockVotesOrphan.erase(it++);
-        } else {
-            ++it;
+    auto& index = mapTxLockVotesOrphan.get<orphan_vote_sequence>();
+    index.push_back(COrphanTxLockVote(vote));
+
+    // Bound memory under vote floods, the evicted votes stay in mapTxLockVotes
+    // so that they are not requested again and expire from there
+    while(index.size() > MAX_ORPHAN_TXLOCK_VOTES) {
+        LogPrint(BCLog::INSTANTSEND, "CInstantSend::AddOrphanTxLockVote -- Evicting orphan vote: txid=%s  masternode=%s\n",
+                index.front().txHash.ToString(), index.front().vote.GetMasternodeOutpoint().ToStringShort());
+        index.pop_front();
+    }
+}
+
+bool CInstantSend::UpdateMasternodeOrphanVoteTime(const COutPoint& outpointMasternode)
+{
+    AssertLockHeld(cs_instantsend);
+
+    // This tracks those messages and allows only the same rate as of the rest of the network
+    // TODO: make sure this works good enough for multi-quorum
+
+    int64_t nMasternodeOrphanExpireTime = GetTime() + 60*10; // keep time data for 10 minutes
+    auto it = mapMasternodeOrphanVotes.find(outpointMasternode);
+    if(it != mapMasternodeOrphanVotes.end()) {
+        int64_t nPrevOrphanVote = it->second;
+        if(nPrevOrphanVote > GetTime() && nPrevOrphanVote > GetAverageMasternodeOrphanVoteTime()) {
+            return false;
         }
     }
+    // new or not spamming, refresh
+    mapMasternodeOrphanVotes[outpointMasternode] = nMasternodeOrphanExpireTime;
+    return true;
 }
+// CRYPTROX END
 
 bool CInstantSend::IsEnoughOrphanVotesForTx(const CTxLockRequest& txLockRequest)
 {
@@ -461,20 +504,11 @@ bool CInstantSend::IsEnoughOrphanVotesForTx(const CTxLockRequest& txLockRequest)
 
 bool CInstantSend::IsEnoughOrphanVotesForTxAndOutPoint(const uint256& txHash, const COutPoint& outpoint)
 {
-    // Scan orphan votes to check if this outpoint has enough orphan votes to be locked in some tx.
+    // Count orphan votes to check if this outpoint has enough orphan votes to be locked in some tx.
     LOCK2(cs_main, cs_instantsend);
-    int nCountVotes = 0;
-    std::map<uint256, CTxLockVote>::iterator it = mapTxLockVotesOrphan.begin();
-    while(it != mapTxLockVotesOrphan.end()) {
-        if(it->second.GetTxHash() == txHash && it->second.GetOutpoint() == outpoint) {
-            nCountVotes++;
-            if(nCountVotes >= COutPointLock::SIGNATURES_REQUIRED) {
-                return true;
-            }
-        }
-        ++it;
-    }
-    return false;
+    // CRYPTROX BEGIN
+    return mapTxLockVotesOrphan.get<orphan_vote_tx_outpoint>().count(boost::make_tuple(txHash, outpoint)) >= (size_t)COutPointLock::SIGNATURES_REQUIRED;
+    // CRYPTROX END
 }
 
 void CInstantSend::TryToFinalizeLockCandidate(const CTxLockCandidate& txLockCandidate)
@@ -546,20 +580,25 @@ void CInstantSend::LockTransactionInputs(const CTxLockCandidate& txLockCandidate
 
     std::map<COutPoint, COutPointLock>::const_iterator it = txLockCandidate.mapOutPointLocks.begin();
 
+    // CRYPTROX BEGIN
+    bool fAllLocked = !txLockCandidate.mapOutPointLocks.empty();
     while(it != txLockCandidate.mapOutPointLocks.end()) {
-        mapLockedOutpoints.insert(std::make_pair(it->first, txHash));
+        uint256 hashLocked;
+        if(!mapLockedOutpoints.Insert(it->first, txHash) && mapLockedOutpoints.Get(it->first, hashLocked) && hashLocked != txHash)
+            fAllLocked = false;
         ++it;
     }
+    if(fAllLocked)
+        mapLockedTxes.Insert(txHash, true);
+    // CRYPTROX END
     LogPrint(BCLog::INSTANTSEND, "CInstantSend::LockTransactionInputs -- done, txid=%s\n", txHash.ToString());
 }
 
 bool CInstantSend::GetLockedOutPointTxHash(const COutPoint& outpoint, uint256& hashRet)
 {
-    LOCK(cs_instantsend);
-    std::map<COutPoint, uint256>::iterator it = mapLockedOutpoints.find(outpoint);
-    if(it == mapLockedOutpoints.end()) return false;
-    hashRet = it->second;
-    return true;
+    // CRYPTROX BEGIN
+    return mapLockedOutpoints.Get(outpoint, hashRet);
+    // CRYPTROX END
 }
 
 bool CInstantSend::ResolveConflicts(const CTxLockCandidate& txLockCandidate)
@@ -594,8 +633,10 @@ bool CInstantSend::ResolveConflicts(const CTxLockCandidate& txLockCandidate)
             itLockCandidateConflicting->second.SetConfirmedHeight(0); // expired
             CheckAndRemove(); // clean up
             // AlreadyHave should still return "true" for both of them
-            mapLockRequestRejected.insert(make_pair(txHash, txLockRequest));
-            mapLockRequestRejected.insert(make_pair(hashConflicting, txLockRequestConflicting));
+            // CRYPTROX BEGIN
+            mapLockRequestRejected.Insert(txHash, std::make_shared<const CTxLockRequest>(txLockRequest));
+            mapLockRequestRejected.Insert(hashConflicting, std::make_shared<const CTxLockRequest>(txLockRequestConflicting));
+            // CRYPTROX END
 
             // TODO: clean up mapLockRequestRejected later somehow
             //       (not a big issue since we already PoSe ban malicious masternodes
@@ -674,54 +715,62 @@ void CInstantSend::CheckAndRemove()
             LogPrintf("CInstantSend::CheckAndRemove -- Removing expired Transaction Lock Candidate: txid=%s\n", txHash.ToString());
             std::map<COutPoint, COutPointLock>::iterator itOutpointLock = txLockCandidate.mapOutPointLocks.begin();
             while(itOutpointLock != txLockCandidate.mapOutPointLocks.end()) {
-                mapLockedOutpoints.erase(itOutpointLock->first);
+                // CRYPTROX BEGIN
+                // the tx owning this outpoint lock is not fully locked anymore
+                uint256 hashLocked;
+                if(mapLockedOutpoints.Get(itOutpointLock->first, hashLocked))
+                    mapLockedTxes.Erase(hashLocked);
+                mapLockedOutpoints.Erase(itOutpointLock->first);
+                // CRYPTROX END
                 mapVotedOutpoints.erase(itOutpointLock->first);
                 ++itOutpointLock;
             }
-            mapLockRequestAccepted.erase(txHash);
-            mapLockRequestRejected.erase(txHash);
+            // CRYPTROX BEGIN
+            mapLockedTxes.Erase(txHash);
+            mapLockRequestAccepted.Erase(txHash);
+            mapLockRequestRejected.Erase(txHash);
+            // CRYPTROX END
             mapTxLockCandidates.erase(itLockCandidate++);
         } else {
             ++itLockCandidate;
         }
     }
 
+    // CRYPTROX BEGIN
     // remove expired votes
-    std::map<uint256, CTxLockVote>::iterator itVote = mapTxLockVotes.begin();
-    while(itVote != mapTxLockVotes.end()) {
-        if(itVote->second.IsExpired(nCachedBlockHeight)) {
-            LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing expired vote: txid=%s  masternode=%s\n",
-                    itVote->second.GetTxHash().ToString(), itVote->second.GetMasternodeOutpoint().ToStringShort());
-            mapTxLockVotes.erase(itVote++);
-        } else {
-            ++itVote;
-        }
-    }
+    mapTxLockVotes.EraseIf([this](const uint256& nVoteHash, const CTxLockVote& vote) {
+        if(!vote.IsExpired(nCachedBlockHeight)) return false;
+        LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing expired vote: txid=%s  masternode=%s\n",
+                vote.GetTxHash().ToString(), vote.GetMasternodeOutpoint().ToStringShort());
+        return true;
+    });
+    // CRYPTROX END
 
     // remove timed out orphan votes
-    std::map<uint256, CTxLockVote>::iterator itOrphanVote = mapTxLockVotesOrphan.begin();
-    while(itOrphanVote != mapTxLockVotesOrphan.end()) {
-        if(itOrphanVote->second.IsTimedOut()) {
+    // CRYPTROX BEGIN
+    auto& orphanVotes = mapTxLockVotesOrphan.get<orphan_vote_sequence>();
+    auto itOrphanVote = orphanVotes.begin();
+    while(itOrphanVote != orphanVotes.end()) {
+        if(itOrphanVote->vote.IsTimedOut()) {
             LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing timed out orphan vote: txid=%s  masternode=%s\n",
-                    itOrphanVote->second.GetTxHash().ToString(), itOrphanVote->second.GetMasternodeOutpoint().ToStringShort());
-            mapTxLockVotes.erase(itOrphanVote->first);
-            mapTxLockVotesOrphan.erase(itOrphanVote++);
+                    itOrphanVote->txHash.ToString(), itOrphanVote->vote.GetMasternodeOutpoint().ToStringShort());
+            mapTxLockVotes.Erase(itOrphanVote->hash);
+            itOrphanVote = orphanVotes.erase(itOrphanVote);
         } else {
             ++itOrphanVote;
         }
     }
+    // CRYPTROX END
 
+    // CRYPTROX BEGIN
     // remove invalid votes and votes for failed lock attempts
-    itVote = mapTxLockVotes.begin();
-    while(itVote != mapTxLockVotes.end()) {
-        if(itVote->second.IsFailed()) {
-            LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing vote for failed lock attempt: txid=%s  masternode=%s\n",
-                    itVote->second.GetTxHash().ToString(), itVote->second.GetMasternodeOutpoint().ToStringShort());
-            mapTxLockVotes.erase(itVote++);
-        } else {
-            ++itVote;
-        }
-    }
+    mapTxLockVotes.EraseIf([](const uint256& nVoteHash, const CTxLockVote& vote) {
+        if(!vote.IsFailed()) return false;
+        LogPrint(BCLog::INSTANTSEND, "CInstantSend::CheckAndRemove -- Removing vote for failed lock attempt: txid=%s  masternode=%s\n",
+                vote.GetTxHash().ToString(), vote.GetMasternodeOutpoint().ToStringShort());
+        return true;
+    });
+    // CRYPTROX END
 
     // remove timed out masternode orphan votes (DOS protection)
     std::map<COutPoint, int64_t>::iterator itMasternodeOrphan = mapMasternodeOrphanVotes.begin();
@@ -739,22 +788,27 @@ void CInstantSend::CheckAndRemove()
 
 bool CInstantSend::AlreadyHave(const uint256& hash)
 {
-    LOCK(cs_instantsend);
-    return mapLockRequestAccepted.count(hash) ||
-            mapLockRequestRejected.count(hash) ||
-            mapTxLockVotes.count(hash);
+    // CRYPTROX BEGIN
+    return mapLockRequestAccepted.Contains(hash) ||
+            mapLockRequestRejected.Contains(hash) ||
+            mapTxLockVotes.Contains(hash);
+    // CRYPTROX END
 }
 
 void CInstantSend::AcceptLockRequest(const CTxLockRequest& txLockRequest)
 {
     LOCK(cs_instantsend);
-    mapLockRequestAccepted.insert(make_pair(txLockRequest.GetHash(), txLockRequest));
+    // CRYPTROX BEGIN
+    mapLockRequestAccepted.Insert(txLockRequest.GetHash(), std::make_shared<const CTxLockRequest>(txLockRequest));
+    // CRYPTROX END
 }
 
 void CInstantSend::RejectLockRequest(const CTxLockRequest& txLockRequest)
 {
     LOCK(cs_instantsend);
-    mapLockRequestRejected.insert(make_pair(txLockRequest.GetHash(), txLockRequest));
+    // CRYPTROX BEGIN
+    mapLockRequestRejected.Insert(txLockRequest.GetHash(), std::make_shared<const CTxLockRequest>(txLockRequest));
+    // CRYPTROX END
 }
 
 bool CInstantSend::HasTxLockRequest(const uint256& txHash)
@@ -776,13 +830,9 @@ bool CInstantSend::GetTxLockRequest(const uint256& txHash, CTxLockRequest& txLoc
 
 bool CInstantSend::GetTxLockVote(const uint256& hash, CTxLockVote& txLockVoteRet)
 {
-    LOCK(cs_instantsend);
-
-    std::map<uint256, CTxLockVote>::iterator it = mapTxLockVotes.find(hash);
-    if(it == mapTxLockVotes.end()) return false;
-    txLockVoteRet = it->second;
-
-    return true;
+    // CRYPTROX BEGIN
+    return mapTxLockVotes.Get(hash, txLockVoteRet);
+    // CRYPTROX END
 }
 
 bool CInstantSend::IsInstantSendReadyToLock(const uint256& txHash)
@@ -802,24 +852,11 @@ bool CInstantSend::IsLockedInstantSendTransaction(const uint256& txHash)
     if(!fEnableInstantSend || fLargeWorkForkFound || fLargeWorkInvalidChainFound ||
         !sporkManager.IsSporkActive(SPORK_3_INSTANTSEND_BLOCK_FILTERING)) return false;
 
-    LOCK(cs_instantsend);
-
-    // there must be a lock candidate
-    std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
-    if(itLockCandidate == mapTxLockCandidates.end()) return false;
-
-    // which should have outpoints
-    if(itLockCandidate->second.mapOutPointLocks.empty()) return false;
-
-    // and all of these outputs must be included in mapLockedOutpoints with correct hash
-    std::map<COutPoint, COutPointLock>::iterator itOutpointLock = itLockCandidate->second.mapOutPointLocks.begin();
-    while(itOutpointLock != itLockCandidate->second.mapOutPointLocks.end()) {
-        uint256 hashLocked;
-        if(!GetLockedOutPointTxHash(itOutpointLock->first, hashLocked) || hashLocked != txHash) return false;
-        ++itOutpointLock;
-    }
-
-    return true;
+    // CRYPTROX BEGIN
+    // there must be a lock candidate which has outpoints and all of them must be
+    // included in mapLockedOutpoints with correct hash, tracked by mapLockedTxes
+    return mapLockedTxes.Contains(txHash);
+    // CRYPTROX END
 }
 
 int CInstantSend::GetTransactionLockSignatures(const uint256& txHash)
@@ -880,13 +917,14 @@ void CInstantSend::SyncTransaction(const CTransaction& tx, const CBlock* pblock)
 
     if (tx.IsCoinBase()) return;
 
-    LOCK2(cs_main, cs_instantsend);
-
     uint256 txHash = tx.GetHash();
 
     // When tx is 0-confirmed or conflicted, pblock is NULL and nHeightNew should be set to -1
-    CBlockIndex* pblockindex = NULL;
+    // CRYPTROX BEGIN
+    // cs_main is only needed for the block lookup, do not hold it while updating votes
+    int nHeightNew = -1;
     if(pblock) {
+        LOCK(cs_main);
         uint256 blockHash = pblock->GetHash();
         BlockMap::iterator mi = mapBlockIndex.find(blockHash);
         if(mi == mapBlockIndex.end() || !mi->second) {
@@ -894,9 +932,11 @@ void CInstantSend::SyncTransaction(const CTransaction& tx, const CBlock* pblock)
             LogPrint(BCLog::INSTANTSEND, "CTxLockRequest::SyncTransaction -- Failed to find block %s\n", blockHash.ToString());
             return;
         }
-        pblockindex = mi->second;
+        nHeightNew = mi->second->nHeight;
     }
-    int nHeightNew = pblockindex ? pblockindex->nHeight : -1;
+
+    LOCK(cs_instantsend);
+    // CRYPTROX END
 
     LogPrint(BCLog::INSTANTSEND, "CInstantSend::SyncTransaction -- txid=%s nHeightNew=%d\n", txHash.ToString(), nHeightNew);
 
@@ -912,15 +952,13 @@ void CInstantSend::SyncTransaction(const CTransaction& tx, const CBlock* pblock)
             // Check corresponding lock votes
             std::vector<CTxLockVote> vVotes = itOutpointLock->second.GetVotes();
             std::vector<CTxLockVote>::iterator itVote = vVotes.begin();
-            std::map<uint256, CTxLockVote>::iterator it;
             while(itVote != vVotes.end()) {
                 uint256 nVoteHash = itVote->GetHash();
                 LogPrint(BCLog::INSTANTSEND, "CInstantSend::SyncTransaction -- txid=%s nHeightNew=%d vote %s updated\n",
                         txHash.ToString(), nHeightNew, nVoteHash.ToString());
-                it = mapTxLockVotes.find(nVoteHash);
-                if(it != mapTxLockVotes.end()) {
-                    it->second.SetConfirmedHeight(nHeightNew);
-                }
+                // CRYPTROX BEGIN
+                mapTxLockVotes.Update(nVoteHash, [nHeightNew](CTxLockVote& vote) { vote.SetConfirmedHeight(nHeightNew); });
+                // CRYPTROX END
                 ++itVote;
             }
             ++itOutpointLock;
@@ -928,23 +966,33 @@ void CInstantSend::SyncTransaction(const CTransaction& tx, const CBlock* pblock)
     }
 
     // check orphan votes
-    std::map<uint256, CTxLockVote>::iterator itOrphanVote = mapTxLockVotesOrphan.begin();
-    while(itOrphanVote != mapTxLockVotesOrphan.end()) {
-        if(itOrphanVote->second.GetTxHash() == txHash) {
-            LogPrint(BCLog::INSTANTSEND, "CInstantSend::SyncTransaction -- txid=%s nHeightNew=%d vote %s updated\n",
-                    txHash.ToString(), nHeightNew, itOrphanVote->first.ToString());
-            mapTxLockVotes[itOrphanVote->first].SetConfirmedHeight(nHeightNew);
-        }
-        ++itOrphanVote;
+    // CRYPTROX BEGIN
+    auto range = mapTxLockVotesOrphan.get<orphan_vote_tx_outpoint>().equal_range(boost::make_tuple(txHash));
+    for (auto itOrphanVote = range.first; itOrphanVote != range.second; ++itOrphanVote) {
+        LogPrint(BCLog::INSTANTSEND, "CInstantSend::SyncTransaction -- txid=%s nHeightNew=%d vote %s updated\n",
+                txHash.ToString(), nHeightNew, itOrphanVote->hash.ToString());
+        mapTxLockVotes.Update(itOrphanVote->hash, [nHeightNew](CTxLockVote& vote) { vote.SetConfirmedHeight(nHeightNew); });
     }
+    // CRYPTROX END
 }
 
 std::string CInstantSend::ToString()
 {
     LOCK(cs_instantsend);
-    return strprintf("Lock Candidates: %llu, Votes %llu", mapTxLockCandidates.size(), mapTxLockVotes.size());
+    // CRYPTROX BEGIN
+    return strprintf("Lock Candidates: %llu, Votes %llu", mapTxLockCandidates.size(), mapTxLockVotes.Size());
+    // CRYPTROX END
 }
 
+// CRYPTROX BEGIN
+COrphanTxLockVote::COrphanTxLockVote(const CTxLockVote& voteIn) :
+    hash(voteIn.GetHash()),
+    txHash(voteIn.GetTxHash()),
+    outpoint(voteIn.GetOutpoint()),
+    vote(voteIn)
+{}
+// CRYPTROX END
+
 //
 // CTxLockRequest
 //
@@ -1017,7 +1065,7 @@ int CTxLockRequest::GetMaxSignatures() const
 // CTxLockVote
 //
 
-bool CTxLockVote::IsValid(CNode* pnode, CConnman& connman) const
+bool CTxLockVote::IsValid(CNode* pnode, CConnman& connman, SignatureState sigState) const
 {
     if(!mnodeman.Has(outpointMasternode)) {
         LogPrint(BCLog::INSTANTSEND, "CTxLockVote::IsValid -- Unknown masternode %s\n", outpointMasternode.ToStringShort());
@@ -1048,7 +1096,10 @@ bool CTxLockVote::IsValid(CNode* pnode, CConnman& connman) const
         return false;
     }
 
-    if(!CheckSignature()) {
+    // CRYPTROX BEGIN
+    // the signature may already be verified, see CMessageVerifyQueue
+    if(sigState == SignatureState::INVALID || (sigState == SignatureState::UNCHECKED && !CheckSignature())) {
+    // CRYPTROX END
         LogPrintf("CTxLockVote::IsValid -- Signature invalid\n");
         return false;
     }
@@ -1065,10 +1116,16 @@ uint256 CTxLockVote::GetHash() const
     return ss.GetHash();
 }
 
+// CRYPTROX BEGIN
+uint256 CTxLockVote::GetSignatureHash() const
+{
+    return CMessageSigner::GetMessageHash(txHash.ToString() + outpoint.ToStringShort());
+}
+// CRYPTROX END
+
 bool CTxLockVote::CheckSignature() const
 {
     std::string strError;
-    std::string strMessage = txHash.ToString() + outpoint.ToStringShort();
 
     masternode_info_t infoMn;
 
@@ -1077,7 +1134,7 @@ bool CTxLockVote::CheckSignature() const
         return false;
     }
 
-    if(!CMessageSigner::VerifyMessage(infoMn.pubKeyMasternode, vchMasternodeSignature, strMessage, strError)) {
+    if(!CHashSigner::VerifyHash(GetSignatureHash(), infoMn.pubKeyMasternode, vchMasternodeSignature, strError)) { // CRYPTROX
         LogPrintf("CTxLockVote::CheckSignature -- VerifyMessage() failed, error: %s\n", strError);
         return false;
     }
@@ -7,8 +7,16 @@
 #define CRYPTROX_INSTANTX_H
 
 #include <chain.h>
+#include <messagesigner.h>
 #include <net.h>
 #include <primitives/transaction.h>
+// CRYPTROX BEGIN
+#include <shardedmap.h>
+#include <txmempool.h>
+
+#include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/member.hpp>
+// CRYPTROX END
 
 class CTxLockVote;
 class COutPointLock;
@@ -38,6 +46,117 @@ static const int INSTANTSEND_LOCK_TIMEOUT_SECONDS   = 15;
 // For how long we are going to keep invalid votes and votes for failed lock attempts,
 // must be greater than INSTANTSEND_LOCK_TIMEOUT_SECONDS
 static const int INSTANTSEND_FAILED_TIMEOUT_SECONDS = 60;
+// CRYPTROX BEGIN
+// Maximum number of orphan votes kept, the oldest ones are evicted first
+static const size_t MAX_ORPHAN_TXLOCK_VOTES         = 10000;
+// CRYPTROX END
+
+class CTxLockVote
+{
+private:
+    uint256 txHash;
+    COutPoint outpoint;
+    COutPoint outpointMasternode;
+    std::vector<unsigned char> vchMasternodeSignature;
+    // local memory only
+    int nConfirmedHeight; // when corresponding tx is 0-confirmed or conflicted, nConfirmedHeight is -1
+    int64_t nTimeCreated;
+
+public:
+    CTxLockVote() :
+        txHash(),
+        outpoint(),
+        outpointMasternode(),
+        vchMasternodeSignature(),
+        nConfirmedHeight(-1),
+        nTimeCreated(GetTime())
+        {}
+
+    CTxLockVote(const uint256& txHashIn, const COutPoint& outpointIn, const COutPoint& outpointMasternodeIn) :
+        txHash(txHashIn),
+        outpoint(outpointIn),
+        outpointMasternode(outpointMasternodeIn),
+        vchMasternodeSignature(),
+        nConfirmedHeight(-1),
+        nTimeCreated(GetTime())
+        {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(txHash);
+        READWRITE(outpoint);
+        READWRITE(outpointMasternode);
+        READWRITE(vchMasternodeSignature);
+    }
+
+    uint256 GetHash() const;
+
+    uint256 GetTxHash() const { return txHash; }
+    COutPoint GetOutpoint() const { return outpoint; }
+    COutPoint GetMasternodeOutpoint() const { return outpointMasternode; }
+
+    // CRYPTROX BEGIN
+    bool IsValid(CNode* pnode, CConnman& connman, SignatureState sigState = SignatureState::UNCHECKED) const;
+    // CRYPTROX END
+    void SetConfirmedHeight(int nConfirmedHeightIn) { nConfirmedHeight = nConfirmedHeightIn; }
+    bool IsExpired(int nHeight) const;
+    bool IsTimedOut() const;
+    bool IsFailed() const;
+
+    bool Sign();
+    bool CheckSignature() const;
+    // CRYPTROX BEGIN
+    uint256 GetSignatureHash() const;
+    const std::vector<unsigned char>& GetSignature() const { return vchMasternodeSignature; }
+    // CRYPTROX END
+
+    void Relay(CConnman& connman) const;
+};
+
+// CRYPTROX BEGIN
+/** Orphan vote with the keys it is indexed by, computed once */
+struct COrphanTxLockVote
+{
+    uint256 hash;
+    uint256 txHash;
+    COutPoint outpoint;
+    CTxLockVote vote;
+
+    explicit COrphanTxLockVote(const CTxLockVote& voteIn);
+};
+
+// multi_index tag names
+struct orphan_vote_hash {};
+struct orphan_vote_tx_outpoint {};
+struct orphan_vote_sequence {};
+
+typedef boost::multi_index_container<
+    COrphanTxLockVote,
+    boost::multi_index::indexed_by<
+        // lookup by vote hash
+        boost::multi_index::hashed_unique<
+            boost::multi_index::tag<orphan_vote_hash>,
+            boost::multi_index::member<COrphanTxLockVote, uint256, &COrphanTxLockVote::hash>,
+            SaltedTxidHasher
+        >,
+        // all votes for a tx, or for one of its outpoints
+        boost::multi_index::ordered_non_unique<
+            boost::multi_index::tag<orphan_vote_tx_outpoint>,
+            boost::multi_index::composite_key<
+                COrphanTxLockVote,
+                boost::multi_index::member<COrphanTxLockVote, uint256, &COrphanTxLockVote::txHash>,
+                boost::multi_index::member<COrphanTxLockVote, COutPoint, &COrphanTxLockVote::outpoint>
+            >
+        >,
+        // insertion order, for eviction
+        boost::multi_index::sequenced<
+            boost::multi_index::tag<orphan_vote_sequence>
+        >
+    >
+> orphan_txlock_votes_t;
+// CRYPTROX END
 
 extern bool fEnableInstantSend;
 extern int nInstantSendDepth;
@@ -49,27 +168,47 @@ private:
     // Keep track of current block height
     int nCachedBlockHeight;
 
+    // CRYPTROX BEGIN
+    // Maps read outside of vote processing are sharded with their own locks, so AlreadyHave and
+    // lock status queries never wait for cs_instantsend. They are only modified under cs_instantsend.
+
     // maps for AlreadyHave
-    std::map<uint256, CTxLockRequest> mapLockRequestAccepted; // tx hash - tx
-    std::map<uint256, CTxLockRequest> mapLockRequestRejected; // tx hash - tx
-    std::map<uint256, CTxLockVote> mapTxLockVotes; // vote hash - vote
-    std::map<uint256, CTxLockVote> mapTxLockVotesOrphan; // vote hash - vote
+    // (lock requests are held by pointer, CTransaction assignment does not copy)
+    CShardedMap<uint256, std::shared_ptr<const CTxLockRequest>, SaltedTxidHasher> mapLockRequestAccepted; // tx hash - tx
+    CShardedMap<uint256, std::shared_ptr<const CTxLockRequest>, SaltedTxidHasher> mapLockRequestRejected; // tx hash - tx
+    CShardedMap<uint256, CTxLockVote, SaltedTxidHasher> mapTxLockVotes; // vote hash - vote
+    // CRYPTROX END
+    // CRYPTROX BEGIN
+    orphan_txlock_votes_t mapTxLockVotesOrphan;
+    // CRYPTROX END
 
     std::map<uint256, CTxLockCandidate> mapTxLockCandidates; // tx hash - lock candidate
 
     std::map<COutPoint, std::set<uint256> > mapVotedOutpoints; // utxo - tx hash set
-    std::map<COutPoint, uint256> mapLockedOutpoints; // utxo - tx hash
+    // CRYPTROX BEGIN
+    CShardedMap<COutPoint, uint256, SaltedOutpointHasher> mapLockedOutpoints; // utxo - tx hash
+    // txes whose inputs are all in mapLockedOutpoints with their hash
+    CShardedMap<uint256, bool, SaltedTxidHasher> mapLockedTxes; // tx hash - true
+    // CRYPTROX END
 
     //track masternodes who voted with no txreq (for DOS protection)
     std::map<COutPoint, int64_t> mapMasternodeOrphanVotes; // mn outpoint - time
 
+    friend struct CInstantSendTest; // CRYPTROX
+
     bool CreateTxLockCandidate(const CTxLockRequest& txLockRequest);
     void CreateEmptyTxLockCandidate(const uint256& txHash);
     void Vote(CTxLockCandidate& txLockCandidate, CConnman& connman);
 
     //process consensus vote message
     bool ProcessTxLockVote(CNode* pfrom, CTxLockVote& vote, CConnman& connman);
-    void ProcessOrphanTxLockVotes(CConnman& connman);
+    // CRYPTROX BEGIN
+    /// Check a vote received from pfrom once its signature was checked, then take the locks and process it
+    void ProcessVerifiedTxLockVote(CNode* pfrom, CTxLockVote vote, SignatureState sigState, CConnman& connman);
+    void AddOrphanTxLockVote(const CTxLockVote& vote);
+    /// Record an orphan vote of a masternode, false if it sends them faster than the average masternode
+    bool UpdateMasternodeOrphanVoteTime(const COutPoint& outpointMasternode);
+    // CRYPTROX END
     bool IsEnoughOrphanVotesForTx(const CTxLockRequest& txLockRequest);
     bool IsEnoughOrphanVotesForTxAndOutPoint(const uint256& txHash, const COutPoint& outpoint);
     int64_t GetAverageMasternodeOrphanVoteTime();
@@ -142,64 +281,6 @@ public:
     }
 };
 
-class CTxLockVote
-{
-private:
-    uint256 txHash;
-    COutPoint outpoint;
-    COutPoint outpointMasternode;
-    std::vector<unsigned char> vchMasternodeSignature;
-    // local memory only
-    int nConfirmedHeight; // when corresponding tx is 0-confirmed or conflicted, nConfirmedHeight is -1
-    int64_t nTimeCreated;
-
-public:
-    CTxLockVote() :
-        txHash(),
-        outpoint(),
-        outpointMasternode(),
-        vchMasternodeSignature(),
-        nConfirmedHeight(-1),
-        nTimeCreated(GetTime())
-        {}
-
-    CTxLockVote(const uint256& txHashIn, const COutPoint& outpointIn, const COutPoint& outpointMasternodeIn) :
-        txHash(txHashIn),
-        outpoint(outpointIn),
-        outpointMasternode(outpointMasternodeIn),
-        vchMasternodeSignature(),
-        nConfirmedHeight(-1),
-        nTimeCreated(GetTime())
-        {}
-
-    ADD_SERIALIZE_METHODS;
-
-    template <typename Stream, typename Operation>
-    inline void SerializationOp(Stream& s, Operation ser_action) {
-        READWRITE(txHash);
-        READWRITE(outpoint);
-        READWRITE(outpointMasternode);
-        READWRITE(vchMasternodeSignature);
-    }
-
-    uint256 GetHash() const;
-
-    uint256 GetTxHash() const { return txHash; }
-    COutPoint GetOutpoint() const { return outpoint; }
-    COutPoint GetMasternodeOutpoint() const { return outpointMasternode; }
-
-    bool IsValid(CNode* pnode, CConnman& connman) const;
-    void SetConfirmedHeight(int nConfirmedHeightIn) { nConfirmedHeight = nConfirmedHeightIn; }
-    bool IsExpired(int nHeight) const;
-    bool IsTimedOut() const;
-    bool IsFailed() const;
-
-    bool Sign();
-    bool CheckSignature() const;
-
-    void Relay(CConnman& connman) const;
-};
-
 class COutPointLock
 {
 private:
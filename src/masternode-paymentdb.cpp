@@ -0,0 +1,127 @@
+// Copyright (c) 2019 Cryptroxcoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <masternode-paymentdb.h>
+
+#include <crypto/common.h>
+
+static const char DB_VOTE = 'v';
+static const char DB_VOTE_INDEX = 'i';
+
+std::unique_ptr<CMasternodePaymentDB> pMasternodePaymentDB;
+
+namespace {
+
+/** Block height serialized big-endian, so leveldb orders the votes by height */
+struct HeightKey
+{
+    int nHeight;
+
+    explicit HeightKey(int nHeightIn = 0) : nHeight(nHeightIn) {}
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        unsigned char buf[4];
+        WriteBE32(buf, nHeight);
+        s.write((const char*)buf, sizeof(buf));
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        unsigned char buf[4];
+        s.read((char*)buf, sizeof(buf));
+        nHeight = ReadBE32(buf);
+    }
+};
+
+typedef std::pair<char, std::pair<HeightKey, uint256> > vote_key_t;
+
+vote_key_t VoteKey(int nBlockHeight, const uint256& nHash)
+{
+    return std::make_pair(DB_VOTE, std::make_pair(HeightKey(nBlockHeight), nHash));
+}
+
+template <typename K>
+std::string SerializeKey(const K& key)
+{
+    CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+    ssKey << key;
+    return std::string(ssKey.begin(), ssKey.end());
+}
+
+} // namespace
+
+CMasternodePaymentDB::CMasternodePaymentDB(size_t nCacheSize, bool fMemory, bool fWipe) : CLevelDBWrapper(GetDataDir() / "mnpayments", nCacheSize, fMemory, fWipe) {}
+
+bool CMasternodePaymentDB::WriteVote(const CMasternodePaymentVote& vote)
+{
+    uint256 nHash = vote.GetHash();
+    CLevelDBBatch batch;
+    batch.Write(VoteKey(vote.nBlockHeight, nHash), vote);
+    batch.Write(std::make_pair(DB_VOTE_INDEX, nHash), vote.nBlockHeight);
+    return WriteBatch(batch);
+}
+
+bool CMasternodePaymentDB::ReadVote(const uint256& nHash, CMasternodePaymentVote& vote)
+{
+    int nBlockHeight;
+    if (!Read(std::make_pair(DB_VOTE_INDEX, nHash), nBlockHeight)) {
+        return false;
+    }
+    return Read(VoteKey(nBlockHeight, nHash), vote);
+}
+
+bool CMasternodePaymentDB::HasVote(const uint256& nHash)
+{
+    return Exists(std::make_pair(DB_VOTE_INDEX, nHash));
+}
+
+std::vector<CMasternodePaymentVote> CMasternodePaymentDB::ReadVotes(int nBlockHeight)
+{
+    std::vector<CMasternodePaymentVote> vecResult;
+    std::string strPrefix = SerializeKey(std::make_pair(DB_VOTE, HeightKey(nBlockHeight)));
+
+    std::unique_ptr<leveldb::Iterator> pcursor(NewIterator());
+    for (pcursor->Seek(strPrefix); pcursor->Valid() && pcursor->key().starts_with(strPrefix); pcursor->Next()) {
+        leveldb::Slice slValue = pcursor->value();
+        try {
+            CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+            CMasternodePaymentVote vote;
+            ssValue >> vote;
+            vecResult.push_back(vote);
+        } catch (const std::exception& e) {
+            LogPrintf("CMasternodePaymentDB::%s -- skipping unreadable vote: %s\n", __func__, e.what());
+        }
+    }
+    HandleError(pcursor->status());
+    return vecResult;
+}
+
+int CMasternodePaymentDB::EraseVotesBelow(int nBlockHeight)
+{
+    std::string strPrefix(1, DB_VOTE);
+    CLevelDBBatch batch;
+    int nErased = 0;
+
+    // votes are ordered by height, stop at the first one to keep
+    std::unique_ptr<leveldb::Iterator> pcursor(NewIterator());
+    for (pcursor->Seek(strPrefix); pcursor->Valid() && pcursor->key().starts_with(strPrefix); pcursor->Next()) {
+        leveldb::Slice slKey = pcursor->key();
+        CDataStream ssKey(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
+        vote_key_t key;
+        ssKey >> key;
+        if (key.second.first.nHeight >= nBlockHeight) break;
+        batch.Erase(key);
+        batch.Erase(std::make_pair(DB_VOTE_INDEX, key.second.second));
+        ++nErased;
+    }
+    HandleError(pcursor->status());
+
+    if (nErased > 0) {
+        WriteBatch(batch);
+    }
+    return nErased;
+}
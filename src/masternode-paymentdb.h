@@ -0,0 +1,41 @@
+// Copyright (c) 2019 Cryptroxcoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef CRYPTROX_MASTERNODE_PAYMENTDB_H
+#define CRYPTROX_MASTERNODE_PAYMENTDB_H
+
+#include <memory>
+#include <vector>
+
+#include <leveldbwrapper.h>
+#include <masternode-payments.h>
+#include <uint256.h>
+
+/**
+ * On-disk store for the verified masternode payment votes.
+ * Votes are stored under (block height, vote hash) with the height written big-endian,
+ * so the votes of one block and everything below a height are single range scans,
+ * with a second key from the vote hash to its height for direct lookups.
+ */
+class CMasternodePaymentDB : public CLevelDBWrapper
+{
+public:
+    CMasternodePaymentDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+
+private:
+    CMasternodePaymentDB(const CMasternodePaymentDB&);
+    void operator=(const CMasternodePaymentDB&);
+
+public:
+    bool WriteVote(const CMasternodePaymentVote& vote);
+    bool ReadVote(const uint256& nHash, CMasternodePaymentVote& vote);
+    bool HasVote(const uint256& nHash);
+    std::vector<CMasternodePaymentVote> ReadVotes(int nBlockHeight);
+    /// Erase the votes of every block below nBlockHeight, returns the number erased
+    int EraseVotesBelow(int nBlockHeight);
+};
+
+extern std::unique_ptr<CMasternodePaymentDB> pMasternodePaymentDB;
+
+#endif // CRYPTROX_MASTERNODE_PAYMENTDB_H
@@ -6,11 +6,13 @@
 #include <activemasternode.h>
 #include <governance-classes.h>
 #include <masternode-payments.h>
+#include <masternode-paymentdb.h>
 #include <masternode-sync.h>
 #include <masternodeman.h>
 #include <messagesigner.h>
 #include <netfulfilledman.h>
 #include <netmessagemaker.h>
+#include <random.h>
 #include <spork.h>
 #include <util.h>
 
@@ -23,6 +25,10 @@ CCriticalSection cs_vecPayees;
 CCriticalSection cs_mapMasternodeBlocks;
 CCriticalSection cs_mapMasternodePaymentVotes;
 
+// CRYPTROX BEGIN
+const std::string CMasternodePayments::SERIALIZATION_VERSION_STRING = "CMasternodePayments-Version-2";
+// CRYPTROX END
+
 void FillBlockPayments(CMutableTransaction& txNew, int nBlockHeight, CAmount blockReward, CTxOut& txoutMasternodeRet)
 {
     // FILL BLOCK PAYEE WITH MASTERNODE PAYMENT OTHERWISE
@@ -42,7 +48,22 @@ void CMasternodePayments::Clear()
     LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
     mapMasternodeBlocks.clear();
     mapMasternodePaymentVotes.clear();
+    // CRYPTROX BEGIN
+    setVotesByHeight.clear();
+    mapStoredBlockVotes.clear();
+    filterStoredVotes.reset();
+    // CRYPTROX END
+}
+
+// CRYPTROX BEGIN
+void CMasternodePayments::CopyForDump(CMasternodePayments& mnpaymentsCopy)
+{
+    LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
+    mnpaymentsCopy.mapMasternodePaymentVotes = mapMasternodePaymentVotes;
+    mnpaymentsCopy.mapMasternodeBlocks = mapMasternodeBlocks;
+    mnpaymentsCopy.mapStoredBlockVotes = mapStoredBlockVotes;
 }
+// CRYPTROX END
 
 bool CMasternodePayments::CanVote(COutPoint outMasternode, int nBlockHeight)
 {
@@ -71,12 +92,12 @@ void CMasternodePayments::FillBlockPayee(CMutableTransaction& txNew, int nBlockH
     // GET MASTERNODE PAYMENT VARIABLES SETUP
     CAmount masternodePayment = GetMasternodePayment(nBlockHeight, blockReward);
 
-    std::map<COutPoint, CMasternode> mapMasternodes = mnodeman.GetFullMasternodeMap();
-    std::map<COutPoint, CMasternode>::iterator mnit = mapMasternodes.begin();
-    while (mnit != mapMasternodes.end()) {
-        if (mnit->second.IsEnabled())
+    CMasternodeMan::snapshot_t mapMasternodes = mnodeman.GetSnapshot();
+    CMasternodeMan::snapshot_map_t::const_iterator mnit = mapMasternodes->begin();
+    while (mnit != mapMasternodes->end()) {
+        if (mnit->second->IsEnabled())
         {
-            CScript payee = GetScriptForDestination(mnit->second.pubKeyCollateralAddress.GetID());
+            CScript payee = GetScriptForDestination(mnit->second->pubKeyCollateralAddress.GetID());
             txoutMasternodeRet = CTxOut(masternodePayment, payee);
             txNew.vout.push_back(txoutMasternodeRet);
 
@@ -87,7 +108,7 @@ void CMasternodePayments::FillBlockPayee(CMutableTransaction& txNew, int nBlockH
         }
         else
         {
-            LogPrint(BCLog::MNPAYMENTS, "CMasternodePayments::FillBlockPayee -- Masternode payment failed to %s - outpoint %s\n", masternodePayment, mnit->second.vin.prevout.ToStringShort());
+            LogPrint(BCLog::MNPAYMENTS, "CMasternodePayments::FillBlockPayee -- Masternode payment failed to %s - outpoint %s\n", masternodePayment, mnit->second->vin.prevout.ToStringShort());
         }
         ++mnit;
     }
@@ -143,13 +164,19 @@ void CMasternodePayments::ProcessMessage(CNode* pfrom, const std::string& strCom
 
         {
             LOCK(cs_mapMasternodePaymentVotes);
-            if(mapMasternodePaymentVotes.count(nHash)) {
+            // CRYPTROX BEGIN
+            // votes that already left memory are still known from filterStoredVotes
+            if(HasPaymentVote(nHash)) {
+            // CRYPTROX END
                 LogPrint(BCLog::MNPAYMENTS, "MASTERNODEPAYMENTVOTE -- hash=%s, nHeight=%d seen\n", nHash.ToString(), nCachedBlockHeight);
                 return;
             }
 
             // Avoid processing same vote multiple times
             mapMasternodePaymentVotes[nHash] = vote;
+            // CRYPTROX BEGIN
+            setVotesByHeight.emplace(vote.nBlockHeight, nHash);
+            // CRYPTROX END
             // but first mark vote as non-verified,
             // AddPaymentVote() below should take care of it if vote is actually ok
             mapMasternodePaymentVotes[nHash].MarkAsNotVerified();
@@ -180,38 +207,52 @@ void CMasternodePayments::ProcessMessage(CNode* pfrom, const std::string& strCom
             return;
         }
 
-        int nDos = 0;
-        if(!vote.CheckSignature(mnInfo.pubKeyMasternode, nCachedBlockHeight, nDos)) {
-            if(nDos) {
-                LOCK(cs_main);
-                LogPrintf("MASTERNODEPAYMENTVOTE -- ERROR: invalid signature\n");
-                Misbehaving(pfrom->GetId(), nDos);
-            } else {
-                // only warn about anything non-critical (i.e. nDos == 0) in debug mode
-                LogPrint(BCLog::MNPAYMENTS, "MASTERNODEPAYMENTVOTE -- WARNING: invalid signature\n");
-            }
-            // Either our info or vote info could be outdated.
-            // In case our info is outdated, ask for an update,
-            mnodeman.AskForMN(pfrom, vote.vinMasternode.prevout, connman);
-            // but there is nothing we can do if vote info itself is outdated
-            // (i.e. it was signed by a mn which changed its key),
-            // so just quit here.
-            return;
+        // CRYPTROX BEGIN
+        // the signature is verified off-thread, the vote is applied in arrival order
+        int nValidationHeight = nCachedBlockHeight;
+        messageVerifyQueue.Push(vote.GetSignatureHash(), mnInfo.pubKeyMasternode, vote.vchSig, pfrom,
+            [this, vote, nValidationHeight, &connman](bool fValidSignature, CNode* pnode) {
+                ApplyPaymentVote(vote, fValidSignature, nValidationHeight, pnode, connman);
+            });
+        // CRYPTROX END
+    }
+}
+
+// CRYPTROX BEGIN
+void CMasternodePayments::ApplyPaymentVote(const CMasternodePaymentVote& vote, bool fValidSignature, int nValidationHeight, CNode* pfrom, CConnman& connman)
+{
+    if(!fValidSignature) {
+        int nDos = vote.GetBadSignatureDoS(nValidationHeight);
+        if(nDos && pfrom) {
+            LOCK(cs_main);
+            LogPrintf("MASTERNODEPAYMENTVOTE -- ERROR: invalid signature, masternode=%s\n", vote.vinMasternode.prevout.ToStringShort());
+            Misbehaving(pfrom->GetId(), nDos);
+        } else {
+            // only warn about anything non-critical (i.e. nDos == 0) in debug mode
+            LogPrint(BCLog::MNPAYMENTS, "MASTERNODEPAYMENTVOTE -- WARNING: invalid signature, masternode=%s\n", vote.vinMasternode.prevout.ToStringShort());
         }
+        // Either our info or vote info could be outdated.
+        // In case our info is outdated, ask for an update,
+        if(pfrom) mnodeman.AskForMN(pfrom, vote.vinMasternode.prevout, connman);
+        // but there is nothing we can do if vote info itself is outdated
+        // (i.e. it was signed by a mn which changed its key),
+        // so just quit here.
+        return;
+    }
 
-        CTxDestination address1;
-        ExtractDestination(vote.payee, address1);
-        std::string address2 = EncodeDestination(address1);
+    CTxDestination address1;
+    ExtractDestination(vote.payee, address1);
+    std::string address2 = EncodeDestination(address1);
 
-        LogPrint(BCLog::MNPAYMENTS, "MASTERNODEPAYMENTVOTE -- vote: address=%s, nBlockHeight=%d, nHeight=%d, prevout=%s, hash=%s new\n",
-                    address2, vote.nBlockHeight, nCachedBlockHeight, vote.vinMasternode.prevout.ToStringShort(), nHash.ToString());
+    LogPrint(BCLog::MNPAYMENTS, "MASTERNODEPAYMENTVOTE -- vote: address=%s, nBlockHeight=%d, nHeight=%d, prevout=%s, hash=%s new\n",
+                address2, vote.nBlockHeight, nValidationHeight, vote.vinMasternode.prevout.ToStringShort(), vote.GetHash().ToString());
 
-        if(AddPaymentVote(vote)){
-            vote.Relay(connman);
-            masternodeSync.BumpAssetLastTime("MASTERNODEPAYMENTVOTE");
-        }
+    if(AddPaymentVote(vote)){
+        vote.Relay(connman);
+        masternodeSync.BumpAssetLastTime("MASTERNODEPAYMENTVOTE");
     }
 }
+// CRYPTROX END
 
 bool CMasternodePaymentVote::Sign()
 {
@@ -235,9 +276,18 @@ bool CMasternodePaymentVote::Sign()
 
 bool CMasternodePayments::GetBlockPayee(int nBlockHeight, CScript& payee)
 {
-    if(mapMasternodeBlocks.count(nBlockHeight)){
-        return mapMasternodeBlocks[nBlockHeight].GetBestPayee(payee);
+    // CRYPTROX BEGIN
+    LOCK(cs_mapMasternodeBlocks);
+
+    std::map<int, CMasternodeBlockPayees>::iterator it = mapMasternodeBlocks.find(nBlockHeight);
+    if(it != mapMasternodeBlocks.end()) {
+        return it->second.GetBestPayee(payee);
+    }
+    std::map<int, CMasternodeBlockVoteCount>::iterator itStored = mapStoredBlockVotes.find(nBlockHeight);
+    if(itStored != mapStoredBlockVotes.end()) {
+        return itStored->second.GetBestPayee(payee);
     }
+    // CRYPTROX END
 
     return false;
 }
@@ -269,11 +319,29 @@ bool CMasternodePayments::AddPaymentVote(const CMasternodePaymentVote& vote)
     uint256 blockHash = uint256();
     if(!GetBlockHash(blockHash, vote.nBlockHeight - 101)) return false;
 
-    if(HasVerifiedPaymentVote(vote.GetHash())) return false;
+    // CRYPTROX BEGIN
+    uint256 nHash = vote.GetHash();
 
     LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
 
-    mapMasternodePaymentVotes[vote.GetHash()] = vote;
+    if(vote.nBlockHeight < GetFirstMemoryBlock() || mapStoredBlockVotes.count(vote.nBlockHeight)) {
+        // blocks below the in-memory window only keep their vote counts in memory
+        if(pMasternodePaymentDB->HasVote(nHash)) return false;
+        if(!pMasternodePaymentDB->WriteVote(vote)) return false;
+        mapStoredBlockVotes[vote.nBlockHeight].AddVote(vote.payee);
+        filterStoredVotes.insert(nHash);
+        return true;
+    }
+
+    auto itVote = mapMasternodePaymentVotes.find(nHash);
+    if(itVote != mapMasternodePaymentVotes.end() && itVote->second.IsVerified()) return false;
+
+    // every verified vote is written through, so it is still around once it leaves memory
+    if(!pMasternodePaymentDB->WriteVote(vote)) return false;
+
+    mapMasternodePaymentVotes[nHash] = vote;
+    setVotesByHeight.emplace(vote.nBlockHeight, nHash);
+    // CRYPTROX END
 
     if(!mapMasternodeBlocks.count(vote.nBlockHeight)) {
        CMasternodeBlockPayees blockPayees(vote.nBlockHeight);
@@ -289,21 +357,108 @@ bool CMasternodePayments::HasVerifiedPaymentVote(uint256 hashIn)
 {
     LOCK(cs_mapMasternodePaymentVotes);
     std::map<uint256, CMasternodePaymentVote>::iterator it = mapMasternodePaymentVotes.find(hashIn);
-    return it != mapMasternodePaymentVotes.end() && it->second.IsVerified();
+    // CRYPTROX BEGIN
+    if(it != mapMasternodePaymentVotes.end() && it->second.IsVerified()) return true;
+    // only verified votes are written to the store
+    return pMasternodePaymentDB->HasVote(hashIn);
+    // CRYPTROX END
+}
+
+// CRYPTROX BEGIN
+bool CMasternodePayments::HasPaymentVote(const uint256& hashIn)
+{
+    LOCK(cs_mapMasternodePaymentVotes);
+    // a false positive only means a vote is not fetched again, AddPaymentVote() checks the store itself
+    return mapMasternodePaymentVotes.count(hashIn) || filterStoredVotes.contains(hashIn);
+}
+
+bool CMasternodePayments::GetPaymentVote(const uint256& hashIn, CMasternodePaymentVote& voteRet)
+{
+    LOCK(cs_mapMasternodePaymentVotes);
+    std::map<uint256, CMasternodePaymentVote>::iterator it = mapMasternodePaymentVotes.find(hashIn);
+    if(it != mapMasternodePaymentVotes.end() && it->second.IsVerified()) {
+        voteRet = it->second;
+        return true;
+    }
+    return pMasternodePaymentDB->ReadVote(hashIn, voteRet);
 }
 
+bool CMasternodePayments::HasBlockPayees(int nBlockHeight)
+{
+    LOCK(cs_mapMasternodeBlocks);
+    return mapMasternodeBlocks.count(nBlockHeight) || mapStoredBlockVotes.count(nBlockHeight);
+}
+
+bool CMasternodePayments::GetBlockPaymentVotes(int nBlockHeight, std::vector<CMasternodePaymentVote>& vecVotesRet)
+{
+    LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
+
+    vecVotesRet.clear();
+    if(mapStoredBlockVotes.count(nBlockHeight)) {
+        vecVotesRet = pMasternodePaymentDB->ReadVotes(nBlockHeight);
+        return true;
+    }
+
+    std::map<int, CMasternodeBlockPayees>::iterator it = mapMasternodeBlocks.find(nBlockHeight);
+    if(it == mapMasternodeBlocks.end()) return false;
+
+    for (auto& payee : it->second.vecPayees) {
+        for (const auto& hash : payee.GetVoteHashes()) {
+            std::map<uint256, CMasternodePaymentVote>::iterator itVote = mapMasternodePaymentVotes.find(hash);
+            if(itVote != mapMasternodePaymentVotes.end() && itVote->second.IsVerified()) {
+                vecVotesRet.push_back(itVote->second);
+            }
+        }
+    }
+    return true;
+}
+
+bool CMasternodePayments::HasPayeeWithVotes(int nBlockHeight, const CScript& payee, int nVotesReq)
+{
+    LOCK(cs_mapMasternodeBlocks);
+
+    std::map<int, CMasternodeBlockPayees>::iterator it = mapMasternodeBlocks.find(nBlockHeight);
+    if(it != mapMasternodeBlocks.end()) {
+        return it->second.HasPayeeWithVotes(payee, nVotesReq);
+    }
+    std::map<int, CMasternodeBlockVoteCount>::iterator itStored = mapStoredBlockVotes.find(nBlockHeight);
+    return itStored != mapStoredBlockVotes.end() && itStored->second.HasPayeeWithVotes(payee, nVotesReq);
+}
+// CRYPTROX END
+
+// CRYPTROX BEGIN
+SaltedScriptHasher::SaltedScriptHasher() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
+
+void CMasternodeBlockPayees::RebuildIndex()
+{
+    LOCK(cs_vecPayees);
+
+    mapPayeeIndex.clear();
+    nMaxVotes = 0;
+    for (size_t i = 0; i < vecPayees.size(); ++i) {
+        mapPayeeIndex.emplace(vecPayees[i].GetPayee(), i);
+        nMaxVotes = std::max(nMaxVotes, vecPayees[i].GetVoteCount());
+    }
+}
+// CRYPTROX END
+
 void CMasternodeBlockPayees::AddPayee(const CMasternodePaymentVote& vote)
 {
     LOCK(cs_vecPayees);
 
-    for (auto& payee : vecPayees) {
-        if (payee.GetPayee() == vote.payee) {
-            payee.AddVoteHash(vote.GetHash());
-            return;
-        }
+    // CRYPTROX BEGIN
+    auto it = mapPayeeIndex.find(vote.payee);
+    if (it != mapPayeeIndex.end()) {
+        CMasternodePayee& payee = vecPayees[it->second];
+        payee.AddVoteHash(vote.GetHash());
+        nMaxVotes = std::max(nMaxVotes, payee.GetVoteCount());
+        return;
     }
     CMasternodePayee payeeNew(vote.payee, vote.GetHash());
+    mapPayeeIndex.emplace(vote.payee, vecPayees.size());
     vecPayees.push_back(payeeNew);
+    nMaxVotes = std::max(nMaxVotes, 1);
+    // CRYPTROX END
 }
 
 bool CMasternodeBlockPayees::GetBestPayee(CScript& payeeRet)
@@ -330,11 +485,12 @@ bool CMasternodeBlockPayees::HasPayeeWithVotes(const CScript& payeeIn, int nVote
 {
     LOCK(cs_vecPayees);
 
-    for (auto& payee : vecPayees) {
-        if (payee.GetVoteCount() >= nVotesReq && payee.GetPayee() == payeeIn) {
-            return true;
-        }
+    // CRYPTROX BEGIN
+    auto it = mapPayeeIndex.find(payeeIn);
+    if (it != mapPayeeIndex.end() && vecPayees[it->second].GetVoteCount() >= nVotesReq) {
+        return true;
     }
+    // CRYPTROX END
 
     LogPrint(BCLog::MNPAYMENTS, "CMasternodeBlockPayees::HasPayeeWithVotes -- ERROR: couldn't find any payee with %d+ votes\n", nVotesReq);
     return false;
@@ -342,33 +498,32 @@ bool CMasternodeBlockPayees::HasPayeeWithVotes(const CScript& payeeIn, int nVote
 
 bool CMasternodeBlockPayees::IsTransactionValid(const CTransactionRef txNew)
 {
-    LOCK(cs_vecPayees);
-
-    int nMaxSignatures = 0;
-    std::string strPayeesPossible = "";
-
     CAmount nMasternodePayment = GetMasternodePayment(nBlockHeight, txNew->GetValueOut());
 
+    LOCK(cs_vecPayees);
+
     //require at least MNPAYMENTS_SIGNATURES_REQUIRED signatures
 
-    for (auto& payee : vecPayees) {
-        if (payee.GetVoteCount() >= nMaxSignatures) {
-            nMaxSignatures = payee.GetVoteCount();
+    // if we don't have at least MNPAYMENTS_SIGNATURES_REQUIRED signatures on a payee, approve whichever is the longest chain
+    if(nMaxVotes < MNPAYMENTS_SIGNATURES_REQUIRED) return true;
+
+    // CRYPTROX BEGIN
+    // only outputs of exactly the masternode payment can match, look their scripts up in the payee index
+    for (const auto& txout : txNew->vout) {
+        if (txout.nValue != nMasternodePayment) continue;
+        auto it = mapPayeeIndex.find(txout.scriptPubKey);
+        if (it != mapPayeeIndex.end() && vecPayees[it->second].GetVoteCount() >= MNPAYMENTS_SIGNATURES_REQUIRED) {
+            LogPrint(BCLog::MNPAYMENTS, "CMasternodeBlockPayees::IsTransactionValid -- Found required payment\n");
+            return true;
         }
     }
 
-    // if we don't have at least MNPAYMENTS_SIGNATURES_REQUIRED signatures on a payee, approve whichever is the longest chain
-    if(nMaxSignatures < MNPAYMENTS_SIGNATURES_REQUIRED) return true;
+    // no match, build the list of possible payees for the error message
+    std::string strPayeesPossible = "";
+    // CRYPTROX END
 
     for (auto& payee : vecPayees) {
         if (payee.GetVoteCount() >= MNPAYMENTS_SIGNATURES_REQUIRED) {
-            for (auto txout : txNew->vout) {
-                if (payee.GetPayee() == txout.scriptPubKey && nMasternodePayment == txout.nValue) {
-                    LogPrint(BCLog::MNPAYMENTS, "CMasternodeBlockPayees::IsTransactionValid -- Found required payment\n");
-                    return true;
-                }
-            }
-
             CTxDestination address1;
             ExtractDestination(payee.GetPayee(), address1);
             std::string address2 = EncodeDestination(address1);
@@ -407,13 +562,80 @@ std::string CMasternodeBlockPayees::GetRequiredPaymentsString()
     return strRequiredPayments;
 }
 
+// CRYPTROX BEGIN
+CMasternodeBlockVoteCount CMasternodeBlockPayees::GetVoteCount()
+{
+    LOCK(cs_vecPayees);
+
+    CMasternodeBlockVoteCount count;
+    count.nMaxVotes = nMaxVotes;
+    for (auto& payee : vecPayees) {
+        count.nTotalVotes += payee.GetVoteCount();
+        count.mapPayeeVotes[payee.GetPayee()] = payee.GetVoteCount();
+    }
+    return count;
+}
+
+bool CMasternodeBlockVoteCount::GetBestPayee(CScript& payeeRet) const
+{
+    int nVotes = -1;
+    for (const auto& payeepair : mapPayeeVotes) {
+        if (payeepair.second > nVotes) {
+            payeeRet = payeepair.first;
+            nVotes = payeepair.second;
+        }
+    }
+    return (nVotes > -1);
+}
+
+bool CMasternodeBlockVoteCount::HasPayeeWithVotes(const CScript& payeeIn, int nVotesReq) const
+{
+    auto it = mapPayeeVotes.find(payeeIn);
+    return it != mapPayeeVotes.end() && it->second >= nVotesReq;
+}
+
+bool CMasternodeBlockVoteCount::IsTransactionValid(const CTransactionRef txNew, int nBlockHeight) const
+{
+    if(nMaxVotes < MNPAYMENTS_SIGNATURES_REQUIRED) return true;
+
+    CAmount nMasternodePayment = GetMasternodePayment(nBlockHeight, txNew->GetValueOut());
+    for (const auto& txout : txNew->vout) {
+        if (txout.nValue == nMasternodePayment && HasPayeeWithVotes(txout.scriptPubKey, MNPAYMENTS_SIGNATURES_REQUIRED)) {
+            return true;
+        }
+    }
+
+    LogPrintf("CMasternodeBlockVoteCount::IsTransactionValid -- ERROR: Missing required payment, nBlockHeight=%d, amount: %f DASH\n", nBlockHeight, (float)nMasternodePayment/COIN);
+    return false;
+}
+
+std::string CMasternodeBlockVoteCount::GetRequiredPaymentsString() const
+{
+    std::string strRequiredPayments;
+    for (const auto& payeepair : mapPayeeVotes) {
+        CTxDestination dest;
+        ExtractDestination(payeepair.first, dest);
+        if (!strRequiredPayments.empty()) strRequiredPayments += ", ";
+        strRequiredPayments += EncodeDestination(dest) + ":" + boost::lexical_cast<std::string>(payeepair.second);
+    }
+    return strRequiredPayments.empty() ? "Unknown" : strRequiredPayments;
+}
+// CRYPTROX END
+
 std::string CMasternodePayments::GetRequiredPaymentsString(int nBlockHeight)
 {
     LOCK(cs_mapMasternodeBlocks);
 
-    if(mapMasternodeBlocks.count(nBlockHeight)){
-        return mapMasternodeBlocks[nBlockHeight].GetRequiredPaymentsString();
+    // CRYPTROX BEGIN
+    std::map<int, CMasternodeBlockPayees>::iterator it = mapMasternodeBlocks.find(nBlockHeight);
+    if(it != mapMasternodeBlocks.end()) {
+        return it->second.GetRequiredPaymentsString();
     }
+    std::map<int, CMasternodeBlockVoteCount>::iterator itStored = mapStoredBlockVotes.find(nBlockHeight);
+    if(itStored != mapStoredBlockVotes.end()) {
+        return itStored->second.GetRequiredPaymentsString();
+    }
+    // CRYPTROX END
 
     return "Unknown";
 }
@@ -422,9 +644,16 @@ bool CMasternodePayments::IsTransactionValid(const CTransactionRef txNew, int nB
 {
     LOCK(cs_mapMasternodeBlocks);
 
-    if(mapMasternodeBlocks.count(nBlockHeight)){
-        return mapMasternodeBlocks[nBlockHeight].IsTransactionValid(txNew);
+    // CRYPTROX BEGIN
+    std::map<int, CMasternodeBlockPayees>::iterator it = mapMasternodeBlocks.find(nBlockHeight);
+    if(it != mapMasternodeBlocks.end()) {
+        return it->second.IsTransactionValid(txNew);
+    }
+    std::map<int, CMasternodeBlockVoteCount>::iterator itStored = mapStoredBlockVotes.find(nBlockHeight);
+    if(itStored != mapStoredBlockVotes.end()) {
+        return itStored->second.IsTransactionValid(txNew, nBlockHeight);
     }
+    // CRYPTROX END
 
     return true;
 }
@@ -435,20 +664,37 @@ void CMasternodePayments::CheckAndRemove()
 
     LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
 
-    int nLimit = GetStorageLimit();
-
-    std::map<uint256, CMasternodePaymentVote>::iterator it = mapMasternodePaymentVotes.begin();
-    while(it != mapMasternodePaymentVotes.end()) {
-        CMasternodePaymentVote vote = (*it).second;
+    // CRYPTROX BEGIN
+    CMasternodeMaintenanceTimer timer(MN_MAINTENANCE_PAYMENTS);
 
-        if(nCachedBlockHeight - vote.nBlockHeight > nLimit) {
-            LogPrint(BCLog::MNPAYMENTS, "CMasternodePayments::CheckAndRemove -- Removing old Masternode payment: nBlockHeight=%d\n", vote.nBlockHeight);
-            mapMasternodePaymentVotes.erase(it++);
-            mapMasternodeBlocks.erase(vote.nBlockHeight);
-        } else {
-            ++it;
+    int nLimit = GetStorageLimit();
+    int nFirstMemoryBlock = GetFirstMemoryBlock();
+
+    // only the votes below the in-memory window are visited, verified ones are already in the store
+    while(!setVotesByHeight.empty() && setVotesByHeight.begin()->first < nFirstMemoryBlock) {
+        int nBlockHeight = setVotesByHeight.begin()->first;
+        std::map<int, CMasternodeBlockPayees>::iterator it = mapMasternodeBlocks.find(nBlockHeight);
+        if(it != mapMasternodeBlocks.end()) {
+            mapStoredBlockVotes[nBlockHeight] = it->second.GetVoteCount();
+            mapMasternodeBlocks.erase(it);
         }
+        std::map<uint256, CMasternodePaymentVote>::iterator itVote = mapMasternodePaymentVotes.find(setVotesByHeight.begin()->second);
+        if(itVote != mapMasternodePaymentVotes.end()) {
+            if(itVote->second.IsVerified()) filterStoredVotes.insert(itVote->first);
+            mapMasternodePaymentVotes.erase(itVote);
+        }
+        setVotesByHeight.erase(setVotesByHeight.begin());
+        timer.nItems++;
+    }
+
+    // blocks below the storage limit are dropped from the store as well
+    int nFirstBlock = nCachedBlockHeight - nLimit;
+    while(!mapStoredBlockVotes.empty() && mapStoredBlockVotes.begin()->first < nFirstBlock) {
+        LogPrint(BCLog::MNPAYMENTS, "CMasternodePayments::CheckAndRemove -- Removing old Masternode payment: nBlockHeight=%d\n", mapStoredBlockVotes.begin()->first);
+        mapStoredBlockVotes.erase(mapStoredBlockVotes.begin());
     }
+    timer.nItems += pMasternodePaymentDB->EraseVotesBelow(nFirstBlock);
+    // CRYPTROX END
     LogPrintf("CMasternodePayments::CheckAndRemove -- %s\n", ToString());
 }
 
@@ -637,7 +883,7 @@ void CMasternodePayments::CheckPreviousBlockVotes(int nPrevBlockHeight)
     LogPrint(BCLog::MNPAYMENTS, "%s\n", debugStr);
 }
 
-void CMasternodePaymentVote::Relay(CConnman& connman)
+void CMasternodePaymentVote::Relay(CConnman& connman) const
 {
     // Do not relay until fully synced
     if(!masternodeSync.IsSynced()) {
@@ -649,28 +895,27 @@ void CMasternodePaymentVote::Relay(CConnman& connman)
     connman.RelayInv(inv);
 }
 
-bool CMasternodePaymentVote::CheckSignature(const CPubKey& pubKeyMasternode, int nValidationHeight, int &nDos)
+// CRYPTROX BEGIN
+uint256 CMasternodePaymentVote::GetSignatureHash() const
 {
-    // do not ban by default
-    nDos = 0;
-
     std::string strMessage = vinMasternode.prevout.ToStringShort() +
                 boost::lexical_cast<std::string>(nBlockHeight) +
                 ScriptToAsmStr(payee);
 
-    std::string strError = "";
-    if (!CMessageSigner::VerifyMessage(pubKeyMasternode, vchSig, strMessage, strError)) {
-        // Only ban for future block vote when we are already synced.
-        // Otherwise it could be the case when MN which signed this vote is using another key now
-        // and we have no idea about the old one.
-        if(masternodeSync.IsMasternodeListSynced() && nBlockHeight > nValidationHeight) {
-            nDos = 20;
-        }
-        return error("CMasternodePaymentVote::CheckSignature -- Got bad Masternode payment signature, masternode=%s, error: %s", vinMasternode.prevout.ToStringShort().c_str(), strError);
-    }
+    return CMessageSigner::GetMessageHash(strMessage);
+}
 
-    return true;
+int CMasternodePaymentVote::GetBadSignatureDoS(int nValidationHeight) const
+{
+    // Only ban for future block vote when we are already synced.
+    // Otherwise it could be the case when MN which signed this vote is using another key now
+    // and we have no idea about the old one.
+    if(masternodeSync.IsMasternodeListSynced() && nBlockHeight > nValidationHeight) {
+        return 20;
+    }
+    return 0;
 }
+// CRYPTROX END
 
 std::string CMasternodePaymentVote::ToString() const
 {
@@ -723,7 +968,7 @@ void CMasternodePayments::RequestLowDataPaymentBlocks(CNode* pnode, CConnman& co
     const CBlockIndex *pindex = chainActive.Tip();
 
     while(nCachedBlockHeight - pindex->nHeight < nLimit) {
-        if(!mapMasternodeBlocks.count(pindex->nHeight)) {
+        if(!mapMasternodeBlocks.count(pindex->nHeight) && !mapStoredBlockVotes.count(pindex->nHeight)) { // CRYPTROX
             // We have no idea about this block height, let's ask
             vToFetch.push_back(CInv(MSG_MASTERNODE_PAYMENT_BLOCK, pindex->GetBlockHash()));
             // We should not violate GETDATA rules
@@ -783,6 +1028,21 @@ void CMasternodePayments::RequestLowDataPaymentBlocks(CNode* pnode, CConnman& co
         }
         ++it;
     }
+    // CRYPTROX BEGIN
+    // the same for the blocks whose votes are only in the store
+    for (const auto& countpair : mapStoredBlockVotes) {
+        if(!countpair.second.IsLowData()) continue;
+        uint256 hash;
+        if(GetBlockHash(hash, countpair.first)) {
+            vToFetch.push_back(CInv(MSG_MASTERNODE_PAYMENT_BLOCK, hash));
+        }
+        if(vToFetch.size() == MAX_INV_SZ) {
+            LogPrintf("CMasternodePayments::SyncLowDataPaymentBlocks -- asking peer %d for %d payment blocks\n", pnode->GetId(), MAX_INV_SZ);
+            connman.PushMessage(pnode, CNetMsgMaker(pnode->GetSendVersion()).Make(NetMsgType::GETDATA, vToFetch));
+            vToFetch.clear();
+        }
+    }
+    // CRYPTROX END
     // Ask for the rest of it
     if(!vToFetch.empty()) {
         LogPrintf("CMasternodePayments::SyncLowDataPaymentBlocks -- asking peer %d for %d payment blocks\n", pnode->GetId(), vToFetch.size());
@@ -795,7 +1055,8 @@ std::string CMasternodePayments::ToString() const
     std::ostringstream info;
 
     info << "Votes: " << (int)mapMasternodePaymentVotes.size() <<
-            ", Blocks: " << (int)mapMasternodeBlocks.size();
+            ", Blocks: " << (int)mapMasternodeBlocks.size() <<
+            ", Stored blocks: " << (int)mapStoredBlockVotes.size(); // CRYPTROX
 
     return info.str();
 }
@@ -807,6 +1068,24 @@ bool CMasternodePayments::IsEnoughData()
     return GetBlockCount() > nStorageLimit && GetVoteCount() > nStorageLimit * nAverageVotes;
 }
 
+// CRYPTROX BEGIN
+int CMasternodePayments::GetBlockCount()
+{
+    LOCK(cs_mapMasternodeBlocks);
+    return mapMasternodeBlocks.size() + mapStoredBlockVotes.size();
+}
+
+int CMasternodePayments::GetVoteCount()
+{
+    LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
+    int nCount = mapMasternodePaymentVotes.size();
+    for (const auto& countpair : mapStoredBlockVotes) {
+        nCount += countpair.second.nTotalVotes;
+    }
+    return nCount;
+}
+// CRYPTROX END
+
 int CMasternodePayments::GetStorageLimit()
 {
     return std::max(int(mnodeman.size() * nStorageCoeff), nMinBlocksToStore);
@@ -6,19 +6,27 @@
 #ifndef CRYPTROX_MASTERNODE_PAYMENTS_H
 #define CRYPTROX_MASTERNODE_PAYMENTS_H
 
+#include <bloom.h>
 #include <util.h>
 #include <core_io.h>
+#include <hash.h>
 #include <key.h>
 #include <masternode.h>
 #include <net_processing.h>
 #include <utilstrencodings.h>
 
+#include <unordered_map>
+
 class CMasternodePayments;
 class CMasternodePaymentVote;
 class CMasternodeBlockPayees;
 
 static const int MNPAYMENTS_SIGNATURES_REQUIRED         = 6;
 static const int MNPAYMENTS_SIGNATURES_TOTAL            = 10;
+// CRYPTROX BEGIN
+//! payment blocks below the tip whose votes are kept in memory, older votes only live in pMasternodePaymentDB
+static const int MNPAYMENTS_MEMORY_BLOCKS               = 100;
+// CRYPTROX END
 
 //! minimum peer version that can receive and send masternode payment messages,
 //  vote for masternode and be elected as a payment winner
@@ -29,7 +37,7 @@ static const int MIN_MASTERNODE_PAYMENT_PROTO_VERSION_2 = 70208;
 
 extern CCriticalSection cs_vecPayees;
 extern CCriticalSection cs_mapMasternodeBlocks;
-extern CCriticalSection cs_mapMasternodePayeeVotes;
+extern CCriticalSection cs_mapMasternodePaymentVotes;
 
 extern CMasternodePayments mnpayments;
 
@@ -73,18 +81,81 @@ public:
     int GetVoteCount() { return vecVoteHashes.size(); }
 };
 
+// CRYPTROX BEGIN
+/** SipHash of a payee script with a per-instance random salt */
+class SaltedScriptHasher
+{
+private:
+    uint64_t k0, k1;
+
+public:
+    SaltedScriptHasher();
+
+    size_t operator()(const CScript& script) const {
+        return CSipHasher(k0, k1).Write(script.data(), script.size()).Finalize();
+    }
+};
+
+/** Vote counts of a payment block, all that is kept in memory once its votes are only on disk */
+struct CMasternodeBlockVoteCount
+{
+    int nMaxVotes;
+    int nTotalVotes;
+    /// Votes per payee script, enough to answer payee queries without reading the votes back
+    std::map<CScript, int> mapPayeeVotes;
+
+    CMasternodeBlockVoteCount() : nMaxVotes(0), nTotalVotes(0) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(nMaxVotes);
+        READWRITE(nTotalVotes);
+        READWRITE(mapPayeeVotes);
+    }
+
+    void AddVote(const CScript& payee) {
+        nMaxVotes = std::max(nMaxVotes, ++mapPayeeVotes[payee]);
+        nTotalVotes++;
+    }
+
+    bool GetBestPayee(CScript& payeeRet) const;
+    bool HasPayeeWithVotes(const CScript& payeeIn, int nVotesReq) const;
+    bool IsTransactionValid(const CTransactionRef txNew, int nBlockHeight) const;
+    std::string GetRequiredPaymentsString() const;
+
+    /// Neither a clear winner nor the average number of votes, worth asking peers for more
+    bool IsLowData() const {
+        return nMaxVotes < MNPAYMENTS_SIGNATURES_REQUIRED && nTotalVotes < (MNPAYMENTS_SIGNATURES_TOTAL + MNPAYMENTS_SIGNATURES_REQUIRED)/2;
+    }
+};
+// CRYPTROX END
+
 // Keep track of votes for payees from masternodes
 class CMasternodeBlockPayees
 {
+// CRYPTROX BEGIN
+private:
+    /// Position of each payee script in vecPayees
+    std::unordered_map<CScript, size_t, SaltedScriptHasher> mapPayeeIndex;
+    /// Highest vote count of any payee, vote counts only ever grow
+    int nMaxVotes;
+
+    void RebuildIndex();
+// CRYPTROX END
+
 public:
     int nBlockHeight;
     std::vector<CMasternodePayee> vecPayees;
 
     CMasternodeBlockPayees() :
+        nMaxVotes(0),
         nBlockHeight(0),
         vecPayees()
         {}
     CMasternodeBlockPayees(int nBlockHeightIn) :
+        nMaxVotes(0),
         nBlockHeight(nBlockHeightIn),
         vecPayees()
         {}
@@ -95,6 +166,11 @@ public:
     inline void SerializationOp(Stream& s, Operation ser_action) {
         READWRITE(nBlockHeight);
         READWRITE(vecPayees);
+        // CRYPTROX BEGIN
+        if (ser_action.ForRead()) {
+            RebuildIndex();
+        }
+        // CRYPTROX END
     }
 
     void AddPayee(const CMasternodePaymentVote& vote);
@@ -104,6 +180,8 @@ public:
     bool IsTransactionValid(const CTransactionRef txNew);
 
     std::string GetRequiredPaymentsString();
+
+    CMasternodeBlockVoteCount GetVoteCount(); // CRYPTROX
 };
 
 // vote for the winning payment
@@ -149,10 +227,14 @@ public:
     }
 
     bool Sign();
-    bool CheckSignature(const CPubKey& pubKeyMasternode, int nValidationHeight, int &nDos);
+    // CRYPTROX BEGIN
+    uint256 GetSignatureHash() const;
+    /// Misbehavior score of a bad signature, only votes for future blocks are punished once synced
+    int GetBadSignatureDoS(int nValidationHeight) const;
+    // CRYPTROX END
 
     bool IsValid(CNode* pnode, int nValidationHeight, std::string& strError, CConnman& connman);
-    void Relay(CConnman& connman);
+    void Relay(CConnman& connman) const;
 
     bool IsVerified() { return !vchSig.empty(); }
     void MarkAsNotVerified() { vchSig.clear(); }
@@ -176,26 +258,80 @@ private:
     // Keep track of current block height
     int nCachedBlockHeight;
 
+    // CRYPTROX BEGIN
+    static const std::string SERIALIZATION_VERSION_STRING;
+
+    // mapMasternodePaymentVotes ordered by height, lets CheckAndRemove() stop at the first vote to keep
+    std::set<std::pair<int, uint256> > setVotesByHeight;
+    // Vote counts of the blocks below the in-memory window whose votes are in pMasternodePaymentDB
+    std::map<int, CMasternodeBlockVoteCount> mapStoredBlockVotes;
+
+    // Hashes of the verified votes that left memory, lets HasPaymentVote() answer without reading the store
+    CRollingBloomFilter filterStoredVotes;
+
+    int GetFirstMemoryBlock() { return nCachedBlockHeight - MNPAYMENTS_MEMORY_BLOCKS; }
+    // CRYPTROX END
+
 public:
+    // CRYPTROX BEGIN
+    // only the blocks from GetFirstMemoryBlock() on, see mapStoredBlockVotes for older ones
+    // CRYPTROX END
     std::map<uint256, CMasternodePaymentVote> mapMasternodePaymentVotes;
     std::map<int, CMasternodeBlockPayees> mapMasternodeBlocks;
     std::map<COutPoint, int> mapMasternodesLastVote;
     std::map<COutPoint, int> mapMasternodesDidNotVote;
 
-    CMasternodePayments() : nStorageCoeff(1.25), nMinBlocksToStore(5000) {}
+    CMasternodePayments() : nStorageCoeff(1.25), nMinBlocksToStore(5000), nCachedBlockHeight(0), filterStoredVotes(5000 * MNPAYMENTS_SIGNATURES_TOTAL, 0.000001) {} // CRYPTROX
 
     ADD_SERIALIZE_METHODS;
 
     template <typename Stream, typename Operation>
     inline void SerializationOp(Stream& s, Operation ser_action) {
+        // CRYPTROX BEGIN
+        // only the copies taken by CopyForDump are written while running, see FLATDB_CHECKPOINT_INTERVAL
+        std::string strVersion;
+        if(ser_action.ForRead()) {
+            READWRITE(strVersion);
+        }
+        else {
+            strVersion = SERIALIZATION_VERSION_STRING;
+            READWRITE(strVersion);
+        }
+        // CRYPTROX END
         READWRITE(mapMasternodePaymentVotes);
         READWRITE(mapMasternodeBlocks);
+        // CRYPTROX BEGIN
+        READWRITE(mapStoredBlockVotes);
+        if(ser_action.ForRead()) {
+            setVotesByHeight.clear();
+            for (const auto& votepair : mapMasternodePaymentVotes) {
+                setVotesByHeight.emplace(votepair.second.nBlockHeight, votepair.first);
+            }
+            if(strVersion != SERIALIZATION_VERSION_STRING) {
+                Clear();
+            }
+        }
+        // CRYPTROX END
     }
 
     void Clear();
+    // CRYPTROX BEGIN
+    /// Copy the state that is serialized into an empty instance, see CFlatDB::Dump
+    void CopyForDump(CMasternodePayments& mnpaymentsCopy);
+    // CRYPTROX END
 
     bool AddPaymentVote(const CMasternodePaymentVote& vote);
     bool HasVerifiedPaymentVote(uint256 hashIn);
+    // CRYPTROX BEGIN
+    /// Known vote, from memory only so it can be asked under cs_main (AlreadyHave)
+    bool HasPaymentVote(const uint256& hashIn);
+    /// Get a verified vote from memory or from pMasternodePaymentDB, don't call it under cs_main
+    bool GetPaymentVote(const uint256& hashIn, CMasternodePaymentVote& voteRet);
+    bool HasBlockPayees(int nBlockHeight);
+    /// Get the verified votes of a block, returns false if the block is unknown. Don't call it under cs_main
+    bool GetBlockPaymentVotes(int nBlockHeight, std::vector<CMasternodePaymentVote>& vecVotesRet);
+    bool HasPayeeWithVotes(int nBlockHeight, const CScript& payee, int nVotesReq);
+    // CRYPTROX END
     bool ProcessBlock(int nBlockHeight, CConnman& connman);
     void CheckPreviousBlockVotes(int nPrevBlockHeight);
 
@@ -211,12 +347,18 @@ public:
 
     int GetMinMasternodePaymentsProto();
     void ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman);
+    // CRYPTROX BEGIN
+    /// Add and relay a vote received from pfrom once its signature was checked against the masternode key
+    void ApplyPaymentVote(const CMasternodePaymentVote& vote, bool fValidSignature, int nValidationHeight, CNode* pfrom, CConnman& connman);
+    // CRYPTROX END
     std::string GetRequiredPaymentsString(int nBlockHeight);
     void FillBlockPayee(CMutableTransaction& txNew, int nBlockHeight, CAmount blockReward, CTxOut& txoutMasternodeRet);
     std::string ToString() const;
 
-    int GetBlockCount() { return mapMasternodeBlocks.size(); }
-    int GetVoteCount() { return mapMasternodePaymentVotes.size(); }
+    // CRYPTROX BEGIN
+    int GetBlockCount();
+    int GetVoteCount();
+    // CRYPTROX END
 
     bool IsEnoughData();
     int GetStorageLimit();
@@ -4,6 +4,9 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <activemasternode.h>
+#include <clientversion.h>
+#include <crypto/common.h>
+#include <index/payeeindex.h>
 #include <init.h>
 #include <key_io.h>
 #include <netbase.h>
@@ -17,10 +20,17 @@
 #include <shutdown.h>
 // CRYPTROX END
 #include <util.h>
+#include <validation.h>
 #ifdef ENABLE_WALLET
 #include <wallet/wallet.h>
 #endif // ENABLE_WALLET
 
+// CRYPTROX BEGIN
+#include <atomic>
+#include <limits>
+#include <thread>
+// CRYPTROX END
+
 #include <boost/lexical_cast.hpp>
 
 
@@ -44,7 +54,8 @@ CMasternode::CMasternode(const CMasternode& other) :
     nPoSeBanScore(other.nPoSeBanScore),
     nPoSeBanHeight(other.nPoSeBanHeight),
     fAllowMixingTx(other.fAllowMixingTx),
-    fUnitTest(other.fUnitTest)
+    fUnitTest(other.fUnitTest),
+    fCollateralSpent(other.fCollateralSpent)
 {}
 
 CMasternode::CMasternode(const CMasternodeBroadcast& mnb) :
@@ -105,6 +116,58 @@ arith_uint256 CMasternode::CalculateScore(const uint256& blockHash)
     return UintToArith256(ss.GetHash());
 }
 
+// CRYPTROX BEGIN
+CMasternodeScoreHasher::CMasternodeScoreHasher(const COutPoint& outpoint, const uint256& nCollateralMinConfBlockHash)
+{
+    // same bytes as CHashWriter << outpoint << nCollateralMinConfBlockHash
+    unsigned char n[4];
+    WriteLE32(n, outpoint.n);
+    hasher.Write(outpoint.hash.begin(), 32).Write(n, 4).Write(nCollateralMinConfBlockHash.begin(), 32);
+}
+
+arith_uint256 CMasternodeScoreHasher::CalculateScore(const uint256& blockHash) const
+{
+    uint256 hash1, hash2;
+    CSHA256(hasher).Write(blockHash.begin(), 32).Finalize(hash1.begin());
+    CSHA256().Write(hash1.begin(), 32).Finalize(hash2.begin());
+    return UintToArith256(hash2);
+}
+
+/** Masternodes scored by a thread before it takes the next range */
+static const size_t MASTERNODE_SCORE_CHUNK_SIZE = 256;
+
+void CalculateMasternodeScores(const std::vector<CMasternodeScoreHasher>& vHashers, const uint256& blockHash, std::vector<arith_uint256>& vScoresRet, int nThreads)
+{
+    vScoresRet.resize(vHashers.size());
+
+    // scores are cached per block hash, so this runs rarely: the extra threads
+    // live for one call only and only when there is a chunk for each of them
+    if (nThreads <= 0) nThreads = std::max(nScriptCheckThreads, 1);
+    size_t nChunks = (vHashers.size() + MASTERNODE_SCORE_CHUNK_SIZE - 1) / MASTERNODE_SCORE_CHUNK_SIZE;
+    nThreads = std::max<int>(std::min<size_t>(nThreads, nChunks), 1);
+
+    std::atomic<size_t> nNext(0);
+    auto score = [&] {
+        size_t nBegin;
+        while ((nBegin = nNext.fetch_add(MASTERNODE_SCORE_CHUNK_SIZE)) < vHashers.size()) {
+            size_t nEnd = std::min(nBegin + MASTERNODE_SCORE_CHUNK_SIZE, vHashers.size());
+            for (size_t i = nBegin; i < nEnd; i++) {
+                vScoresRet[i] = vHashers[i].CalculateScore(blockHash);
+            }
+        }
+    };
+
+    std::vector<std::thread> vThreads;
+    for (int i = 1; i < nThreads; i++) {
+        vThreads.emplace_back(score);
+    }
+    score();
+    for (auto& thread : vThreads) {
+        thread.join();
+    }
+}
+// CRYPTROX END
+
 CMasternode::CollateralStatus CMasternode::CheckCollateral(const COutPoint& outpoint)
 {
     int nHeight;
@@ -202,6 +265,16 @@ void CMasternode::Check(bool fForce)
     // Don't need to check because masternode list is based on blockchain
     //once spent, stop doing the checks
     //if(IsOutpointSpent()) return;
+
+    // The collateral is not looked up here, CMasternodeMan::UpdateCollaterals
+    // flags it as soon as a connected block spends it
+    if(fCollateralSpent) {
+        if(nActiveState != MASTERNODE_OUTPOINT_SPENT) {
+            nActiveState = MASTERNODE_OUTPOINT_SPENT;
+            LogPrint(BCLog::MASTERNODE, "CMasternode::Check -- Masternode UTXO was spent, masternode=%s\n", vin.prevout.ToStringShort());
+        }
+        return;
+    }
     // CRYPTROX END
 
     int nHeight = 0;
@@ -326,6 +399,25 @@ void CMasternode::Check(bool fForce)
     }
 }
 
+// CRYPTROX BEGIN
+int64_t CMasternode::GetNextCheckTime()
+{
+    LOCK(cs);
+
+    // a spent collateral is final and a PoSe ban ends at a height, not at a time
+    if(fCollateralSpent || IsPoSeBanned() || lastPing == CMasternodePing()) return std::numeric_limits<int64_t>::max();
+
+    int64_t nNow = GetAdjustedTime();
+    int64_t nNextTime = std::numeric_limits<int64_t>::max();
+    for (int nSeconds : {MASTERNODE_MIN_MNP_SECONDS, MASTERNODE_EXPIRATION_SECONDS, MASTERNODE_NEW_START_REQUIRED_SECONDS}) {
+        // IsPingedWithin(nSeconds) turns false at this time
+        int64_t nTime = lastPing.sigTime + nSeconds;
+        if(nTime > nNow && nTime < nNextTime) nNextTime = nTime;
+    }
+    return nNextTime;
+}
+// CRYPTROX END
+
 bool CMasternode::IsInputAssociatedWithPubkey()
 {
     CScript payee;
@@ -401,11 +493,27 @@ void CMasternode::UpdateLastPaid(const CBlockIndex *pindex, int nMaxBlocksToScan
     CScript mnpayee = GetScriptForDestination(pubKeyCollateralAddress.GetID());
     // LogPrint(BCLog::MASTERNODE, "CMasternode::UpdateLastPaidBlock -- searching for block with payment to %s\n", vin.prevout.ToStringShort());
 
-    LOCK(cs_mapMasternodeBlocks);
+    // CRYPTROX BEGIN
+    // The payee index already knows the last coinbase that paid us, including that there was none.
+    // Only the blocks it has not caught up with yet are scanned, all of them while it is still syncing
+    // or following another branch.
+    const CBlockIndex* pindexIndexed = nullptr;
+    int nHeightIndexed = -1;
+    int64_t nTimeIndexed = 0;
+    int nScanStopHeight = nBlockLastPaid;
+    if (g_payeeindex && g_payeeindex->IsSynced() &&
+        g_payeeindex->FindLastPayment(mnpayee, pindexIndexed, nHeightIndexed, nTimeIndexed) &&
+        pindexIndexed->nHeight <= pindex->nHeight && pindex->GetAncestor(pindexIndexed->nHeight) == pindexIndexed) {
+        nScanStopHeight = std::max(nScanStopHeight, pindexIndexed->nHeight);
+    } else {
+        pindexIndexed = nullptr;
+    }
 
-    for (int i = 0; BlockReading && BlockReading->nHeight > nBlockLastPaid && i < nMaxBlocksToScanBack; i++) {
-        if(mnpayments.mapMasternodeBlocks.count(BlockReading->nHeight) &&
-            mnpayments.mapMasternodeBlocks[BlockReading->nHeight].HasPayeeWithVotes(mnpayee, 2))
+    for (int i = 0; BlockReading && BlockReading->nHeight > nScanStopHeight && i < nMaxBlocksToScanBack; i++) {
+    // CRYPTROX END
+        // CRYPTROX BEGIN
+        if(mnpayments.HasPayeeWithVotes(BlockReading->nHeight, mnpayee, 2))
+        // CRYPTROX END
         {
             CBlock block;
             if(!ReadBlockFromDisk(block, BlockReading, Params().GetConsensus())) // shouldn't really happen
@@ -426,6 +534,14 @@ void CMasternode::UpdateLastPaid(const CBlockIndex *pindex, int nMaxBlocksToScan
         BlockReading = BlockReading->pprev;
     }
 
+    // CRYPTROX BEGIN
+    if (pindexIndexed && nHeightIndexed > nBlockLastPaid && nHeightIndexed <= pindex->nHeight) {
+        nBlockLastPaid = nHeightIndexed;
+        nTimeLastPaid = nTimeIndexed;
+        LogPrint(BCLog::MASTERNODE, "CMasternode::UpdateLastPaidBlock -- searching for block with payment to %s -- found new %d\n", vin.prevout.ToStringShort(), nBlockLastPaid);
+    }
+    // CRYPTROX END
+
     // Last payment for this masternode wasn't found in latest mnpayments blocks
     // or it was found in mnpayments blocks but wasn't found in the blockchain.
     // LogPrint(BCLog::MASTERNODE, "CMasternode::UpdateLastPaidBlock -- searching for block with payment to %s -- keeping old %d\n", vin.prevout.ToStringShort(), nBlockLastPaid);
@@ -697,23 +813,31 @@ bool CMasternodeBroadcast::CheckOutpoint(int& nDos)
     return true;
 }
 
+// CRYPTROX BEGIN
+CSignedPayload CMasternodeBroadcast::GetSignaturePayload() const
+{
+    CSignedPayload payload;
+    // the address text depends on the network type, it is the one field still formatted by its ToString()
+    payload << addr.ToString(false) << sigTime << pubKeyCollateralAddress.GetID()
+            << pubKeyMasternode.GetID() << nProtocolVersion;
+    return payload;
+}
+// CRYPTROX END
+
 bool CMasternodeBroadcast::Sign(const CKey& keyCollateralAddress)
 {
     std::string strError;
-    std::string strMessage;
 
     sigTime = GetAdjustedTime();
 
-    strMessage = addr.ToString(false) + boost::lexical_cast<std::string>(sigTime) +
-                    pubKeyCollateralAddress.GetID().ToString() + pubKeyMasternode.GetID().ToString() +
-                    boost::lexical_cast<std::string>(nProtocolVersion);
+    uint256 hash = GetSignaturePayload().GetHash(); // CRYPTROX
 
-    if(!CMessageSigner::SignMessage(strMessage, vchSig, keyCollateralAddress)) {
+    if(!CHashSigner::SignHash(hash, keyCollateralAddress, vchSig)) {
         LogPrintf("CMasternodeBroadcast::Sign -- SignMessage() failed\n");
         return false;
     }
 
-    if(!CMessageSigner::VerifyMessage(pubKeyCollateralAddress, vchSig, strMessage, strError)) {
+    if(!CHashSigner::VerifyHash(hash, pubKeyCollateralAddress, vchSig, strError)) {
         LogPrintf("CMasternodeBroadcast::Sign -- VerifyMessage() failed, error: %s\n", strError);
         return false;
     }
@@ -723,17 +847,14 @@ bool CMasternodeBroadcast::Sign(const CKey& keyCollateralAddress)
 
 bool CMasternodeBroadcast::CheckSignature(int& nDos)
 {
-    std::string strMessage;
     std::string strError = "";
     nDos = 0;
 
-    strMessage = addr.ToString(false) + boost::lexical_cast<std::string>(sigTime) +
-                    pubKeyCollateralAddress.GetID().ToString() + pubKeyMasternode.GetID().ToString() +
-                    boost::lexical_cast<std::string>(nProtocolVersion);
+    CSignedPayload payload = GetSignaturePayload(); // CRYPTROX
 
-    LogPrint(BCLog::MASTERNODE, "CMasternodeBroadcast::CheckSignature -- strMessage: %s  pubKeyCollateralAddress address: %s  sig: %s\n", strMessage, EncodeDestination(pubKeyCollateralAddress.GetID()), EncodeBase64(&vchSig[0], vchSig.size()));
+    LogPrint(BCLog::MASTERNODE, "CMasternodeBroadcast::CheckSignature -- strMessage: %s  pubKeyCollateralAddress address: %s  sig: %s\n", payload.GetMessage(), EncodeDestination(pubKeyCollateralAddress.GetID()), EncodeBase64(&vchSig[0], vchSig.size()));
 
-    if(!CMessageSigner::VerifyMessage(pubKeyCollateralAddress, vchSig, strMessage, strError)){
+    if(!CHashSigner::VerifyHash(payload.GetHash(), pubKeyCollateralAddress, vchSig, strError)){
         LogPrintf("CMasternodeBroadcast::CheckSignature -- Got bad Masternode announce signature, error: %s\n", strError);
         nDos = 100;
         return false;
@@ -765,21 +886,30 @@ CMasternodePing::CMasternodePing(const COutPoint& outpoint)
     nDaemonVersion = CLIENT_VERSION;
 }
 
+// CRYPTROX BEGIN
+uint256 CMasternodePing::GetSignatureHash() const
+{
+    // TODO: add sentinel data
+    CSignedPayload payload;
+    payload.WriteTxIn(vin) << blockHash << sigTime;
+    return payload.GetHash();
+}
+// CRYPTROX END
+
 bool CMasternodePing::Sign(const CKey& keyMasternode, const CPubKey& pubKeyMasternode)
 {
     std::string strError;
-    std::string strMasterNodeSignMessage;
 
-    // TODO: add sentinel data
     sigTime = GetAdjustedTime();
-    std::string strMessage = vin.ToString() + blockHash.ToString() + boost::lexical_cast<std::string>(sigTime);
 
-    if(!CMessageSigner::SignMessage(strMessage, vchSig, keyMasternode)) {
+    uint256 hash = GetSignatureHash(); // CRYPTROX
+
+    if(!CHashSigner::SignHash(hash, keyMasternode, vchSig)) {
         LogPrintf("CMasternodePing::Sign -- SignMessage() failed\n");
         return false;
     }
 
-    if(!CMessageSigner::VerifyMessage(pubKeyMasternode, vchSig, strMessage, strError)) {
+    if(!CHashSigner::VerifyHash(hash, pubKeyMasternode, vchSig, strError)) {
         LogPrintf("CMasternodePing::Sign -- VerifyMessage() failed, error: %s\n", strError);
         return false;
     }
@@ -789,12 +919,10 @@ bool CMasternodePing::Sign(const CKey& keyMasternode, const CPubKey& pubKeyMaste
 
 bool CMasternodePing::CheckSignature(CPubKey& pubKeyMasternode, int &nDos)
 {
-    // TODO: add sentinel data
-    std::string strMessage = vin.ToString() + blockHash.ToString() + boost::lexical_cast<std::string>(sigTime);
     std::string strError = "";
     nDos = 0;
 
-    if(!CMessageSigner::VerifyMessage(pubKeyMasternode, vchSig, strMessage, strError)) {
+    if(!CHashSigner::VerifyHash(GetSignatureHash(), pubKeyMasternode, vchSig, strError)) {
         LogPrintf("CMasternodePing::CheckSignature -- Got bad Masternode ping signature, masternode=%s, error: %s\n", vin.prevout.ToStringShort(), strError);
         nDos = 33;
         return false;
@@ -827,8 +955,19 @@ bool CMasternodePing::SimpleCheck(int& nDos)
     return true;
 }
 
+// CRYPTROX BEGIN
 bool CMasternodePing::CheckAndUpdate(CMasternode* pmn, bool fFromNewBroadcast, int& nDos, CConnman& connman)
 {
+    if (!CheckBeforeSignature(pmn, fFromNewBroadcast, nDos)) return false;
+
+    if (!CheckSignature(pmn->pubKeyMasternode, nDos)) return false;
+
+    return UpdateMasternode(pmn, connman);
+}
+
+bool CMasternodePing::CheckBeforeSignature(CMasternode* pmn, bool fFromNewBroadcast, int& nDos)
+{
+// CRYPTROX END
     // don't ban by default
     nDos = 0;
 
@@ -874,8 +1013,13 @@ bool CMasternodePing::CheckAndUpdate(CMasternode* pmn, bool fFromNewBroadcast, i
         return false;
     }
 
-    if (!CheckSignature(pmn->pubKeyMasternode, nDos)) return false;
+    // CRYPTROX BEGIN
+    return true;
+}
 
+bool CMasternodePing::UpdateMasternode(CMasternode* pmn, CConnman& connman)
+{
+    // CRYPTROX END
     // so, ping seems to be ok
 
     // if we are still syncing and there was no known ping for this mn for quite a while
@@ -6,7 +6,9 @@
 #ifndef CRYPTROX_MASTERNODE_H
 #define CRYPTROX_MASTERNODE_H
 
+#include <crypto/sha256.h>
 #include <key.h>
+#include <messagesigner.h>
 #include <validation.h>
 #include <spork.h>
 
@@ -76,9 +78,16 @@ public:
 
     bool IsExpired() const { return GetAdjustedTime() - sigTime > MASTERNODE_NEW_START_REQUIRED_SECONDS; }
 
+    uint256 GetSignatureHash() const; // CRYPTROX
     bool Sign(const CKey& keyMasternode, const CPubKey& pubKeyMasternode);
     bool CheckSignature(CPubKey& pubKeyMasternode, int &nDos);
     bool SimpleCheck(int& nDos);
+    // CRYPTROX BEGIN
+    /// The checks of CheckAndUpdate up to the signature check
+    bool CheckBeforeSignature(CMasternode* pmn, bool fFromNewBroadcast, int& nDos);
+    /// The part of CheckAndUpdate after the signature check, store and relay the ping
+    bool UpdateMasternode(CMasternode* pmn, CConnman& connman);
+    // CRYPTROX END
     bool CheckAndUpdate(CMasternode* pmn, bool fFromNewBroadcast, int& nDos, CConnman& connman);
     void Relay(CConnman& connman);
 };
@@ -169,6 +178,10 @@ public:
     int nPoSeBanHeight{};
     bool fAllowMixingTx{};
     bool fUnitTest = false;
+    // CRYPTROX BEGIN
+    // memory only, kept up to date by CMasternodeMan::UpdateCollaterals
+    bool fCollateralSpent = false;
+    // CRYPTROX END
 
     // KEEP TRACK OF GOVERNANCE ITEMS EACH MASTERNODE HAS VOTE UPON FOR RECALCULATION
     std::map<uint256, int> mapGovernanceObjectsVotedOn;
@@ -220,6 +233,10 @@ public:
     // CRYPTROX END
 
     void Check(bool fForce = false);
+    // CRYPTROX BEGIN
+    /// Adjusted time at which the next ping threshold used by Check() is crossed, max if none is left
+    int64_t GetNextCheckTime();
+    // CRYPTROX END
 
     bool IsBroadcastedWithin(int nSeconds) { return GetAdjustedTime() - sigTime < nSeconds; }
 
@@ -233,7 +250,7 @@ public:
         return nTimeToCheckAt - lastPing.sigTime < nSeconds;
     }
 
-    bool IsEnabled() { return nActiveState == MASTERNODE_ENABLED; }
+    bool IsEnabled() const { return nActiveState == MASTERNODE_ENABLED; }
     bool IsPreEnabled() { return nActiveState == MASTERNODE_PRE_ENABLED; }
     bool IsPoSeBanned() { return nActiveState == MASTERNODE_POSE_BAN; }
     // NOTE: this one relies on nPoSeBanScore, not on nActiveState as everything else here
@@ -281,8 +298,8 @@ public:
     std::string GetStateString() const;
     std::string GetStatus() const;
 
-    int GetLastPaidTime() { return nTimeLastPaid; }
-    int GetLastPaidBlock() { return nBlockLastPaid; }
+    int GetLastPaidTime() const { return nTimeLastPaid; }
+    int GetLastPaidBlock() const { return nBlockLastPaid; }
     void UpdateLastPaid(const CBlockIndex *pindex, int nMaxBlocksToScanBack);
 
     // KEEP TRACK OF EACH GOVERNANCE ITEM INCASE THIS NODE GOES OFFLINE, SO WE CAN RECALC THEIR STATUS
@@ -294,6 +311,10 @@ public:
 
     void UpdateWatchdogVoteTime(uint64_t nVoteTime = 0);
 
+    // CRYPTROX BEGIN
+    void SetCollateralSpent(bool fSpent) { LOCK(cs); fCollateralSpent = fSpent; }
+    // CRYPTROX END
+
     CMasternode& operator=(CMasternode const& from)
     {
         static_cast<masternode_info_t&>(*this)=from;
@@ -305,6 +326,7 @@ public:
         nPoSeBanHeight = from.nPoSeBanHeight;
         fAllowMixingTx = from.fAllowMixingTx;
         fUnitTest = from.fUnitTest;
+        fCollateralSpent = from.fCollateralSpent;
         mapGovernanceObjectsVotedOn = from.mapGovernanceObjectsVotedOn;
         return *this;
     }
@@ -319,6 +341,27 @@ inline bool operator!=(const CMasternode& a, const CMasternode& b)
     return !(a.vin == b.vin);
 }
 
+// CRYPTROX BEGIN
+//
+// Same score as CMasternode::CalculateScore, split in two. The outpoint and the collateral block hash
+// fill the first SHA256 block of the preimage, so that compression is done once per masternode and
+// only the block hash is hashed for each new block.
+//
+class CMasternodeScoreHasher
+{
+private:
+    CSHA256 hasher;
+
+public:
+    CMasternodeScoreHasher() {}
+    CMasternodeScoreHasher(const COutPoint& outpoint, const uint256& nCollateralMinConfBlockHash);
+
+    arith_uint256 CalculateScore(const uint256& blockHash) const;
+};
+
+/** Score many masternodes against one block hash on up to nThreads threads, the caller's included (0: one per script check thread) */
+void CalculateMasternodeScores(const std::vector<CMasternodeScoreHasher>& vHashers, const uint256& blockHash, std::vector<arith_uint256>& vScoresRet, int nThreads = 0);
+// CRYPTROX END
 
 //
 // The Masternode Broadcast Class : Contains a different serialize method for sending masternodes through the network
@@ -366,6 +409,7 @@ public:
     bool Update(CMasternode* pmn, int& nDos, CConnman& connman);
     bool CheckOutpoint(int& nDos);
 
+    CSignedPayload GetSignaturePayload() const; // CRYPTROX
     bool Sign(const CKey& keyCollateralAddress);
     bool CheckSignature(int& nDos);
     void Relay(CConnman& connman);
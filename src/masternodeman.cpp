@@ -18,19 +18,62 @@
 #include <script/standard.h>
 #include <util.h>
 
+// CRYPTROX BEGIN
+#include <atomic>
+#include <limits>
+// CRYPTROX END
+
 /** Masternode manager */
 CMasternodeMan mnodeman;
 
 const std::string CMasternodeMan::SERIALIZATION_VERSION_STRING = "CMasternodeMan-Version-7";
 
-struct CompareLastPaidBlock
+// CRYPTROX BEGIN
+namespace {
+struct CMasternodeMaintenanceCounter {
+    std::atomic<uint64_t> nCount{0};
+    std::atomic<uint64_t> nTimeMicros{0};
+    std::atomic<uint64_t> nLastTimeMicros{0};
+    std::atomic<uint64_t> nItems{0};
+};
+
+CMasternodeMaintenanceCounter vMaintenanceCounters[MN_MAINTENANCE_TASK_COUNT];
+
+const char* const vMaintenanceTaskNames[MN_MAINTENANCE_TASK_COUNT] = {
+    "check",
+    "checkandremove",
+    "checksameaddr",
+    "fullverification",
+    "payments",
+};
+} // namespace
+
+CMasternodeMaintenanceTimer::CMasternodeMaintenanceTimer(MasternodeMaintenanceTask taskIn)
+: task(taskIn),
+  nTimeStart(GetTimeMicros()),
+  nItems(0)
+{}
+
+CMasternodeMaintenanceTimer::~CMasternodeMaintenanceTimer()
 {
-    bool operator()(const std::pair<int, CMasternode*>& t1,
-                    const std::pair<int, CMasternode*>& t2) const
-    {
-        return (t1.first != t2.first) ? (t1.first < t2.first) : (t1.second->vin < t2.second->vin);
+    uint64_t nTimeMicros = GetTimeMicros() - nTimeStart;
+    CMasternodeMaintenanceCounter& counter = vMaintenanceCounters[task];
+    counter.nCount++;
+    counter.nTimeMicros += nTimeMicros;
+    counter.nLastTimeMicros = nTimeMicros;
+    counter.nItems += nItems;
+}
+
+std::vector<CMasternodeMaintenanceStats> GetMasternodeMaintenanceStats()
+{
+    std::vector<CMasternodeMaintenanceStats> vStats;
+    for (int i = 0; i < MN_MAINTENANCE_TASK_COUNT; i++) {
+        const CMasternodeMaintenanceCounter& counter = vMaintenanceCounters[i];
+        vStats.push_back({vMaintenanceTaskNames[i], counter.nCount.load(), counter.nTimeMicros.load(), counter.nLastTimeMicros.load(), counter.nItems.load()});
     }
-};
+    return vStats;
+}
+// CRYPTROX END
 
 struct CompareScoreMN
 {
@@ -41,16 +84,6 @@ struct CompareScoreMN
     }
 };
 
-struct CompareByAddr
-
-{
-    bool operator()(const CMasternode* t1,
-                    const CMasternode* t2) const
-    {
-        return t1->addr < t2->addr;
-    }
-};
-
 CMasternodeMan::CMasternodeMan()
 : cs(),
   mapMasternodes(),
@@ -65,6 +98,28 @@ CMasternodeMan::CMasternodeMan()
   fMasternodesRemoved(false),
   vecDirtyGovernanceObjectHashes(),
   nLastWatchdogVoteTime(0),
+  fCollateralsChecked(false),
+  setCheckSchedule(),
+  mapCheckScheduleTime(),
+  setPoSeBanEnd(),
+  setMaintenanceCandidates(),
+  fCheckAll(true),
+  fCheckListSynced(false),
+  nCheckMinProto(0),
+  nListVersion(0),
+  nIndexVersion(0),
+  mapIndexByPubKey(),
+  mapIndexByPayee(),
+  mapIndexByAddr(),
+  vecDuplicateAddrs(),
+  setIndexByLastPaid(),
+  vecScoreMasternodes(),
+  vecScoreHashers(),
+  mapScoreCache(),
+  listScoreCacheOrder(),
+  snapshot(),
+  setSnapshotDirty(),
+  fSnapshotAllDirty(true),
   mapSeenMasternodeBroadcast(),
   mapSeenMasternodePing(),
   nDsqCount(0)
@@ -78,6 +133,9 @@ bool CMasternodeMan::Add(CMasternode &mn)
 
     LogPrint(BCLog::MASTERNODE, "CMasternodeMan::Add -- Adding new Masternode: addr=%s, %i now\n", mn.addr.ToString(), size() + 1);
     mapMasternodes[mn.vin.prevout] = mn;
+    InvalidateIndexes();
+    ScheduleCheck(mn.vin.prevout);
+    SetSnapshotDirty(mn.vin.prevout);
     fMasternodesAdded = true;
     return true;
 }
@@ -91,6 +149,10 @@ bool CMasternodeMan::Remove(COutPoint out)
     {
         LogPrint(BCLog::MASTERNODE, "CMasternodeMan::Remove -- Removing Masternode: addr=%s\n", mnit->second.addr.ToString());
         mapMasternodes.erase(mnit);
+        InvalidateIndexes();
+        ScheduleCheck(out, std::numeric_limits<int64_t>::max());
+        setMaintenanceCandidates.erase(out);
+        SetSnapshotDirty(out);
     }
     fMasternodesRemoved = true;
     return true;
@@ -135,6 +197,7 @@ bool CMasternodeMan::AllowMixing(const COutPoint &outpoint)
     nDsqCount++;
     pmn->nLastDsq = nDsqCount;
     pmn->fAllowMixingTx = true;
+    SetSnapshotDirty(outpoint);
 
     return true;
 }
@@ -147,6 +210,7 @@ bool CMasternodeMan::DisallowMixing(const COutPoint &outpoint)
         return false;
     }
     pmn->fAllowMixingTx = false;
+    SetSnapshotDirty(outpoint);
 
     return true;
 }
@@ -159,21 +223,149 @@ bool CMasternodeMan::PoSeBan(const COutPoint &outpoint)
         return false;
     }
     pmn->PoSeBan();
+    ScheduleCheck(outpoint);
+    SetSnapshotDirty(outpoint);
 
     return true;
 }
 
 void CMasternodeMan::Check()
 {
-    LOCK(cs);
+    // CRYPTROX BEGIN
+    // every state depends on these, a change requires a full check
+    bool fListSynced = masternodeSync.IsMasternodeListSynced();
+    int nMinProto = mnpayments.GetMinMasternodePaymentsProto();
+
+    {
+        // most runs find nothing due, those do not need cs_main
+        LOCK(cs);
+        bool fDue = fCheckAll || fListSynced != fCheckListSynced || nMinProto != nCheckMinProto ||
+                (!setCheckSchedule.empty() && setCheckSchedule.begin()->first <= GetAdjustedTime());
+        if(!fDue) return;
+    }
+
+    // CMasternode::Check() gives up without cs_main, take it here so that a due check is never lost
+    LOCK2(cs_main, cs);
+
+    CMasternodeMaintenanceTimer timer(MN_MAINTENANCE_CHECK);
 
     LogPrint(BCLog::MASTERNODE, "CMasternodeMan::Check -- nLastWatchdogVoteTime=%d, IsWatchdogActive()=%d\n", nLastWatchdogVoteTime, IsWatchdogActive());
 
-    for (auto& mnpair : mapMasternodes) {
-        mnpair.second.Check();
+    if(fListSynced != fCheckListSynced || nMinProto != nCheckMinProto) {
+        fCheckListSynced = fListSynced;
+        nCheckMinProto = nMinProto;
+        fCheckAll = true;
+    }
+
+    if(fCheckAll) {
+        setCheckSchedule.clear();
+        mapCheckScheduleTime.clear();
+        setPoSeBanEnd.clear();
+        setMaintenanceCandidates.clear();
+        for (auto& mnpair : mapMasternodes) {
+            CheckAndReschedule(mnpair.second);
+        }
+        timer.nItems = mapMasternodes.size();
+        fCheckAll = false;
+        return;
+    }
+
+    // only the masternodes whose next check is due
+    int64_t nNow = GetAdjustedTime();
+    while(!setCheckSchedule.empty() && setCheckSchedule.begin()->first <= nNow) {
+        COutPoint outpoint = setCheckSchedule.begin()->second;
+        ScheduleCheck(outpoint, std::numeric_limits<int64_t>::max());
+        CMasternode* pmn = Find(outpoint);
+        if(pmn) {
+            CheckAndReschedule(*pmn);
+            timer.nItems++;
+        }
+    }
+    // CRYPTROX END
+}
+
+// CRYPTROX BEGIN
+void CMasternodeMan::ScheduleCheck(const COutPoint& outpoint, int64_t nTime)
+{
+    AssertLockHeld(cs);
+
+    auto it = mapCheckScheduleTime.find(outpoint);
+    if(it != mapCheckScheduleTime.end()) {
+        if(it->second == nTime) return;
+        setCheckSchedule.erase(std::make_pair(it->second, outpoint));
+        mapCheckScheduleTime.erase(it);
+    }
+    if(nTime == std::numeric_limits<int64_t>::max()) return;
+    setCheckSchedule.emplace(nTime, outpoint);
+    mapCheckScheduleTime.emplace(outpoint, nTime);
+}
+
+void CMasternodeMan::CheckAndReschedule(CMasternode& mn)
+{
+    AssertLockHeld(cs);
+
+    const COutPoint& outpoint = mn.vin.prevout;
+    int nActiveStatePrev = mn.nActiveState;
+    int nPoSeBanScorePrev = mn.nPoSeBanScore;
+    mn.Check(true);
+    if(mn.nActiveState != nActiveStatePrev || mn.nPoSeBanScore != nPoSeBanScorePrev) {
+        SetSnapshotDirty(outpoint);
+    }
+
+    if(mn.IsOutpointSpent() || mn.IsNewStartRequired()) {
+        setMaintenanceCandidates.insert(outpoint);
+    } else {
+        setMaintenanceCandidates.erase(outpoint);
+    }
+    // the ban is lifted by the first check at or above this height, see UpdatedBlockTip()
+    if(mn.IsPoSeBanned()) {
+        setPoSeBanEnd.emplace(mn.nPoSeBanHeight, outpoint);
     }
+    ScheduleCheck(outpoint, mn.GetNextCheckTime());
 }
 
+void CMasternodeMan::SetSnapshotDirty(const COutPoint& outpoint)
+{
+    AssertLockHeld(cs);
+    if(!fSnapshotAllDirty) {
+        setSnapshotDirty.insert(outpoint);
+    }
+}
+
+CMasternodeMan::snapshot_t CMasternodeMan::GetSnapshot()
+{
+    LOCK(cs);
+
+    if(!fSnapshotAllDirty && setSnapshotDirty.empty()) {
+        return snapshot;
+    }
+
+    // readers may still hold the previous snapshot, build a new one sharing its unchanged entries
+    std::shared_ptr<snapshot_map_t> pnewSnapshot = std::make_shared<snapshot_map_t>();
+    if(fSnapshotAllDirty) {
+        for (const auto& mnpair : mapMasternodes) {
+            pnewSnapshot->emplace_hint(pnewSnapshot->end(), mnpair.first, std::make_shared<const CMasternode>(mnpair.second));
+        }
+    } else {
+        *pnewSnapshot = *snapshot;
+        for (const auto& outpoint : setSnapshotDirty) {
+            auto it = mapMasternodes.find(outpoint);
+            if(it == mapMasternodes.end()) {
+                pnewSnapshot->erase(outpoint);
+            } else {
+                (*pnewSnapshot)[outpoint] = std::make_shared<const CMasternode>(it->second);
+            }
+        }
+    }
+    LogPrint(BCLog::MASTERNODE, "CMasternodeMan::GetSnapshot -- %d masternodes, %s entries copied\n", pnewSnapshot->size(), fSnapshotAllDirty ? "all" : std::to_string(setSnapshotDirty.size()));
+
+    snapshot = pnewSnapshot;
+    setSnapshotDirty.clear();
+    fSnapshotAllDirty = false;
+    return snapshot;
+}
+// CRYPTROX END
+
 void CMasternodeMan::CheckAndRemove(CConnman& connman)
 {
     if(!masternodeSync.IsMasternodeListSynced()) return;
@@ -185,14 +377,43 @@ void CMasternodeMan::CheckAndRemove(CConnman& connman)
         // in CheckMnbAndUpdateMasternodeList()
         LOCK2(cs_main, cs);
 
+        // CRYPTROX BEGIN
+        // Blocks connected while we were offline are not seen by UpdateCollaterals,
+        // look the collaterals of the masternodes from mncache.dat up once
+        if(!fCollateralsChecked) {
+            for (auto& mnpair : mapMasternodes) {
+                Coin coin;
+                if(!GetUTXOCoin(mnpair.first, coin)) {
+                    mnpair.second.SetCollateralSpent(true);
+                    ScheduleCheck(mnpair.first);
+                    SetSnapshotDirty(mnpair.first);
+                }
+            }
+            fCollateralsChecked = true;
+        }
+        // CRYPTROX END
+
         Check();
 
+        // CRYPTROX BEGIN
+        CMasternodeMaintenanceTimer timer(MN_MAINTENANCE_CHECK_AND_REMOVE);
+        // CRYPTROX END
+
         // Remove spent masternodes, prepare structures and make requests to reasure the state of inactive ones
         rank_pair_vec_t vecMasternodeRanks;
         // ask for up to MNB_RECOVERY_MAX_ASK_ENTRIES masternode entries at a time
         int nAskForMnbRecovery = MNB_RECOVERY_MAX_ASK_ENTRIES;
-        std::map<COutPoint, CMasternode>::iterator it = mapMasternodes.begin();
-        while (it != mapMasternodes.end()) {
+        // CRYPTROX BEGIN
+        // Check() keeps track of the masternodes in these states, no need to look at the others
+        auto itCandidate = setMaintenanceCandidates.begin();
+        while (itCandidate != setMaintenanceCandidates.end()) {
+            auto it = mapMasternodes.find(*itCandidate);
+            if (it == mapMasternodes.end()) {
+                itCandidate = setMaintenanceCandidates.erase(itCandidate);
+                continue;
+            }
+            timer.nItems++;
+        // CRYPTROX END
             CMasternodeBroadcast mnb = CMasternodeBroadcast(it->second);
             uint256 hash = mnb.GetHash();
             // If collateral was spent ...
@@ -205,7 +426,13 @@ void CMasternodeMan::CheckAndRemove(CConnman& connman)
 
                 // and finally remove it from the list
                 it->second.FlagGovernanceItemsAsDirty();
-                mapMasternodes.erase(it++);
+                // CRYPTROX BEGIN
+                ScheduleCheck(it->first, std::numeric_limits<int64_t>::max());
+                SetSnapshotDirty(it->first);
+                mapMasternodes.erase(it);
+                itCandidate = setMaintenanceCandidates.erase(itCandidate);
+                // CRYPTROX END
+                InvalidateIndexes();
                 fMasternodesRemoved = true;
             } else {
                 bool fAsk = (nAskForMnbRecovery > 0) &&
@@ -238,7 +465,9 @@ void CMasternodeMan::CheckAndRemove(CConnman& connman)
                     // wait for mnb recovery replies for MNB_RECOVERY_WAIT_SECONDS seconds
                     mMnbRecoveryRequests[hash] = std::make_pair(GetTime() + MNB_RECOVERY_WAIT_SECONDS, setRequested);
                 }
-                ++it;
+                // CRYPTROX BEGIN
+                ++itCandidate;
+                // CRYPTROX END
             }
         }
 
@@ -361,6 +590,15 @@ void CMasternodeMan::Clear()
 {
     LOCK(cs);
     mapMasternodes.clear();
+    InvalidateIndexes();
+    // CRYPTROX BEGIN
+    setCheckSchedule.clear();
+    mapCheckScheduleTime.clear();
+    setPoSeBanEnd.clear();
+    setMaintenanceCandidates.clear();
+    fCheckAll = true;
+    fSnapshotAllDirty = true;
+    // CRYPTROX END
     mAskedUsForMasternodeList.clear();
     mWeAskedForMasternodeList.clear();
     mWeAskedForMasternodeListEntry.clear();
@@ -370,6 +608,26 @@ void CMasternodeMan::Clear()
     nLastWatchdogVoteTime = 0;
 }
 
+// CRYPTROX BEGIN
+void CMasternodeMan::CopyForDump(CMasternodeMan& mnodemanCopy)
+{
+    LOCK(cs);
+    for (const auto& mnpair : mapMasternodes) {
+        // unlike the copy constructor assignment takes the governance votes along
+        mnodemanCopy.mapMasternodes.emplace_hint(mnodemanCopy.mapMasternodes.end(), mnpair.first, CMasternode())->second = mnpair.second;
+    }
+    mnodemanCopy.mAskedUsForMasternodeList = mAskedUsForMasternodeList;
+    mnodemanCopy.mWeAskedForMasternodeList = mWeAskedForMasternodeList;
+    mnodemanCopy.mWeAskedForMasternodeListEntry = mWeAskedForMasternodeListEntry;
+    mnodemanCopy.mMnbRecoveryRequests = mMnbRecoveryRequests;
+    mnodemanCopy.mMnbRecoveryGoodReplies = mMnbRecoveryGoodReplies;
+    mnodemanCopy.nLastWatchdogVoteTime = nLastWatchdogVoteTime;
+    mnodemanCopy.nDsqCount = nDsqCount;
+    mnodemanCopy.mapSeenMasternodeBroadcast = mapSeenMasternodeBroadcast;
+    mnodemanCopy.mapSeenMasternodePing = mapSeenMasternodePing;
+}
+// CRYPTROX END
+
 int CMasternodeMan::CountMasternodes(int nProtocolVersion)
 {
     LOCK(cs);
@@ -470,26 +728,27 @@ bool CMasternodeMan::GetMasternodeInfo(const COutPoint& outpoint, masternode_inf
 bool CMasternodeMan::GetMasternodeInfo(const CPubKey& pubKeyMasternode, masternode_info_t& mnInfoRet)
 {
     LOCK(cs);
-    for (auto& mnpair : mapMasternodes) {
-        if (mnpair.second.pubKeyMasternode == pubKeyMasternode) {
-            mnInfoRet = mnpair.second.GetInfo();
-            return true;
-        }
+    // CRYPTROX BEGIN
+    EnsureIndexes();
+    auto itIndex = mapIndexByPubKey.find(pubKeyMasternode);
+    if (itIndex == mapIndexByPubKey.end()) {
+        return false;
     }
-    return false;
+    return GetMasternodeInfo(itIndex->second, mnInfoRet);
+    // CRYPTROX END
 }
 
 bool CMasternodeMan::GetMasternodeInfo(const CScript& payee, masternode_info_t& mnInfoRet)
 {
     LOCK(cs);
-    for (auto& mnpair : mapMasternodes) {
-        CScript scriptCollateralAddress = GetScriptForDestination(mnpair.second.pubKeyCollateralAddress.GetID());
-        if (scriptCollateralAddress == payee) {
-            mnInfoRet = mnpair.second.GetInfo();
-            return true;
-        }
+    // CRYPTROX BEGIN
+    EnsureIndexes();
+    auto itIndex = mapIndexByPayee.find(payee);
+    if (itIndex == mapIndexByPayee.end()) {
+        return false;
     }
-    return false;
+    return GetMasternodeInfo(itIndex->second, mnInfoRet);
+    // CRYPTROX END
 }
 
 bool CMasternodeMan::Has(const COutPoint& outpoint)
@@ -527,23 +786,28 @@ bool CMasternodeMan::GetNextMasternodeInQueueForPayment(int nBlockHeight, bool f
 
     int nMnCount = CountMasternodes();
 
-    for (auto& mnpair : mapMasternodes) {
-        if(!mnpair.second.IsValidForPayment()) continue;
+    // CRYPTROX BEGIN
+    // walk the last paid index, it is already sorted low to high (ties broken by outpoint)
+    EnsureIndexes();
+    for (const auto& lastPaidPair : setIndexByLastPaid) {
+        CMasternode& mn = mapMasternodes.at(lastPaidPair.second);
+        if(!mn.IsValidForPayment()) continue;
 
         //check protocol version
-        if(mnpair.second.nProtocolVersion < mnpayments.GetMinMasternodePaymentsProto()) continue;
+        if(mn.nProtocolVersion < mnpayments.GetMinMasternodePaymentsProto()) continue;
 
         //it's in the list (up to 8 entries ahead of current block to allow propagation) -- so let's skip it
-        if(mnpayments.IsScheduled(mnpair.second, nBlockHeight)) continue;
+        if(mnpayments.IsScheduled(mn, nBlockHeight)) continue;
 
         //it's too new, wait for a cycle
-        if(fFilterSigTime && mnpair.second.sigTime + (nMnCount*2.6*60) > GetAdjustedTime()) continue;
+        if(fFilterSigTime && mn.sigTime + (nMnCount*2.6*60) > GetAdjustedTime()) continue;
 
         //make sure it has at least as many confirmations as there are masternodes
-        if(GetUTXOConfirmations(mnpair.first) < nMnCount) continue;
+        if(GetUTXOConfirmations(lastPaidPair.second) < nMnCount) continue;
 
-        vecMasternodeLastPaid.push_back(std::make_pair(mnpair.second.GetLastPaidBlock(), &mnpair.second));
+        vecMasternodeLastPaid.push_back(std::make_pair(lastPaidPair.first, &mn));
     }
+    // CRYPTROX END
 
     nCountRet = (int)vecMasternodeLastPaid.size();
 
@@ -551,9 +815,6 @@ bool CMasternodeMan::GetNextMasternodeInQueueForPayment(int nBlockHeight, bool f
     if(fFilterSigTime && nCountRet < nMnCount/3)
         return GetNextMasternodeInQueueForPayment(nBlockHeight, false, nCountRet, mnInfoRet);
 
-    // Sort them low to high
-    sort(vecMasternodeLastPaid.begin(), vecMasternodeLastPaid.end(), CompareLastPaidBlock());
-
     uint256 blockHash;
     if(!GetBlockHash(blockHash, nBlockHeight - 101)) {
         LogPrintf("CMasternode::GetNextMasternodeInQueueForPayment -- ERROR: GetBlockHash() failed at nBlockHeight %d\n", nBlockHeight - 101);
@@ -567,8 +828,11 @@ bool CMasternodeMan::GetNextMasternodeInQueueForPayment(int nBlockHeight, bool f
     int nCountTenth = 0;
     arith_uint256 nHighest = 0;
     CMasternode *pBestMasternode = NULL;
+    // CRYPTROX BEGIN
+    const ScoreCacheEntry& scores = GetCachedScores(blockHash);
     for (std::pair<int, CMasternode*>& s : vecMasternodeLastPaid){
-        arith_uint256 nScore = s.second->CalculateScore(blockHash);
+        const arith_uint256& nScore = scores.mapScores.at(s.second->vin.prevout);
+    // CRYPTROX END
         if(nScore > nHighest){
             nHighest = nScore;
             pBestMasternode = s.second;
@@ -637,17 +901,95 @@ bool CMasternodeMan::GetMasternodeScores(const uint256& nBlockHash, CMasternodeM
     if (mapMasternodes.empty())
         return false;
 
-    // calculate scores
-    for (auto& mnpair : mapMasternodes) {
-        if (mnpair.second.nProtocolVersion >= nMinProtocol) {
-            vecMasternodeScoresRet.push_back(std::make_pair(mnpair.second.CalculateScore(nBlockHash), &mnpair.second));
+    // CRYPTROX BEGIN
+    // scores are memoised per block hash, only the protocol filter is applied on every call
+    for (const auto& scorePair : GetCachedScores(nBlockHash).vecScores) {
+        if (scorePair.second->nProtocolVersion >= nMinProtocol) {
+            vecMasternodeScoresRet.push_back(scorePair);
         }
     }
+    // CRYPTROX END
 
-    sort(vecMasternodeScoresRet.rbegin(), vecMasternodeScoresRet.rend(), CompareScoreMN());
     return !vecMasternodeScoresRet.empty();
 }
 
+// CRYPTROX BEGIN
+void CMasternodeMan::InvalidateIndexes()
+{
+    AssertLockHeld(cs);
+    nListVersion++;
+    mapScoreCache.clear();
+    listScoreCacheOrder.clear();
+}
+
+void CMasternodeMan::EnsureIndexes()
+{
+    AssertLockHeld(cs);
+    if (nIndexVersion == nListVersion) return;
+
+    mapIndexByPubKey.clear();
+    mapIndexByPayee.clear();
+    mapIndexByAddr.clear();
+    vecScoreMasternodes.clear();
+    vecScoreHashers.clear();
+    for (auto& mnpair : mapMasternodes) {
+        mapIndexByPubKey.emplace(mnpair.second.pubKeyMasternode, mnpair.first);
+        mapIndexByPayee.emplace(GetScriptForDestination(mnpair.second.pubKeyCollateralAddress.GetID()), mnpair.first);
+        mapIndexByAddr.emplace(mnpair.second.addr, mnpair.first);
+        vecScoreMasternodes.push_back(&mnpair.second);
+        vecScoreHashers.emplace_back(mnpair.first, mnpair.second.nCollateralMinConfBlockHash);
+    }
+    vecDuplicateAddrs.clear();
+    for (auto it = mapIndexByAddr.begin(); it != mapIndexByAddr.end(); it = mapIndexByAddr.upper_bound(it->first)) {
+        if (mapIndexByAddr.count(it->first) > 1) {
+            vecDuplicateAddrs.push_back(it->first);
+        }
+    }
+    RebuildLastPaidIndex();
+    nIndexVersion = nListVersion;
+}
+
+void CMasternodeMan::RebuildLastPaidIndex()
+{
+    AssertLockHeld(cs);
+    setIndexByLastPaid.clear();
+    for (auto& mnpair : mapMasternodes) {
+        setIndexByLastPaid.emplace(mnpair.second.GetLastPaidBlock(), mnpair.first);
+    }
+}
+
+const CMasternodeMan::ScoreCacheEntry& CMasternodeMan::GetCachedScores(const uint256& nBlockHash)
+{
+    AssertLockHeld(cs);
+
+    auto it = mapScoreCache.find(nBlockHash);
+    if (it != mapScoreCache.end()) {
+        return it->second;
+    }
+
+    if ((int)listScoreCacheOrder.size() >= MAX_SCORE_CACHE_BLOCKS) {
+        mapScoreCache.erase(listScoreCacheOrder.front());
+        listScoreCacheOrder.pop_front();
+    }
+
+    ScoreCacheEntry& entry = mapScoreCache[nBlockHash];
+    listScoreCacheOrder.push_back(nBlockHash);
+
+    EnsureIndexes();
+    std::vector<arith_uint256> vecScores;
+    CalculateMasternodeScores(vecScoreHashers, nBlockHash, vecScores);
+
+    entry.vecScores.reserve(vecScores.size());
+    for (size_t i = 0; i < vecScores.size(); i++) {
+        entry.vecScores.push_back(std::make_pair(vecScores[i], vecScoreMasternodes[i]));
+        entry.mapScores.emplace(vecScoreMasternodes[i]->vin.prevout, vecScores[i]);
+    }
+    sort(entry.vecScores.rbegin(), entry.vecScores.rend(), CompareScoreMN());
+
+    return entry;
+}
+// CRYPTROX END
+
 bool CMasternodeMan::GetMasternodeRank(const COutPoint& outpoint, int& nRankRet, int nBlockHeight, int nMinProtocol)
 {
     nRankRet = -1;
@@ -709,6 +1051,58 @@ bool CMasternodeMan::GetMasternodeRanks(CMasternodeMan::rank_pair_vec_t& vecMast
     return true;
 }
 
+// CRYPTROX BEGIN
+void CMasternodeMan::ProcessVerifiedPing(const CMasternodePing& mnpIn, const CPubKey& pubKeyChecked, bool fValidSignature, CNode* pfrom, CConnman& connman)
+{
+    LOCK2(cs_main, cs);
+
+    CMasternodePing mnp(mnpIn);
+    // the masternode may have changed while the ping was waiting for its signature check
+    CMasternode* pmn = Find(mnp.vin.prevout);
+    if(pmn && pmn->IsNewStartRequired()) return;
+
+    int nDos = 0;
+    bool fUpdated = false;
+    if(mnp.CheckBeforeSignature(pmn, false, nDos)) {
+        if(pmn->pubKeyMasternode != pubKeyChecked) {
+            fValidSignature = mnp.CheckSignature(pmn->pubKeyMasternode, nDos);
+        } else if(!fValidSignature) {
+            LogPrintf("CMasternodePing::CheckSignature -- Got bad Masternode ping signature, masternode=%s\n", mnp.vin.prevout.ToStringShort());
+            nDos = 33;
+        }
+        if(fValidSignature) {
+            fUpdated = mnp.UpdateMasternode(pmn, connman);
+        }
+    }
+    FinishPing(mnp, pmn, fUpdated, nDos, pfrom, connman);
+}
+
+void CMasternodeMan::FinishPing(const CMasternodePing& mnp, CMasternode* pmn, bool fUpdated, int nDos, CNode* pfrom, CConnman& connman)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs);
+
+    if(pmn) {
+        // a new ping brings a masternode that was taken off the schedule back
+        ScheduleCheck(mnp.vin.prevout);
+        SetSnapshotDirty(mnp.vin.prevout);
+    }
+    if(fUpdated || !pfrom) return;
+
+    if(nDos > 0) {
+        // if anything significant failed, mark that node
+        Misbehaving(pfrom->GetId(), nDos);
+    } else if(pmn != NULL) {
+        // nothing significant failed, mn is a known one too
+        return;
+    }
+
+    // something significant is broken or mn is unknown,
+    // we might have to ask for a masternode entry once
+    AskForMN(pfrom, mnp.vin.prevout, connman);
+}
+// CRYPTROX END
+
 void CMasternodeMan::ProcessMasternodeConnections(CConnman& connman)
 {
     //we don't care about this for regtest
@@ -820,19 +1214,19 @@ void CMasternodeMan::ProcessMessage(CNode* pfrom, const std::string& strCommand,
         if(pmn && pmn->IsNewStartRequired()) return;
 
         int nDos = 0;
-        if(mnp.CheckAndUpdate(pmn, false, nDos, connman)) return;
-
-        if(nDos > 0) {
-            // if anything significant failed, mark that node
-            Misbehaving(pfrom->GetId(), nDos);
-        } else if(pmn != NULL) {
-            // nothing significant failed, mn is a known one too
+        // CRYPTROX BEGIN
+        //if(mnp.CheckAndUpdate(pmn, false, nDos, connman)) return;
+        if(mnp.CheckBeforeSignature(pmn, false, nDos)) {
+            // the signature is verified off-thread, the ping is applied in arrival order
+            CPubKey pubKeyMasternode = pmn->pubKeyMasternode;
+            messageVerifyQueue.Push(mnp.GetSignatureHash(), pubKeyMasternode, mnp.vchSig, pfrom,
+                [this, mnp, pubKeyMasternode, &connman](bool fValidSignature, CNode* pnode) {
+                    ProcessVerifiedPing(mnp, pubKeyMasternode, fValidSignature, pnode, connman);
+                });
             return;
         }
-
-        // something significant is broken or mn is unknown,
-        // we might have to ask for a masternode entry once
-        AskForMN(pfrom, mnp.vin.prevout, connman);
+        FinishPing(mnp, pmn, false, nDos, pfrom, connman);
+        // CRYPTROX END
 
     } else if (strCommand == NetMsgType::DSEG) { //Get Masternode list or specific entry
         // Ignore such requests until we are fully synced.
@@ -928,33 +1322,37 @@ void CMasternodeMan::DoFullVerificationStep(CConnman& connman)
     if(activeMasternode.outpoint == COutPoint()) return;
     if(!masternodeSync.IsSynced()) return;
 
-    rank_pair_vec_t vecMasternodeRanks;
-    GetMasternodeRanks(vecMasternodeRanks, nCachedBlockHeight - 1, MIN_POSE_PROTO_VERSION);
-
     // Need LOCK2 here to ensure consistent locking order because the SendVerifyRequest call below locks cs_main
     // through GetHeight() signal in ConnectNode
     LOCK2(cs_main, cs);
 
+    // CRYPTROX BEGIN
+    CMasternodeMaintenanceTimer timer(MN_MAINTENANCE_FULL_VERIFICATION);
+
+    // walk the memoised scores instead of copying every masternode into a rank vector
+    uint256 nBlockHash;
+    score_pair_vec_t vecMasternodeScores;
+    if(!GetBlockHash(nBlockHash, nCachedBlockHeight - 1)) return;
+    if(!GetMasternodeScores(nBlockHash, vecMasternodeScores, MIN_POSE_PROTO_VERSION)) return;
+
     int nCount = 0;
 
     int nMyRank = -1;
-    int nRanksTotal = (int)vecMasternodeRanks.size();
+    int nRanksTotal = (int)vecMasternodeScores.size();
 
     // send verify requests only if we are in top MAX_POSE_RANK
-    std::vector<std::pair<int, CMasternode> >::iterator it = vecMasternodeRanks.begin();
-    while(it != vecMasternodeRanks.end()) {
-        if(it->first > MAX_POSE_RANK) {
+    for (int nRank = 1; nRank <= nRanksTotal; nRank++) {
+        if(nRank > MAX_POSE_RANK) {
             LogPrint(BCLog::MASTERNODE, "CMasternodeMan::DoFullVerificationStep -- Must be in top %d to send verify request\n",
                         (int)MAX_POSE_RANK);
             return;
         }
-        if(it->second.vin.prevout == activeMasternode.outpoint) {
-            nMyRank = it->first;
+        if(vecMasternodeScores[nRank - 1].second->vin.prevout == activeMasternode.outpoint) {
+            nMyRank = nRank;
             LogPrint(BCLog::MASTERNODE, "CMasternodeMan::DoFullVerificationStep -- Found self at rank %d/%d, verifying up to %d masternodes\n",
                         nMyRank, nRanksTotal, (int)MAX_POSE_CONNECTIONS);
             break;
         }
-        ++it;
     }
 
     // edge case: list is too short and this masternode is not enabled
@@ -962,39 +1360,25 @@ void CMasternodeMan::DoFullVerificationStep(CConnman& connman)
 
     // send verify requests to up to MAX_POSE_CONNECTIONS masternodes
     // starting from MAX_POSE_RANK + nMyRank and using MAX_POSE_CONNECTIONS as a step
-    int nOffset = MAX_POSE_RANK + nMyRank - 1;
-    if(nOffset >= (int)vecMasternodeRanks.size()) return;
-
-    std::vector<CMasternode*> vSortedByAddr;
-    for (auto& mnpair : mapMasternodes) {
-        vSortedByAddr.push_back(&mnpair.second);
-    }
-
-    sort(vSortedByAddr.begin(), vSortedByAddr.end(), CompareByAddr());
-
-    it = vecMasternodeRanks.begin() + nOffset;
-    while(it != vecMasternodeRanks.end()) {
-        if(it->second.IsPoSeVerified() || it->second.IsPoSeBanned()) {
+    for (int nOffset = MAX_POSE_RANK + nMyRank - 1; nOffset < nRanksTotal; nOffset += MAX_POSE_CONNECTIONS) {
+        CMasternode* pmn = vecMasternodeScores[nOffset].second;
+        timer.nItems++;
+        if(pmn->IsPoSeVerified() || pmn->IsPoSeBanned()) {
             LogPrint(BCLog::MASTERNODE, "CMasternodeMan::DoFullVerificationStep -- Already %s%s%s masternode %s address %s, skipping...\n",
-                        it->second.IsPoSeVerified() ? "verified" : "",
-                        it->second.IsPoSeVerified() && it->second.IsPoSeBanned() ? " and " : "",
-                        it->second.IsPoSeBanned() ? "banned" : "",
-                        it->second.vin.prevout.ToStringShort(), it->second.addr.ToString());
-            nOffset += MAX_POSE_CONNECTIONS;
-            if(nOffset >= (int)vecMasternodeRanks.size()) break;
-            it += MAX_POSE_CONNECTIONS;
+                        pmn->IsPoSeVerified() ? "verified" : "",
+                        pmn->IsPoSeVerified() && pmn->IsPoSeBanned() ? " and " : "",
+                        pmn->IsPoSeBanned() ? "banned" : "",
+                        pmn->vin.prevout.ToStringShort(), pmn->addr.ToString());
             continue;
         }
         LogPrint(BCLog::MASTERNODE, "CMasternodeMan::DoFullVerificationStep -- Verifying masternode %s rank %d/%d address %s\n",
-                    it->second.vin.prevout.ToStringShort(), it->first, nRanksTotal, it->second.addr.ToString());
-        if(SendVerifyRequest(CAddress(it->second.addr, NODE_NETWORK), vSortedByAddr, connman)) {
+                    pmn->vin.prevout.ToStringShort(), nOffset + 1, nRanksTotal, pmn->addr.ToString());
+        if(SendVerifyRequest(CAddress(pmn->addr, NODE_NETWORK), connman)) {
             nCount++;
             if(nCount >= MAX_POSE_CONNECTIONS) break;
         }
-        nOffset += MAX_POSE_CONNECTIONS;
-        if(nOffset >= (int)vecMasternodeRanks.size()) break;
-        it += MAX_POSE_CONNECTIONS;
     }
+    // CRYPTROX END
 
     LogPrint(BCLog::MASTERNODE, "CMasternodeMan::DoFullVerificationStep -- Sent verification requests to %d masternodes\n", nCount);
 }
@@ -1009,21 +1393,22 @@ void CMasternodeMan::CheckSameAddr()
     if(!masternodeSync.IsSynced() || mapMasternodes.empty()) return;
 
     std::vector<CMasternode*> vBan;
-    std::vector<CMasternode*> vSortedByAddr;
 
-    {
-        LOCK(cs);
+    LOCK(cs);
+
+    // CRYPTROX BEGIN
+    CMasternodeMaintenanceTimer timer(MN_MAINTENANCE_CHECK_SAME_ADDR);
 
+    // only the addresses the index found more than one masternode for
+    EnsureIndexes();
+    for (const auto& addr : vecDuplicateAddrs) {
         CMasternode* pprevMasternode = NULL;
         CMasternode* pverifiedMasternode = NULL;
 
-        for (auto& mnpair : mapMasternodes) {
-            vSortedByAddr.push_back(&mnpair.second);
-        }
-
-        sort(vSortedByAddr.begin(), vSortedByAddr.end(), CompareByAddr());
-
-        for (auto* pmn : vSortedByAddr) {
+        auto range = mapIndexByAddr.equal_range(addr);
+        for (auto itAddr = range.first; itAddr != range.second; ++itAddr) {
+            CMasternode* pmn = &mapMasternodes.at(itAddr->second);
+            timer.nItems++;
             // check only (pre)enabled masternodes
             if(!pmn->IsEnabled() && !pmn->IsPreEnabled()) continue;
             // initial step
@@ -1033,18 +1418,14 @@ void CMasternodeMan::CheckSameAddr()
                 continue;
             }
             // second+ step
-            if(pmn->addr == pprevMasternode->addr) {
-                if(pverifiedMasternode) {
-                    // another masternode with the same ip is verified, ban this one
-                    vBan.push_back(pmn);
-                } else if(pmn->IsPoSeVerified()) {
-                    // this masternode with the same ip is verified, ban previous one
-                    vBan.push_back(pprevMasternode);
-                    // and keep a reference to be able to ban following masternodes with the same ip
-                    pverifiedMasternode = pmn;
-                }
-            } else {
-                pverifiedMasternode = pmn->IsPoSeVerified() ? pmn : NULL;
+            if(pverifiedMasternode) {
+                // another masternode with the same ip is verified, ban this one
+                vBan.push_back(pmn);
+            } else if(pmn->IsPoSeVerified()) {
+                // this masternode with the same ip is verified, ban previous one
+                vBan.push_back(pprevMasternode);
+                // and keep a reference to be able to ban following masternodes with the same ip
+                pverifiedMasternode = pmn;
             }
             pprevMasternode = pmn;
         }
@@ -1054,10 +1435,13 @@ void CMasternodeMan::CheckSameAddr()
     for (auto* pmn : vBan) {
         LogPrintf("CMasternodeMan::CheckSameAddr -- increasing PoSe ban score for masternode %s\n", pmn->vin.prevout.ToStringShort());
         pmn->IncreasePoSeBanScore();
+        ScheduleCheck(pmn->vin.prevout);
+        SetSnapshotDirty(pmn->vin.prevout);
     }
+    // CRYPTROX END
 }
 
-bool CMasternodeMan::SendVerifyRequest(const CAddress& addr, const std::vector<CMasternode*>& vSortedByAddr, CConnman& connman)
+bool CMasternodeMan::SendVerifyRequest(const CAddress& addr, CConnman& connman)
 {
     if(netfulfilledman.HasFulfilledRequest(addr, strprintf("%s", NetMsgType::MNVERIFY)+"-request")) {
         // we already asked for verification, not a good idea to do this too often, skip it
@@ -1182,6 +1566,9 @@ void CMasternodeMan::ProcessVerifyReply(CNode* pnode, CMasternodeVerification& m
                     prealMasternode = &mnpair.second;
                     if(!mnpair.second.IsPoSeVerified()) {
                         mnpair.second.DecreasePoSeBanScore();
+                        // CRYPTROX BEGIN
+                        SetSnapshotDirty(mnpair.first);
+                        // CRYPTROX END
                     }
                     netfulfilledman.AddFulfilledRequest(pnode->addr, strprintf("%s", NetMsgType::MNVERIFY)+"-done");
 
@@ -1228,6 +1615,10 @@ void CMasternodeMan::ProcessVerifyReply(CNode* pnode, CMasternodeVerification& m
         // increase ban score for everyone else
         for (auto* pmn : vpMasternodesToBan) {
             pmn->IncreasePoSeBanScore();
+            // CRYPTROX BEGIN
+            ScheduleCheck(pmn->vin.prevout);
+            SetSnapshotDirty(pmn->vin.prevout);
+            // CRYPTROX END
             LogPrint(BCLog::MASTERNODE, "CMasternodeMan::ProcessVerifyReply -- increased PoSe ban score for %s addr %s, new score %d\n",
                         prealMasternode->vin.prevout.ToStringShort(), pnode->addr.ToString(), pmn->nPoSeBanScore);
         }
@@ -1322,6 +1713,9 @@ void CMasternodeMan::ProcessVerifyBroadcast(CNode* pnode, const CMasternodeVerif
 
         if(!pmn1->IsPoSeVerified()) {
             pmn1->DecreasePoSeBanScore();
+            // CRYPTROX BEGIN
+            SetSnapshotDirty(pmn1->vin.prevout);
+            // CRYPTROX END
         }
         mnv.Relay();
 
@@ -1333,6 +1727,10 @@ void CMasternodeMan::ProcessVerifyBroadcast(CNode* pnode, const CMasternodeVerif
         for (auto& mnpair : mapMasternodes) {
             if(mnpair.second.addr != mnv.addr || mnpair.first == mnv.vin1.prevout) continue;
             mnpair.second.IncreasePoSeBanScore();
+            // CRYPTROX BEGIN
+            ScheduleCheck(mnpair.first);
+            SetSnapshotDirty(mnpair.first);
+            // CRYPTROX END
             nCount++;
             LogPrint(BCLog::MASTERNODE, "CMasternodeMan::ProcessVerifyBroadcast -- increased PoSe ban score for %s addr %s, new score %d\n",
                         mnpair.first.ToStringShort(), mnpair.second.addr.ToString(), mnpair.second.nPoSeBanScore);
@@ -1371,7 +1769,13 @@ void CMasternodeMan::UpdateMasternodeList(CMasternodeBroadcast mnb, CConnman& co
         }
     } else {
         CMasternodeBroadcast mnbOld = mapSeenMasternodeBroadcast[CMasternodeBroadcast(*pmn).GetHash()].second;
-        if(pmn->UpdateFromNewBroadcast(mnb, connman)) {
+        bool fUpdated = pmn->UpdateFromNewBroadcast(mnb, connman);
+        // CRYPTROX BEGIN
+        InvalidateIndexes();
+        ScheduleCheck(mnb.vin.prevout);
+        SetSnapshotDirty(mnb.vin.prevout);
+        // CRYPTROX END
+        if(fUpdated) {
             masternodeSync.BumpAssetLastTime("CMasternodeMan::UpdateMasternodeList - seen");
             mapSeenMasternodeBroadcast.erase(mnbOld.GetHash());
         }
@@ -1433,7 +1837,13 @@ bool CMasternodeMan::CheckMnbAndUpdateMasternodeList(CNode* pfrom, CMasternodeBr
         CMasternode* pmn = Find(mnb.vin.prevout);
         if(pmn) {
             CMasternodeBroadcast mnbOld = mapSeenMasternodeBroadcast[CMasternodeBroadcast(*pmn).GetHash()].second;
-            if(!mnb.Update(pmn, nDos, connman)) {
+            bool fUpdated = mnb.Update(pmn, nDos, connman);
+            // CRYPTROX BEGIN
+            InvalidateIndexes();
+            ScheduleCheck(mnb.vin.prevout);
+            SetSnapshotDirty(mnb.vin.prevout);
+            // CRYPTROX END
+            if(!fUpdated) {
                 LogPrint(BCLog::MASTERNODE, "CMasternodeMan::CheckMnbAndUpdateMasternodeList -- Update() failed, masternode=%s\n", mnb.vin.prevout.ToStringShort());
                 return false;
             }
@@ -1480,14 +1890,26 @@ void CMasternodeMan::UpdateLastPaid(const CBlockIndex* pindex)
     static bool IsFirstRun = true;
     // Do full scan on first run or if we are not a masternode
     // (MNs should update this info on every block, so limited scan should be enough for them)
+    // CRYPTROX: once the payee index is synced only masternodes it has no payment for are scanned, see CMasternode::UpdateLastPaid
     int nMaxBlocksToScanBack = (IsFirstRun || !fMasterNode) ? mnpayments.GetStorageLimit() : LAST_PAID_SCAN_BLOCKS;
 
     // LogPrint("mnpayments", "CMasternodeMan::UpdateLastPaid -- nHeight=%d, nMaxBlocksToScanBack=%d, IsFirstRun=%s\n",
     //                         nCachedBlockHeight, nMaxBlocksToScanBack, IsFirstRun ? "true" : "false");
 
     for (auto& mnpair: mapMasternodes) {
+        // CRYPTROX BEGIN
+        int nBlockLastPaidPrev = mnpair.second.GetLastPaidBlock();
         mnpair.second.UpdateLastPaid(pindex, nMaxBlocksToScanBack);
+        if (mnpair.second.GetLastPaidBlock() != nBlockLastPaidPrev) {
+            SetSnapshotDirty(mnpair.first);
+        }
+        // CRYPTROX END
+    }
+    // CRYPTROX BEGIN
+    if (nIndexVersion == nListVersion) {
+        RebuildLastPaidIndex();
     }
+    // CRYPTROX END
 
     IsFirstRun = false;
 }
@@ -1500,6 +1922,7 @@ void CMasternodeMan::UpdateWatchdogVoteTime(const COutPoint& outpoint, uint64_t
         return;
     }
     pmn->UpdateWatchdogVoteTime(nVoteTime);
+    SetSnapshotDirty(outpoint);
     nLastWatchdogVoteTime = GetTime();
 }
 
@@ -1518,6 +1941,7 @@ bool CMasternodeMan::AddGovernanceVote(const COutPoint& outpoint, uint256 nGover
         return false;
     }
     pmn->AddGovernanceVote(nGovernanceObjectHash);
+    SetSnapshotDirty(outpoint);
     return true;
 }
 
@@ -1527,17 +1951,22 @@ void CMasternodeMan::RemoveGovernanceObject(uint256 nGovernanceObjectHash)
     for(auto& mnpair : mapMasternodes) {
         mnpair.second.RemoveGovernanceObject(nGovernanceObjectHash);
     }
+    // CRYPTROX BEGIN
+    fSnapshotAllDirty = true;
+    // CRYPTROX END
 }
 
 void CMasternodeMan::CheckMasternode(const CPubKey& pubKeyMasternode, bool fForce)
 {
     LOCK(cs);
-    for (auto& mnpair : mapMasternodes) {
-        if (mnpair.second.pubKeyMasternode == pubKeyMasternode) {
-            mnpair.second.Check(fForce);
-            return;
-        }
+    // CRYPTROX BEGIN
+    EnsureIndexes();
+    auto itIndex = mapIndexByPubKey.find(pubKeyMasternode);
+    if (itIndex != mapIndexByPubKey.end()) {
+        mapMasternodes.at(itIndex->second).Check(fForce);
+        SetSnapshotDirty(itIndex->second);
     }
+    // CRYPTROX END
 }
 
 bool CMasternodeMan::IsMasternodePingedWithin(const COutPoint& outpoint, int nSeconds, int64_t nTimeToCheckAt)
@@ -1555,6 +1984,10 @@ void CMasternodeMan::SetMasternodeLastPing(const COutPoint& outpoint, const CMas
         return;
     }
     pmn->lastPing = mnp;
+    // CRYPTROX BEGIN
+    ScheduleCheck(outpoint);
+    SetSnapshotDirty(outpoint);
+    // CRYPTROX END
     // if masternode uses sentinel ping instead of watchdog
     // we shoud update nTimeLastWatchdogVote here if sentinel
     // ping flag is actual
@@ -1575,6 +2008,20 @@ void CMasternodeMan::UpdatedBlockTip(const CBlockIndex *pindex)
     nCachedBlockHeight = pindex->nHeight;
     LogPrint(BCLog::MASTERNODE, "CMasternodeMan::UpdatedBlockTip -- nCachedBlockHeight=%d\n", nCachedBlockHeight);
 
+    // CRYPTROX BEGIN
+    {
+        LOCK(cs);
+        // bans ending at this height are lifted by the next Check()
+        while(!setPoSeBanEnd.empty() && setPoSeBanEnd.begin()->first <= nCachedBlockHeight) {
+            const COutPoint& outpoint = setPoSeBanEnd.begin()->second;
+            if(mapMasternodes.count(outpoint)) {
+                ScheduleCheck(outpoint);
+            }
+            setPoSeBanEnd.erase(setPoSeBanEnd.begin());
+        }
+    }
+    // CRYPTROX END
+
     CheckSameAddr();
 
     if(fMasterNode) {
@@ -1583,6 +2030,43 @@ void CMasternodeMan::UpdatedBlockTip(const CBlockIndex *pindex)
     }
 }
 
+// CRYPTROX BEGIN
+void CMasternodeMan::UpdateCollaterals(const CBlock& block, bool fConnected)
+{
+    LOCK(cs);
+
+    if(mapMasternodes.empty()) return;
+
+    auto SetSpent = [&](const COutPoint& outpoint, bool fSpent) {
+        auto it = mapMasternodes.find(outpoint);
+        if(it == mapMasternodes.end()) return;
+        it->second.SetCollateralSpent(fSpent);
+        ScheduleCheck(outpoint);
+        SetSnapshotDirty(outpoint);
+        LogPrint(BCLog::MASTERNODE, "CMasternodeMan::UpdateCollaterals -- collateral %s %s\n", outpoint.ToStringShort(), fSpent ? "spent" : "restored");
+    };
+
+    // Undo a disconnected block in reverse, so that an output created and
+    // spent within the block ends up spent on connect and gone on disconnect
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        const CTransaction& tx = *block.vtx[fConnected ? i : block.vtx.size() - 1 - i];
+        if(fConnected && !tx.IsCoinBase()) {
+            for (const auto& txin : tx.vin) SetSpent(txin.prevout, true);
+        }
+        // outputs of this transaction that are collaterals of known masternodes
+        const uint256& hash = tx.GetHash();
+        for (auto it = mapMasternodes.lower_bound(COutPoint(hash, 0)); it != mapMasternodes.end() && it->first.hash == hash; ++it) {
+            it->second.SetCollateralSpent(!fConnected);
+            ScheduleCheck(it->first);
+            SetSnapshotDirty(it->first);
+        }
+        if(!fConnected && !tx.IsCoinBase()) {
+            for (const auto& txin : tx.vin) SetSpent(txin.prevout, false);
+        }
+    }
+}
+// CRYPTROX END
+
 void CMasternodeMan::NotifyMasternodeUpdates(CConnman& connman)
 {
     // Avoid double locking
@@ -16,6 +16,42 @@ class CConnman;
 
 extern CMasternodeMan mnodeman;
 
+// CRYPTROX BEGIN
+/** Periodic maintenance tasks of the masternode list whose runs are timed */
+enum MasternodeMaintenanceTask {
+    MN_MAINTENANCE_CHECK,
+    MN_MAINTENANCE_CHECK_AND_REMOVE,
+    MN_MAINTENANCE_CHECK_SAME_ADDR,
+    MN_MAINTENANCE_FULL_VERIFICATION,
+    MN_MAINTENANCE_PAYMENTS,
+    MN_MAINTENANCE_TASK_COUNT
+};
+
+struct CMasternodeMaintenanceStats {
+    std::string strTask;
+    uint64_t nCount;
+    uint64_t nTimeMicros;
+    uint64_t nLastTimeMicros;
+    uint64_t nItems;
+};
+
+/** Accounts the duration of one run of a maintenance task and the number of entries it visited */
+class CMasternodeMaintenanceTimer
+{
+private:
+    MasternodeMaintenanceTask task;
+    int64_t nTimeStart;
+
+public:
+    size_t nItems;
+
+    explicit CMasternodeMaintenanceTimer(MasternodeMaintenanceTask taskIn);
+    ~CMasternodeMaintenanceTimer();
+};
+
+std::vector<CMasternodeMaintenanceStats> GetMasternodeMaintenanceStats();
+// CRYPTROX END
+
 class CMasternodeMan
 {
 public:
@@ -23,6 +59,11 @@ public:
     typedef std::vector<score_pair_t> score_pair_vec_t;
     typedef std::pair<int, CMasternode> rank_pair_t;
     typedef std::vector<rank_pair_t> rank_pair_vec_t;
+    // CRYPTROX BEGIN
+    /// Immutable view of the masternode list, unchanged entries are shared between snapshots
+    typedef std::map<COutPoint, std::shared_ptr<const CMasternode> > snapshot_map_t;
+    typedef std::shared_ptr<const snapshot_map_t> snapshot_t;
+    // CRYPTROX END
 
 private:
     static const std::string SERIALIZATION_VERSION_STRING;
@@ -42,6 +83,8 @@ private:
     static const int MNB_RECOVERY_WAIT_SECONDS      = 60;
     static const int MNB_RECOVERY_RETRY_SECONDS     = 3 * 60 * 60;
 
+    static const int MAX_SCORE_CACHE_BLOCKS         = 16;
+
 
     // critical section to protect the inner data structures
     mutable CCriticalSection cs;
@@ -75,12 +118,79 @@ private:
 
     int64_t nLastWatchdogVoteTime;
 
+    // CRYPTROX BEGIN
+    /// Set once the collaterals of the masternodes loaded on startup were looked up
+    bool fCollateralsChecked;
+    /// Masternodes to Check() by the adjusted time their state may change next
+    std::set<std::pair<int64_t, COutPoint> > setCheckSchedule;
+    std::map<COutPoint, int64_t> mapCheckScheduleTime;
+    /// PoSe banned masternodes by the height their ban ends, entries of removed ones are skipped
+    std::set<std::pair<int, COutPoint> > setPoSeBanEnd;
+    /// Masternodes CheckAndRemove() has to act on: spent collaterals and new start required
+    std::set<COutPoint> setMaintenanceCandidates;
+    /// Set when every masternode has to be checked again, e.g. after loading the list
+    bool fCheckAll;
+    /// Global conditions Check() depends on, as of the last run
+    bool fCheckListSynced;
+    int nCheckMinProto;
+    /// Bumped whenever masternodes are added, removed or updated from a new broadcast
+    uint64_t nListVersion;
+    /// Value of nListVersion the secondary indexes below were built for
+    uint64_t nIndexVersion;
+    // secondary indexes over mapMasternodes, rebuilt lazily after the list changes
+    std::map<CPubKey, COutPoint> mapIndexByPubKey;
+    std::map<CScript, COutPoint> mapIndexByPayee;
+    std::multimap<CService, COutPoint> mapIndexByAddr;
+    // keys of mapIndexByAddr shared by more than one masternode
+    std::vector<CService> vecDuplicateAddrs;
+    // ordered the same way as CompareLastPaidBlock, refreshed by UpdateLastPaid
+    std::set<std::pair<int, COutPoint> > setIndexByLastPaid;
+    // block hash independent part of every score, in mapMasternodes order
+    std::vector<CMasternode*> vecScoreMasternodes;
+    std::vector<CMasternodeScoreHasher> vecScoreHashers;
+
+    struct ScoreCacheEntry {
+        // all masternodes sorted by score, highest first
+        score_pair_vec_t vecScores;
+        std::map<COutPoint, arith_uint256> mapScores;
+    };
+    // memoised scores per block hash, dropped on every list change
+    std::map<uint256, ScoreCacheEntry> mapScoreCache;
+    std::list<uint256> listScoreCacheOrder;
+
+    // last published snapshot and the masternodes added, removed or changed since
+    snapshot_t snapshot;
+    std::set<COutPoint> setSnapshotDirty;
+    bool fSnapshotAllDirty;
+    // CRYPTROX END
+
     friend class CMasternodeSync;
+    friend struct CMasternodeManTest; // CRYPTROX
     /// Find an entry
     CMasternode* Find(const COutPoint& outpoint);
 
     bool GetMasternodeScores(const uint256& nBlockHash, score_pair_vec_t& vecMasternodeScoresRet, int nMinProtocol = 0);
 
+    // CRYPTROX BEGIN
+    /// Drop the secondary indexes and the score cache, must be called after any change to the list
+    void InvalidateIndexes();
+    /// Rebuild the secondary indexes if the list has changed since they were built
+    void EnsureIndexes();
+    void RebuildLastPaidIndex();
+    /// Scores of all masternodes for the given block hash, calculated once per hash
+    const ScoreCacheEntry& GetCachedScores(const uint256& nBlockHash);
+    /// Have Check() look at a masternode at the given adjusted time, max to take it off the schedule
+    void ScheduleCheck(const COutPoint& outpoint, int64_t nTime = 0);
+    /// Check a masternode now and schedule its next check
+    void CheckAndReschedule(CMasternode& mn);
+    /// Have the next snapshot copy this entry again, must be called after any change to a masternode
+    void SetSnapshotDirty(const COutPoint& outpoint);
+    /// Apply a ping received from pfrom once its signature was checked against pubKeyChecked
+    void ProcessVerifiedPing(const CMasternodePing& mnp, const CPubKey& pubKeyChecked, bool fValidSignature, CNode* pfrom, CConnman& connman);
+    /// Reschedule the pinged masternode, then penalize pfrom or ask it for the entry unless the ping was applied
+    void FinishPing(const CMasternodePing& mnp, CMasternode* pmn, bool fUpdated, int nDos, CNode* pfrom, CConnman& connman);
+    // CRYPTROX END
+
 public:
     // Keep track of all broadcasts I've seen
     std::map<uint256, std::pair<int64_t, CMasternodeBroadcast> > mapSeenMasternodeBroadcast;
@@ -107,6 +217,13 @@ public:
         }
 
         READWRITE(mapMasternodes);
+        // CRYPTROX BEGIN
+        if(ser_action.ForRead()) {
+            InvalidateIndexes();
+            fCheckAll = true;
+            fSnapshotAllDirty = true;
+        }
+        // CRYPTROX END
         READWRITE(mAskedUsForMasternodeList);
         READWRITE(mWeAskedForMasternodeList);
         READWRITE(mWeAskedForMasternodeListEntry);
@@ -136,16 +253,20 @@ public:
     bool AllowMixing(const COutPoint &outpoint);
     bool DisallowMixing(const COutPoint &outpoint);
 
-    /// Check all Masternodes
+    /// Check the Masternodes whose state may have changed
     void Check();
 
-    /// Check all Masternodes and remove inactive
+    /// Check Masternodes and remove inactive
     void CheckAndRemove(CConnman& connman);
     /// This is dummy overload to be used for dumping/loading mncache.dat
     void CheckAndRemove() {}
 
     /// Clear Masternode vector
     void Clear();
+    // CRYPTROX BEGIN
+    /// Copy the state that is serialized into an empty manager, see CFlatDB::Dump
+    void CopyForDump(CMasternodeMan& mnodemanCopy);
+    // CRYPTROX END
 
     /// Count Masternodes filtered by nProtocolVersion.
     /// Masternode nProtocolVersion should match or be above the one specified in param here.
@@ -175,7 +296,10 @@ public:
     /// Find a random entry
     masternode_info_t FindRandomNotInVec(const std::vector<COutPoint> &vecToExclude, int nProtocolVersion = -1);
 
-    std::map<COutPoint, CMasternode> GetFullMasternodeMap() { return mapMasternodes; }
+    // CRYPTROX BEGIN
+    /// Consistent view of the whole list, only the entries changed since the last call are copied
+    snapshot_t GetSnapshot();
+    // CRYPTROX END
 
     bool GetMasternodeRanks(rank_pair_vec_t& vecMasternodeRanksRet, int nBlockHeight = -1, int nMinProtocol = 0);
     bool GetMasternodeRank(const COutPoint &outpoint, int& nRankRet, int nBlockHeight = -1, int nMinProtocol = 0);
@@ -187,7 +311,7 @@ public:
 
     void DoFullVerificationStep(CConnman& connman);
     void CheckSameAddr();
-    bool SendVerifyRequest(const CAddress& addr, const std::vector<CMasternode*>& vSortedByAddr, CConnman& connman);
+    bool SendVerifyRequest(const CAddress& addr, CConnman& connman);
     void SendVerifyReply(CNode* pnode, CMasternodeVerification& mnv, CConnman& connman);
     void ProcessVerifyReply(CNode* pnode, CMasternodeVerification& mnv);
     void ProcessVerifyBroadcast(CNode* pnode, const CMasternodeVerification& mnv);
@@ -231,6 +355,11 @@ public:
 
     void UpdatedBlockTip(const CBlockIndex *pindex);
 
+    // CRYPTROX BEGIN
+    /// Flag the masternodes whose collateral a connected or disconnected block spent or restored
+    void UpdateCollaterals(const CBlock& block, bool fConnected);
+    // CRYPTROX END
+
     /**
      * Called to notify CGovernanceManager that the masternode index has been updated.
      * Must be called while not holding the CMasternodeMan::cs mutex
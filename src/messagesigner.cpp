@@ -3,14 +3,72 @@
 // Distributed under the MIT/X11 software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <checkqueue.h>
+#include <crypto/sha256.h>
+#include <cuckoocache.h>
 #include <hash.h>
 #include <key_io.h>
 #include <validation.h> // For strMessageMagic
 #include <messagesigner.h>
+#include <net.h>
+#include <primitives/transaction.h>
+#include <random.h>
+#include <script/sigcache.h>
 #include <tinyformat.h>
+#include <util.h>
 #include <utilstrencodings.h>
 
-bool CMessageSigner::GetKeysFromSecret(const std::string strSecret, CKey& keyRet, CPubKey& pubkeyRet)
+#include <boost/thread.hpp>
+
+// CRYPTROX BEGIN
+namespace {
+/**
+ * Cache of valid masternode message signatures. Votes, pings and payment
+ * votes are relayed by many peers and checked again on sync, so the same
+ * (hash, pubkey, signature) triple is seen many times.
+ */
+class CMessageSignatureCache
+{
+private:
+    //! Entries are SHA256(nonce || hash || public key || signature):
+    uint256 nonce;
+    CuckooCache::cache<uint256, SignatureCacheHasher> setValid;
+    boost::shared_mutex cs_sigcache;
+
+public:
+    static const size_t CACHE_BYTES = 4 << 20;
+
+    CMessageSignatureCache()
+    {
+        GetRandBytes(nonce.begin(), 32);
+        setValid.setup_bytes(CACHE_BYTES);
+    }
+
+    void ComputeEntry(uint256& entry, const uint256& hash, const CPubKey& pubkey, const std::vector<unsigned char>& vchSig)
+    {
+        CSHA256().Write(nonce.begin(), 32).Write(hash.begin(), 32).Write(pubkey.begin(), pubkey.size()).Write(vchSig.data(), vchSig.size()).Finalize(entry.begin());
+    }
+
+    bool Get(const uint256& entry)
+    {
+        boost::shared_lock<boost::shared_mutex> lock(cs_sigcache);
+        return setValid.contains(entry, false);
+    }
+
+    void Set(uint256& entry)
+    {
+        boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
+        setValid.insert(entry);
+    }
+};
+
+CMessageSignatureCache messageSignatureCache;
+
+CCheckQueue<CHashSignatureCheck> sigcheckqueue(16);
+} // namespace
+// CRYPTROX END
+
+bool CMessageSigner::GetKeysFromSecret(const std::string& strSecret, CKey& keyRet, CPubKey& pubkeyRet)
 {
     keyRet = DecodeSecret(strSecret);
     if (!keyRet.IsValid()) return false;
@@ -20,31 +78,103 @@ bool CMessageSigner::GetKeysFromSecret(const std::string strSecret, CKey& keyRet
     return true;
 }
 
-bool CMessageSigner::SignMessage(const std::string strMessage, std::vector<unsigned char>& vchSigRet, const CKey key)
+bool CMessageSigner::SignMessage(const std::string& strMessage, std::vector<unsigned char>& vchSigRet, const CKey& key)
 {
-    CHashWriter ss(SER_GETHASH, 0);
-    ss << strMessageMagic;
-    ss << strMessage;
+    return CHashSigner::SignHash(GetMessageHash(strMessage), key, vchSigRet);
+}
 
-    return CHashSigner::SignHash(ss.GetHash(), key, vchSigRet);
+bool CMessageSigner::VerifyMessage(const CPubKey& pubkey, const std::vector<unsigned char>& vchSig, const std::string& strMessage, std::string& strErrorRet)
+{
+    return CHashSigner::VerifyHash(GetMessageHash(strMessage), pubkey, vchSig, strErrorRet);
 }
 
-bool CMessageSigner::VerifyMessage(const CPubKey pubkey, const std::vector<unsigned char>& vchSig, const std::string strMessage, std::string& strErrorRet)
+uint256 CMessageSigner::GetMessageHash(const std::string& strMessage)
 {
-    CHashWriter ss(SER_GETHASH, 0);
-    ss << strMessageMagic;
+    // CRYPTROX BEGIN
+    // the magic prefix is the same for every message, serialize it only once
+    // and continue from a copy of that hasher state
+    static const CHashWriter ssMagic = [] {
+        CHashWriter ss(SER_GETHASH, 0);
+        ss << strMessageMagic;
+        return ss;
+    }();
+
+    CHashWriter ss(ssMagic);
     ss << strMessage;
+    return ss.GetHash();
+    // CRYPTROX END
+}
 
-    return CHashSigner::VerifyHash(ss.GetHash(), pubkey, vchSig, strErrorRet);
+// CRYPTROX BEGIN
+void CSignedPayload::WriteDecimal(uint64_t n)
+{
+    char buf[20];
+    char* pend = buf + sizeof(buf);
+    char* p = pend;
+    do {
+        *--p = '0' + n % 10;
+        n /= 10;
+    } while (n != 0);
+    strMessage.append(p, pend - p);
 }
 
-bool CHashSigner::SignHash(const uint256& hash, const CKey key, std::vector<unsigned char>& vchSigRet)
+void CSignedPayload::WriteHex(const unsigned char* pch, size_t nSize, size_t nMaxChars, bool fReverse)
+{
+    static const char hexmap[] = "0123456789abcdef";
+    size_t nChars = std::min(nSize * 2, nMaxChars);
+    for (size_t i = 0; i < nChars; i++) {
+        unsigned char c = fReverse ? pch[nSize - 1 - i / 2] : pch[i / 2];
+        strMessage.push_back(hexmap[i % 2 ? c & 15 : c >> 4]);
+    }
+}
+
+CSignedPayload& CSignedPayload::WriteOutPointShort(const COutPoint& outpoint)
+{
+    *this << outpoint.hash;
+    strMessage.push_back('-');
+    WriteDecimal(outpoint.n);
+    return *this;
+}
+
+CSignedPayload& CSignedPayload::WriteTxIn(const CTxIn& txin)
+{
+    // COutPoint::ToString() shows the first 10 hex digits of the hash
+    strMessage.append("CTxIn(COutPoint(");
+    WriteHex(txin.prevout.hash.begin(), txin.prevout.hash.size(), 10, true);
+    strMessage.append(", ");
+    WriteDecimal(txin.prevout.n);
+    strMessage.push_back(')');
+    if (txin.prevout.IsNull()) {
+        strMessage.append(", coinbase ");
+        WriteHex(txin.scriptSig.data(), txin.scriptSig.size(), txin.scriptSig.size() * 2, false);
+    } else {
+        strMessage.append(", scriptSig=");
+        WriteHex(txin.scriptSig.data(), txin.scriptSig.size(), 24, false);
+    }
+    if (txin.nSequence != CTxIn::SEQUENCE_FINAL) {
+        strMessage.append(", nSequence=");
+        WriteDecimal(txin.nSequence);
+    }
+    strMessage.push_back(')');
+    return *this;
+}
+// CRYPTROX END
+
+bool CHashSigner::SignHash(const uint256& hash, const CKey& key, std::vector<unsigned char>& vchSigRet)
 {
     return key.SignCompact(hash, vchSigRet);
 }
 
-bool CHashSigner::VerifyHash(const uint256& hash, const CPubKey pubkey, const std::vector<unsigned char>& vchSig, std::string& strErrorRet)
+bool CHashSigner::VerifyHash(const uint256& hash, const CPubKey& pubkey, const std::vector<unsigned char>& vchSig, std::string& strErrorRet)
 {
+    // CRYPTROX BEGIN
+    uint256 entry;
+    messageSignatureCache.ComputeEntry(entry, hash, pubkey, vchSig);
+    if(messageSignatureCache.Get(entry)) {
+        return true;
+    }
+    // CRYPTROX END
+
     CPubKey pubkeyFromSig;
     if(!pubkeyFromSig.RecoverCompact(hash, vchSig)) {
         strErrorRet = "Error recovering public key.";
@@ -58,5 +188,141 @@ bool CHashSigner::VerifyHash(const uint256& hash, const CPubKey pubkey, const st
         return false;
     }
 
+    messageSignatureCache.Set(entry); // CRYPTROX
+
+    return true;
+}
+
+// CRYPTROX BEGIN
+bool CHashSignatureCheck::operator()()
+{
+    std::string strError;
+    *pfValid = CHashSigner::VerifyHash(hash, pubkey, vchSig, strError);
+    // failures are reported by the caller, never abort the rest of the batch
     return true;
 }
+
+void CSignatureBatch::AddMessage(const CPubKey& pubkey, const std::vector<unsigned char>& vchSig, const std::string& strMessage)
+{
+    AddHash(CMessageSigner::GetMessageHash(strMessage), pubkey, vchSig);
+}
+
+void CSignatureBatch::AddHash(const uint256& hash, const CPubKey& pubkey, const std::vector<unsigned char>& vchSig)
+{
+    vHashes.push_back(hash);
+    vPubKeys.push_back(pubkey);
+    vSigs.push_back(vchSig);
+}
+
+std::vector<bool> CSignatureBatch::Verify()
+{
+    std::vector<char> vValid(vHashes.size(), false);
+
+    std::vector<CHashSignatureCheck> vChecks;
+    vChecks.reserve(vHashes.size());
+    for (size_t i = 0; i < vHashes.size(); ++i) {
+        vChecks.emplace_back(vHashes[i], vPubKeys[i], vSigs[i], &vValid[i]);
+    }
+
+    // without check threads the calling thread runs all checks itself
+    CCheckQueueControl<CHashSignatureCheck> control(&sigcheckqueue);
+    control.Add(vChecks);
+    control.Wait();
+
+    return std::vector<bool>(vValid.begin(), vValid.end());
+}
+
+bool IsMessageSignatureCached(const uint256& hash, const CPubKey& pubkey, const std::vector<unsigned char>& vchSig)
+{
+    uint256 entry;
+    messageSignatureCache.ComputeEntry(entry, hash, pubkey, vchSig);
+    return messageSignatureCache.Get(entry);
+}
+
+void ThreadMessageSignatureCheck() {
+    RenameThread("cryptrox-msgsig");
+    sigcheckqueue.Thread();
+}
+
+CMessageVerifyQueue messageVerifyQueue;
+
+const size_t CMessageVerifyQueue::MAX_BATCH_SIZE;
+
+void CMessageVerifyQueue::Push(const uint256& hash, const CPubKey& pubkey, const std::vector<unsigned char>& vchSig, CNode* pfrom, ApplyFunc fnApply)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (fRunning) {
+            queue.push_back(CEntry{hash, pubkey, vchSig, pfrom ? pfrom->AddRef() : nullptr, std::move(fnApply)});
+            condWork.notify_one();
+            return;
+        }
+    }
+
+    std::string strError;
+    fnApply(CHashSigner::VerifyHash(hash, pubkey, vchSig, strError), pfrom);
+}
+
+void CMessageVerifyQueue::Flush()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    condIdle.wait(lock, [this] { return queue.empty() && !fBusy; });
+}
+
+void CMessageVerifyQueue::Start()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fRunning) return;
+    fRunning = true;
+    fStop = false;
+    threadWorker = std::thread(&TraceThread<std::function<void()> >, "msgverify", std::bind(&CMessageVerifyQueue::ThreadVerify, this));
+}
+
+void CMessageVerifyQueue::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!fRunning) return;
+        fStop = true;
+        condWork.notify_all();
+    }
+    threadWorker.join();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& entry : queue) {
+        if (entry.pfrom) entry.pfrom->Release();
+    }
+    queue.clear();
+    fRunning = false;
+    condIdle.notify_all();
+}
+
+void CMessageVerifyQueue::ThreadVerify()
+{
+    while (true) {
+        std::vector<CEntry> vEntries;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            fBusy = false;
+            if (queue.empty()) condIdle.notify_all();
+            condWork.wait(lock, [this] { return fStop || !queue.empty(); });
+            if (fStop) return;
+            size_t nCount = std::min(queue.size(), MAX_BATCH_SIZE);
+            vEntries.assign(std::make_move_iterator(queue.begin()), std::make_move_iterator(queue.begin() + nCount));
+            queue.erase(queue.begin(), queue.begin() + nCount);
+            fBusy = true;
+        }
+
+        CSignatureBatch batch;
+        for (const auto& entry : vEntries) {
+            batch.AddHash(entry.hash, entry.pubkey, entry.vchSig);
+        }
+        std::vector<bool> vValid = batch.Verify();
+
+        for (size_t i = 0; i < vEntries.size(); ++i) {
+            vEntries[i].fnApply(vValid[i], vEntries[i].pfrom);
+            if (vEntries[i].pfrom) vEntries[i].pfrom->Release();
+        }
+    }
+}
+// CRYPTROX END
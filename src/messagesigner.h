@@ -8,18 +8,93 @@
 
 #include <key.h>
 
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
 /** Helper class for signing messages and checking their signatures
  */
 class CMessageSigner
 {
 public:
     /// Set the private/public key values, returns true if successful
-    static bool GetKeysFromSecret(const std::string strSecret, CKey& keyRet, CPubKey& pubkeyRet);
+    static bool GetKeysFromSecret(const std::string& strSecret, CKey& keyRet, CPubKey& pubkeyRet);
     /// Sign the message, returns true if successful
-    static bool SignMessage(const std::string strMessage, std::vector<unsigned char>& vchSigRet, const CKey key);
+    static bool SignMessage(const std::string& strMessage, std::vector<unsigned char>& vchSigRet, const CKey& key);
     /// Verify the message signature, returns true if succcessful
-    static bool VerifyMessage(const CPubKey pubkey, const std::vector<unsigned char>& vchSig, const std::string strMessage, std::string& strErrorRet);
+    static bool VerifyMessage(const CPubKey& pubkey, const std::vector<unsigned char>& vchSig, const std::string& strMessage, std::string& strErrorRet);
+    /// Hash of the message prefixed with strMessageMagic, the value that actually gets signed
+    static uint256 GetMessageHash(const std::string& strMessage);
+};
+
+// CRYPTROX BEGIN
+class COutPoint;
+class CTxIn;
+
+/** Canonical text of a masternode-signed message. Every field is formatted
+ *  straight into one reserved buffer, the same text the old boost::lexical_cast
+ *  and ToString() concatenation produced, and the result is hashed once so
+ *  signing and verifying can share it.
+ */
+class CSignedPayload
+{
+private:
+    std::string strMessage;
+
+    void WriteDecimal(uint64_t n);
+    /// Hex of the bytes like HexStr(), or in reverse order like base_blob::GetHex(), at most nMaxChars of it
+    void WriteHex(const unsigned char* pch, size_t nSize, size_t nMaxChars, bool fReverse);
+
+public:
+    explicit CSignedPayload(size_t nReserve = 128) { strMessage.reserve(nReserve); }
+
+    CSignedPayload& operator<<(const std::string& str) { strMessage.append(str); return *this; }
+    CSignedPayload& operator<<(const char* psz) { strMessage.append(psz); return *this; }
+
+    /// Integers are written in decimal, bools as 0/1, matching boost::lexical_cast
+    CSignedPayload& operator<<(bool f) { strMessage.push_back(f ? '1' : '0'); return *this; }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, CSignedPayload&>::type operator<<(T n)
+    {
+        if (n < 0) {
+            strMessage.push_back('-');
+            WriteDecimal(0 - (uint64_t)n);
+        } else {
+            WriteDecimal(n);
+        }
+        return *this;
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_unsigned<T>::value && !std::is_same<T, bool>::value, CSignedPayload&>::type operator<<(T n)
+    {
+        WriteDecimal(n);
+        return *this;
+    }
+
+    /// Hashes and key ids as their ToString()
+    template <unsigned int BITS>
+    CSignedPayload& operator<<(const base_blob<BITS>& blob)
+    {
+        WriteHex(blob.begin(), blob.size(), blob.size() * 2, true);
+        return *this;
+    }
+
+    /// Same text as COutPoint::ToStringShort()
+    CSignedPayload& WriteOutPointShort(const COutPoint& outpoint);
+    /// Same text as CTxIn::ToString()
+    CSignedPayload& WriteTxIn(const CTxIn& txin);
+
+    const std::string& GetMessage() const { return strMessage; }
+    uint256 GetHash() const { return CMessageSigner::GetMessageHash(strMessage); }
 };
+// CRYPTROX END
 
 /** Helper class for signing hashes and checking their signatures
  */
@@ -27,9 +102,124 @@ class CHashSigner
 {
 public:
     /// Sign the hash, returns true if successful
-    static bool SignHash(const uint256& hash, const CKey key, std::vector<unsigned char>& vchSigRet);
+    static bool SignHash(const uint256& hash, const CKey& key, std::vector<unsigned char>& vchSigRet);
     /// Verify the hash signature, returns true if succcessful
-    static bool VerifyHash(const uint256& hash, const CPubKey pubkey, const std::vector<unsigned char>& vchSig, std::string& strErrorRet);
+    static bool VerifyHash(const uint256& hash, const CPubKey& pubkey, const std::vector<unsigned char>& vchSig, std::string& strErrorRet);
+};
+
+// CRYPTROX BEGIN
+/** Deferred check of one signed hash, run by the message signature check queue
+ */
+class CHashSignatureCheck
+{
+private:
+    uint256 hash;
+    CPubKey pubkey;
+    std::vector<unsigned char> vchSig;
+    char* pfValid;
+
+public:
+    CHashSignatureCheck() : pfValid(nullptr) {}
+    CHashSignatureCheck(const uint256& hashIn, const CPubKey& pubkeyIn, const std::vector<unsigned char>& vchSigIn, char* pfValidIn) :
+        hash(hashIn), pubkey(pubkeyIn), vchSig(vchSigIn), pfValid(pfValidIn) {}
+
+    bool operator()();
+
+    void swap(CHashSignatureCheck& check) {
+        std::swap(hash, check.hash);
+        std::swap(pubkey, check.pubkey);
+        vchSig.swap(check.vchSig);
+        std::swap(pfValid, check.pfValid);
+    }
 };
 
+/** Collects masternode-signed messages and verifies them together on the
+ *  message signature check threads. Valid signatures end up in the signature
+ *  cache, so the regular in-order processing that follows does not recover
+ *  the public keys again.
+ */
+class CSignatureBatch
+{
+private:
+    std::vector<uint256> vHashes;
+    std::vector<CPubKey> vPubKeys;
+    std::vector<std::vector<unsigned char> > vSigs;
+
+public:
+    void AddMessage(const CPubKey& pubkey, const std::vector<unsigned char>& vchSig, const std::string& strMessage);
+    void AddHash(const uint256& hash, const CPubKey& pubkey, const std::vector<unsigned char>& vchSig);
+    size_t Size() const { return vHashes.size(); }
+    /// Verify all queued signatures, the results are in the order they were added
+    std::vector<bool> Verify();
+};
+
+/** What is known about the signature of a message when it gets processed */
+enum class SignatureState {
+    UNCHECKED, //!< not verified yet, the message processing verifies it
+    VALID,     //!< verified with the key of the signing masternode
+    INVALID,   //!< failed verification with the key of the signing masternode
+};
+
+class CNode;
+
+/** Verifies the signatures of masternode messages off the message handler
+ *  thread and applies the messages in the order they arrived. The worker
+ *  takes everything queued while it was busy, verifies it as one
+ *  CSignatureBatch and runs each message's apply function with its result,
+ *  so the processing does not check the signature again. Until the worker
+ *  is started, and after it is stopped, messages are verified and applied
+ *  on the calling thread.
+ */
+class CMessageVerifyQueue
+{
+public:
+    /// Called with the result of the signature check and the peer the message came from
+    typedef std::function<void(bool fValidSignature, CNode* pfrom)> ApplyFunc;
+
+    /// Most messages verified in one batch
+    static const size_t MAX_BATCH_SIZE = 1024;
+
+private:
+    struct CEntry
+    {
+        uint256 hash;
+        CPubKey pubkey;
+        std::vector<unsigned char> vchSig;
+        CNode* pfrom;
+        ApplyFunc fnApply;
+    };
+
+    std::mutex mutex;
+    std::condition_variable condWork;
+    std::condition_variable condIdle;
+    std::deque<CEntry> queue;
+    bool fRunning = false;
+    bool fStop = false;
+    bool fBusy = false;
+    std::thread threadWorker;
+
+    void ThreadVerify();
+
+public:
+    ~CMessageVerifyQueue() { Stop(); }
+
+    /// Queue a signed message, pfrom (may be null) is kept alive until fnApply returned
+    void Push(const uint256& hash, const CPubKey& pubkey, const std::vector<unsigned char>& vchSig, CNode* pfrom, ApplyFunc fnApply);
+    /// Wait until every message pushed so far has been applied
+    void Flush();
+    /// Start the worker thread
+    void Start();
+    /// Stop the worker thread, messages not applied yet are dropped
+    void Stop();
+};
+
+extern CMessageVerifyQueue messageVerifyQueue;
+
+/** Whether a valid (hash, pubkey, signature) triple is in the message signature cache */
+bool IsMessageSignatureCached(const uint256& hash, const CPubKey& pubkey, const std::vector<unsigned char>& vchSig);
+
+/** Run a message signature check thread */
+void ThreadMessageSignatureCheck();
+// CRYPTROX END
+
 #endif // CRYPTROX_MESSAGESIGNER_H
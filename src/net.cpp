@@ -34,6 +34,12 @@
 #include <fcntl.h>
 #endif
 
+// CRYPTROX BEGIN
+#ifdef USE_EPOLL
+#include <sys/epoll.h>
+#endif
+// CRYPTROX END
+
 #ifdef USE_UPNP
 #include <miniupnpc/miniupnpc.h>
 #include <miniupnpc/miniwget.h>
@@ -50,6 +56,16 @@
 // We add a random period time (0 to 1 seconds) to feeler connections to prevent synchronization.
 #define FEELER_SLEEP_WINDOW 1
 
+// CRYPTROX BEGIN
+// Interval at which the socket handler visits every node, bounds how late a paused peer is resumed
+// or a disconnected one removed; in between only nodes with socket events are serviced
+static const int SOCKET_EVENTS_TIMEOUT_MS = 50;
+// Maximum number of events returned by one epoll_wait() call
+static const int MAX_SOCKET_EVENTS = 1024;
+// epoll event data of listen sockets is their index in vhListenSocket with this bit set, node events carry the NodeId
+static const uint64_t EPOLL_LISTEN_SOCKET_FLAG = 1ULL << 63;
+// CRYPTROX END
+
 // MSG_NOSIGNAL is not available on some platforms, if it doesn't exist define it as 0
 #if !defined(MSG_NOSIGNAL)
 #define MSG_NOSIGNAL 0
@@ -1239,202 +1255,515 @@ void CConnman::AcceptConnection(const ListenSocket& hListenSocket) {
     {
         LOCK(cs_vNodes);
         vNodes.push_back(pnode);
+        mapNodesById.emplace(pnode->GetId(), pnode); // CRYPTROX
     }
+    // CRYPTROX BEGIN
+    AddSocketEvents(pnode);
+    // CRYPTROX END
 }
 
-void CConnman::ThreadSocketHandler()
+// CRYPTROX BEGIN
+void CConnman::AddSocketEvents(CNode* pnode)
 {
-    unsigned int nPrevNodeCount = 0;
-    while (!interruptNet)
+    LOCK(pnode->cs_hSocket);
+    if (pnode->hSocket == INVALID_SOCKET)
+        return;
+#ifndef WIN32
+    // select() cannot watch descriptors from FD_SETSIZE on
+    if (socketEventsMode == SOCKETEVENTS_SELECT && pnode->hSocket >= FD_SETSIZE) {
+        LogPrintf("socket descriptor of peer=%d does not fit into select(), use -socketevents=epoll\n", pnode->GetId());
+        pnode->CloseSocketDisconnect();
+        return;
+    }
+#endif
+#ifdef USE_EPOLL
+    if (socketEventsMode != SOCKETEVENTS_EPOLL)
+        return;
+    // Edge-triggered: readiness is remembered in the node until recv/send would block
+    struct epoll_event event = {};
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    // The NodeId rather than the pointer: events already queued for a node that is deleted afterwards are dropped
+    event.data.u64 = pnode->GetId();
+    if (epoll_ctl(epollfd, EPOLL_CTL_ADD, pnode->hSocket, &event) != 0) {
+        LogPrintf("epoll_ctl failed for peer=%d: %s\n", pnode->GetId(), NetworkErrorString(errno));
+        pnode->CloseSocketDisconnect();
+    }
+#endif
+}
+
+bool CConnman::InitSocketEvents()
+{
+    if (socketEventsMode == SOCKETEVENTS_SELECT)
+        return true;
+#ifdef USE_EPOLL
+    epollfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollfd == -1) {
+        LogPrintf("epoll_create1 failed: %s\n", NetworkErrorString(errno));
+        return false;
+    }
+    for (size_t i = 0; i < vhListenSocket.size(); i++) {
+        // Level-triggered, one connection is accepted per iteration
+        struct epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u64 = EPOLL_LISTEN_SOCKET_FLAG | i;
+        if (epoll_ctl(epollfd, EPOLL_CTL_ADD, vhListenSocket[i].socket, &event) != 0) {
+            LogPrintf("epoll_ctl failed for listen socket: %s\n", NetworkErrorString(errno));
+            return false;
+        }
+    }
+    return true;
+#else
+    LogPrintf("epoll is not supported on this platform\n");
+    return false;
+#endif
+}
+
+void CConnman::SocketEvents(std::vector<const ListenSocket*>& vListenReady, std::set<NodeId>& setNodesReady, int nTimeoutMs)
+{
+#ifdef USE_EPOLL
+    if (socketEventsMode == SOCKETEVENTS_EPOLL) {
+        SocketEventsEpoll(vListenReady, setNodesReady, nTimeoutMs);
+        return;
+    }
+#endif
+    SocketEventsSelect(vListenReady, setNodesReady, nTimeoutMs);
+}
+
+#ifdef USE_EPOLL
+void CConnman::SocketEventsEpoll(std::vector<const ListenSocket*>& vListenReady, std::set<NodeId>& setNodesReady, int nTimeoutMs)
+{
+    struct epoll_event events[MAX_SOCKET_EVENTS];
+    int nEvents = epoll_wait(epollfd, events, MAX_SOCKET_EVENTS, nTimeoutMs);
+    if (nEvents < 0) {
+        if (errno != EINTR) {
+            LogPrintf("socket epoll_wait error %s\n", NetworkErrorString(errno));
+            interruptNet.sleep_for(std::chrono::milliseconds(nTimeoutMs));
+        }
+        return;
+    }
+
+    std::map<NodeId, uint32_t> mapNodeEvents;
+    for (int i = 0; i < nEvents; i++) {
+        uint64_t data = events[i].data.u64;
+        if (data & EPOLL_LISTEN_SOCKET_FLAG) {
+            size_t nListenSocket = data & ~EPOLL_LISTEN_SOCKET_FLAG;
+            if (nListenSocket < vhListenSocket.size())
+                vListenReady.push_back(&vhListenSocket[nListenSocket]);
+            continue;
+        }
+        mapNodeEvents[(NodeId)data] |= events[i].events;
+    }
+    if (mapNodeEvents.empty())
+        return;
+
+    // A closed fd may still have a duplicate open (fork, dup) and keep reporting events,
+    // only nodes that are still in vNodes are flagged
+    LOCK(cs_vNodes);
+    for (const auto& nodeEvents : mapNodeEvents) {
+        auto it = mapNodesById.find(nodeEvents.first);
+        if (it == mapNodesById.end())
+            continue;
+        CNode* pnode = it->second;
+        if (nodeEvents.second & (EPOLLIN | EPOLLRDHUP))
+            pnode->fSocketReadable = true;
+        if (nodeEvents.second & EPOLLOUT)
+            pnode->fSocketWritable = true;
+        if (nodeEvents.second & (EPOLLERR | EPOLLHUP))
+            pnode->fSocketError = true;
+        setNodesReady.insert(nodeEvents.first);
+    }
+}
+#endif // USE_EPOLL
+
+void CConnman::SocketEventsSelect(std::vector<const ListenSocket*>& vListenReady, std::set<NodeId>& setNodesReady, int nTimeoutMs)
+{
+    //
+    // Find which sockets have data to receive
+    //
+    struct timeval timeout;
+    timeout.tv_sec  = nTimeoutMs / 1000;
+    timeout.tv_usec = (nTimeoutMs % 1000) * 1000; // frequency to poll pnode->vSend
+
+    fd_set fdsetRecv;
+    fd_set fdsetSend;
+    fd_set fdsetError;
+    FD_ZERO(&fdsetRecv);
+    FD_ZERO(&fdsetSend);
+    FD_ZERO(&fdsetError);
+    SOCKET hSocketMax = 0;
+    bool have_fds = false;
+
+    for (const ListenSocket& hListenSocket : vhListenSocket) {
+        FD_SET(hListenSocket.socket, &fdsetRecv);
+        hSocketMax = std::max(hSocketMax, hListenSocket.socket);
+        have_fds = true;
+    }
+
     {
-        //
-        // Disconnect nodes
-        //
+        LOCK(cs_vNodes);
+        for (CNode* pnode : vNodes)
         {
-            LOCK(cs_vNodes);
+            // Implement the following logic:
+            // * If there is data to send, select() for sending data. As this only
+            //   happens when optimistic write failed, we choose to first drain the
+            //   write buffer in this case before receiving more. This avoids
+            //   needlessly queueing received data, if the remote peer is not themselves
+            //   receiving data. This means properly utilizing TCP flow control signalling.
+            // * Otherwise, if there is space left in the receive buffer, select() for
+            //   receiving data.
+            // * Hand off all complete messages to the processor, to be handled without
+            //   blocking here.
+
+            bool select_recv = !pnode->fPauseRecv;
+            bool select_send;
+            {
+                LOCK(pnode->cs_vSend);
+                select_send = !pnode->vSendMsg.empty();
+            }
 
-            if (!fNetworkActive) {
-                // Disconnect any connected nodes
-                for (CNode* pnode : vNodes) {
-                    if (!pnode->fDisconnect) {
-                        LogPrint(BCLog::NET, "Network not active, dropping peer=%d\n", pnode->GetId());
-                        pnode->fDisconnect = true;
-                    }
-                }
+            LOCK(pnode->cs_hSocket);
+            if (pnode->hSocket == INVALID_SOCKET)
+                continue;
+
+            FD_SET(pnode->hSocket, &fdsetError);
+            hSocketMax = std::max(hSocketMax, pnode->hSocket);
+            have_fds = true;
+
+            if (select_send) {
+                FD_SET(pnode->hSocket, &fdsetSend);
+                continue;
             }
+            if (select_recv) {
+                FD_SET(pnode->hSocket, &fdsetRecv);
+            }
+        }
+    }
 
-            // Disconnect unused nodes
-            std::vector<CNode*> vNodesCopy = vNodes;
-            for (CNode* pnode : vNodesCopy)
-            {
-                if (pnode->fDisconnect)
-                {
-                    LogPrintf("ThreadSocketHandler -- removing node: peer=%d addr=%s nRefCount=%d fNetworkNode=%d fInbound=%d fMasternode=%d\n",
-                              pnode->id, pnode->addr.ToString(), pnode->GetRefCount(), pnode->fNetworkNode, pnode->fInbound, pnode->fMasternode);
+    int nSelect = select(have_fds ? hSocketMax + 1 : 0,
+                         &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
+    if (interruptNet)
+        return;
 
-                    // remove from vNodes
-                    vNodes.erase(remove(vNodes.begin(), vNodes.end(), pnode), vNodes.end());
+    if (nSelect == SOCKET_ERROR)
+    {
+        if (have_fds)
+        {
+            int nErr = WSAGetLastError();
+            LogPrintf("socket select error %s\n", NetworkErrorString(nErr));
+            for (unsigned int i = 0; i <= hSocketMax; i++)
+                FD_SET(i, &fdsetRecv);
+        }
+        FD_ZERO(&fdsetSend);
+        FD_ZERO(&fdsetError);
+        if (!interruptNet.sleep_for(std::chrono::milliseconds(nTimeoutMs)))
+            return;
+    }
 
-                    // release outbound grant (if any)
-                    pnode->grantOutbound.Release();
-                    // Dash
-                    pnode->grantMasternodeOutbound.Release();
-                    //
+    for (const ListenSocket& hListenSocket : vhListenSocket)
+    {
+        if (hListenSocket.socket != INVALID_SOCKET && FD_ISSET(hListenSocket.socket, &fdsetRecv))
+        {
+            vListenReady.push_back(&hListenSocket);
+        }
+    }
+    if (nSelect == 0)
+        return;
 
-                    // close socket and cleanup
-                    pnode->CloseSocketDisconnect();
+    // select() is level-triggered, the readiness of every node is refreshed on each call
+    LOCK(cs_vNodes);
+    for (CNode* pnode : vNodes)
+    {
+        LOCK(pnode->cs_hSocket);
+        if (pnode->hSocket == INVALID_SOCKET)
+            continue;
+        pnode->fSocketReadable = FD_ISSET(pnode->hSocket, &fdsetRecv);
+        pnode->fSocketWritable = FD_ISSET(pnode->hSocket, &fdsetSend);
+        pnode->fSocketError = FD_ISSET(pnode->hSocket, &fdsetError);
+        if (pnode->fSocketReadable || pnode->fSocketWritable || pnode->fSocketError)
+            setNodesReady.insert(pnode->GetId());
+    }
+}
 
-                    // hold in disconnected pool until all refs are released
-                    // Dash
-                    //pnode->Release();
-                    if (pnode->fNetworkNode || pnode->fInbound)
-                        pnode->Release();
-                    if (pnode->fMasternode)
-                        pnode->Release();
-                    //
-                    vNodesDisconnected.push_back(pnode);
+void CConnman::DisconnectNodes()
+{
+    {
+        LOCK(cs_vNodes);
+
+        if (!fNetworkActive) {
+            // Disconnect any connected nodes
+            for (CNode* pnode : vNodes) {
+                if (!pnode->fDisconnect) {
+                    LogPrint(BCLog::NET, "Network not active, dropping peer=%d\n", pnode->GetId());
+                    pnode->fDisconnect = true;
                 }
             }
         }
+
+        // Disconnect unused nodes
+        std::vector<CNode*> vNodesCopy = vNodes;
+        for (CNode* pnode : vNodesCopy)
         {
-            // Delete disconnected nodes
-            std::list<CNode*> vNodesDisconnectedCopy = vNodesDisconnected;
-            for (CNode* pnode : vNodesDisconnectedCopy)
+            if (pnode->fDisconnect)
             {
-                // CRYPTROX BEGIN
-                LogPrint(BCLog::NET, "ThreadSocketHandler -- disconnected node: peer=%d addr=%s nRefCount=%d fNetworkNode=%d fInbound=%d fMasternode=%d\n",
+                LogPrintf("ThreadSocketHandler -- removing node: peer=%d addr=%s nRefCount=%d fNetworkNode=%d fInbound=%d fMasternode=%d\n",
                           pnode->id, pnode->addr.ToString(), pnode->GetRefCount(), pnode->fNetworkNode, pnode->fInbound, pnode->fMasternode);
-                // CRYPTROX END
-                // wait until threads are done using it
-                if (pnode->GetRefCount() <= 0) {
-                    bool fDelete = false;
-                    {
-                        TRY_LOCK(pnode->cs_inventory, lockInv);
-                        if (lockInv) {
-                            TRY_LOCK(pnode->cs_vSend, lockSend);
-                            if (lockSend) {
-                                fDelete = true;
-                            }
+
+                // remove from vNodes
+                vNodes.erase(remove(vNodes.begin(), vNodes.end(), pnode), vNodes.end());
+                mapNodesById.erase(pnode->GetId());
+
+                // release outbound grant (if any)
+                pnode->grantOutbound.Release();
+                // Dash
+                pnode->grantMasternodeOutbound.Release();
+                //
+
+                // close socket and cleanup
+                pnode->CloseSocketDisconnect();
+
+                // hold in disconnected pool until all refs are released
+                // Dash
+                //pnode->Release();
+                if (pnode->fNetworkNode || pnode->fInbound)
+                    pnode->Release();
+                if (pnode->fMasternode)
+                    pnode->Release();
+                //
+                vNodesDisconnected.push_back(pnode);
+            }
+        }
+    }
+    {
+        // Delete disconnected nodes
+        std::list<CNode*> vNodesDisconnectedCopy = vNodesDisconnected;
+        for (CNode* pnode : vNodesDisconnectedCopy)
+        {
+            LogPrint(BCLog::NET, "ThreadSocketHandler -- disconnected node: peer=%d addr=%s nRefCount=%d fNetworkNode=%d fInbound=%d fMasternode=%d\n",
+                      pnode->id, pnode->addr.ToString(), pnode->GetRefCount(), pnode->fNetworkNode, pnode->fInbound, pnode->fMasternode);
+            // wait until threads are done using it
+            if (pnode->GetRefCount() <= 0) {
+                bool fDelete = false;
+                {
+                    TRY_LOCK(pnode->cs_inventory, lockInv);
+                    if (lockInv) {
+                        TRY_LOCK(pnode->cs_vSend, lockSend);
+                        if (lockSend) {
+                            fDelete = true;
                         }
                     }
-                    if (fDelete) {
-                        vNodesDisconnected.remove(pnode);
-                        DeleteNode(pnode);
-                    }
+                }
+                if (fDelete) {
+                    vNodesDisconnected.remove(pnode);
+                    DeleteNode(pnode);
                 }
             }
         }
-        size_t vNodesSize;
+    }
+}
+
+bool CConnman::SocketHandlerNode(CNode* pnode)
+{
+    //
+    // Receive
+    //
+    {
+        LOCK(pnode->cs_hSocket);
+        if (pnode->hSocket == INVALID_SOCKET)
+            return false;
+    }
+    // Drain the write buffer before receiving more, see SocketEventsSelect()
+    bool fSendPending;
+    {
+        LOCK(pnode->cs_vSend);
+        fSendPending = !pnode->vSendMsg.empty();
+    }
+    const bool recvSet = pnode->fSocketReadable && !fSendPending && !pnode->fPauseRecv;
+    const bool sendSet = pnode->fSocketWritable && fSendPending;
+    const bool errorSet = pnode->fSocketError;
+    pnode->fSocketError = false;
+    if (recvSet || errorSet)
+    {
+        // typical socket buffer is 8K-64K
+        char pchBuf[0x10000];
+        int nBytes = 0;
         {
-            LOCK(cs_vNodes);
-            vNodesSize = vNodes.size();
+            LOCK(pnode->cs_hSocket);
+            if (pnode->hSocket == INVALID_SOCKET)
+                return false;
+            nBytes = recv(pnode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
         }
-        if(vNodesSize != nPrevNodeCount) {
-            nPrevNodeCount = vNodesSize;
-            if(clientInterface)
-                clientInterface->NotifyNumConnectionsChanged(nPrevNodeCount);
+        if (nBytes > 0)
+        {
+            // A short read drained the socket, edge-triggered events report any data that arrives later
+            if ((size_t)nBytes < sizeof(pchBuf))
+                pnode->fSocketReadable = false;
+            bool notify = false;
+            if (!pnode->ReceiveMsgBytes(pchBuf, nBytes, notify))
+                pnode->CloseSocketDisconnect();
+            RecordBytesRecv(nBytes);
+            if (notify) {
+                size_t nSizeAdded = 0;
+                auto it(pnode->vRecvMsg.begin());
+                for (; it != pnode->vRecvMsg.end(); ++it) {
+                    if (!it->complete())
+                        break;
+                    nSizeAdded += it->vRecv.size() + CMessageHeader::HEADER_SIZE;
+                }
+                {
+                    LOCK(pnode->cs_vProcessMsg);
+                    pnode->vProcessMsg.splice(pnode->vProcessMsg.end(), pnode->vRecvMsg, pnode->vRecvMsg.begin(), it);
+                    pnode->nProcessQueueSize += nSizeAdded;
+                    pnode->fPauseRecv = pnode->nProcessQueueSize > nReceiveFloodSize;
+                }
+                WakeMessageHandler();
+            }
         }
-
-        //
-        // Find which sockets have data to receive
-        //
-        struct timeval timeout;
-        timeout.tv_sec  = 0;
-        timeout.tv_usec = 50000; // frequency to poll pnode->vSend
-
-        fd_set fdsetRecv;
-        fd_set fdsetSend;
-        fd_set fdsetError;
-        FD_ZERO(&fdsetRecv);
-        FD_ZERO(&fdsetSend);
-        FD_ZERO(&fdsetError);
-        SOCKET hSocketMax = 0;
-        bool have_fds = false;
-
-        for (const ListenSocket& hListenSocket : vhListenSocket) {
-            FD_SET(hListenSocket.socket, &fdsetRecv);
-            hSocketMax = std::max(hSocketMax, hListenSocket.socket);
-            have_fds = true;
+        else if (nBytes == 0)
+        {
+            // socket closed gracefully
+            if (!pnode->fDisconnect) {
+                LogPrint(BCLog::NET, "socket closed\n");
+            }
+            pnode->CloseSocketDisconnect();
         }
-
+        else if (nBytes < 0)
         {
-            LOCK(cs_vNodes);
-            for (CNode* pnode : vNodes)
+            // error
+            int nErr = WSAGetLastError();
+            if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS)
             {
-                // Implement the following logic:
-                // * If there is data to send, select() for sending data. As this only
-                //   happens when optimistic write failed, we choose to first drain the
-                //   write buffer in this case before receiving more. This avoids
-                //   needlessly queueing received data, if the remote peer is not themselves
-                //   receiving data. This means properly utilizing TCP flow control signalling.
-                // * Otherwise, if there is space left in the receive buffer, select() for
-                //   receiving data.
-                // * Hand off all complete messages to the processor, to be handled without
-                //   blocking here.
-
-                bool select_recv = !pnode->fPauseRecv;
-                bool select_send;
-                {
-                    LOCK(pnode->cs_vSend);
-                    select_send = !pnode->vSendMsg.empty();
-                }
+                if (!pnode->fDisconnect)
+                    LogPrintf("socket recv error %s\n", NetworkErrorString(nErr));
+                pnode->CloseSocketDisconnect();
+            }
+            else if (nErr == WSAEWOULDBLOCK)
+            {
+                pnode->fSocketReadable = false;
+            }
+        }
+    }
 
-                LOCK(pnode->cs_hSocket);
-                if (pnode->hSocket == INVALID_SOCKET)
-                    continue;
+    //
+    // Send
+    //
+    if (sendSet)
+    {
+        LOCK(pnode->cs_vSend);
+        size_t nBytes = SocketSendData(pnode);
+        if (nBytes) {
+            RecordBytesSent(nBytes);
+        }
+        // The socket buffer is full, wait for the next writable event
+        if (!pnode->vSendMsg.empty())
+            pnode->fSocketWritable = false;
+    }
 
-                FD_SET(pnode->hSocket, &fdsetError);
-                hSocketMax = std::max(hSocketMax, pnode->hSocket);
-                have_fds = true;
+    if (pnode->fDisconnect)
+        return false;
+    {
+        LOCK(pnode->cs_vSend);
+        fSendPending = !pnode->vSendMsg.empty();
+    }
+    return (pnode->fSocketReadable && !fSendPending && !pnode->fPauseRecv) || (pnode->fSocketWritable && fSendPending);
+}
 
-                if (select_send) {
-                    FD_SET(pnode->hSocket, &fdsetSend);
-                    continue;
-                }
-                if (select_recv) {
-                    FD_SET(pnode->hSocket, &fdsetRecv);
-                }
-            }
+void CConnman::InactivityCheck(CNode* pnode)
+{
+    int64_t nTime = GetSystemTimeInSeconds();
+    if (nTime - pnode->nTimeConnected > 60)
+    {
+        if (pnode->nLastRecv == 0 || pnode->nLastSend == 0)
+        {
+            LogPrint(BCLog::NET, "socket no message in first 60 seconds, %d %d from %d\n", pnode->nLastRecv != 0, pnode->nLastSend != 0, pnode->GetId());
+            pnode->fDisconnect = true;
         }
+        else if (nTime - pnode->nLastSend > TIMEOUT_INTERVAL)
+        {
+            LogPrintf("socket sending timeout: %is\n", nTime - pnode->nLastSend);
+            pnode->fDisconnect = true;
+        }
+        else if (nTime - pnode->nLastRecv > (pnode->nVersion > BIP0031_VERSION ? TIMEOUT_INTERVAL : 90*60))
+        {
+            LogPrintf("socket receive timeout: %is\n", nTime - pnode->nLastRecv);
+            pnode->fDisconnect = true;
+        }
+        else if (pnode->nPingNonceSent && pnode->nPingUsecStart + TIMEOUT_INTERVAL * 1000000 < GetTimeMicros())
+        {
+            LogPrintf("ping timeout: %fs\n", 0.000001 * (GetTimeMicros() - pnode->nPingUsecStart));
+            pnode->fDisconnect = true;
+        }
+        else if (!pnode->fSuccessfullyConnected)
+        {
+            LogPrint(BCLog::NET, "version handshake timeout from %d\n", pnode->GetId());
+            pnode->fDisconnect = true;
+        }
+    }
+}
+// CRYPTROX END
 
-        int nSelect = select(have_fds ? hSocketMax + 1 : 0,
-                             &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
-        if (interruptNet)
-            return;
+void CConnman::ThreadSocketHandler()
+{
+    unsigned int nPrevNodeCount = 0;
+    // CRYPTROX BEGIN
+    // Nodes that had more to receive or send after their turn, serviced again without waiting
+    std::set<NodeId> setNodesMoreWork;
+    int64_t nNextSweep = 0;
+    while (!interruptNet)
+    {
+        //
+        // Every SOCKET_EVENTS_TIMEOUT_MS all nodes are visited: disconnected nodes are removed,
+        // paused nodes are resumed and inactive ones dropped. In between only ready nodes are serviced.
+        //
+        const bool fSweep = GetTimeMillis() >= nNextSweep;
+        if (fSweep) {
+            nNextSweep = GetTimeMillis() + SOCKET_EVENTS_TIMEOUT_MS;
 
-        if (nSelect == SOCKET_ERROR)
-        {
-            if (have_fds)
+            DisconnectNodes();
+
+            size_t vNodesSize;
             {
-                int nErr = WSAGetLastError();
-                LogPrintf("socket select error %s\n", NetworkErrorString(nErr));
-                for (unsigned int i = 0; i <= hSocketMax; i++)
-                    FD_SET(i, &fdsetRecv);
+                LOCK(cs_vNodes);
+                vNodesSize = vNodes.size();
+            }
+            if(vNodesSize != nPrevNodeCount) {
+                nPrevNodeCount = vNodesSize;
+                if(clientInterface)
+                    clientInterface->NotifyNumConnectionsChanged(nPrevNodeCount);
             }
-            FD_ZERO(&fdsetSend);
-            FD_ZERO(&fdsetError);
-            if (!interruptNet.sleep_for(std::chrono::milliseconds(timeout.tv_usec/1000)))
-                return;
         }
 
         //
-        // Accept new connections
+        // Wait for socket events and accept new connections
         //
-        for (const ListenSocket& hListenSocket : vhListenSocket)
+        std::vector<const ListenSocket*> vListenReady;
+        std::set<NodeId> setNodesReady;
+        setNodesReady.swap(setNodesMoreWork);
+        int nTimeoutMs = setNodesReady.empty() ? std::max<int64_t>(nNextSweep - GetTimeMillis(), 0) : 0;
+        SocketEvents(vListenReady, setNodesReady, nTimeoutMs);
+        if (interruptNet)
+            return;
+
+        for (const ListenSocket* pListenSocket : vListenReady)
         {
-            if (hListenSocket.socket != INVALID_SOCKET && FD_ISSET(hListenSocket.socket, &fdsetRecv))
-            {
-                AcceptConnection(hListenSocket);
-            }
+            AcceptConnection(*pListenSocket);
         }
 
         //
-        // Service each socket
+        // Service each ready socket
         //
         std::vector<CNode*> vNodesCopy;
         {
             LOCK(cs_vNodes);
-            vNodesCopy = vNodes;
+            if (fSweep) {
+                vNodesCopy = vNodes;
+            } else {
+                vNodesCopy.reserve(setNodesReady.size());
+                for (NodeId id : setNodesReady) {
+                    auto it = mapNodesById.find(id);
+                    if (it != mapNodesById.end())
+                        vNodesCopy.push_back(it->second);
+                }
+            }
             for (CNode* pnode : vNodesCopy)
                 pnode->AddRef();
         }
@@ -1443,119 +1772,14 @@ void CConnman::ThreadSocketHandler()
             if (interruptNet)
                 return;
 
-            //
-            // Receive
-            //
-            bool recvSet = false;
-            bool sendSet = false;
-            bool errorSet = false;
-            {
-                LOCK(pnode->cs_hSocket);
-                if (pnode->hSocket == INVALID_SOCKET)
-                    continue;
-                recvSet = FD_ISSET(pnode->hSocket, &fdsetRecv);
-                sendSet = FD_ISSET(pnode->hSocket, &fdsetSend);
-                errorSet = FD_ISSET(pnode->hSocket, &fdsetError);
-            }
-            if (recvSet || errorSet)
-            {
-                // typical socket buffer is 8K-64K
-                char pchBuf[0x10000];
-                int nBytes = 0;
-                {
-                    LOCK(pnode->cs_hSocket);
-                    if (pnode->hSocket == INVALID_SOCKET)
-                        continue;
-                    nBytes = recv(pnode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
-                }
-                if (nBytes > 0)
-                {
-                    bool notify = false;
-                    if (!pnode->ReceiveMsgBytes(pchBuf, nBytes, notify))
-                        pnode->CloseSocketDisconnect();
-                    RecordBytesRecv(nBytes);
-                    if (notify) {
-                        size_t nSizeAdded = 0;
-                        auto it(pnode->vRecvMsg.begin());
-                        for (; it != pnode->vRecvMsg.end(); ++it) {
-                            if (!it->complete())
-                                break;
-                            nSizeAdded += it->vRecv.size() + CMessageHeader::HEADER_SIZE;
-                        }
-                        {
-                            LOCK(pnode->cs_vProcessMsg);
-                            pnode->vProcessMsg.splice(pnode->vProcessMsg.end(), pnode->vRecvMsg, pnode->vRecvMsg.begin(), it);
-                            pnode->nProcessQueueSize += nSizeAdded;
-                            pnode->fPauseRecv = pnode->nProcessQueueSize > nReceiveFloodSize;
-                        }
-                        WakeMessageHandler();
-                    }
-                }
-                else if (nBytes == 0)
-                {
-                    // socket closed gracefully
-                    if (!pnode->fDisconnect) {
-                        LogPrint(BCLog::NET, "socket closed\n");
-                    }
-                    pnode->CloseSocketDisconnect();
-                }
-                else if (nBytes < 0)
-                {
-                    // error
-                    int nErr = WSAGetLastError();
-                    if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS)
-                    {
-                        if (!pnode->fDisconnect)
-                            LogPrintf("socket recv error %s\n", NetworkErrorString(nErr));
-                        pnode->CloseSocketDisconnect();
-                    }
-                }
-            }
-
-            //
-            // Send
-            //
-            if (sendSet)
-            {
-                LOCK(pnode->cs_vSend);
-                size_t nBytes = SocketSendData(pnode);
-                if (nBytes) {
-                    RecordBytesSent(nBytes);
-                }
-            }
+            if (SocketHandlerNode(pnode))
+                setNodesMoreWork.insert(pnode->GetId());
 
             //
             // Inactivity checking
             //
-            int64_t nTime = GetSystemTimeInSeconds();
-            if (nTime - pnode->nTimeConnected > 60)
-            {
-                if (pnode->nLastRecv == 0 || pnode->nLastSend == 0)
-                {
-                    LogPrint(BCLog::NET, "socket no message in first 60 seconds, %d %d from %d\n", pnode->nLastRecv != 0, pnode->nLastSend != 0, pnode->GetId());
-                    pnode->fDisconnect = true;
-                }
-                else if (nTime - pnode->nLastSend > TIMEOUT_INTERVAL)
-                {
-                    LogPrintf("socket sending timeout: %is\n", nTime - pnode->nLastSend);
-                    pnode->fDisconnect = true;
-                }
-                else if (nTime - pnode->nLastRecv > (pnode->nVersion > BIP0031_VERSION ? TIMEOUT_INTERVAL : 90*60))
-                {
-                    LogPrintf("socket receive timeout: %is\n", nTime - pnode->nLastRecv);
-                    pnode->fDisconnect = true;
-                }
-                else if (pnode->nPingNonceSent && pnode->nPingUsecStart + TIMEOUT_INTERVAL * 1000000 < GetTimeMicros())
-                {
-                    LogPrintf("ping timeout: %fs\n", 0.000001 * (GetTimeMicros() - pnode->nPingUsecStart));
-                    pnode->fDisconnect = true;
-                }
-                else if (!pnode->fSuccessfullyConnected)
-                {
-                    LogPrint(BCLog::NET, "version handshake timeout from %d\n", pnode->GetId());
-                    pnode->fDisconnect = true;
-                }
-            }
+            if (fSweep)
+                InactivityCheck(pnode);
         }
         {
             LOCK(cs_vNodes);
@@ -1563,6 +1787,7 @@ void CConnman::ThreadSocketHandler()
                 pnode->Release();
         }
     }
+    // CRYPTROX END
 }
 
 void CConnman::WakeMessageHandler()
@@ -2214,8 +2439,10 @@ CNode* CConnman::OpenNetworkConnection(const CAddress& addrConnect, bool fCountF
     {
         LOCK(cs_vNodes);
         vNodes.push_back(pnode);
+        mapNodesById.emplace(pnode->GetId(), pnode); // CRYPTROX
     }
     // CRYPTROX BEGIN
+    AddSocketEvents(pnode);
     return pnode;
     // CRYPTROX END
 }
@@ -2543,6 +2770,11 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
         semAddnode = MakeUnique<CSemaphore>(nMaxAddnode);
     }
 
+    // CRYPTROX BEGIN
+    if (!InitSocketEvents())
+        return false;
+    // CRYPTROX END
+
     //
     // Start threads
     //
@@ -2676,8 +2908,17 @@ void CConnman::Stop()
         DeleteNode(pnode);
     }
     vNodes.clear();
+    mapNodesById.clear(); // CRYPTROX
     vNodesDisconnected.clear();
     vhListenSocket.clear();
+    // CRYPTROX BEGIN
+#ifdef USE_EPOLL
+    if (epollfd != -1) {
+        close(epollfd);
+        epollfd = -1;
+    }
+#endif
+    // CRYPTROX END
     semOutbound.reset();
     // Dash
     semMasternodeOutbound.reset();
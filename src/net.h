@@ -30,6 +30,7 @@
 #include <thread>
 #include <memory>
 #include <condition_variable>
+#include <unordered_map> // CRYPTROX
 
 #ifndef WIN32
 #include <arpa/inet.h>
@@ -129,6 +130,18 @@ public:
         CONNECTIONS_ALL = (CONNECTIONS_IN | CONNECTIONS_OUT),
     };
 
+    // CRYPTROX BEGIN
+    enum SocketEventsMode {
+        SOCKETEVENTS_SELECT = 0,
+        SOCKETEVENTS_EPOLL = 1,
+    };
+#ifdef USE_EPOLL
+    static const SocketEventsMode DEFAULT_SOCKETEVENTS_MODE = SOCKETEVENTS_EPOLL;
+#else
+    static const SocketEventsMode DEFAULT_SOCKETEVENTS_MODE = SOCKETEVENTS_SELECT;
+#endif
+    // CRYPTROX END
+
     struct Options
     {
         ServiceFlags nLocalServices = NODE_NONE;
@@ -149,6 +162,7 @@ public:
         bool m_use_addrman_outgoing = true;
         std::vector<std::string> m_specified_outgoing;
         std::vector<std::string> m_added_nodes;
+        SocketEventsMode socketEventsMode = DEFAULT_SOCKETEVENTS_MODE; // CRYPTROX
     };
 
     void Init(const Options& connOptions) {
@@ -162,6 +176,7 @@ public:
         m_msgproc = connOptions.m_msgproc;
         nSendBufferMaxSize = connOptions.nSendBufferMaxSize;
         nReceiveFloodSize = connOptions.nReceiveFloodSize;
+        socketEventsMode = connOptions.socketEventsMode; // CRYPTROX
         {
             LOCK(cs_totalBytesSent);
             nMaxOutboundTimeframe = connOptions.nMaxOutboundTimeframe;
@@ -426,6 +441,26 @@ private:
     void ThreadOpenConnections(std::vector<std::string> connect);
     void ThreadMessageHandler();
     void AcceptConnection(const ListenSocket& hListenSocket);
+    // CRYPTROX BEGIN
+    /** Set up the socket event backend and register the listen sockets */
+    bool InitSocketEvents();
+    /** Register a new node's socket for readiness events */
+    void AddSocketEvents(CNode* pnode);
+    /**
+     * Wait up to nTimeoutMs for socket events, flag the ready nodes and add their ids to setNodesReady.
+     * Also returns the listen sockets with pending connections.
+     */
+    void SocketEvents(std::vector<const ListenSocket*>& vListenReady, std::set<NodeId>& setNodesReady, int nTimeoutMs);
+#ifdef USE_EPOLL
+    void SocketEventsEpoll(std::vector<const ListenSocket*>& vListenReady, std::set<NodeId>& setNodesReady, int nTimeoutMs);
+#endif
+    void SocketEventsSelect(std::vector<const ListenSocket*>& vListenReady, std::set<NodeId>& setNodesReady, int nTimeoutMs);
+    /** Drop the nodes marked for disconnection and delete those that are no longer referenced */
+    void DisconnectNodes();
+    /** Receive from and send to one node as far as its socket allows, returns whether it is still ready */
+    bool SocketHandlerNode(CNode* pnode);
+    void InactivityCheck(CNode* pnode);
+    // CRYPTROX END
     void ThreadSocketHandler();
     void ThreadDNSAddressSeed();
     // Dash
@@ -490,6 +525,12 @@ private:
     unsigned int nReceiveFloodSize;
 
     std::vector<ListenSocket> vhListenSocket;
+    // CRYPTROX BEGIN
+    SocketEventsMode socketEventsMode = DEFAULT_SOCKETEVENTS_MODE;
+#ifdef USE_EPOLL
+    int epollfd = -1;
+#endif
+    // CRYPTROX END
     std::atomic<bool> fNetworkActive;
     banmap_t setBanned;
     CCriticalSection cs_setBanned;
@@ -501,6 +542,10 @@ private:
     std::vector<std::string> vAddedNodes GUARDED_BY(cs_vAddedNodes);
     CCriticalSection cs_vAddedNodes;
     std::vector<CNode*> vNodes;
+    // CRYPTROX BEGIN
+    // vNodes by id, lets the socket handler resolve ready nodes without walking vNodes
+    std::unordered_map<NodeId, CNode*> mapNodesById GUARDED_BY(cs_vNodes);
+    // CRYPTROX END
     std::list<CNode*> vNodesDisconnected;
     mutable CCriticalSection cs_vNodes;
     std::atomic<NodeId> nLastNodeId;
@@ -550,6 +595,7 @@ private:
     std::atomic<int64_t> m_next_send_inv_to_incoming{0};
 
     friend struct CConnmanTest;
+    friend struct CConnmanSocketBench; // CRYPTROX
 };
 extern std::unique_ptr<CConnman> g_connman;
 void Discover();
@@ -793,6 +839,12 @@ public:
     const uint64_t nKeyedNetGroup;
     std::atomic_bool fPauseRecv;
     std::atomic_bool fPauseSend;
+    // CRYPTROX BEGIN
+    // Socket readiness, only accessed by the socket handler thread
+    bool fSocketReadable = false;
+    bool fSocketWritable = false;
+    bool fSocketError = false;
+    // CRYPTROX END
 protected:
 
     mapMsgCmdSize mapSendBytesPerMsgCmd;
@@ -1093,14 +1093,16 @@ bool static AlreadyHave(const CInv& inv) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
     case MSG_SPORK:
         return mapSporks.count(inv.hash);
 
+    // CRYPTROX BEGIN
     case MSG_MASTERNODE_PAYMENT_VOTE:
-        return mnpayments.mapMasternodePaymentVotes.count(inv.hash);
+        return mnpayments.HasPaymentVote(inv.hash);
 
     case MSG_MASTERNODE_PAYMENT_BLOCK:
         {
             BlockMap::iterator mi = mapBlockIndex.find(inv.hash);
-            return mi != mapBlockIndex.end() && mnpayments.mapMasternodeBlocks.find(mi->second->nHeight) != mnpayments.mapMasternodeBlocks.end();
+            return mi != mapBlockIndex.end() && mnpayments.HasBlockPayees(mi->second->nHeight);
         }
+    // CRYPTROX END
 
     case MSG_MASTERNODE_ANNOUNCE:
         return mnodeman.mapSeenMasternodeBroadcast.count(inv.hash) && !mnodeman.IsMnbRecoveryRequested(inv.hash);
@@ -1332,6 +1334,10 @@ void static ProcessGetData(CNode* pfrom, const CChainParams& chainparams, CConnm
     std::deque<CInv>::iterator it = pfrom->vRecvGetData.begin();
     std::vector<CInv> vNotFound;
     const CNetMsgMaker msgMaker(pfrom->GetSendVersion());
+    // CRYPTROX BEGIN
+    // payment votes read from the store once cs_main is released, with the block height of MSG_MASTERNODE_PAYMENT_BLOCK
+    std::vector<std::pair<CInv, int> > vPaymentVoteInv;
+    // CRYPTROX END
     {
         LOCK(cs_main);
 
@@ -1441,34 +1447,21 @@ void static ProcessGetData(CNode* pfrom, const CChainParams& chainparams, CConnm
                     }
                 }
 
+                // CRYPTROX BEGIN
+                // votes may have to be read from the payment vote store, that is done without cs_main below
                 if (!pushed && inv.type == MSG_MASTERNODE_PAYMENT_VOTE) {
-                    if(mnpayments.HasVerifiedPaymentVote(inv.hash)) {
-                        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-                        ss.reserve(1000);
-                        ss << mnpayments.mapMasternodePaymentVotes[inv.hash];
-                        connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::MASTERNODEPAYMENTVOTE, ss));
-                        pushed = true;
-                    }
+                    vPaymentVoteInv.emplace_back(inv, 0);
+                    continue;
                 }
 
                 if (!pushed && inv.type == MSG_MASTERNODE_PAYMENT_BLOCK) {
                     BlockMap::iterator mi = mapBlockIndex.find(inv.hash);
-                    LOCK(cs_mapMasternodeBlocks);
-                    if (mi != mapBlockIndex.end() && mnpayments.mapMasternodeBlocks.count(mi->second->nHeight)) {
-                        for (CMasternodePayee& payee : mnpayments.mapMasternodeBlocks[mi->second->nHeight].vecPayees) {
-                            std::vector<uint256> vecVoteHashes = payee.GetVoteHashes();
-                            for (uint256& hash : vecVoteHashes) {
-                                if(mnpayments.HasVerifiedPaymentVote(hash)) {
-                                    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-                                    ss.reserve(1000);
-                                    ss << mnpayments.mapMasternodePaymentVotes[hash];
-                                    connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::MASTERNODEPAYMENTVOTE, ss));
-                                }
-                            }
-                        }
-                        pushed = true;
+                    if (mi != mapBlockIndex.end()) {
+                        vPaymentVoteInv.emplace_back(inv, mi->second->nHeight);
+                        continue;
                     }
                 }
+                // CRYPTROX END
 
                 if (!pushed && inv.type == MSG_MASTERNODE_ANNOUNCE) {
                     if(mnodeman.mapSeenMasternodeBroadcast.count(inv.hash)){
@@ -1557,6 +1550,30 @@ void static ProcessGetData(CNode* pfrom, const CChainParams& chainparams, CConnm
         }
     } // release cs_main
 
+    // CRYPTROX BEGIN
+    for (const auto& invpair : vPaymentVoteInv) {
+        std::vector<CMasternodePaymentVote> vecVotes;
+        bool fFound;
+        if (invpair.first.type == MSG_MASTERNODE_PAYMENT_VOTE) {
+            CMasternodePaymentVote vote;
+            fFound = mnpayments.GetPaymentVote(invpair.first.hash, vote);
+            if (fFound) vecVotes.push_back(vote);
+        } else {
+            fFound = mnpayments.GetBlockPaymentVotes(invpair.second, vecVotes);
+        }
+        if (!fFound) {
+            vNotFound.push_back(invpair.first);
+            continue;
+        }
+        for (const auto& vote : vecVotes) {
+            CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+            ss.reserve(1000);
+            ss << vote;
+            connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::MASTERNODEPAYMENTVOTE, ss));
+        }
+    }
+    // CRYPTROX END
+
     if (it != pfrom->vRecvGetData.end() && !pfrom->fPauseSend) {
         const CInv &inv = *it;
         if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK || inv.type == MSG_CMPCT_BLOCK || inv.type == MSG_WITNESS_BLOCK) {
@@ -1824,7 +1841,101 @@ bool static ProcessHeadersMessage(CNode *pfrom, CConnman *connman, const std::ve
     return true;
 }
 
-bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, int64_t nTimeReceived, const CChainParams& chainparams, CConnman* connman, const std::atomic<bool>& interruptMsgProc, bool enable_bip61)
+// CRYPTROX BEGIN
+namespace {
+/** Handler for a Dash extension message, called once the peer has completed the handshake */
+typedef void (*ExtensionMessageHandler)(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman);
+
+void RegisterExtensionHandler(std::vector<ExtensionMessageHandler>& vHandlers, const char* pszCommand, ExtensionMessageHandler handler)
+{
+    int nCommandId = GetNetMessageTypeId(pszCommand);
+    assert(nCommandId >= 0 && vHandlers[nCommandId] == nullptr);
+    vHandlers[nCommandId] = handler;
+}
+
+void ProcessPrivateSendQueue(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman)
+{
+    // dsq is the only message handled by both the client and the server, each reads its own copy
+#ifdef ENABLE_WALLET
+    CDataStream vRecvClient(vRecv);
+    privateSendClient.ProcessMessage(pfrom, strCommand, vRecvClient, connman);
+#endif // ENABLE_WALLET
+    privateSendServer.ProcessMessage(pfrom, strCommand, vRecv, connman);
+}
+
+/**
+ * Handlers for the extension messages, indexed by GetNetMessageTypeId(). Message types without a
+ * handler (e.g. the masternode list and payment messages, which are disabled) are known but ignored.
+ */
+const std::vector<ExtensionMessageHandler>& GetExtensionHandlers()
+{
+    static const std::vector<ExtensionMessageHandler> vHandlers = [] {
+        std::vector<ExtensionMessageHandler> vRet(getAllNetMessageTypes().size(), nullptr);
+#ifdef ENABLE_WALLET
+        auto client = [](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) { privateSendClient.ProcessMessage(pfrom, strCommand, vRecv, connman); };
+        RegisterExtensionHandler(vRet, NetMsgType::DSSTATUSUPDATE, client);
+        RegisterExtensionHandler(vRet, NetMsgType::DSFINALTX, client);
+        RegisterExtensionHandler(vRet, NetMsgType::DSCOMPLETE, client);
+#endif // ENABLE_WALLET
+        RegisterExtensionHandler(vRet, NetMsgType::DSQUEUE, ProcessPrivateSendQueue);
+        auto server = [](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) { privateSendServer.ProcessMessage(pfrom, strCommand, vRecv, connman); };
+        RegisterExtensionHandler(vRet, NetMsgType::DSACCEPT, server);
+        RegisterExtensionHandler(vRet, NetMsgType::DSVIN, server);
+        RegisterExtensionHandler(vRet, NetMsgType::DSSIGNFINALTX, server);
+        RegisterExtensionHandler(vRet, NetMsgType::TXLOCKVOTE, [](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) { instantsend.ProcessMessage(pfrom, strCommand, vRecv, connman); });
+        auto spork = [](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) { sporkManager.ProcessSpork(pfrom, strCommand, vRecv, connman); };
+        RegisterExtensionHandler(vRet, NetMsgType::SPORK, spork);
+        RegisterExtensionHandler(vRet, NetMsgType::GETSPORKS, spork);
+        RegisterExtensionHandler(vRet, NetMsgType::SYNCSTATUSCOUNT, [](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) { masternodeSync.ProcessMessage(pfrom, strCommand, vRecv); });
+        auto gov = [](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) { governance.ProcessMessage(pfrom, strCommand, vRecv, connman); };
+        RegisterExtensionHandler(vRet, NetMsgType::MNGOVERNANCESYNC, gov);
+        RegisterExtensionHandler(vRet, NetMsgType::MNGOVERNANCEOBJECT, gov);
+        RegisterExtensionHandler(vRet, NetMsgType::MNGOVERNANCEOBJECTVOTE, gov);
+        RegisterExtensionHandler(vRet, NetMsgType::MNGOVERNANCEVOTESUMMARY, gov);
+        return vRet;
+    }();
+    return vHandlers;
+}
+
+/** Dispatch an extension message to its handler, returns false if nCommandId has no handler */
+bool DispatchExtensionMessage(CNode* pfrom, int nCommandId, const std::string& strCommand, CDataStream& vRecv, CConnman& connman)
+{
+    if (nCommandId < 0)
+        return false;
+    ExtensionMessageHandler handler = GetExtensionHandlers()[nCommandId];
+    if (handler == nullptr)
+        return false;
+    handler(pfrom, strCommand, vRecv, connman);
+    return true;
+}
+
+struct CNetMessageCounter {
+    std::atomic<uint64_t> nCount{0};
+    std::atomic<uint64_t> nTimeMicros{0};
+};
+
+/** Counters indexed by GetNetMessageTypeId(), the last entry collects unknown message types */
+std::vector<CNetMessageCounter>& GetNetMessageCounters()
+{
+    static std::vector<CNetMessageCounter> vCounters(getAllNetMessageTypes().size() + 1);
+    return vCounters;
+}
+} // namespace
+
+std::vector<CNetMessageStats> GetNetMessageStats()
+{
+    const std::vector<std::string>& allMessages = getAllNetMessageTypes();
+    const std::vector<CNetMessageCounter>& vCounters = GetNetMessageCounters();
+    std::vector<CNetMessageStats> vStats;
+    vStats.reserve(vCounters.size());
+    for (size_t i = 0; i < vCounters.size(); i++) {
+        vStats.push_back({i < allMessages.size() ? allMessages[i] : "*other*", vCounters[i].nCount.load(), vCounters[i].nTimeMicros.load()});
+    }
+    return vStats;
+}
+// CRYPTROX END
+
+bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, int nCommandId, CDataStream& vRecv, int64_t nTimeReceived, const CChainParams& chainparams, CConnman* connman, const std::atomic<bool>& interruptMsgProc, bool enable_bip61)
 {
     LogPrint(BCLog::NET, "received: %s (%u bytes) peer=%d\n", SanitizeString(strCommand), vRecv.size(), pfrom->GetId());
     if (gArgs.IsArgSet("-dropmessagestest") && GetRand(gArgs.GetArg("-dropmessagestest", 0)) == 0)
@@ -2113,6 +2224,13 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return false;
     }
 
+    // CRYPTROX BEGIN
+    else if (DispatchExtensionMessage(pfrom, nCommandId, strCommand, vRecv, *connman))
+    {
+        // Dash extension message, handled by its subsystem
+    }
+    // CRYPTROX END
+
     else if (strCommand == NetMsgType::ADDR)
     {
         std::vector<CAddress> vAddr;
@@ -2922,7 +3040,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         } // cs_main
 
         if (fProcessBLOCKTXN)
-            return ProcessMessage(pfrom, NetMsgType::BLOCKTXN, blockTxnMsg, nTimeReceived, chainparams, connman, interruptMsgProc, enable_bip61);
+            return ProcessMessage(pfrom, NetMsgType::BLOCKTXN, GetNetMessageTypeId(NetMsgType::BLOCKTXN), blockTxnMsg, nTimeReceived, chainparams, connman, interruptMsgProc, enable_bip61);
 
         if (fRevertToHeaderProcessing) {
             // Headers received from HB compact block peers are permitted to be
@@ -3299,41 +3417,14 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
     }
     else
     {
-        // Dash
-        bool found = false;
-        const std::vector<std::string> &allMessages = getAllNetMessageTypes();
-        for (const std::string msg : allMessages) {
-            if(msg == strCommand) {
-                found = true;
-                break;
-            }
-        }
-
-        if (found)
-        {
-            //probably one the extensions
-#ifdef ENABLE_WALLET
-            privateSendClient.ProcessMessage(pfrom, strCommand, vRecv, *connman);
-#endif // ENABLE_WALLET
-            privateSendServer.ProcessMessage(pfrom, strCommand, vRecv, *connman);
-            // CRYPTROX BEGIN
-            //mnodeman.ProcessMessage(pfrom, strCommand, vRecv, *connman);
-            //mnpayments.ProcessMessage(pfrom, strCommand, vRecv, *connman);
-            // CRYPTROX END
-            instantsend.ProcessMessage(pfrom, strCommand, vRecv, *connman);
-            sporkManager.ProcessSpork(pfrom, strCommand, vRecv, *connman);
-            masternodeSync.ProcessMessage(pfrom, strCommand, vRecv);
-            governance.ProcessMessage(pfrom, strCommand, vRecv, *connman);
+        // CRYPTROX BEGIN
+        // Extension messages were dispatched above, the known ones left here have no handler
+        if (nCommandId < 0) {
+            // Ignore unknown commands for extensibility
+            LogPrint(BCLog::NET, "Unknown command \"%s\" from peer=%d\n", SanitizeString(strCommand), pfrom->GetId());
         }
-        //
-    else
-    {
-        // Ignore unknown commands for extensibility
-        LogPrint(BCLog::NET, "Unknown command \"%s\" from peer=%d\n", SanitizeString(strCommand), pfrom->GetId());
-    }
-    // Dash
+        // CRYPTROX END
     }
-    //
 
     return true;
 }
@@ -3445,7 +3536,14 @@ bool PeerLogicValidation::ProcessMessages(CNode* pfrom, std::atomic<bool>& inter
     bool fRet = false;
     try
     {
-        fRet = ProcessMessage(pfrom, strCommand, vRecv, msg.nTime, chainparams, connman, interruptMsgProc, m_enable_bip61);
+        // CRYPTROX BEGIN
+        const int nCommandId = GetNetMessageTypeId(strCommand);
+        const int64_t nTimeStart = GetTimeMicros();
+        fRet = ProcessMessage(pfrom, strCommand, nCommandId, vRecv, msg.nTime, chainparams, connman, interruptMsgProc, m_enable_bip61);
+        CNetMessageCounter& counter = GetNetMessageCounters()[nCommandId < 0 ? getAllNetMessageTypes().size() : (size_t)nCommandId];
+        counter.nCount++;
+        counter.nTimeMicros += GetTimeMicros() - nTimeStart;
+        // CRYPTROX END
         if (interruptMsgProc)
             return false;
         if (!pfrom->vRecvGetData.empty())
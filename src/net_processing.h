@@ -98,4 +98,15 @@ struct CNodeStateStats {
 /** Get statistics from node state */
 bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats);
 
+// CRYPTROX BEGIN
+struct CNetMessageStats {
+    std::string strCommand;
+    uint64_t nCount;
+    uint64_t nTimeMicros;
+};
+
+/** Get the number of processed messages and the time spent in ProcessMessage, per message type */
+std::vector<CNetMessageStats> GetNetMessageStats();
+// CRYPTROX END
+
 #endif // CRYPTROX_NET_PROCESSING_H
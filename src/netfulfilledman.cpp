@@ -65,6 +65,14 @@ void CNetFulfilledRequestManager::Clear()
     mapFulfilledRequests.clear();
 }
 
+// CRYPTROX BEGIN
+void CNetFulfilledRequestManager::CopyForDump(CNetFulfilledRequestManager& netfulfilledmanCopy)
+{
+    LOCK(cs_mapFulfilledRequests);
+    netfulfilledmanCopy.mapFulfilledRequests = mapFulfilledRequests;
+}
+// CRYPTROX END
+
 std::string CNetFulfilledRequestManager::ToString() const
 {
     std::ostringstream info;
@@ -43,6 +43,10 @@ public:
 
     void CheckAndRemove();
     void Clear();
+    // CRYPTROX BEGIN
+    /// Copy the state that is serialized into an empty manager, see CFlatDB::Dump
+    void CopyForDump(CNetFulfilledRequestManager& netfulfilledmanCopy);
+    // CRYPTROX END
 
     std::string ToString() const;
 };
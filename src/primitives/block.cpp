@@ -13,24 +13,33 @@
 
 #include <crypto/x16r.h>
 
+#include <cassert>
+
 uint256 CBlockHeader::GetHash() const
 {
     return SerializeHash(*this);
 }
 
-uint256 CBlockHeader::GetPoWHash() const
+uint256 CBlockHeader::GetPoWHash(X16RCaller caller) const
 {
     uint256 powHash = uint256S("ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
 
     switch (nVersion & ALGO_VERSION_MASK)
     {
-        case ALGO_X16R:    powHash = HashX16R(BEGIN(nVersion), END(nNonce), hashPrevBlock); break;
+        case ALGO_X16R:    X16RCountHash(caller); powHash = HashX16R(BEGIN(nVersion), END(nNonce), hashPrevBlock); break;
         default:           break; // CRYPTROX TODO: we should not be here
     }
 
     return powHash;
 }
 
+uint256 CBlockHeader::GetPoWHash(const CX16RPreparedHeader& prepared) const
+{
+    // a prepared header only exists for X16R
+    assert((nVersion & ALGO_VERSION_MASK) == ALGO_X16R);
+    return prepared.Hash(nNonce);
+}
+
 unsigned int CBlockHeader::GetAlgoEfficiency(int nBlockHeight) const
 {
     switch (nVersion & ALGO_VERSION_MASK)
@@ -8,6 +8,7 @@
 #ifndef CRYPTROX_PRIMITIVES_BLOCK_H
 #define CRYPTROX_PRIMITIVES_BLOCK_H
 
+#include <crypto/x16r.h>
 #include <primitives/transaction.h>
 #include <serialize.h>
 #include <uint256.h>
@@ -75,7 +76,9 @@ public:
 
     uint256 GetHash() const;
 
-    uint256 GetPoWHash() const;
+    uint256 GetPoWHash(X16RCaller caller = X16RCaller::OTHER) const;
+    //! GetPoWHash() for nonce scanning of an X16R header, prepared must have been built from this header
+    uint256 GetPoWHash(const CX16RPreparedHeader& prepared) const;
 
     unsigned int GetAlgoEfficiency(int nBlockHeight) const;
 
@@ -18,9 +18,24 @@
 #include <txmempool.h>
 #include <util.h>
 #include <utilmoneystr.h>
+// CRYPTROX BEGIN
+#include <validation.h>
+
+#include <set>
+// CRYPTROX END
 
 CPrivateSendServer privateSendServer;
 
+// CRYPTROX BEGIN
+CPrivateSendServer::CPrivateSendServer() :
+    fUnitTest(false)
+{
+    SetNull();
+}
+
+CPrivateSendServer::~CPrivateSendServer() {}
+// CRYPTROX END
+
 void CPrivateSendServer::ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman)
 {
     if(!fMasterNode) return;
@@ -254,18 +269,14 @@ void CPrivateSendServer::ProcessMessage(CNode* pfrom, const std::string& strComm
 
         LogPrint(BCLog::PRIVATESEND, "DSSIGNFINALTX -- vecTxIn.size() %s\n", vecTxIn.size());
 
-        int nTxInIndex = 0;
-        int nTxInsCount = (int)vecTxIn.size();
-
-        for (const auto txin : vecTxIn) {
-            nTxInIndex++;
-            if(!AddScriptSig(txin)) {
-                LogPrint(BCLog::PRIVATESEND, "DSSIGNFINALTX -- AddScriptSig() failed at %d/%d, session: %d\n", nTxInIndex, nTxInsCount, nSessionID);
-                RelayStatus(STATUS_REJECTED, connman);
-                return;
-            }
-            LogPrint(BCLog::PRIVATESEND, "DSSIGNFINALTX -- AddScriptSig() %d/%d success\n", nTxInIndex, nTxInsCount);
+        // CRYPTROX BEGIN
+        if(!AddScriptSigs(vecTxIn)) {
+            LogPrint(BCLog::PRIVATESEND, "DSSIGNFINALTX -- AddScriptSigs() failed, session: %d\n", nSessionID);
+            RelayStatus(STATUS_REJECTED, connman);
+            return;
         }
+        LogPrint(BCLog::PRIVATESEND, "DSSIGNFINALTX -- AddScriptSigs() %d inputs success\n", vecTxIn.size());
+        // CRYPTROX END
         // all is good
         CheckPool(connman);
     }
@@ -275,6 +286,10 @@ void CPrivateSendServer::SetNull()
 {
     // MN side
     vecSessionCollaterals.clear();
+    // CRYPTROX BEGIN
+    pFinalTxData.reset();
+    vecFinalTxSpentOutputs.clear();
+    // CRYPTROX END
 
     CPrivateSendBase::SetNull();
 }
@@ -313,6 +328,17 @@ void CPrivateSendServer::CreateFinalTransaction(CConnman& connman)
 {
     LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::CreateFinalTransaction -- FINALIZE TRANSACTIONS\n");
 
+    // CRYPTROX BEGIN
+    BuildFinalTransaction();
+
+    // request signatures from clients
+    RelayFinalTransaction(finalMutableTransaction, connman);
+    SetState(POOL_STATE_SIGNING);
+}
+
+void CPrivateSendServer::BuildFinalTransaction()
+{
+    // CRYPTROX END
     CMutableTransaction txNew;
 
     // make our new transaction
@@ -330,9 +356,19 @@ void CPrivateSendServer::CreateFinalTransaction(CConnman& connman)
     finalMutableTransaction = txNew;
     LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::CreateFinalTransaction -- finalMutableTransaction=%s\n", txNew.ToString());
 
-    // request signatures from clients
-    RelayFinalTransaction(finalMutableTransaction, connman);
-    SetState(POOL_STATE_SIGNING);
+    // CRYPTROX BEGIN
+    // Neither changes while the clients sign, so compute them once for all signatures
+    std::map<COutPoint, CScript> mapPrevPubKeys;
+    for (const auto& entry : vecEntries)
+        for (const auto& txdsin : entry.vecTxDSIn)
+            mapPrevPubKeys.emplace(txdsin.prevout, txdsin.prevPubKey);
+
+    vecFinalTxSpentOutputs.clear();
+    vecFinalTxSpentOutputs.reserve(txNew.vin.size());
+    for (const auto& txin : txNew.vin)
+        vecFinalTxSpentOutputs.emplace_back(txNew.vout[0].nValue, mapPrevPubKeys[txin.prevout]);
+    pFinalTxData.reset(new PrecomputedTransactionData(txNew));
+    // CRYPTROX END
 }
 
 void CPrivateSendServer::CommitFinalTransaction(CConnman& connman)
@@ -535,50 +571,6 @@ void CPrivateSendServer::CheckForCompleteQueue(CConnman& connman)
     }
 }
 
-// Check to make sure a given input matches an input in the pool and its scriptSig is valid
-bool CPrivateSendServer::IsInputScriptSigValid(const CTxIn& txin)
-{
-    CMutableTransaction txNew;
-    txNew.vin.clear();
-    txNew.vout.clear();
-
-    int i = 0;
-    int nTxInIndex = -1;
-    CScript sigPubKey = CScript();
-
-    for (auto& entry : vecEntries) {
-
-        for (const auto& txout : entry.vecTxOut)
-            txNew.vout.push_back(txout);
-
-        for (const auto& txdsin : entry.vecTxDSIn) {
-            txNew.vin.push_back(txdsin);
-
-            if(txdsin.prevout == txin.prevout) {
-                nTxInIndex = i;
-                sigPubKey = txdsin.prevPubKey;
-            }
-            i++;
-        }
-    }
-
-    if(nTxInIndex >= 0) { //might have to do this one input at a time?
-        txNew.vin[nTxInIndex].scriptSig = txin.scriptSig;
-        LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::IsInputScriptSigValid -- verifying scriptSig %s\n", ScriptToAsmStr(txin.scriptSig).substr(0,24));
-        // CRYPTROX TODO: if(!VerifyScript(txNew.vin[nTxInIndex].scriptSig, sigPubKey, SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_STRICTENC, MutableTransactionSignatureChecker(&txNew, nTxInIndex))) {
-        if(!VerifyScript(txNew.vin[nTxInIndex].scriptSig, sigPubKey, &txNew.vin[nTxInIndex].scriptWitness , SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_STRICTENC, MutableTransactionSignatureChecker(&txNew, nTxInIndex, txNew.vout[0].nValue))) {
-            LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::IsInputScriptSigValid -- VerifyScript() failed on input %d\n", nTxInIndex);
-            return false;
-        }
-    } else {
-        LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::IsInputScriptSigValid -- Failed to find matching input in pool, %s\n", txin.ToString());
-        return false;
-    }
-
-    LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::IsInputScriptSigValid -- Successfully validated input and scriptSig\n");
-    return true;
-}
-
 //
 // Add a clients transaction to the pool
 //
@@ -628,42 +620,88 @@ bool CPrivateSendServer::AddEntry(const CDarkSendEntry& entryNew, PoolMessage& n
     return true;
 }
 
-bool CPrivateSendServer::AddScriptSig(const CTxIn& txinNew)
+// CRYPTROX BEGIN
+// Check that the txins match inputs of the final transaction and that their
+// scriptSigs are valid, then add them. Either all of them are added or none.
+bool CPrivateSendServer::AddScriptSigs(const std::vector<CTxIn>& vecTxIn)
 {
-    LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::AddScriptSig -- scriptSig=%s\n", ScriptToAsmStr(txinNew.scriptSig).substr(0,24));
+    if(!pFinalTxData) {
+        LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::AddScriptSigs -- no final transaction to sign\n");
+        return false;
+    }
+
+    CMutableTransaction txSigned(finalMutableTransaction);
+    std::vector<size_t> vecTxInIndex;
+    std::set<size_t> setTxInIndex;
+    std::set<CScript> setScriptSigs;
+    vecTxInIndex.reserve(vecTxIn.size());
 
-    for (const auto& entry : vecEntries) {
-        for (const auto& txdsin : entry.vecTxDSIn) {
-            if(txdsin.scriptSig == txinNew.scriptSig) {
-                LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::AddScriptSig -- already exists\n");
-                return false;
+    for (const auto& txinNew : vecTxIn) {
+        LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::AddScriptSigs -- scriptSig=%s\n", ScriptToAsmStr(txinNew.scriptSig).substr(0,24));
+
+        bool fExists = !setScriptSigs.insert(txinNew.scriptSig).second;
+        for (const auto& entry : vecEntries) {
+            for (const auto& txdsin : entry.vecTxDSIn) {
+                if(txdsin.scriptSig == txinNew.scriptSig) fExists = true;
             }
         }
-    }
+        if(fExists) {
+            LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::AddScriptSigs -- already exists\n");
+            return false;
+        }
 
-    if(!IsInputScriptSigValid(txinNew)) {
-        LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::AddScriptSig -- Invalid scriptSig\n");
-        return false;
+        size_t nTxInIndex = 0;
+        while(nTxInIndex < txSigned.vin.size() &&
+                !(txSigned.vin[nTxInIndex].prevout == txinNew.prevout && txSigned.vin[nTxInIndex].nSequence == txinNew.nSequence)) {
+            nTxInIndex++;
+        }
+        if(nTxInIndex == txSigned.vin.size() || !setTxInIndex.insert(nTxInIndex).second) {
+            LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::AddScriptSigs -- Failed to find matching input in pool, %s\n", txinNew.ToString());
+            return false;
+        }
+
+        txSigned.vin[nTxInIndex].scriptSig = txinNew.scriptSig;
+        vecTxInIndex.push_back(nTxInIndex);
     }
 
-    LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::AddScriptSig -- scriptSig=%s new\n", ScriptToAsmStr(txinNew.scriptSig).substr(0,24));
+    // The signature hash does not cover scriptSigs, so a single copy of the
+    // final transaction carrying all new scriptSigs serves every check
+    const CTransaction txTo(txSigned);
+    std::vector<CScriptCheck> vChecks;
+    vChecks.reserve(vecTxInIndex.size());
+    for (size_t nTxInIndex : vecTxInIndex) {
+        vChecks.emplace_back(vecFinalTxSpentOutputs[nTxInIndex], txTo, nTxInIndex, SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_STRICTENC, true, pFinalTxData.get());
+    }
 
-    for (auto& txin : finalMutableTransaction.vin) {
-        if(txinNew.prevout == txin.prevout && txin.nSequence == txinNew.nSequence) {
-            txin.scriptSig = txinNew.scriptSig;
-            LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::AddScriptSig -- adding to finalMutableTransaction, scriptSig=%s\n", ScriptToAsmStr(txinNew.scriptSig).substr(0,24));
+    // A participant signs only a few inputs, run the checks right here rather than
+    // waiting for the script check queue, which is held while a block is connected
+    for (auto& check : vChecks) {
+        if(!check()) {
+            LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::AddScriptSigs -- VerifyScript() failed: %s\n", ScriptErrorString(check.GetScriptError()));
+            return false;
         }
     }
-    for(int i = 0; i < GetEntriesCount(); i++) {
-        if(vecEntries[i].AddScriptSig(txinNew)) {
-            LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::AddScriptSig -- adding to entries, scriptSig=%s\n", ScriptToAsmStr(txinNew.scriptSig).substr(0,24));
-            return true;
+
+    for (size_t i = 0; i < vecTxIn.size(); i++) {
+        finalMutableTransaction.vin[vecTxInIndex[i]].scriptSig = vecTxIn[i].scriptSig;
+
+        bool fAdded = false;
+        for (auto& entry : vecEntries) {
+            if(entry.AddScriptSig(vecTxIn[i])) {
+                fAdded = true;
+                break;
+            }
+        }
+        if(!fAdded) {
+            LogPrintf("CPrivateSendServer::AddScriptSigs -- Couldn't set sig!\n" );
+            return false;
         }
     }
 
-    LogPrintf("CPrivateSendServer::AddScriptSig -- Couldn't set sig!\n" );
-    return false;
+    LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::AddScriptSigs -- Successfully validated and added %d scriptSigs\n", vecTxIn.size());
+    return true;
 }
+// CRYPTROX END
 
 // Check to make sure everything is signed
 bool CPrivateSendServer::IsSignaturesComplete()
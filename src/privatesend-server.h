@@ -9,6 +9,12 @@
 #include <net.h>
 #include <privatesend.h>
 
+// CRYPTROX BEGIN
+#include <memory>
+
+struct PrecomputedTransactionData;
+// CRYPTROX END
+
 class CPrivateSendServer;
 
 // The main object for accessing mixing
@@ -25,10 +31,19 @@ private:
 
     bool fUnitTest;
 
+    // CRYPTROX BEGIN
+    // Built once per session in CreateFinalTransaction: the sighash midstates
+    // of finalMutableTransaction and the output each of its inputs spends
+    std::unique_ptr<PrecomputedTransactionData> pFinalTxData;
+    std::vector<CTxOut> vecFinalTxSpentOutputs;
+    // CRYPTROX END
+
     /// Add a clients entry to the pool
     bool AddEntry(const CDarkSendEntry& entryNew, PoolMessage& nMessageIDRet);
-    /// Add signature to a txin
-    bool AddScriptSig(const CTxIn& txin);
+    // CRYPTROX BEGIN
+    /// Verify the signatures of a set of txins against the final transaction and add them
+    bool AddScriptSigs(const std::vector<CTxIn>& vecTxIn);
+    // CRYPTROX END
 
     /// Charge fees to bad actors (Charge clients a fee if they're abusive)
     void ChargeFees(CConnman& connman);
@@ -39,6 +54,10 @@ private:
     void CheckPool(CConnman& connman);
 
     void CreateFinalTransaction(CConnman& connman);
+    // CRYPTROX BEGIN
+    /// Build finalMutableTransaction from the entries and prepare the signature checks
+    void BuildFinalTransaction();
+    // CRYPTROX END
     void CommitFinalTransaction(CConnman& connman);
 
     /// Is this nDenom and txCollateral acceptable?
@@ -50,8 +69,6 @@ private:
 
     /// Check that all inputs are signed. (Are all inputs signed?)
     bool IsSignaturesComplete();
-    /// Check to make sure a given input matches an input in the pool and its scriptSig is valid
-    bool IsInputScriptSigValid(const CTxIn& txin);
     /// Are these outputs compatible with other client in the pool?
     bool IsOutputsCompatibleWithSessionDenom(const std::vector<CTxOut>& vecTxOut);
 
@@ -67,13 +84,15 @@ private:
     void SetNull();
 
 public:
-    CPrivateSendServer() :
-        fUnitTest(false) { SetNull(); }
+    CPrivateSendServer();
+    ~CPrivateSendServer();
 
     void ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman);
 
     void CheckTimeout(CConnman& connman);
     void CheckForCompleteQueue(CConnman& connman);
+
+    friend struct CPrivateSendServerTest; // CRYPTROX
 };
 
 void ThreadCheckPrivateSendServer(CConnman& connman);
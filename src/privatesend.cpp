@@ -41,13 +41,20 @@ bool CDarkSendEntry::AddScriptSig(const CTxIn& txin)
     return false;
 }
 
+// CRYPTROX BEGIN
+uint256 CDarksendQueue::GetSignatureHash() const
+{
+    CSignedPayload payload;
+    payload.WriteTxIn(vin) << nDenom << nTime << fReady;
+    return payload.GetHash();
+}
+// CRYPTROX END
+
 bool CDarksendQueue::Sign()
 {
     if(!fMasterNode) return false;
 
-    std::string strMessage = vin.ToString() + boost::lexical_cast<std::string>(nDenom) + boost::lexical_cast<std::string>(nTime) + boost::lexical_cast<std::string>(fReady);
-
-    if(!CMessageSigner::SignMessage(strMessage, vchSig, activeMasternode.keyMasternode)) {
+    if(!CHashSigner::SignHash(GetSignatureHash(), activeMasternode.keyMasternode, vchSig)) {
         LogPrintf("CDarksendQueue::Sign -- SignMessage() failed, %s\n", ToString());
         return false;
     }
@@ -57,10 +64,9 @@ bool CDarksendQueue::Sign()
 
 bool CDarksendQueue::CheckSignature(const CPubKey& pubKeyMasternode)
 {
-    std::string strMessage = vin.ToString() + boost::lexical_cast<std::string>(nDenom) + boost::lexical_cast<std::string>(nTime) + boost::lexical_cast<std::string>(fReady);
     std::string strError = "";
 
-    if(!CMessageSigner::VerifyMessage(pubKeyMasternode, vchSig, strMessage, strError)) {
+    if(!CHashSigner::VerifyHash(GetSignatureHash(), pubKeyMasternode, vchSig, strError)) {
         LogPrintf("CDarksendQueue::CheckSignature -- Got bad Masternode queue signature: %s; error: %s\n", ToString(), strError);
         return false;
     }
@@ -79,13 +85,20 @@ bool CDarksendQueue::Relay(CConnman& connman)
     return true;
 }
 
+// CRYPTROX BEGIN
+uint256 CDarksendBroadcastTx::GetSignatureHash() const
+{
+    CSignedPayload payload;
+    payload << tx.GetHash() << sigTime;
+    return payload.GetHash();
+}
+// CRYPTROX END
+
 bool CDarksendBroadcastTx::Sign()
 {
     if(!fMasterNode) return false;
 
-    std::string strMessage = tx.GetHash().ToString() + boost::lexical_cast<std::string>(sigTime);
-
-    if(!CMessageSigner::SignMessage(strMessage, vchSig, activeMasternode.keyMasternode)) {
+    if(!CHashSigner::SignHash(GetSignatureHash(), activeMasternode.keyMasternode, vchSig)) {
         LogPrintf("CDarksendBroadcastTx::Sign -- SignMessage() failed\n");
         return false;
     }
@@ -95,10 +108,9 @@ bool CDarksendBroadcastTx::Sign()
 
 bool CDarksendBroadcastTx::CheckSignature(const CPubKey& pubKeyMasternode)
 {
-    std::string strMessage = tx.GetHash().ToString() + boost::lexical_cast<std::string>(sigTime);
     std::string strError = "";
 
-    if(!CMessageSigner::VerifyMessage(pubKeyMasternode, vchSig, strMessage, strError)) {
+    if(!CHashSigner::VerifyHash(GetSignatureHash(), pubKeyMasternode, vchSig, strError)) {
         LogPrintf("CDarksendBroadcastTx::CheckSignature -- Got bad dstx signature, error: %s\n", strError);
         return false;
     }
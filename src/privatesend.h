@@ -189,6 +189,7 @@ public:
     bool Sign();
     /// Check if we have a valid Masternode address
     bool CheckSignature(const CPubKey& pubKeyMasternode);
+    uint256 GetSignatureHash() const; // CRYPTROX
 
     bool Relay(CConnman &connman);
 
@@ -263,6 +264,7 @@ public:
 
     bool Sign();
     bool CheckSignature(const CPubKey& pubKeyMasternode);
+    uint256 GetSignatureHash() const; // CRYPTROX
 
     void SetConfirmedHeight(int nConfirmedHeightIn) { nConfirmedHeight = nConfirmedHeightIn; }
     bool IsExpired(int nHeight);
@@ -10,6 +10,8 @@
 #include <util.h>
 #include <utilstrencodings.h>
 
+#include <unordered_map>
+
 #ifndef WIN32
 # include <arpa/inet.h>
 #endif
@@ -68,6 +70,7 @@ const char *MNGOVERNANCESYNC="govsync";
 const char *MNGOVERNANCEOBJECT="govobj";
 const char *MNGOVERNANCEOBJECTVOTE="govobjvote";
 const char *MNVERIFY="mnv";
+const char *MNGOVERNANCEVOTESUMMARY="govvotesum"; // CRYPTROX
 } // namespace NetMsgType
 
 /** All known message types. Keep this in the same order as the list of
@@ -125,6 +128,7 @@ const static std::string allNetMessageTypes[] = {
     NetMsgType::MNGOVERNANCEOBJECT,
     NetMsgType::MNGOVERNANCEOBJECTVOTE,
     NetMsgType::MNVERIFY,
+    NetMsgType::MNGOVERNANCEVOTESUMMARY, // CRYPTROX
 };
 const static std::vector<std::string> allNetMessageTypesVec(allNetMessageTypes, allNetMessageTypes+ARRAYLEN(allNetMessageTypes));
 
@@ -267,3 +271,18 @@ const std::vector<std::string> &getAllNetMessageTypes()
 {
     return allNetMessageTypesVec;
 }
+
+// CRYPTROX BEGIN
+int GetNetMessageTypeId(const std::string& strCommand)
+{
+    static const std::unordered_map<std::string, int> mapNetMessageTypeIds = [] {
+        std::unordered_map<std::string, int> mapRet;
+        for (size_t i = 0; i < allNetMessageTypesVec.size(); i++)
+            mapRet.emplace(allNetMessageTypesVec[i], (int)i);
+        return mapRet;
+    }();
+
+    auto it = mapNetMessageTypeIds.find(strCommand);
+    return it == mapNetMessageTypeIds.end() ? -1 : it->second;
+}
+// CRYPTROX END
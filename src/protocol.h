@@ -266,10 +266,19 @@ extern const char *MNGOVERNANCESYNC;
 extern const char *MNGOVERNANCEOBJECT;
 extern const char *MNGOVERNANCEOBJECTVOTE;
 extern const char *MNVERIFY;
+/**
+ * The govvotesum message carries a governance object hash and a summary of
+ * the votes the sender has for it, the peer announces the votes it is missing.
+ */
+extern const char *MNGOVERNANCEVOTESUMMARY; // CRYPTROX
 };
 
 /* Get a vector of all valid message types (see above) */
 const std::vector<std::string> &getAllNetMessageTypes();
+// CRYPTROX BEGIN
+/* Get the index of a message type in getAllNetMessageTypes(), or -1 if the type is unknown */
+int GetNetMessageTypeId(const std::string& strCommand);
+// CRYPTROX END
 
 /** nServices flags */
 enum ServiceFlags : uint64_t {
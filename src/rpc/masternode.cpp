@@ -34,9 +34,10 @@ static std::string FormatVersion(int nVersion)
 }
 // CRYPTROX END
 
+UniValue masternodelist(const JSONRPCRequest& request);
+
 #ifdef ENABLE_WALLET
 void EnsureWalletIsUnlocked();
-UniValue masternodelist(const JSONRPCRequest& request);
 
 UniValue privatesend(const JSONRPCRequest& request)
 {
@@ -153,7 +154,7 @@ UniValue masternode(const JSONRPCRequest& request)
          strCommand != "debug" && strCommand != "current" && strCommand != "winner" && strCommand != "winners" && strCommand != "genkey" &&
          // CRYPTROX BEGIN
          //strCommand != "connect" && strCommand != "status"))
-         strCommand != "connect" && strCommand != "status" && strCommand != "collateral"))
+         strCommand != "connect" && strCommand != "status" && strCommand != "collateral" && strCommand != "maintenance"))
          // CRYPTROX END
             throw std::runtime_error(
                 "masternode \"command\"...\n"
@@ -176,6 +177,7 @@ UniValue masternode(const JSONRPCRequest& request)
                 "  winners      - Print list of masternode winners\n"
                 // CRYPTROX BEGIN
                 "  collateral   - Print actual masternode collateral value\n"
+                "  maintenance  - Print run count, duration and visited entries of the masternode list maintenance tasks\n"
                 // CRYPTROX END
                 );
 
@@ -487,6 +489,20 @@ UniValue masternode(const JSONRPCRequest& request)
 
         return ValueFromAmount(nValue);
     }
+
+    if (strCommand == "maintenance")
+    {
+        UniValue obj(UniValue::VOBJ);
+        for (const CMasternodeMaintenanceStats& stats : GetMasternodeMaintenanceStats()) {
+            UniValue entry(UniValue::VOBJ);
+            entry.pushKV("count", stats.nCount);
+            entry.pushKV("time_micros", stats.nTimeMicros);
+            entry.pushKV("last_time_micros", stats.nLastTimeMicros);
+            entry.pushKV("items", stats.nItems);
+            obj.pushKV(stats.strTask, entry);
+        }
+        return obj;
+    }
     // CRYPTROX END
 
     return NullUniValue;
@@ -554,9 +570,9 @@ UniValue masternodelist(const JSONRPCRequest& request)
             obj.push_back(Pair(strOutpoint, s.first));
         }
     } else {
-        std::map<COutPoint, CMasternode> mapMasternodes = mnodeman.GetFullMasternodeMap();
-        for (auto& mnpair : mapMasternodes) {
-            CMasternode mn = mnpair.second;
+        CMasternodeMan::snapshot_t mapMasternodes = mnodeman.GetSnapshot();
+        for (const auto& mnpair : *mapMasternodes) {
+            const CMasternode& mn = *mnpair.second;
             std::string strOutpoint = mnpair.first.ToStringShort();
             if (strMode == "activeseconds") {
                 if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
@@ -12,6 +12,7 @@
 #include <consensus/params.h>
 #include <consensus/validation.h>
 #include <core_io.h>
+#include <crypto/x16r.h>
 #include <validation.h>
 #include <key_io.h>
 #include <miner.h>
@@ -144,7 +145,10 @@ UniValue generateBlocks(std::shared_ptr<CReserveScript> coinbaseScript, int nGen
             LOCK(cs_main);
             IncrementExtraNonce(pblock, chainActive.Tip(), nExtraNonce);
         }
-        while (nMaxTries > 0 && pblock->nNonce < nInnerLoopCount && !CheckProofOfWork(pblock->GetPoWHash(), pblock->nBits, Params().GetConsensus())) {
+        // Only the nonce changes below, so derive the X16R algorithm order
+        // and first round midstate once per block template.
+        CX16RPreparedHeader powHeader(UBEGIN(pblock->nVersion));
+        while (nMaxTries > 0 && pblock->nNonce < nInnerLoopCount && !CheckProofOfWork(pblock->GetPoWHash(powHeader), pblock->nBits, Params().GetConsensus())) {
             ++pblock->nNonce;
             --nMaxTries;
         }
@@ -242,6 +246,61 @@ static UniValue getmininginfo(const JSONRPCRequest& request)
     return obj;
 }
 
+static UniValue getpowstats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getpowstats\n"
+            "\nReturns statistics about the X16R proof of work hashing done by this node since startup."
+            "\nResult:\n"
+            "{\n"
+            "  \"algorithms\": {          (object) Per primitive statistics\n"
+            "    \"name\": {\n"
+            "      \"hashes\": nnn,       (numeric) Digests computed by this primitive\n"
+            "      \"time\": x.xxx,       (numeric) Seconds spent in this primitive while -powstatstiming was set\n"
+            "    }, ...\n"
+            "  },\n"
+            "  \"callers\": {             (object) Proof of work hashes computed, by reason\n"
+            "    \"header_sync\": nnn,    (numeric) Accepting block headers\n"
+            "    \"block_check\": nnn,    (numeric) Checking full blocks\n"
+            "    \"block_read\": nnn,     (numeric) Reading blocks back from disk\n"
+            "    \"index_load\": nnn,     (numeric) Loading the block index at startup\n"
+            "    \"mining\": nnn,         (numeric) Scanning nonces\n"
+            "    \"other\": nnn           (numeric) Anything else\n"
+            "  },\n"
+            "  \"time\": x.xxx,           (numeric) Seconds spent in all primitives while -powstatstiming was set\n"
+            "  \"timing\": true|false     (boolean) Whether the primitives are currently timed\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getpowstats", "")
+            + HelpExampleRpc("getpowstats", "")
+        );
+
+    const X16RStats stats = GetX16RStats();
+
+    UniValue algorithms(UniValue::VOBJ);
+    uint64_t nTotalNanos = 0;
+    for (int i = 0; i < 16; i++) {
+        UniValue algo(UniValue::VOBJ);
+        algo.pushKV("hashes", stats.algoHits[i]);
+        algo.pushKV("time", stats.algoNanos[i] / 1e9);
+        algorithms.pushKV(X16RAlgoName(i), algo);
+        nTotalNanos += stats.algoNanos[i];
+    }
+
+    UniValue callers(UniValue::VOBJ);
+    for (int i = 0; i < X16R_CALLER_COUNT; i++) {
+        callers.pushKV(X16RCallerName(static_cast<X16RCaller>(i)), stats.callerHashes[i]);
+    }
+
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("algorithms", algorithms);
+    obj.pushKV("callers", callers);
+    obj.pushKV("time", nTotalNanos / 1e9);
+    obj.pushKV("timing", X16RTimingEnabled());
+    return obj;
+}
+
 
 // NOTE: Unlike wallet RPC (which use BTC values), mining RPCs follow GBT (BIP 22) in using satoshi amounts
 static UniValue prioritisetransaction(const JSONRPCRequest& request)
@@ -737,17 +796,17 @@ static UniValue getblocktemplate(const JSONRPCRequest& request)
 
     CAmount blockReward = nFees + GetBlockSubsidy(pindexPrev->nHeight + 1, pindexPrev->GetBlockHeader(), consensusParams);
 
-    std::map<COutPoint, CMasternode> mapMasternodes = mnodeman.GetFullMasternodeMap();
-    std::map<COutPoint, CMasternode>::iterator mnit = mapMasternodes.begin();
-    while (mnit != mapMasternodes.end()) {
-        if (mnit->second.IsEnabled())
+    CMasternodeMan::snapshot_t mapMasternodes = mnodeman.GetSnapshot();
+    CMasternodeMan::snapshot_map_t::const_iterator mnit = mapMasternodes->begin();
+    while (mnit != mapMasternodes->end()) {
+        if (mnit->second->IsEnabled())
         {
-            CScript payee = GetScriptForDestination(mnit->second.pubKeyCollateralAddress.GetID());
+            CScript payee = GetScriptForDestination(mnit->second->pubKeyCollateralAddress.GetID());
             CTxDestination address1;
             ExtractDestination(payee, address1);
             std::string address2 = EncodeDestination(address1);
             masternodeObj.pushKV("payee", address2);
-            masternodeObj.pushKV("script", mnit->second.vin.prevout.ToStringShort());
+            masternodeObj.pushKV("script", mnit->second->vin.prevout.ToStringShort());
             CAmount masternodePayment = GetMasternodePayment(pindexPrev->nHeight + 1, blockReward);
             masternodeObj.pushKV("amount", masternodePayment);
 
@@ -1048,6 +1107,7 @@ static const CRPCCommand commands[] =
   //  --------------------- ------------------------  -----------------------  ----------
     { "mining",             "getnetworkhashps",       &getnetworkhashps,       {"nblocks","height"} },
     { "mining",             "getmininginfo",          &getmininginfo,          {} },
+    { "mining",             "getpowstats",            &getpowstats,            {} },
     { "mining",             "prioritisetransaction",  &prioritisetransaction,  {"txid","dummy","fee_delta"} },
     { "mining",             "getblocktemplate",       &getblocktemplate,       {"template_request"} },
     { "mining",             "submitblock",            &submitblock,            {"hexdata","dummy"} },
@@ -393,6 +393,37 @@ static UniValue getnettotals(const JSONRPCRequest& request)
     return obj;
 }
 
+// CRYPTROX BEGIN
+static UniValue getmessagestats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 0)
+        throw std::runtime_error(
+            "getmessagestats\n"
+            "\nReturns the number of processed P2P messages and the time spent processing them, per message type.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"command\": {           (json object) Message type, \"*other*\" for unknown message types\n"
+            "    \"count\": n,          (numeric) Number of messages processed\n"
+            "    \"time_micros\": n     (numeric) Total processing time in microseconds\n"
+            "  },\n"
+            "  ...\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getmessagestats", "")
+            + HelpExampleRpc("getmessagestats", "")
+       );
+
+    UniValue obj(UniValue::VOBJ);
+    for (const CNetMessageStats& stats : GetNetMessageStats()) {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("count", stats.nCount);
+        entry.pushKV("time_micros", stats.nTimeMicros);
+        obj.pushKV(stats.strCommand, entry);
+    }
+    return obj;
+}
+// CRYPTROX END
+
 static UniValue GetNetworksInfo()
 {
     UniValue networks(UniValue::VARR);
@@ -635,6 +666,9 @@ static const CRPCCommand commands[] =
     { "network",            "disconnectnode",         &disconnectnode,         {"address", "nodeid"} },
     { "network",            "getaddednodeinfo",       &getaddednodeinfo,       {"node"} },
     { "network",            "getnettotals",           &getnettotals,           {} },
+    // CRYPTROX BEGIN
+    { "network",            "getmessagestats",        &getmessagestats,        {} },
+    // CRYPTROX END
     { "network",            "getnetworkinfo",         &getnetworkinfo,         {} },
     { "network",            "setban",                 &setban,                 {"subnet", "command", "bantime", "absolute"} },
     { "network",            "listbanned",             &listbanned,             {} },
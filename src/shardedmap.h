@@ -0,0 +1,136 @@
+// Copyright (c) 2019 Cryptroxcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef CRYPTROX_SHARDEDMAP_H
+#define CRYPTROX_SHARDEDMAP_H
+
+#include <array>
+#include <functional>
+#include <unordered_map>
+
+#include <boost/thread/locks.hpp>
+#include <boost/thread/shared_mutex.hpp>
+
+/**
+ * Hash map split into N shards, each guarded by its own reader/writer lock.
+ * Lookups only take a shared lock on the shard of their key, so readers never
+ * block each other and writers only contend with accesses to the same shard.
+ * Values are copied out; no reference into the map outlives the shard lock.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>, size_t N = 16>
+class CShardedMap
+{
+private:
+    struct Shard {
+        mutable boost::shared_mutex mutex;
+        std::unordered_map<K, V, Hash> map;
+    };
+
+    const Hash hasher{};
+    std::array<Shard, N> shards;
+
+    Shard& GetShard(const K& key) { return shards[hasher(key) % N]; }
+    const Shard& GetShard(const K& key) const { return shards[hasher(key) % N]; }
+
+public:
+    bool Get(const K& key, V& valueRet) const
+    {
+        const Shard& shard = GetShard(key);
+        boost::shared_lock<boost::shared_mutex> lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end())
+            return false;
+        valueRet = it->second;
+        return true;
+    }
+
+    bool Contains(const K& key) const
+    {
+        const Shard& shard = GetShard(key);
+        boost::shared_lock<boost::shared_mutex> lock(shard.mutex);
+        return shard.map.count(key) != 0;
+    }
+
+    /** Insert the value unless the key is already present, returns whether it was inserted */
+    bool Insert(const K& key, const V& value)
+    {
+        Shard& shard = GetShard(key);
+        boost::unique_lock<boost::shared_mutex> lock(shard.mutex);
+        return shard.map.emplace(key, value).second;
+    }
+
+    /** Insert or overwrite the value of a key */
+    void Set(const K& key, const V& value)
+    {
+        Shard& shard = GetShard(key);
+        boost::unique_lock<boost::shared_mutex> lock(shard.mutex);
+        shard.map[key] = value;
+    }
+
+    bool Erase(const K& key)
+    {
+        Shard& shard = GetShard(key);
+        boost::unique_lock<boost::shared_mutex> lock(shard.mutex);
+        return shard.map.erase(key) != 0;
+    }
+
+    /** Call f(V&) on the value of a key while holding its shard exclusively, returns false if the key is absent */
+    template <typename F>
+    bool Update(const K& key, F f)
+    {
+        Shard& shard = GetShard(key);
+        boost::unique_lock<boost::shared_mutex> lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end())
+            return false;
+        f(it->second);
+        return true;
+    }
+
+    /** Call f(const K&, const V&) on every entry, one shard at a time */
+    template <typename F>
+    void ForEach(F f) const
+    {
+        for (const Shard& shard : shards) {
+            boost::shared_lock<boost::shared_mutex> lock(shard.mutex);
+            for (const auto& entry : shard.map)
+                f(entry.first, entry.second);
+        }
+    }
+
+    /** Erase every entry for which pred(const K&, V&) returns true, one shard at a time */
+    template <typename P>
+    void EraseIf(P pred)
+    {
+        for (Shard& shard : shards) {
+            boost::unique_lock<boost::shared_mutex> lock(shard.mutex);
+            for (auto it = shard.map.begin(); it != shard.map.end(); ) {
+                if (pred(it->first, it->second))
+                    it = shard.map.erase(it);
+                else
+                    ++it;
+            }
+        }
+    }
+
+    size_t Size() const
+    {
+        size_t nSize = 0;
+        for (const Shard& shard : shards) {
+            boost::shared_lock<boost::shared_mutex> lock(shard.mutex);
+            nSize += shard.map.size();
+        }
+        return nSize;
+    }
+
+    void Clear()
+    {
+        for (Shard& shard : shards) {
+            boost::unique_lock<boost::shared_mutex> lock(shard.mutex);
+            shard.map.clear();
+        }
+    }
+};
+
+#endif // CRYPTROX_SHARDEDMAP_H
@@ -28,6 +28,56 @@ std::map<uint256, CSporkMessage> mapSporks;
 // CRYPTROX BEGIN
 std::unique_ptr<CSporkDB> pSporkDB = NULL;
 
+CSporkManager::CSporkManager()
+{
+    for (int i = 0; i < SPORK_TABLE_SIZE; ++i) {
+        int nSporkID = i <= SPORK_END - SPORK_START ? SPORK_START + i : SPORK_CRYPTROX_START + i - (SPORK_END - SPORK_START + 1);
+        vSporkValues[i].store(GetSporkDefaultValue(nSporkID), std::memory_order_relaxed);
+    }
+}
+
+int CSporkManager::GetSporkIndex(int nSporkID)
+{
+    if (nSporkID >= SPORK_START && nSporkID <= SPORK_END)
+        return nSporkID - SPORK_START;
+    if (nSporkID >= SPORK_CRYPTROX_START && nSporkID <= SPORK_CRYPTROX_END)
+        return nSporkID - SPORK_CRYPTROX_START + (SPORK_END - SPORK_START + 1);
+    return -1;
+}
+
+int64_t CSporkManager::GetSporkDefaultValue(int nSporkID)
+{
+    switch (nSporkID) {
+        case SPORK_2_INSTANTSEND_ENABLED:               return SPORK_2_INSTANTSEND_ENABLED_DEFAULT;
+        case SPORK_3_INSTANTSEND_BLOCK_FILTERING:       return SPORK_3_INSTANTSEND_BLOCK_FILTERING_DEFAULT;
+        case SPORK_5_INSTANTSEND_MAX_VALUE:             return SPORK_5_INSTANTSEND_MAX_VALUE_DEFAULT;
+        case SPORK_8_MASTERNODE_PAYMENT_ENFORCEMENT:    return SPORK_8_MASTERNODE_PAYMENT_ENFORCEMENT_DEFAULT;
+        case SPORK_9_SUPERBLOCKS_ENABLED:               return SPORK_9_SUPERBLOCKS_ENABLED_DEFAULT;
+        case SPORK_10_MASTERNODE_PAY_UPDATED_NODES:     return SPORK_10_MASTERNODE_PAY_UPDATED_NODES_DEFAULT;
+        case SPORK_12_RECONSIDER_BLOCKS:                return SPORK_12_RECONSIDER_BLOCKS_DEFAULT;
+        case SPORK_13_OLD_SUPERBLOCK_FLAG:              return SPORK_13_OLD_SUPERBLOCK_FLAG_DEFAULT;
+        case SPORK_14_REQUIRE_SENTINEL_FLAG:            return SPORK_14_REQUIRE_SENTINEL_FLAG_DEFAULT;
+        case SPORK_CRYPTROX_01_HANDBRAKE_HEIGHT:            return SPORK_CRYPTROX_01_HANDBRAKE_HEIGHT_DEFAULT;
+        case SPORK_CRYPTROX_01_HANDBRAKE_FORCE_X16R:        return SPORK_CRYPTROX_01_HANDBRAKE_FORCE_X16R_DEFAULT;
+
+        case SPORK_CRYPTROX_02_IGNORE_SLIGHTLY_HIGHER_COINBASE:     return SPORK_CRYPTROX_02_IGNORE_SLIGHTLY_HIGHER_COINBASE_DEFAULT;
+        case SPORK_CRYPTROX_02_IGNORE_FOUNDER_REWARD_CHECK:         return SPORK_CRYPTROX_02_IGNORE_FOUNDER_REWARD_CHECK_DEFAULT;
+        case SPORK_CRYPTROX_02_IGNORE_FOUNDER_REWARD_VALUE:         return SPORK_CRYPTROX_02_IGNORE_FOUNDER_REWARD_VALUE_DEFAULT;
+        case SPORK_CRYPTROX_02_IGNORE_MASTERNODE_REWARD_VALUE:      return SPORK_CRYPTROX_02_IGNORE_MASTERNODE_REWARD_VALUE_DEFAULT;
+        case SPORK_CRYPTROX_02_IGNORE_MASTERNODE_REWARD_PAYEE:      return SPORK_CRYPTROX_02_IGNORE_MASTERNODE_REWARD_PAYEE_DEFAULT;
+
+        case SPORK_CRYPTROX_03_BLOCK_REWARD_SMOOTH_HALVING_START:   return SPORK_CRYPTROX_03_BLOCK_REWARD_SMOOTH_HALVING_START_DEFAULT;
+        default:                                        return SPORK_VALUE_UNKNOWN;
+    }
+}
+
+void CSporkManager::SetSporkValue(int nSporkID, int64_t nValue)
+{
+    int nIndex = GetSporkIndex(nSporkID);
+    if (nIndex < 0) return;
+    vSporkValues[nIndex].store(nValue, std::memory_order_relaxed);
+}
+
 // PIVX: on startup load spork values from previous session if they exist in the sporkDB
 void CSporkManager::LoadSporksFromDB()
 {
@@ -50,6 +100,7 @@ void CSporkManager::LoadSporksFromDB()
         // add spork to memory
         mapSporks[spork.GetHash()] = spork;
         mapSporksActive[spork.nSporkID] = spork;
+        SetSporkValue(spork.nSporkID, spork.nValue);
         std::time_t result = spork.nValue;
         // If SPORK Value is greater than 1,000,000 assume it's actually a Date and then convert to a more readable format
         if (spork.nValue > 1000000) {
@@ -103,6 +154,9 @@ void CSporkManager::ProcessSpork(CNode* pfrom, const std::string& strCommand, CD
 
         mapSporks[hash] = spork;
         mapSporksActive[spork.nSporkID] = spork;
+        // CRYPTROX BEGIN
+        SetSporkValue(spork.nSporkID, spork.nValue);
+        // CRYPTROX END
         spork.Relay(connman);
 
         //does a task if needed
@@ -162,6 +216,9 @@ bool CSporkManager::UpdateSpork(int nSporkID, int64_t nValue, CConnman& connman)
         spork.Relay(connman);
         mapSporks[spork.GetHash()] = spork;
         mapSporksActive[nSporkID] = spork;
+        // CRYPTROX BEGIN
+        SetSporkValue(nSporkID, nValue);
+        // CRYPTROX END
         return true;
     }
 
@@ -171,39 +228,15 @@ bool CSporkManager::UpdateSpork(int nSporkID, int64_t nValue, CConnman& connman)
 // grab the spork, otherwise say it's off
 bool CSporkManager::IsSporkActive(int nSporkID)
 {
-    int64_t r = -1;
+    // CRYPTROX BEGIN
+    int nIndex = GetSporkIndex(nSporkID);
+    int64_t r = nIndex < 0 ? SPORK_VALUE_UNKNOWN : vSporkValues[nIndex].load(std::memory_order_relaxed);
 
-    if(mapSporksActive.count(nSporkID)){
-        r = mapSporksActive[nSporkID].nValue;
-    } else {
-        switch (nSporkID) {
-            case SPORK_2_INSTANTSEND_ENABLED:               r = SPORK_2_INSTANTSEND_ENABLED_DEFAULT; break;
-            case SPORK_3_INSTANTSEND_BLOCK_FILTERING:       r = SPORK_3_INSTANTSEND_BLOCK_FILTERING_DEFAULT; break;
-            case SPORK_5_INSTANTSEND_MAX_VALUE:             r = SPORK_5_INSTANTSEND_MAX_VALUE_DEFAULT; break;
-            case SPORK_8_MASTERNODE_PAYMENT_ENFORCEMENT:    r = SPORK_8_MASTERNODE_PAYMENT_ENFORCEMENT_DEFAULT; break;
-            case SPORK_9_SUPERBLOCKS_ENABLED:               r = SPORK_9_SUPERBLOCKS_ENABLED_DEFAULT; break;
-            case SPORK_10_MASTERNODE_PAY_UPDATED_NODES:     r = SPORK_10_MASTERNODE_PAY_UPDATED_NODES_DEFAULT; break;
-            case SPORK_12_RECONSIDER_BLOCKS:                r = SPORK_12_RECONSIDER_BLOCKS_DEFAULT; break;
-            case SPORK_13_OLD_SUPERBLOCK_FLAG:              r = SPORK_13_OLD_SUPERBLOCK_FLAG_DEFAULT; break;
-            case SPORK_14_REQUIRE_SENTINEL_FLAG:            r = SPORK_14_REQUIRE_SENTINEL_FLAG_DEFAULT; break;
-            // CRYPTROX BEGIN
-            case SPORK_CRYPTROX_01_HANDBRAKE_HEIGHT :           r = SPORK_CRYPTROX_01_HANDBRAKE_HEIGHT_DEFAULT; break;
-            case SPORK_CRYPTROX_01_HANDBRAKE_FORCE_X16R:        r = SPORK_CRYPTROX_01_HANDBRAKE_FORCE_X16R_DEFAULT; break;
-
-            case SPORK_CRYPTROX_02_IGNORE_SLIGHTLY_HIGHER_COINBASE:     r = SPORK_CRYPTROX_02_IGNORE_SLIGHTLY_HIGHER_COINBASE_DEFAULT; break;
-            case SPORK_CRYPTROX_02_IGNORE_FOUNDER_REWARD_CHECK:         r = SPORK_CRYPTROX_02_IGNORE_FOUNDER_REWARD_CHECK_DEFAULT; break;
-            case SPORK_CRYPTROX_02_IGNORE_FOUNDER_REWARD_VALUE:         r = SPORK_CRYPTROX_02_IGNORE_FOUNDER_REWARD_VALUE_DEFAULT; break;
-            case SPORK_CRYPTROX_02_IGNORE_MASTERNODE_REWARD_VALUE:      r = SPORK_CRYPTROX_02_IGNORE_MASTERNODE_REWARD_VALUE_DEFAULT; break;
-            case SPORK_CRYPTROX_02_IGNORE_MASTERNODE_REWARD_PAYEE:      r = SPORK_CRYPTROX_02_IGNORE_MASTERNODE_REWARD_PAYEE_DEFAULT; break;
-
-            case SPORK_CRYPTROX_03_BLOCK_REWARD_SMOOTH_HALVING_START:   r = SPORK_CRYPTROX_03_BLOCK_REWARD_SMOOTH_HALVING_START_DEFAULT; break;
-            // CRYPTROX END
-            default:
-                LogPrint(BCLog::SPORK, "CSporkManager::IsSporkActive -- Unknown Spork ID %d\n", nSporkID);
-                r = 4070908800ULL; // 2099-1-1 i.e. off by default
-                break;
-        }
+    if (r == SPORK_VALUE_UNKNOWN) {
+        LogPrint(BCLog::SPORK, "CSporkManager::IsSporkActive -- Unknown Spork ID %d\n", nSporkID);
+        r = 4070908800ULL; // 2099-1-1 i.e. off by default
     }
+    // CRYPTROX END
 
     return r < GetAdjustedTime();
 }
@@ -211,36 +244,17 @@ bool CSporkManager::IsSporkActive(int nSporkID)
 // grab the value of the spork on the network, or the default
 int64_t CSporkManager::GetSporkValue(int nSporkID)
 {
-    if (mapSporksActive.count(nSporkID))
-        return mapSporksActive[nSporkID].nValue;
-
-    switch (nSporkID) {
-        case SPORK_2_INSTANTSEND_ENABLED:               return SPORK_2_INSTANTSEND_ENABLED_DEFAULT;
-        case SPORK_3_INSTANTSEND_BLOCK_FILTERING:       return SPORK_3_INSTANTSEND_BLOCK_FILTERING_DEFAULT;
-        case SPORK_5_INSTANTSEND_MAX_VALUE:             return SPORK_5_INSTANTSEND_MAX_VALUE_DEFAULT;
-        case SPORK_8_MASTERNODE_PAYMENT_ENFORCEMENT:    return SPORK_8_MASTERNODE_PAYMENT_ENFORCEMENT_DEFAULT;
-        case SPORK_9_SUPERBLOCKS_ENABLED:               return SPORK_9_SUPERBLOCKS_ENABLED_DEFAULT;
-        case SPORK_10_MASTERNODE_PAY_UPDATED_NODES:     return SPORK_10_MASTERNODE_PAY_UPDATED_NODES_DEFAULT;
-        case SPORK_12_RECONSIDER_BLOCKS:                return SPORK_12_RECONSIDER_BLOCKS_DEFAULT;
-        case SPORK_13_OLD_SUPERBLOCK_FLAG:              return SPORK_13_OLD_SUPERBLOCK_FLAG_DEFAULT;
-        case SPORK_14_REQUIRE_SENTINEL_FLAG:            return SPORK_14_REQUIRE_SENTINEL_FLAG_DEFAULT;
-        // CRYPTROX BEGIN
-        case SPORK_CRYPTROX_01_HANDBRAKE_HEIGHT:            return SPORK_CRYPTROX_01_HANDBRAKE_HEIGHT_DEFAULT;
-        case SPORK_CRYPTROX_01_HANDBRAKE_FORCE_X16R:        return SPORK_CRYPTROX_01_HANDBRAKE_FORCE_X16R_DEFAULT;
-
-        case SPORK_CRYPTROX_02_IGNORE_SLIGHTLY_HIGHER_COINBASE:     return SPORK_CRYPTROX_02_IGNORE_SLIGHTLY_HIGHER_COINBASE_DEFAULT;
-        case SPORK_CRYPTROX_02_IGNORE_FOUNDER_REWARD_CHECK:         return SPORK_CRYPTROX_02_IGNORE_FOUNDER_REWARD_CHECK_DEFAULT;
-        case SPORK_CRYPTROX_02_IGNORE_FOUNDER_REWARD_VALUE:         return SPORK_CRYPTROX_02_IGNORE_FOUNDER_REWARD_VALUE_DEFAULT;
-        case SPORK_CRYPTROX_02_IGNORE_MASTERNODE_REWARD_VALUE:      return SPORK_CRYPTROX_02_IGNORE_MASTERNODE_REWARD_VALUE_DEFAULT;
-        case SPORK_CRYPTROX_02_IGNORE_MASTERNODE_REWARD_PAYEE:      return SPORK_CRYPTROX_02_IGNORE_MASTERNODE_REWARD_PAYEE_DEFAULT;
+    // CRYPTROX BEGIN
+    int nIndex = GetSporkIndex(nSporkID);
+    int64_t r = nIndex < 0 ? SPORK_VALUE_UNKNOWN : vSporkValues[nIndex].load(std::memory_order_relaxed);
 
-        case SPORK_CRYPTROX_03_BLOCK_REWARD_SMOOTH_HALVING_START:   return SPORK_CRYPTROX_03_BLOCK_REWARD_SMOOTH_HALVING_START_DEFAULT;
-        // CRYPTROX END
-        default:
-            LogPrint(BCLog::SPORK, "CSporkManager::GetSporkValue -- Unknown Spork ID %d\n", nSporkID);
-            return -1;
+    if (r == SPORK_VALUE_UNKNOWN) {
+        LogPrint(BCLog::SPORK, "CSporkManager::GetSporkValue -- Unknown Spork ID %d\n", nSporkID);
+        return -1;
     }
+    // CRYPTROX END
 
+    return r;
 }
 
 int CSporkManager::GetSporkIDByName(std::string strName)
@@ -10,6 +10,10 @@
 #include <net.h>
 #include <utilstrencodings.h>
 
+#include <array>
+#include <atomic>
+#include <limits>
+
 // CRYPTROX BEGIN
 class CSporkDB;
 
@@ -29,6 +33,8 @@ static const int SPORK_END                                              = 10013;
 // CRYPTROX BEGIN
 static const int SPORK_CRYPTROX_START                                    = 94680010;
 static const int SPORK_CRYPTROX_END                                      = 94680031;
+//! Number of slots in the spork value table, one per ID of both ranges
+static const int SPORK_TABLE_SIZE = (SPORK_END - SPORK_START + 1) + (SPORK_CRYPTROX_END - SPORK_CRYPTROX_START + 1);
 // CRYPTROX END
 
 static const int SPORK_2_INSTANTSEND_ENABLED                            = 10001;
@@ -137,10 +143,24 @@ private:
     std::vector<unsigned char> vchSig;
     std::string strMasterPrivKey;
     std::map<int, CSporkMessage> mapSporksActive;
+    // CRYPTROX BEGIN
+    //! Marks a table slot of an ID that has neither a default nor an accepted spork
+    static const int64_t SPORK_VALUE_UNKNOWN = std::numeric_limits<int64_t>::min();
+    /**
+     * Effective value of every spork, indexed by GetSporkIndex(). Written only
+     * when a spork is accepted or loaded from the spork database, so readers
+     * never touch mapSporksActive and never block.
+     */
+    std::array<std::atomic<int64_t>, SPORK_TABLE_SIZE> vSporkValues;
+
+    static int GetSporkIndex(int nSporkID);
+    static int64_t GetSporkDefaultValue(int nSporkID);
+    void SetSporkValue(int nSporkID, int64_t nValue);
+    // CRYPTROX END
 
 public:
 
-    CSporkManager() {}
+    CSporkManager();
 
     // CRYPTROX BEGIN
     void LoadSporksFromDB();
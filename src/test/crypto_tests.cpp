@@ -4,10 +4,12 @@
 
 #include <crypto/aes.h>
 #include <crypto/chacha20.h>
+#include <crypto/common.h>
 #include <crypto/ripemd160.h>
 #include <crypto/sha1.h>
 #include <crypto/sha256.h>
 #include <crypto/sha512.h>
+#include <crypto/x16r.h>
 #include <crypto/hmac_sha256.h>
 #include <crypto/hmac_sha512.h>
 #include <random.h>
@@ -562,4 +564,46 @@ BOOST_AUTO_TEST_CASE(sha256d64)
     }
 }
 
+BOOST_AUTO_TEST_CASE(x16r_batch)
+{
+    BOOST_CHECK(X16R_InitSanityCheck());
+    for (int i = 0; i <= 12; ++i) {
+        unsigned char in[X16R_HEADER_SIZE * 12];
+        for (size_t j = 0; j < X16R_HEADER_SIZE * i; ++j) {
+            in[j] = InsecureRandBits(8);
+        }
+        // Let some headers share a previous block hash, so they are hashed as lanes of one group.
+        for (int j = 1; j < i; ++j) {
+            if (InsecureRandBool()) {
+                memcpy(in + X16R_HEADER_SIZE * j + 4, in + 4, 32);
+            }
+        }
+        uint256 out[12];
+        HashX16RBatch(out, in, i);
+        for (int j = 0; j < i; ++j) {
+            const unsigned char* header = in + X16R_HEADER_SIZE * j;
+            uint256 hashPrevBlock;
+            memcpy(hashPrevBlock.begin(), header + 4, 32);
+            BOOST_CHECK_EQUAL(out[j], HashX16R(header, header + X16R_HEADER_SIZE, hashPrevBlock));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(x16r_prepared_header)
+{
+    unsigned char header[X16R_HEADER_SIZE];
+    for (size_t i = 0; i < X16R_HEADER_SIZE; ++i) {
+        header[i] = InsecureRandBits(8);
+    }
+    uint256 hashPrevBlock;
+    memcpy(hashPrevBlock.begin(), header + 4, 32);
+
+    CX16RPreparedHeader prepared(header);
+    for (int i = 0; i < 32; ++i) {
+        uint32_t nonce = InsecureRand32();
+        WriteLE32(header + X16R_HEADER_SIZE - 4, nonce);
+        BOOST_CHECK_EQUAL(prepared.Hash(nonce), HashX16R(header, header + X16R_HEADER_SIZE, hashPrevBlock));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
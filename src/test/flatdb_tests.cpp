@@ -0,0 +1,166 @@
+// Copyright (c) 2019 Cryptroxcoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <flat-database.h>
+#include <test/test_bitcoin.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+struct CFlatDBTestObject
+{
+    std::vector<int> vData;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(vData);
+    }
+
+    void Clear() { vData.clear(); }
+    void CheckAndRemove() {}
+    void CopyForDump(CFlatDBTestObject& objCopy) { objCopy.vData = vData; }
+    std::string ToString() const { return strprintf("Items: %d", vData.size()); }
+};
+
+struct FlatDBTestingSetup : public BasicTestingSetup {
+    fs::path pathDB;
+
+    FlatDBTestingSetup()
+    {
+        pathDB = SetDataDir("flatdb") / "test.dat";
+        ClearDatadirCache();
+    }
+
+    ~FlatDBTestingSetup()
+    {
+        ClearDatadirCache();
+    }
+
+    void Append(const std::vector<unsigned char>& vch)
+    {
+        FILE* file = fsbridge::fopen(pathDB, "ab");
+        BOOST_REQUIRE(file);
+        BOOST_REQUIRE_EQUAL(fwrite(vch.data(), 1, vch.size(), file), vch.size());
+        fclose(file);
+    }
+};
+
+CFlatDBTestObject MakeObject(int n)
+{
+    CFlatDBTestObject obj;
+    for (int i = 0; i < n; i++) {
+        obj.vData.push_back(i);
+    }
+    return obj;
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(flatdb_tests, FlatDBTestingSetup)
+
+BOOST_AUTO_TEST_CASE(flatdb_dump_load)
+{
+    CFlatDB<CFlatDBTestObject> flatdb("test.dat", "magicFlatDBTest");
+
+    // a missing file loads as empty
+    CFlatDBTestObject objLoaded;
+    BOOST_CHECK(flatdb.Load(objLoaded));
+    BOOST_CHECK(objLoaded.vData.empty());
+
+    // every dump replaces the file with a single snapshot
+    CFlatDBTestObject obj = MakeObject(100);
+    uint64_t nSnapshotSize = GetSerializeSize(std::string("magicFlatDBTest"), SER_DISK, CLIENT_VERSION) + CMessageHeader::MESSAGE_START_SIZE +
+                             sizeof(FLATDB_FORMAT_VERSION) + GetSerializeSize(obj, SER_DISK, CLIENT_VERSION) + sizeof(uint256);
+    for (int i = 0; i < 5; i++) {
+        BOOST_CHECK(flatdb.Dump(obj));
+        BOOST_CHECK_EQUAL(fs::file_size(pathDB), nSnapshotSize);
+        BOOST_CHECK(flatdb.Load(objLoaded));
+        BOOST_CHECK(objLoaded.vData == obj.vData);
+    }
+    BOOST_CHECK(!fs::exists(pathDB.string() + ".new"));
+
+    obj = MakeObject(10);
+    BOOST_CHECK(flatdb.Dump(obj));
+    BOOST_CHECK(flatdb.Load(objLoaded));
+    BOOST_CHECK(objLoaded.vData == obj.vData);
+
+    // another network's or type's file is refused
+    CFlatDB<CFlatDBTestObject> flatdbOther("test.dat", "magicOther");
+    BOOST_CHECK(!flatdbOther.Load(objLoaded));
+}
+
+BOOST_AUTO_TEST_CASE(flatdb_damaged)
+{
+    CFlatDB<CFlatDBTestObject> flatdb("test.dat", "magicFlatDBTest");
+    CFlatDBTestObject obj1 = MakeObject(10), obj2 = MakeObject(20);
+    BOOST_CHECK(flatdb.Dump(obj1));
+
+    // a write that never finished leaves the previous snapshot alone
+    fs::path pathNew = pathDB.string() + ".new";
+    FILE* file = fsbridge::fopen(pathNew, "wb");
+    BOOST_REQUIRE(file);
+    fclose(file);
+    CFlatDBTestObject objLoaded;
+    BOOST_CHECK(flatdb.Load(objLoaded));
+    BOOST_CHECK(objLoaded.vData == obj1.vData);
+    BOOST_CHECK(flatdb.Dump(obj2));
+    BOOST_CHECK(!fs::exists(pathNew));
+    BOOST_CHECK(flatdb.Load(objLoaded));
+    BOOST_CHECK(objLoaded.vData == obj2.vData);
+
+    // a corrupted checksum is refused
+    uint64_t nFileSize = fs::file_size(pathDB);
+    file = fsbridge::fopen(pathDB, "rb+");
+    BOOST_REQUIRE(file);
+    BOOST_REQUIRE_EQUAL(fseek(file, nFileSize - 1, SEEK_SET), 0);
+    int nLastByte = fgetc(file);
+    BOOST_REQUIRE_EQUAL(fseek(file, nFileSize - 1, SEEK_SET), 0);
+    BOOST_REQUIRE_EQUAL(fputc(nLastByte ^ 0x5a, file), nLastByte ^ 0x5a);
+    fclose(file);
+    BOOST_CHECK(!flatdb.Load(objLoaded));
+    BOOST_CHECK(objLoaded.vData.empty());
+
+    // a truncated file is recreated
+    BOOST_CHECK(flatdb.Dump(obj2));
+    fs::resize_file(pathDB, nFileSize - sizeof(uint256) - 8);
+    BOOST_CHECK(flatdb.Load(objLoaded));
+    BOOST_CHECK(objLoaded.vData.empty());
+}
+
+BOOST_AUTO_TEST_CASE(flatdb_legacy)
+{
+    CFlatDB<CFlatDBTestObject> flatdb("test.dat", "magicFlatDBTest");
+    CFlatDBTestObject obj = MakeObject(30);
+
+    // the format before the format version: header and data under one checksum
+    CDataStream ssLegacy(SER_DISK, CLIENT_VERSION);
+    ssLegacy << std::string("magicFlatDBTest");
+    ssLegacy << Params().MessageStart();
+    ssLegacy << obj;
+    uint256 hash = Hash(ssLegacy.begin(), ssLegacy.end());
+    ssLegacy << hash;
+    Append(std::vector<unsigned char>(ssLegacy.begin(), ssLegacy.end()));
+
+    CFlatDBTestObject objLoaded;
+    BOOST_CHECK(flatdb.Load(objLoaded));
+    BOOST_CHECK(objLoaded.vData == obj.vData);
+
+    // the next dump writes the current format
+    BOOST_CHECK(flatdb.Dump(objLoaded));
+    BOOST_CHECK(fs::file_size(pathDB) == ssLegacy.size() + sizeof(FLATDB_FORMAT_VERSION));
+    CFlatDBTestObject objReloaded;
+    BOOST_CHECK(flatdb.Load(objReloaded));
+    BOOST_CHECK(objReloaded.vData == obj.vData);
+
+    // a legacy file that does not check out is refused
+    fs::remove(pathDB);
+    ssLegacy[ssLegacy.size() - 1] ^= 0x5a;
+    Append(std::vector<unsigned char>(ssLegacy.begin(), ssLegacy.end()));
+    BOOST_CHECK(!flatdb.Load(objReloaded));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
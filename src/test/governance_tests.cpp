@@ -0,0 +1,192 @@
+// Copyright (c) 2019 Cryptroxcoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <governance-vote.h>
+#include <governance-votedb.h>
+#include <streams.h>
+#include <test/test_bitcoin.h>
+
+#include <boost/test/unit_test.hpp>
+
+static CGovernanceVote MakeVote(const uint256& nParentHash, const COutPoint& outpointMasternode, int64_t nTime)
+{
+    CGovernanceVote vote(outpointMasternode, nParentHash, VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_YES);
+    vote.SetTime(nTime);
+    return vote;
+}
+
+BOOST_FIXTURE_TEST_SUITE(governance_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(votedb_write_read)
+{
+    uint256 nParent1 = InsecureRand256(), nParent2 = InsecureRand256();
+    COutPoint outpoint1(InsecureRand256(), 0), outpoint2(InsecureRand256(), 1);
+
+    std::vector<CGovernanceVote> vecVotes1 = {MakeVote(nParent1, outpoint1, 1), MakeVote(nParent1, outpoint1, 2), MakeVote(nParent1, outpoint2, 1)};
+    CGovernanceVote vote2 = MakeVote(nParent2, outpoint1, 1);
+    for (const auto& vote : vecVotes1) {
+        BOOST_CHECK(pGovernanceVoteDB->WriteVote(vote));
+    }
+    BOOST_CHECK(pGovernanceVoteDB->WriteVote(vote2));
+
+    CGovernanceVote voteRead;
+    BOOST_CHECK(pGovernanceVoteDB->ReadVote(vote2.GetHash(), voteRead));
+    BOOST_CHECK(voteRead.GetHash() == vote2.GetHash());
+    BOOST_CHECK(!pGovernanceVoteDB->ReadVote(InsecureRand256(), voteRead));
+
+    // lookups scoped to the parent object
+    BOOST_CHECK(pGovernanceVoteDB->HasVote(vote2.GetHash()));
+    BOOST_CHECK(pGovernanceVoteDB->HasVote(nParent2, vote2.GetHash()));
+    BOOST_CHECK(!pGovernanceVoteDB->HasVote(nParent1, vote2.GetHash()));
+
+    // per parent listing
+    std::vector<CGovernanceVote> vecRead = pGovernanceVoteDB->ReadVotes(nParent1);
+    std::vector<uint256> vecHashes = pGovernanceVoteDB->ReadVoteHashes(nParent1);
+    BOOST_CHECK_EQUAL(vecRead.size(), vecVotes1.size());
+    BOOST_CHECK_EQUAL(vecHashes.size(), vecVotes1.size());
+    for (const auto& vote : vecVotes1) {
+        BOOST_CHECK(std::count(vecHashes.begin(), vecHashes.end(), vote.GetHash()) == 1);
+    }
+    for (const auto& vote : vecRead) {
+        BOOST_CHECK(vote.GetParentHash() == nParent1);
+    }
+    BOOST_CHECK_EQUAL(pGovernanceVoteDB->ReadVotes(nParent2).size(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(votedb_erase)
+{
+    uint256 nParent1 = InsecureRand256(), nParent2 = InsecureRand256();
+    COutPoint outpoint1(InsecureRand256(), 0), outpoint2(InsecureRand256(), 1);
+
+    CGovernanceVote vote11 = MakeVote(nParent1, outpoint1, 1);
+    CGovernanceVote vote12 = MakeVote(nParent1, outpoint2, 1);
+    CGovernanceVote vote21 = MakeVote(nParent2, outpoint1, 1);
+    for (const auto& vote : {vote11, vote12, vote21}) {
+        BOOST_CHECK(pGovernanceVoteDB->WriteVote(vote));
+    }
+
+    // one masternode's votes on one object
+    BOOST_CHECK_EQUAL(pGovernanceVoteDB->EraseVotes(nParent1, outpoint1), 1);
+    BOOST_CHECK(!pGovernanceVoteDB->HasVote(vote11.GetHash()));
+    BOOST_CHECK(pGovernanceVoteDB->HasVote(vote12.GetHash()));
+    BOOST_CHECK(pGovernanceVoteDB->HasVote(vote21.GetHash()));
+
+    // all votes of the objects that are not kept
+    BOOST_CHECK_EQUAL(pGovernanceVoteDB->EraseVotesIf([&](const uint256& nParentHash) { return nParentHash == nParent2; }), 1);
+    BOOST_CHECK(!pGovernanceVoteDB->HasVote(vote12.GetHash()));
+    BOOST_CHECK(pGovernanceVoteDB->HasVote(vote21.GetHash()));
+
+    BOOST_CHECK_EQUAL(pGovernanceVoteDB->EraseVotes(nParent2), 1);
+    BOOST_CHECK(pGovernanceVoteDB->ReadVoteHashes(nParent2).empty());
+}
+
+BOOST_AUTO_TEST_CASE(votefile_count)
+{
+    uint256 nParent = InsecureRand256(), nOther = InsecureRand256();
+    COutPoint outpoint1(InsecureRand256(), 0), outpoint2(InsecureRand256(), 1);
+    CGovernanceVote vote1 = MakeVote(nParent, outpoint1, 1);
+    CGovernanceVote vote2 = MakeVote(nParent, outpoint2, 1);
+    CGovernanceVote voteOther = MakeVote(nOther, outpoint1, 1);
+
+    CGovernanceObjectVoteFile fileVotes;
+    BOOST_CHECK(!fileVotes.HasVote(vote1.GetHash()));
+    fileVotes.AddVote(vote1);
+    fileVotes.AddVote(vote1);
+    fileVotes.AddVote(vote2);
+    BOOST_CHECK_EQUAL(fileVotes.GetVoteCount(), 2);
+    BOOST_CHECK(fileVotes.HasVote(vote1.GetHash()));
+
+    // votes of another object are not this file's
+    BOOST_CHECK(pGovernanceVoteDB->WriteVote(voteOther));
+    CGovernanceVote voteRead;
+    BOOST_CHECK(!fileVotes.HasVote(voteOther.GetHash()));
+    BOOST_CHECK(!fileVotes.GetVote(voteOther.GetHash(), voteRead));
+    BOOST_CHECK(fileVotes.GetVote(vote2.GetHash(), voteRead));
+
+    fileVotes.RemoveVotesFromMasternode(outpoint1);
+    BOOST_CHECK_EQUAL(fileVotes.GetVoteCount(), 1);
+    BOOST_CHECK_EQUAL(fileVotes.GetVoteHashes().size(), 1U);
+
+    // a stale count is taken from the store on load
+    CGovernanceObjectVoteFile fileLoaded;
+    fileLoaded.LoadVoteCount(nParent);
+    BOOST_CHECK_EQUAL(fileLoaded.GetVoteCount(), 1);
+
+    fileVotes.EraseVotes();
+    BOOST_CHECK_EQUAL(fileVotes.GetVoteCount(), 0);
+    BOOST_CHECK(pGovernanceVoteDB->HasVote(voteOther.GetHash()));
+}
+
+BOOST_AUTO_TEST_CASE(vote_summary)
+{
+    // sized by the vote count, never empty and never beyond the cap
+    BOOST_CHECK(!CGovernanceVoteSummary().IsValid());
+    BOOST_CHECK_EQUAL(CGovernanceVoteSummary::ForVoteCount(0).GetBucketCount(), 1U);
+    BOOST_CHECK_EQUAL(CGovernanceVoteSummary::ForVoteCount(100).GetBucketCount(), 100U / CGovernanceVoteSummary::VOTES_PER_BUCKET);
+    BOOST_CHECK_EQUAL(CGovernanceVoteSummary::ForVoteCount(1000000).GetBucketCount(), size_t(CGovernanceVoteSummary::MAX_BUCKETS));
+    BOOST_CHECK(CGovernanceVoteSummary::ForVoteCount(1000000).IsValid());
+    BOOST_CHECK(!CGovernanceVoteSummary(0, 0, CGovernanceVoteSummary::MAX_BUCKETS + 1).IsValid());
+
+    std::vector<uint256> vecShared, vecOurs;
+    for (int i = 0; i < 200; i++) {
+        vecShared.push_back(InsecureRand256());
+    }
+    for (int i = 0; i < 20; i++) {
+        vecOurs.push_back(InsecureRand256());
+    }
+
+    CGovernanceVoteSummary summaryTheirs = CGovernanceVoteSummary::ForVoteCount(vecShared.size());
+    CGovernanceVoteSummary summaryOurs = summaryTheirs.EmptyCopy();
+    BOOST_CHECK_EQUAL(summaryOurs.GetBucketCount(), summaryTheirs.GetBucketCount());
+    for (const auto& hash : vecShared) {
+        summaryTheirs.Add(hash);
+        summaryOurs.Add(hash);
+    }
+
+    // the same sets match everywhere
+    for (const auto& hash : vecShared) {
+        BOOST_CHECK(summaryTheirs.Matches(summaryOurs, hash));
+    }
+
+    // a vote only we have changes its bucket, unless its 16 bit fingerprint happens to be zero
+    for (const auto& hash : vecOurs) {
+        summaryOurs.Add(hash);
+    }
+    int nMatched = 0;
+    for (const auto& hash : vecOurs) {
+        if (summaryTheirs.Matches(summaryOurs, hash)) ++nMatched;
+    }
+    BOOST_CHECK(nMatched <= 1);
+
+    // adding a vote twice takes it out again
+    for (const auto& hash : vecOurs) {
+        summaryOurs.Add(hash);
+    }
+    for (const auto& hash : vecShared) {
+        BOOST_CHECK(summaryTheirs.Matches(summaryOurs, hash));
+    }
+
+    // the key and buckets survive the network round trip
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << summaryTheirs;
+    CGovernanceVoteSummary summaryRead;
+    ss >> summaryRead;
+    BOOST_CHECK(ss.empty());
+    BOOST_CHECK(summaryRead.IsValid());
+    BOOST_CHECK_EQUAL(summaryRead.GetBucketCount(), summaryTheirs.GetBucketCount());
+    CGovernanceVoteSummary summaryRebuilt = summaryRead.EmptyCopy();
+    for (const auto& hash : vecShared) {
+        summaryRebuilt.Add(hash);
+    }
+    for (const auto& hash : vecShared) {
+        BOOST_CHECK(summaryRead.Matches(summaryTheirs, hash));
+        BOOST_CHECK(summaryRead.Matches(summaryRebuilt, hash));
+    }
+    CDataStream ssTheirs(SER_NETWORK, PROTOCOL_VERSION), ssRebuilt(SER_NETWORK, PROTOCOL_VERSION);
+    ssTheirs << summaryTheirs;
+    ssRebuilt << summaryRebuilt;
+    BOOST_CHECK(ssTheirs.str() == ssRebuilt.str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
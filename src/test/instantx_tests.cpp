@@ -0,0 +1,212 @@
+// Copyright (c) 2019 Cryptroxcoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <instantx.h>
+#include <masternode-sync.h>
+#include <net.h>
+#include <test/test_bitcoin.h>
+#include <utiltime.h>
+
+#include <boost/test/unit_test.hpp>
+
+struct CInstantSendTest {
+    /// Keep a vote as an orphan, the way ProcessTxLockVote does for votes of unknown txes
+    static void AddOrphanVote(CInstantSend& is, const CTxLockVote& vote)
+    {
+        LOCK(is.cs_instantsend);
+        is.mapTxLockVotes.Insert(vote.GetHash(), vote);
+        is.AddOrphanTxLockVote(vote);
+    }
+
+    static bool HasOrphanVote(CInstantSend& is, const uint256& hash)
+    {
+        LOCK(is.cs_instantsend);
+        return is.mapTxLockVotesOrphan.get<orphan_vote_hash>().count(hash) != 0;
+    }
+
+    static size_t GetOrphanVoteCount(CInstantSend& is)
+    {
+        LOCK(is.cs_instantsend);
+        return is.mapTxLockVotesOrphan.size();
+    }
+
+    static bool HasVote(CInstantSend& is, const uint256& hash)
+    {
+        return is.mapTxLockVotes.Contains(hash);
+    }
+
+    static bool IsEnoughOrphanVotesForTx(CInstantSend& is, const CTxLockRequest& txLockRequest)
+    {
+        return is.IsEnoughOrphanVotesForTx(txLockRequest);
+    }
+
+    static bool UpdateMasternodeOrphanVoteTime(CInstantSend& is, const COutPoint& outpointMasternode)
+    {
+        LOCK(is.cs_instantsend);
+        return is.UpdateMasternodeOrphanVoteTime(outpointMasternode);
+    }
+
+    static bool HasMasternodeOrphanVoteTime(CInstantSend& is, const COutPoint& outpointMasternode)
+    {
+        LOCK(is.cs_instantsend);
+        return is.mapMasternodeOrphanVotes.count(outpointMasternode) != 0;
+    }
+
+    static void CheckAndRemove(CInstantSend& is)
+    {
+        LOCK(is.cs_instantsend);
+        is.CheckAndRemove();
+    }
+};
+
+static std::vector<CTxLockVote> MakeVotes(const uint256& txHash, const COutPoint& outpoint, int nCount)
+{
+    std::vector<CTxLockVote> vecVotes;
+    for (int i = 0; i < nCount; i++) {
+        vecVotes.emplace_back(txHash, outpoint, COutPoint(InsecureRand256(), 0));
+    }
+    return vecVotes;
+}
+
+struct InstantSendTestingSetup : public TestingSetup {
+    InstantSendTestingSetup()
+    {
+        // CheckAndRemove() waits for the masternode list
+        masternodeSync.Reset();
+        while (!masternodeSync.IsSynced()) {
+            masternodeSync.SwitchToNextAsset(*g_connman);
+        }
+    }
+
+    ~InstantSendTestingSetup()
+    {
+        masternodeSync.Reset();
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(instantx_tests, InstantSendTestingSetup)
+
+BOOST_AUTO_TEST_CASE(orphan_votes_by_tx_outpoint)
+{
+    CInstantSend is{};
+    const int nRequired = COutPointLock::SIGNATURES_REQUIRED;
+
+    CMutableTransaction mtx;
+    mtx.vin.emplace_back(COutPoint(InsecureRand256(), 0));
+    mtx.vin.emplace_back(COutPoint(InsecureRand256(), 1));
+    mtx.vout.resize(1);
+    CTxLockRequest txLockRequest{CTransaction(mtx)};
+    uint256 txHash = txLockRequest.GetHash();
+
+    // enough votes for one input only, votes for the other input of another tx do not count
+    for (const auto& vote : MakeVotes(txHash, mtx.vin[0].prevout, nRequired)) {
+        CInstantSendTest::AddOrphanVote(is, vote);
+    }
+    for (const auto& vote : MakeVotes(InsecureRand256(), mtx.vin[1].prevout, nRequired)) {
+        CInstantSendTest::AddOrphanVote(is, vote);
+    }
+    std::vector<CTxLockVote> vecVotes = MakeVotes(txHash, mtx.vin[1].prevout, nRequired);
+    for (int i = 0; i < nRequired - 1; i++) {
+        CInstantSendTest::AddOrphanVote(is, vecVotes[i]);
+    }
+    BOOST_CHECK_EQUAL(CInstantSendTest::GetOrphanVoteCount(is), size_t(3 * nRequired - 1));
+    BOOST_CHECK(!CInstantSendTest::IsEnoughOrphanVotesForTx(is, txLockRequest));
+
+    CInstantSendTest::AddOrphanVote(is, vecVotes.back());
+    BOOST_CHECK(CInstantSendTest::HasOrphanVote(is, vecVotes.back().GetHash()));
+    BOOST_CHECK(CInstantSendTest::IsEnoughOrphanVotesForTx(is, txLockRequest));
+}
+
+BOOST_AUTO_TEST_CASE(orphan_votes_limit)
+{
+    CInstantSend is{};
+    std::vector<CTxLockVote> vecVotes = MakeVotes(InsecureRand256(), COutPoint(InsecureRand256(), 0), MAX_ORPHAN_TXLOCK_VOTES + 10);
+    for (const auto& vote : vecVotes) {
+        CInstantSendTest::AddOrphanVote(is, vote);
+    }
+
+    // the oldest votes are evicted, they are still known so they are not requested again
+    BOOST_CHECK_EQUAL(CInstantSendTest::GetOrphanVoteCount(is), MAX_ORPHAN_TXLOCK_VOTES);
+    for (size_t i = 0; i < 10; i++) {
+        BOOST_CHECK(!CInstantSendTest::HasOrphanVote(is, vecVotes[i].GetHash()));
+        BOOST_CHECK(CInstantSendTest::HasVote(is, vecVotes[i].GetHash()));
+    }
+    BOOST_CHECK(CInstantSendTest::HasOrphanVote(is, vecVotes[10].GetHash()));
+    BOOST_CHECK(CInstantSendTest::HasOrphanVote(is, vecVotes.back().GetHash()));
+}
+
+BOOST_AUTO_TEST_CASE(orphan_votes_expiry)
+{
+    CInstantSend is{};
+    int64_t nNow = GetTime();
+    SetMockTime(nNow);
+
+    uint256 txHash = InsecureRand256();
+    COutPoint outpoint(InsecureRand256(), 0);
+    std::vector<CTxLockVote> vecOld = MakeVotes(txHash, outpoint, 3);
+    for (const auto& vote : vecOld) {
+        CInstantSendTest::AddOrphanVote(is, vote);
+    }
+    SetMockTime(nNow + INSTANTSEND_LOCK_TIMEOUT_SECONDS);
+    std::vector<CTxLockVote> vecNew = MakeVotes(txHash, outpoint, 2);
+    for (const auto& vote : vecNew) {
+        CInstantSendTest::AddOrphanVote(is, vote);
+    }
+
+    // nothing timed out yet
+    CInstantSendTest::CheckAndRemove(is);
+    BOOST_CHECK_EQUAL(CInstantSendTest::GetOrphanVoteCount(is), 5U);
+
+    // timed out orphan votes are dropped from both maps, the younger ones stay
+    SetMockTime(nNow + INSTANTSEND_LOCK_TIMEOUT_SECONDS + 1);
+    CInstantSendTest::CheckAndRemove(is);
+    BOOST_CHECK_EQUAL(CInstantSendTest::GetOrphanVoteCount(is), 2U);
+    for (const auto& vote : vecOld) {
+        BOOST_CHECK(!CInstantSendTest::HasOrphanVote(is, vote.GetHash()));
+        BOOST_CHECK(!CInstantSendTest::HasVote(is, vote.GetHash()));
+    }
+    for (const auto& vote : vecNew) {
+        BOOST_CHECK(CInstantSendTest::HasOrphanVote(is, vote.GetHash()));
+        BOOST_CHECK(CInstantSendTest::HasVote(is, vote.GetHash()));
+    }
+
+    SetMockTime(nNow + 2 * INSTANTSEND_LOCK_TIMEOUT_SECONDS + 1);
+    CInstantSendTest::CheckAndRemove(is);
+    BOOST_CHECK_EQUAL(CInstantSendTest::GetOrphanVoteCount(is), 0U);
+
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_CASE(orphan_votes_per_masternode)
+{
+    CInstantSend is{};
+    int64_t nNow = GetTime();
+    COutPoint outpointFast(InsecureRand256(), 0), outpointSlow(InsecureRand256(), 1);
+
+    SetMockTime(nNow - 300);
+    BOOST_CHECK(CInstantSendTest::UpdateMasternodeOrphanVoteTime(is, outpointSlow));
+    SetMockTime(nNow);
+    BOOST_CHECK(CInstantSendTest::UpdateMasternodeOrphanVoteTime(is, outpointFast));
+
+    // a masternode sending orphan votes faster than the average one is refused
+    BOOST_CHECK(!CInstantSendTest::UpdateMasternodeOrphanVoteTime(is, outpointFast));
+
+    // one at or below the average is not, and is refreshed
+    BOOST_CHECK(CInstantSendTest::UpdateMasternodeOrphanVoteTime(is, outpointSlow));
+    BOOST_CHECK(CInstantSendTest::UpdateMasternodeOrphanVoteTime(is, outpointFast));
+
+    // the times expire after 10 minutes
+    SetMockTime(nNow + 60 * 10);
+    CInstantSendTest::CheckAndRemove(is);
+    BOOST_CHECK(CInstantSendTest::HasMasternodeOrphanVoteTime(is, outpointFast));
+    SetMockTime(nNow + 60 * 10 + 1);
+    CInstantSendTest::CheckAndRemove(is);
+    BOOST_CHECK(!CInstantSendTest::HasMasternodeOrphanVoteTime(is, outpointFast));
+    BOOST_CHECK(!CInstantSendTest::HasMasternodeOrphanVoteTime(is, outpointSlow));
+    BOOST_CHECK(CInstantSendTest::UpdateMasternodeOrphanVoteTime(is, outpointFast));
+
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
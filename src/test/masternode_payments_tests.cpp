@@ -0,0 +1,188 @@
+// Copyright (c) 2019 Cryptroxcoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <masternode-paymentdb.h>
+#include <masternode-payments.h>
+#include <streams.h>
+#include <test/test_bitcoin.h>
+
+#include <boost/test/unit_test.hpp>
+
+static CMasternodePaymentVote MakeVote(int nBlockHeight, const CScript& payee = CScript() << OP_TRUE)
+{
+    CMasternodePaymentVote vote(COutPoint(InsecureRand256(), 0), nBlockHeight, payee);
+    vote.vchSig = {1, 2, 3};
+    return vote;
+}
+
+// The linear scans over vecPayees that the payee index replaced
+
+static int GetMaxVotesLinear(CMasternodeBlockPayees& blockPayees)
+{
+    int nMaxVotes = 0;
+    for (auto& payee : blockPayees.vecPayees) {
+        nMaxVotes = std::max(nMaxVotes, payee.GetVoteCount());
+    }
+    return nMaxVotes;
+}
+
+static bool HasPayeeWithVotesLinear(CMasternodeBlockPayees& blockPayees, const CScript& payeeIn, int nVotesReq)
+{
+    for (auto& payee : blockPayees.vecPayees) {
+        if (payee.GetVoteCount() >= nVotesReq && payee.GetPayee() == payeeIn) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool IsTransactionValidLinear(CMasternodeBlockPayees& blockPayees, const CTransactionRef& txNew)
+{
+    CAmount nMasternodePayment = GetMasternodePayment(blockPayees.nBlockHeight, txNew->GetValueOut());
+    if (GetMaxVotesLinear(blockPayees) < MNPAYMENTS_SIGNATURES_REQUIRED) return true;
+    for (auto& payee : blockPayees.vecPayees) {
+        if (payee.GetVoteCount() >= MNPAYMENTS_SIGNATURES_REQUIRED) {
+            for (const auto& txout : txNew->vout) {
+                if (payee.GetPayee() == txout.scriptPubKey && nMasternodePayment == txout.nValue) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+static void CheckAgainstLinear(CMasternodeBlockPayees& blockPayees, const std::vector<CScript>& vecScripts, const std::vector<CTransactionRef>& vecTxes)
+{
+    // the vote counts kept for blocks that left memory answer the same
+    CMasternodeBlockVoteCount count = blockPayees.GetVoteCount();
+    BOOST_CHECK_EQUAL(count.nMaxVotes, GetMaxVotesLinear(blockPayees));
+    for (const auto& script : vecScripts) {
+        for (int nVotesReq = 1; nVotesReq <= MNPAYMENTS_SIGNATURES_TOTAL; nVotesReq++) {
+            BOOST_CHECK_EQUAL(blockPayees.HasPayeeWithVotes(script, nVotesReq), HasPayeeWithVotesLinear(blockPayees, script, nVotesReq));
+            BOOST_CHECK_EQUAL(count.HasPayeeWithVotes(script, nVotesReq), HasPayeeWithVotesLinear(blockPayees, script, nVotesReq));
+        }
+    }
+    for (const auto& tx : vecTxes) {
+        BOOST_CHECK_EQUAL(blockPayees.IsTransactionValid(tx), IsTransactionValidLinear(blockPayees, tx));
+        BOOST_CHECK_EQUAL(count.IsTransactionValid(tx, blockPayees.nBlockHeight), IsTransactionValidLinear(blockPayees, tx));
+    }
+}
+
+BOOST_FIXTURE_TEST_SUITE(masternode_payments_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(paymentdb_write_read)
+{
+    std::vector<CMasternodePaymentVote> vecVotes = {MakeVote(255), MakeVote(256), MakeVote(256), MakeVote(1000)};
+    for (const auto& vote : vecVotes) {
+        BOOST_CHECK(pMasternodePaymentDB->WriteVote(vote));
+    }
+
+    for (const auto& vote : vecVotes) {
+        CMasternodePaymentVote voteRead;
+        BOOST_CHECK(pMasternodePaymentDB->HasVote(vote.GetHash()));
+        BOOST_CHECK(pMasternodePaymentDB->ReadVote(vote.GetHash(), voteRead));
+        BOOST_CHECK(voteRead.GetHash() == vote.GetHash());
+        BOOST_CHECK(voteRead.vchSig == vote.vchSig);
+    }
+    BOOST_CHECK(!pMasternodePaymentDB->HasVote(InsecureRand256()));
+
+    // reads by height only return the votes of that block
+    BOOST_CHECK_EQUAL(pMasternodePaymentDB->ReadVotes(255).size(), 1U);
+    BOOST_CHECK_EQUAL(pMasternodePaymentDB->ReadVotes(256).size(), 2U);
+    BOOST_CHECK_EQUAL(pMasternodePaymentDB->ReadVotes(257).size(), 0U);
+    for (const auto& vote : pMasternodePaymentDB->ReadVotes(256)) {
+        BOOST_CHECK_EQUAL(vote.nBlockHeight, 256);
+    }
+
+    // the payments manager finds votes that only exist in the store, HasPaymentVote() doesn't read it
+    BOOST_CHECK(!mnpayments.HasPaymentVote(vecVotes[0].GetHash()));
+    BOOST_CHECK(mnpayments.HasVerifiedPaymentVote(vecVotes[0].GetHash()));
+    CMasternodePaymentVote voteRead;
+    BOOST_CHECK(mnpayments.GetPaymentVote(vecVotes[3].GetHash(), voteRead));
+    BOOST_CHECK(voteRead.GetHash() == vecVotes[3].GetHash());
+}
+
+BOOST_AUTO_TEST_CASE(paymentdb_erase_below)
+{
+    std::vector<CMasternodePaymentVote> vecVotes;
+    for (int nHeight : {1, 255, 256, 256, 257, 70000}) {
+        vecVotes.push_back(MakeVote(nHeight));
+        BOOST_CHECK(pMasternodePaymentDB->WriteVote(vecVotes.back()));
+    }
+
+    // heights are compared numerically, not by their little-endian bytes
+    BOOST_CHECK_EQUAL(pMasternodePaymentDB->EraseVotesBelow(256), 2);
+    BOOST_CHECK_EQUAL(pMasternodePaymentDB->EraseVotesBelow(256), 0);
+    for (const auto& vote : vecVotes) {
+        BOOST_CHECK_EQUAL(pMasternodePaymentDB->HasVote(vote.GetHash()), vote.nBlockHeight >= 256);
+    }
+    BOOST_CHECK(pMasternodePaymentDB->ReadVotes(255).empty());
+    BOOST_CHECK_EQUAL(pMasternodePaymentDB->ReadVotes(256).size(), 2U);
+
+    BOOST_CHECK_EQUAL(pMasternodePaymentDB->EraseVotesBelow(70001), 4);
+    for (const auto& vote : vecVotes) {
+        CMasternodePaymentVote voteRead;
+        BOOST_CHECK(!pMasternodePaymentDB->ReadVote(vote.GetHash(), voteRead));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(block_payees_index)
+{
+    const int nBlockHeight = 1000;
+
+    // the last script never gets a vote
+    std::vector<CScript> vecScripts;
+    for (int i = 0; i < 6; i++) {
+        vecScripts.push_back(CScript() << OP_TRUE << i);
+    }
+
+    // coinbases paying each script the masternode payment, a wrong amount or next to the right payee
+    CAmount nMasternodePayment = GetMasternodePayment(nBlockHeight, 10 * COIN);
+    std::vector<CTransactionRef> vecTxes;
+    for (const auto& script : vecScripts) {
+        CMutableTransaction mtx;
+        mtx.vout.emplace_back(10 * COIN - nMasternodePayment, CScript() << OP_FALSE);
+        mtx.vout.emplace_back(nMasternodePayment, script);
+        vecTxes.push_back(MakeTransactionRef(mtx));
+        mtx.vout[0].nValue += 1;
+        mtx.vout[1].nValue -= 1;
+        vecTxes.push_back(MakeTransactionRef(mtx));
+        mtx.vout[0].nValue -= 1;
+        mtx.vout[1].nValue += 1;
+        mtx.vout.insert(mtx.vout.begin() + 1, CTxOut(nMasternodePayment, vecScripts.back()));
+        mtx.vout[0].nValue -= nMasternodePayment;
+        vecTxes.push_back(MakeTransactionRef(mtx));
+    }
+
+    CMasternodeBlockPayees blockPayees(nBlockHeight);
+    CMasternodeBlockVoteCount count;
+    CheckAgainstLinear(blockPayees, vecScripts, vecTxes);
+    for (int i = 0; i < 60; i++) {
+        CMasternodePaymentVote vote = MakeVote(nBlockHeight, vecScripts[InsecureRandRange(vecScripts.size() - 1)]);
+        blockPayees.AddPayee(vote);
+        count.AddVote(vote.payee);
+        CheckAgainstLinear(blockPayees, vecScripts, vecTxes);
+    }
+    BOOST_CHECK(GetMaxVotesLinear(blockPayees) >= MNPAYMENTS_SIGNATURES_REQUIRED);
+
+    // counting the votes of a stored block one by one gives the same counts
+    CMasternodeBlockVoteCount countFull = blockPayees.GetVoteCount();
+    BOOST_CHECK_EQUAL(count.nMaxVotes, countFull.nMaxVotes);
+    BOOST_CHECK_EQUAL(count.nTotalVotes, countFull.nTotalVotes);
+    BOOST_CHECK(count.mapPayeeVotes == countFull.mapPayeeVotes);
+
+    // the index is rebuilt when read from disk
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << blockPayees;
+    CMasternodeBlockPayees blockPayeesRead;
+    ss >> blockPayeesRead;
+    BOOST_CHECK_EQUAL(blockPayeesRead.vecPayees.size(), blockPayees.vecPayees.size());
+    CheckAgainstLinear(blockPayeesRead, vecScripts, vecTxes);
+    blockPayeesRead.AddPayee(MakeVote(nBlockHeight, vecScripts.back()));
+    BOOST_CHECK(blockPayeesRead.HasPayeeWithVotes(vecScripts.back(), 1));
+    CheckAgainstLinear(blockPayeesRead, vecScripts, vecTxes);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
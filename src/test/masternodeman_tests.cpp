@@ -0,0 +1,366 @@
+// Copyright (c) 2019 Cryptroxcoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <masternode.h>
+#include <masternodeman.h>
+#include <script/standard.h>
+#include <test/test_bitcoin.h>
+#include <utiltime.h>
+
+#include <functional>
+#include <limits>
+
+#include <boost/test/unit_test.hpp>
+
+struct CMasternodeManTest {
+    /// Adjusted time of the next scheduled Check() of a masternode, max if it is not scheduled
+    static int64_t GetCheckTime(const COutPoint& outpoint)
+    {
+        LOCK(mnodeman.cs);
+        auto it = mnodeman.mapCheckScheduleTime.find(outpoint);
+        return it == mnodeman.mapCheckScheduleTime.end() ? std::numeric_limits<int64_t>::max() : it->second;
+    }
+
+    /// Memoised scores of all masternodes for a block hash, highest first
+    static const CMasternodeMan::score_pair_vec_t& GetCachedScores(const uint256& nBlockHash)
+    {
+        LOCK(mnodeman.cs);
+        return mnodeman.GetCachedScores(nBlockHash).vecScores;
+    }
+
+    static size_t GetScoreCacheSize()
+    {
+        LOCK(mnodeman.cs);
+        assert(mnodeman.mapScoreCache.size() == mnodeman.listScoreCacheOrder.size());
+        return mnodeman.mapScoreCache.size();
+    }
+
+    static size_t GetMaxScoreCacheBlocks() { return CMasternodeMan::MAX_SCORE_CACHE_BLOCKS; }
+
+    static bool IsCollateralSpent(const COutPoint& outpoint)
+    {
+        LOCK(mnodeman.cs);
+        CMasternode* pmn = mnodeman.Find(outpoint);
+        assert(pmn);
+        return pmn->fCollateralSpent;
+    }
+};
+
+static CMasternodePing MakePing(const COutPoint& outpoint, int64_t nTime)
+{
+    CMasternodePing mnp;
+    mnp.vin = CTxIn(outpoint);
+    mnp.blockHash = InsecureRand256();
+    mnp.sigTime = nTime;
+    return mnp;
+}
+
+static CMasternode MakeMasternode(uint16_t nPort, const COutPoint& outpoint = COutPoint(InsecureRand256(), 0))
+{
+    CKey key;
+    key.MakeNewKey(true);
+    in_addr ipv4Addr;
+    ipv4Addr.s_addr = 0x0100000a;
+    CMasternode mn(CService(ipv4Addr, nPort), outpoint, key.GetPubKey(), key.GetPubKey(), PROTOCOL_VERSION);
+    mn.fUnitTest = true;
+    return mn;
+}
+
+BOOST_FIXTURE_TEST_SUITE(masternodeman_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(check_schedule)
+{
+    const int64_t nMax = std::numeric_limits<int64_t>::max();
+    int64_t nNow = GetTime();
+    SetMockTime(nNow);
+    mnodeman.Clear();
+
+    CMasternode mnPinged = MakeMasternode(1);
+    mnPinged.lastPing = MakePing(mnPinged.vin.prevout, nNow);
+    CMasternode mnNoPing = MakeMasternode(2);
+    const COutPoint& outpointPinged = mnPinged.vin.prevout;
+    const COutPoint& outpointNoPing = mnNoPing.vin.prevout;
+
+    // new masternodes are due right away
+    BOOST_CHECK(mnodeman.Add(mnPinged));
+    BOOST_CHECK(mnodeman.Add(mnNoPing));
+    BOOST_CHECK_EQUAL(CMasternodeManTest::GetCheckTime(outpointPinged), 0);
+    BOOST_CHECK_EQUAL(CMasternodeManTest::GetCheckTime(outpointNoPing), 0);
+
+    // the next check is at the first ping age a state depends on, without a ping there is none
+    mnodeman.Check();
+    BOOST_CHECK_EQUAL(CMasternodeManTest::GetCheckTime(outpointPinged), nNow + MASTERNODE_MIN_MNP_SECONDS);
+    BOOST_CHECK_EQUAL(CMasternodeManTest::GetCheckTime(outpointNoPing), nMax);
+
+    // nothing due, nothing changes
+    SetMockTime(nNow + MASTERNODE_MIN_MNP_SECONDS - 1);
+    mnodeman.Check();
+    BOOST_CHECK_EQUAL(CMasternodeManTest::GetCheckTime(outpointPinged), nNow + MASTERNODE_MIN_MNP_SECONDS);
+
+    SetMockTime(nNow + MASTERNODE_MIN_MNP_SECONDS);
+    mnodeman.Check();
+    BOOST_CHECK_EQUAL(CMasternodeManTest::GetCheckTime(outpointPinged), nNow + MASTERNODE_EXPIRATION_SECONDS);
+
+    SetMockTime(nNow + MASTERNODE_EXPIRATION_SECONDS);
+    mnodeman.Check();
+    BOOST_CHECK_EQUAL(CMasternodeManTest::GetCheckTime(outpointPinged), nNow + MASTERNODE_NEW_START_REQUIRED_SECONDS);
+
+    // a masternode that went off the schedule comes back with its next ping
+    int64_t nPingTime = nNow + MASTERNODE_EXPIRATION_SECONDS;
+    mnodeman.SetMasternodeLastPing(outpointNoPing, MakePing(outpointNoPing, nPingTime));
+    BOOST_CHECK_EQUAL(CMasternodeManTest::GetCheckTime(outpointNoPing), 0);
+    mnodeman.Check();
+    BOOST_CHECK_EQUAL(CMasternodeManTest::GetCheckTime(outpointNoPing), nPingTime + MASTERNODE_MIN_MNP_SECONDS);
+
+    // removed masternodes leave the schedule
+    mnodeman.Remove(outpointPinged);
+    BOOST_CHECK_EQUAL(CMasternodeManTest::GetCheckTime(outpointPinged), nMax);
+
+    mnodeman.Clear();
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_CASE(index_lookups)
+{
+    mnodeman.Clear();
+
+    CMasternode mn1 = MakeMasternode(1), mn2 = MakeMasternode(2);
+    BOOST_CHECK(mnodeman.Add(mn1));
+    BOOST_CHECK(mnodeman.Add(mn2));
+
+    masternode_info_t mnInfo;
+    for (const auto& mn : {mn1, mn2}) {
+        BOOST_CHECK(mnodeman.GetMasternodeInfo(mn.pubKeyMasternode, mnInfo));
+        BOOST_CHECK(mnInfo.vin.prevout == mn.vin.prevout);
+        BOOST_CHECK(mnodeman.GetMasternodeInfo(GetScriptForDestination(mn.pubKeyCollateralAddress.GetID()), mnInfo));
+        BOOST_CHECK(mnInfo.vin.prevout == mn.vin.prevout);
+    }
+    CKey keyUnknown;
+    keyUnknown.MakeNewKey(true);
+    BOOST_CHECK(!mnodeman.GetMasternodeInfo(keyUnknown.GetPubKey(), mnInfo));
+    BOOST_CHECK(!mnodeman.GetMasternodeInfo(GetScriptForDestination(keyUnknown.GetPubKey().GetID()), mnInfo));
+
+    // the indexes follow every change of the list once they were built
+    mnodeman.Remove(mn1.vin.prevout);
+    BOOST_CHECK(!mnodeman.GetMasternodeInfo(mn1.pubKeyMasternode, mnInfo));
+    BOOST_CHECK(!mnodeman.GetMasternodeInfo(GetScriptForDestination(mn1.pubKeyCollateralAddress.GetID()), mnInfo));
+    BOOST_CHECK(mnodeman.GetMasternodeInfo(mn2.pubKeyMasternode, mnInfo));
+
+    CMasternode mn3 = MakeMasternode(3);
+    BOOST_CHECK(mnodeman.Add(mn3));
+    BOOST_CHECK(mnodeman.GetMasternodeInfo(mn3.pubKeyMasternode, mnInfo));
+    BOOST_CHECK(mnInfo.vin.prevout == mn3.vin.prevout);
+    BOOST_CHECK(mnodeman.GetMasternodeInfo(GetScriptForDestination(mn3.pubKeyCollateralAddress.GetID()), mnInfo));
+    BOOST_CHECK(mnInfo.vin.prevout == mn3.vin.prevout);
+
+    mnodeman.Clear();
+    BOOST_CHECK(!mnodeman.GetMasternodeInfo(mn2.pubKeyMasternode, mnInfo));
+}
+
+BOOST_AUTO_TEST_CASE(score_cache)
+{
+    mnodeman.Clear();
+    for (uint16_t nPort = 1; nPort <= 5; nPort++) {
+        CMasternode mn = MakeMasternode(nPort);
+        BOOST_CHECK(mnodeman.Add(mn));
+    }
+
+    // every masternode, highest score first, each the score CMasternode calculates itself
+    uint256 nBlockHash = InsecureRand256();
+    const CMasternodeMan::score_pair_vec_t& vecScores = CMasternodeManTest::GetCachedScores(nBlockHash);
+    BOOST_CHECK_EQUAL(vecScores.size(), 5U);
+    for (size_t i = 0; i < vecScores.size(); i++) {
+        BOOST_CHECK(vecScores[i].first == vecScores[i].second->CalculateScore(nBlockHash));
+        if (i > 0) BOOST_CHECK(vecScores[i - 1].first >= vecScores[i].first);
+    }
+
+    // calculated once per block hash
+    BOOST_CHECK_EQUAL(CMasternodeManTest::GetScoreCacheSize(), 1U);
+    BOOST_CHECK(&CMasternodeManTest::GetCachedScores(nBlockHash) == &vecScores);
+    BOOST_CHECK_EQUAL(CMasternodeManTest::GetScoreCacheSize(), 1U);
+
+    // only the last hashes are kept
+    for (size_t i = 0; i < 2 * CMasternodeManTest::GetMaxScoreCacheBlocks(); i++) {
+        CMasternodeManTest::GetCachedScores(InsecureRand256());
+        BOOST_CHECK(CMasternodeManTest::GetScoreCacheSize() <= CMasternodeManTest::GetMaxScoreCacheBlocks());
+    }
+    BOOST_CHECK_EQUAL(CMasternodeManTest::GetScoreCacheSize(), CMasternodeManTest::GetMaxScoreCacheBlocks());
+
+    // any change of the list drops the cache
+    CMasternode mnNew = MakeMasternode(6);
+    BOOST_CHECK(mnodeman.Add(mnNew));
+    BOOST_CHECK_EQUAL(CMasternodeManTest::GetScoreCacheSize(), 0U);
+    BOOST_CHECK_EQUAL(CMasternodeManTest::GetCachedScores(nBlockHash).size(), 6U);
+
+    mnodeman.Remove(mnNew.vin.prevout);
+    BOOST_CHECK_EQUAL(CMasternodeManTest::GetScoreCacheSize(), 0U);
+    const CMasternodeMan::score_pair_vec_t& vecScoresAgain = CMasternodeManTest::GetCachedScores(nBlockHash);
+    BOOST_CHECK_EQUAL(vecScoresAgain.size(), 5U);
+    for (const auto& scorePair : vecScoresAgain) {
+        BOOST_CHECK(scorePair.second->vin.prevout != mnNew.vin.prevout);
+        BOOST_CHECK(scorePair.first == scorePair.second->CalculateScore(nBlockHash));
+    }
+
+    mnodeman.Clear();
+}
+
+BOOST_AUTO_TEST_CASE(collateral_spend_undo)
+{
+    mnodeman.Clear();
+
+    CMutableTransaction txCoinbase;
+    txCoinbase.vin.emplace_back(COutPoint());
+    txCoinbase.vout.emplace_back(1, CScript() << OP_TRUE);
+
+    // spends the collateral of an existing masternode
+    CMasternode mnSpent = MakeMasternode(1);
+    CMutableTransaction txSpend;
+    txSpend.vin.emplace_back(mnSpent.vin.prevout);
+    txSpend.vout.emplace_back(1, CScript() << OP_TRUE);
+
+    // creates a collateral that stays unspent
+    CMutableTransaction txCreate;
+    txCreate.vin.emplace_back(COutPoint(InsecureRand256(), 0));
+    txCreate.vout.emplace_back(1, CScript() << OP_TRUE);
+    CMasternode mnCreated = MakeMasternode(2, COutPoint(txCreate.GetHash(), 0));
+
+    // creates a collateral that a later transaction of the same block spends
+    CMutableTransaction txCreateSpent;
+    txCreateSpent.vin.emplace_back(COutPoint(InsecureRand256(), 0));
+    txCreateSpent.vout.resize(2, CTxOut(1, CScript() << OP_TRUE));
+    CMasternode mnCreatedSpent = MakeMasternode(3, COutPoint(txCreateSpent.GetHash(), 1));
+    CMutableTransaction txSpendCreated;
+    txSpendCreated.vin.emplace_back(mnCreatedSpent.vin.prevout);
+    txSpendCreated.vout.emplace_back(1, CScript() << OP_TRUE);
+
+    // unrelated to the block
+    CMasternode mnOther = MakeMasternode(4);
+
+    CBlock block;
+    for (const auto& mtx : {txCoinbase, txSpend, txCreate, txCreateSpent, txSpendCreated}) {
+        block.vtx.push_back(MakeTransactionRef(mtx));
+    }
+
+    // nothing to do without masternodes
+    mnodeman.UpdateCollaterals(block, true);
+
+    for (auto& mn : {mnSpent, mnCreated, mnCreatedSpent, mnOther}) {
+        CMasternode mnAdd(mn);
+        BOOST_CHECK(mnodeman.Add(mnAdd));
+    }
+    mnodeman.Check();
+    BOOST_CHECK(CMasternodeManTest::GetCheckTime(mnSpent.vin.prevout) != 0);
+
+    mnodeman.UpdateCollaterals(block, true);
+    BOOST_CHECK(CMasternodeManTest::IsCollateralSpent(mnSpent.vin.prevout));
+    BOOST_CHECK(!CMasternodeManTest::IsCollateralSpent(mnCreated.vin.prevout));
+    BOOST_CHECK(CMasternodeManTest::IsCollateralSpent(mnCreatedSpent.vin.prevout));
+    BOOST_CHECK(!CMasternodeManTest::IsCollateralSpent(mnOther.vin.prevout));
+
+    // touched masternodes are checked again right away and show up in the next snapshot
+    BOOST_CHECK_EQUAL(CMasternodeManTest::GetCheckTime(mnSpent.vin.prevout), 0);
+    BOOST_CHECK_EQUAL(CMasternodeManTest::GetCheckTime(mnCreatedSpent.vin.prevout), 0);
+    BOOST_CHECK(CMasternodeManTest::GetCheckTime(mnOther.vin.prevout) != 0);
+    BOOST_CHECK(mnodeman.GetSnapshot()->at(mnSpent.vin.prevout)->fCollateralSpent);
+
+    // disconnecting restores spent collaterals and removes the ones the block created
+    mnodeman.UpdateCollaterals(block, false);
+    BOOST_CHECK(!CMasternodeManTest::IsCollateralSpent(mnSpent.vin.prevout));
+    BOOST_CHECK(CMasternodeManTest::IsCollateralSpent(mnCreated.vin.prevout));
+    BOOST_CHECK(CMasternodeManTest::IsCollateralSpent(mnCreatedSpent.vin.prevout));
+    BOOST_CHECK(!CMasternodeManTest::IsCollateralSpent(mnOther.vin.prevout));
+    BOOST_CHECK(!mnodeman.GetSnapshot()->at(mnSpent.vin.prevout)->fCollateralSpent);
+
+    // and connecting it again gets back to the same state
+    mnodeman.UpdateCollaterals(block, true);
+    BOOST_CHECK(CMasternodeManTest::IsCollateralSpent(mnSpent.vin.prevout));
+    BOOST_CHECK(!CMasternodeManTest::IsCollateralSpent(mnCreated.vin.prevout));
+    BOOST_CHECK(CMasternodeManTest::IsCollateralSpent(mnCreatedSpent.vin.prevout));
+
+    mnodeman.Clear();
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_invalidation)
+{
+    int64_t nNow = GetTime();
+    SetMockTime(nNow);
+    mnodeman.Clear();
+    BOOST_CHECK(mnodeman.GetSnapshot()->empty());
+
+    CMasternode mn1 = MakeMasternode(1), mn2 = MakeMasternode(2);
+    mn1.lastPing = MakePing(mn1.vin.prevout, nNow);
+    const COutPoint& outpoint1 = mn1.vin.prevout;
+    const COutPoint& outpoint2 = mn2.vin.prevout;
+    BOOST_CHECK(mnodeman.Add(mn1));
+    BOOST_CHECK(mnodeman.Add(mn2));
+
+    CMasternodeMan::snapshot_t snapshot = mnodeman.GetSnapshot();
+    BOOST_CHECK_EQUAL(snapshot->size(), 2U);
+    BOOST_CHECK(mnodeman.GetSnapshot() == snapshot);
+
+    // every mutation publishes a new snapshot with a fresh copy of the entry, earlier snapshots stay as they were
+    auto CheckChanged = [&](const char* pszMutation, const COutPoint& outpoint, bool fAllCopied, std::function<bool(const CMasternode&)> fChanged) {
+        BOOST_TEST_MESSAGE(pszMutation);
+        CMasternodeMan::snapshot_t snapshotNew = mnodeman.GetSnapshot();
+        BOOST_CHECK(snapshotNew != snapshot);
+        BOOST_CHECK(snapshotNew->at(outpoint) != snapshot->at(outpoint));
+        if (fChanged) {
+            BOOST_CHECK(fChanged(*snapshotNew->at(outpoint)));
+            BOOST_CHECK(!fChanged(*snapshot->at(outpoint)));
+        }
+        // unchanged entries are shared with the previous snapshot
+        for (const auto& mnpair : *snapshot) {
+            if (mnpair.first != outpoint) BOOST_CHECK_EQUAL(snapshotNew->at(mnpair.first) == mnpair.second, !fAllCopied);
+        }
+        BOOST_CHECK(mnodeman.GetSnapshot() == snapshotNew);
+        snapshot = snapshotNew;
+    };
+
+    BOOST_CHECK(mnodeman.DisallowMixing(outpoint1));
+    CheckChanged("DisallowMixing", outpoint1, false, [](const CMasternode& mn) { return !mn.fAllowMixingTx; });
+    BOOST_CHECK(mnodeman.AllowMixing(outpoint1));
+    CheckChanged("AllowMixing", outpoint1, false, [](const CMasternode& mn) { return mn.fAllowMixingTx; });
+
+    int nPoSeBanScore = snapshot->at(outpoint2)->nPoSeBanScore;
+    BOOST_CHECK(mnodeman.PoSeBan(outpoint2));
+    CheckChanged("PoSeBan", outpoint2, false, [&](const CMasternode& mn) { return mn.nPoSeBanScore != nPoSeBanScore; });
+
+    mnodeman.UpdateWatchdogVoteTime(outpoint1, nNow + 1);
+    CheckChanged("UpdateWatchdogVoteTime", outpoint1, false, [&](const CMasternode& mn) { return mn.nTimeLastWatchdogVote == nNow + 1; });
+
+    // the governance votes of a masternode are not copied along with it, only check the entry is republished
+    uint256 nGovernanceObjectHash = InsecureRand256();
+    BOOST_CHECK(mnodeman.AddGovernanceVote(outpoint1, nGovernanceObjectHash));
+    BOOST_CHECK(snapshot->at(outpoint1) != mnodeman.GetSnapshot()->at(outpoint1));
+    snapshot = mnodeman.GetSnapshot();
+    mnodeman.RemoveGovernanceObject(nGovernanceObjectHash);
+    CheckChanged("RemoveGovernanceObject", outpoint1, true, nullptr);
+
+    CMasternodePing mnp = MakePing(outpoint2, nNow);
+    mnodeman.SetMasternodeLastPing(outpoint2, mnp);
+    CheckChanged("SetMasternodeLastPing", outpoint2, false, [&](const CMasternode& mn) { return mn.lastPing.blockHash == mnp.blockHash; });
+
+    // a state change found by Check(), the ban above takes effect
+    mnodeman.Check();
+    CheckChanged("Check", outpoint2, false, [](const CMasternode& mn) { return mn.nActiveState == CMasternode::MASTERNODE_POSE_BAN; });
+
+    // adding and removing masternodes
+    CMasternode mn3 = MakeMasternode(3);
+    BOOST_CHECK(mnodeman.Add(mn3));
+    CMasternodeMan::snapshot_t snapshotAdded = mnodeman.GetSnapshot();
+    BOOST_CHECK_EQUAL(snapshotAdded->size(), 3U);
+    BOOST_CHECK_EQUAL(snapshot->size(), 2U);
+    mnodeman.Remove(outpoint1);
+    CMasternodeMan::snapshot_t snapshotRemoved = mnodeman.GetSnapshot();
+    BOOST_CHECK_EQUAL(snapshotRemoved->count(outpoint1), 0U);
+    BOOST_CHECK_EQUAL(snapshotRemoved->size(), 2U);
+    BOOST_CHECK_EQUAL(snapshotAdded->count(outpoint1), 1U);
+
+    mnodeman.Clear();
+    BOOST_CHECK(mnodeman.GetSnapshot()->empty());
+    BOOST_CHECK_EQUAL(snapshotRemoved->size(), 2U);
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,237 @@
+// Copyright (c) 2019 Cryptroxcoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <governance-object.h>
+#include <governance-vote.h>
+#include <key.h>
+#include <masternode.h>
+#include <messagesigner.h>
+#include <privatesend.h>
+#include <test/test_bitcoin.h>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/test/unit_test.hpp>
+
+/** Inputs covering every CTxIn::ToString() branch: a null prevout, long and
+ *  short scriptSigs and a non-final nSequence */
+static std::vector<CTxIn> MakeTxIns()
+{
+    std::vector<CTxIn> vecTxIn;
+    vecTxIn.push_back(CTxIn(COutPoint(InsecureRand256(), 7)));
+    vecTxIn.push_back(CTxIn(COutPoint(InsecureRand256(), 0xffffffff), CScript() << std::vector<unsigned char>(40, 0xab), 5));
+    vecTxIn.push_back(CTxIn(COutPoint(), CScript() << OP_TRUE << std::vector<unsigned char>(30, 0x01)));
+    vecTxIn.push_back(CTxIn(COutPoint(), CScript(), 0));
+    return vecTxIn;
+}
+
+BOOST_FIXTURE_TEST_SUITE(messagesigner_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(signature_cache)
+{
+    CKey key, keyOther;
+    key.MakeNewKey(true);
+    keyOther.MakeNewKey(true);
+    CPubKey pubkey = key.GetPubKey();
+
+    uint256 hash = InsecureRand256();
+    std::vector<unsigned char> vchSig;
+    BOOST_REQUIRE(CHashSigner::SignHash(hash, key, vchSig));
+
+    // miss, then a hit once verified
+    std::string strError;
+    BOOST_CHECK(!IsMessageSignatureCached(hash, pubkey, vchSig));
+    BOOST_CHECK(CHashSigner::VerifyHash(hash, pubkey, vchSig, strError));
+    BOOST_CHECK(IsMessageSignatureCached(hash, pubkey, vchSig));
+    BOOST_CHECK(CHashSigner::VerifyHash(hash, pubkey, vchSig, strError));
+
+    // the entry does not match any other hash, key or signature
+    uint256 hashOther = InsecureRand256();
+    BOOST_CHECK(!IsMessageSignatureCached(hashOther, pubkey, vchSig));
+    BOOST_CHECK(!IsMessageSignatureCached(hash, keyOther.GetPubKey(), vchSig));
+    std::vector<unsigned char> vchSigOther;
+    BOOST_REQUIRE(CHashSigner::SignHash(hash, keyOther, vchSigOther));
+    BOOST_CHECK(!IsMessageSignatureCached(hash, pubkey, vchSigOther));
+
+    // failed checks are never cached
+    BOOST_CHECK(!CHashSigner::VerifyHash(hash, pubkey, vchSigOther, strError));
+    BOOST_CHECK(!IsMessageSignatureCached(hash, pubkey, vchSigOther));
+    BOOST_CHECK(!CHashSigner::VerifyHash(hashOther, pubkey, vchSig, strError));
+    BOOST_CHECK(!IsMessageSignatureCached(hashOther, pubkey, vchSig));
+}
+
+BOOST_AUTO_TEST_CASE(signature_batch)
+{
+    CKey key, keyOther;
+    key.MakeNewKey(true);
+    keyOther.MakeNewKey(true);
+    CPubKey pubkey = key.GetPubKey();
+
+    CSignatureBatch batch;
+    std::vector<bool> vExpected;
+    std::vector<uint256> vHashes;
+    std::vector<std::vector<unsigned char> > vSigs;
+    for (int i = 0; i < 20; i++) {
+        bool fValid = i % 3 != 0;
+        uint256 hash = InsecureRand256();
+        std::vector<unsigned char> vchSig;
+        BOOST_REQUIRE(CHashSigner::SignHash(hash, fValid ? key : keyOther, vchSig));
+        batch.AddHash(hash, pubkey, vchSig);
+        vExpected.push_back(fValid);
+        vHashes.push_back(hash);
+        vSigs.push_back(vchSig);
+    }
+
+    // messages go through the same message hash as VerifyMessage
+    std::string strMessage = "batched message";
+    std::vector<unsigned char> vchSigMessage;
+    BOOST_REQUIRE(CMessageSigner::SignMessage(strMessage, vchSigMessage, key));
+    batch.AddMessage(pubkey, vchSigMessage, strMessage);
+    vExpected.push_back(true);
+    vHashes.push_back(CMessageSigner::GetMessageHash(strMessage));
+    vSigs.push_back(vchSigMessage);
+
+    BOOST_CHECK_EQUAL(batch.Size(), vExpected.size());
+    std::vector<bool> vValid = batch.Verify();
+    BOOST_CHECK(vValid == vExpected);
+
+    // the valid signatures were put in the cache for the in-order checks that follow
+    for (size_t i = 0; i < vExpected.size(); i++) {
+        BOOST_CHECK_EQUAL(IsMessageSignatureCached(vHashes[i], pubkey, vSigs[i]), vExpected[i]);
+    }
+
+    CSignatureBatch batchEmpty;
+    BOOST_CHECK(batchEmpty.Verify().empty());
+}
+
+BOOST_AUTO_TEST_CASE(verify_queue)
+{
+    CKey key, keyOther;
+    key.MakeNewKey(true);
+    keyOther.MakeNewKey(true);
+    CPubKey pubkey = key.GetPubKey();
+
+    CMessageVerifyQueue queue;
+    std::vector<int> vApplied;
+    std::vector<bool> vResults;
+    auto Push = [&](int n, bool fValid) {
+        uint256 hash = InsecureRand256();
+        std::vector<unsigned char> vchSig;
+        BOOST_REQUIRE(CHashSigner::SignHash(hash, fValid ? key : keyOther, vchSig));
+        queue.Push(hash, pubkey, vchSig, nullptr, [&vApplied, &vResults, n](bool fValidSignature, CNode* pfrom) {
+            vApplied.push_back(n);
+            vResults.push_back(fValidSignature);
+        });
+    };
+
+    // without a worker the message is applied before Push returns
+    Push(0, true);
+    BOOST_CHECK_EQUAL(vApplied.size(), 1U);
+    BOOST_CHECK(vResults[0]);
+
+    // with a worker every message is applied once, in the order it was pushed
+    queue.Start();
+    std::vector<bool> vExpected{true};
+    for (int n = 1; n < 3000; n++) {
+        bool fValid = n % 5 != 0;
+        Push(n, fValid);
+        vExpected.push_back(fValid);
+    }
+    queue.Flush();
+    BOOST_CHECK_EQUAL(vApplied.size(), vExpected.size());
+    for (size_t i = 0; i < vApplied.size(); i++) {
+        BOOST_CHECK_EQUAL(vApplied[i], (int)i);
+    }
+    BOOST_CHECK(vResults == vExpected);
+
+    // and inline again once stopped
+    queue.Stop();
+    Push(3000, false);
+    BOOST_CHECK_EQUAL(vApplied.size(), 3001U);
+    BOOST_CHECK(!vResults.back());
+}
+
+BOOST_AUTO_TEST_CASE(signed_payload_format)
+{
+    CSignedPayload payload;
+    payload << int64_t(-1234567890123) << "|" << 0 << "|" << uint32_t(0xffffffff) << "|" << true << false
+            << "|" << std::numeric_limits<int64_t>::min() << "|" << std::numeric_limits<uint64_t>::max();
+    std::string strExpected = "-1234567890123|0|4294967295|10|" + boost::lexical_cast<std::string>(std::numeric_limits<int64_t>::min())
+            + "|" + boost::lexical_cast<std::string>(std::numeric_limits<uint64_t>::max());
+    BOOST_CHECK_EQUAL(payload.GetMessage(), strExpected);
+    BOOST_CHECK(payload.GetHash() == CMessageSigner::GetMessageHash(strExpected));
+
+    uint256 hash = InsecureRand256();
+    CKey key;
+    key.MakeNewKey(true);
+    CSignedPayload payloadIds;
+    payloadIds << hash << key.GetPubKey().GetID();
+    BOOST_CHECK_EQUAL(payloadIds.GetMessage(), hash.ToString() + key.GetPubKey().GetID().ToString());
+
+    for (const auto& txin : MakeTxIns()) {
+        CSignedPayload payloadTxIn;
+        payloadTxIn.WriteTxIn(txin) << "|";
+        payloadTxIn.WriteOutPointShort(txin.prevout);
+        BOOST_CHECK_EQUAL(payloadTxIn.GetMessage(), txin.ToString() + "|" + txin.prevout.ToStringShort());
+    }
+}
+
+// Every signed message must hash the exact text of the old
+// boost::lexical_cast concatenation or existing signatures stop verifying
+BOOST_AUTO_TEST_CASE(signed_payload_messages)
+{
+    CKey key, keyOther;
+    key.MakeNewKey(true);
+    keyOther.MakeNewKey(true);
+
+    for (const auto& txin : MakeTxIns()) {
+        CDarksendQueue dsq(-3, txin.prevout, GetTime(), true);
+        dsq.vin = txin;
+        std::string strDsq = dsq.vin.ToString() + boost::lexical_cast<std::string>(dsq.nDenom) +
+                             boost::lexical_cast<std::string>(dsq.nTime) + boost::lexical_cast<std::string>(dsq.fReady);
+        BOOST_CHECK(dsq.GetSignatureHash() == CMessageSigner::GetMessageHash(strDsq));
+
+        CMasternodePing mnp;
+        mnp.vin = txin;
+        mnp.blockHash = InsecureRand256();
+        mnp.sigTime = GetTime();
+        std::string strMnp = mnp.vin.ToString() + mnp.blockHash.ToString() + boost::lexical_cast<std::string>(mnp.sigTime);
+        BOOST_CHECK(mnp.GetSignatureHash() == CMessageSigner::GetMessageHash(strMnp));
+
+        CGovernanceVote vote(txin.prevout, InsecureRand256(), VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_NO);
+        vote.SetTime(GetTime());
+        std::string strVote = txin.prevout.ToStringShort() + "|" + vote.GetParentHash().ToString() + "|" +
+                              boost::lexical_cast<std::string>(vote.GetSignal()) + "|" +
+                              boost::lexical_cast<std::string>(vote.GetOutcome()) + "|" +
+                              boost::lexical_cast<std::string>(vote.GetTimestamp());
+        BOOST_CHECK(vote.GetSignatureHash() == CMessageSigner::GetMessageHash(strVote));
+
+        uint256 nHashParent = InsecureRand256(), nCollateralHash = InsecureRand256();
+        int64_t nTime = GetTime();
+        CGovernanceObject govobj(nHashParent, 2, nTime, nCollateralHash, "7b226e616d65223a2274657374227d");
+        govobj.SetMasternodeVin(txin.prevout);
+        std::string strGovobj = nHashParent.ToString() + "|" + boost::lexical_cast<std::string>(2) + "|" +
+                                boost::lexical_cast<std::string>(nTime) + "|" + govobj.GetDataAsHex() + "|" +
+                                txin.prevout.ToStringShort() + "|" + nCollateralHash.ToString();
+        BOOST_CHECK(govobj.GetSignatureHash() == CMessageSigner::GetMessageHash(strGovobj));
+    }
+
+    CMutableTransaction mtx;
+    mtx.vout.resize(1);
+    mtx.vout[0].nValue = 1;
+    CDarksendBroadcastTx dstx(mtx, COutPoint(InsecureRand256(), 1), GetTime());
+    std::string strDstx = dstx.tx.GetHash().ToString() + boost::lexical_cast<std::string>(dstx.sigTime);
+    BOOST_CHECK(dstx.GetSignatureHash() == CMessageSigner::GetMessageHash(strDstx));
+
+    in_addr ipv4Addr;
+    ipv4Addr.s_addr = 0x0100000a;
+    CMasternodeBroadcast mnb(CService(ipv4Addr, 9999), COutPoint(InsecureRand256(), 0), key.GetPubKey(), keyOther.GetPubKey(), PROTOCOL_VERSION);
+    mnb.sigTime = GetTime();
+    std::string strMnb = mnb.addr.ToString(false) + boost::lexical_cast<std::string>(mnb.sigTime) +
+                         key.GetPubKey().GetID().ToString() + keyOther.GetPubKey().GetID().ToString() +
+                         boost::lexical_cast<std::string>(mnb.nProtocolVersion);
+    BOOST_CHECK_EQUAL(mnb.GetSignaturePayload().GetMessage(), strMnb);
+    BOOST_CHECK(mnb.GetSignaturePayload().GetHash() == CMessageSigner::GetMessageHash(strMnb));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -227,4 +227,65 @@ BOOST_AUTO_TEST_CASE(ipv4_peer_with_ipv6_addrMe_test)
     BOOST_CHECK(1);
 }
 
+// CRYPTROX BEGIN
+#ifndef WIN32
+static void CheckSocketEventsNodeLookup(CConnman::SocketEventsMode mode)
+{
+    BOOST_REQUIRE(CConnmanTest::InitSocketEvents(mode));
+
+    int fds1[2], fds2[2];
+    BOOST_REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds1) == 0);
+    BOOST_REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds2) == 0);
+
+    in_addr ipv4Addr;
+    ipv4Addr.s_addr = 0xa0b0c001;
+    CAddress addr = CAddress(CService(ipv4Addr, 7777), NODE_NETWORK);
+    CNode* pnode1 = new CNode(1, NODE_NETWORK, 0, fds1[0], addr, 0, 0, CAddress(), "", true);
+    CNode* pnode2 = new CNode(2, NODE_NETWORK, 0, fds2[0], addr, 1, 1, CAddress(), "", true);
+    CConnmanTest::AddNode(*pnode1);
+    CConnmanTest::AddSocketEvents(pnode1);
+
+    // data on the peer's socket flags it readable and reports it ready
+    CConnmanTest::SocketEvents();
+    BOOST_CHECK(!pnode1->fSocketReadable);
+    BOOST_REQUIRE(send(fds1[1], "x", 1, MSG_NOSIGNAL) == 1);
+    std::set<NodeId> setNodesReady = CConnmanTest::SocketEvents();
+    BOOST_CHECK(pnode1->fSocketReadable);
+    BOOST_CHECK(!pnode1->fSocketError);
+    BOOST_CHECK(setNodesReady.count(1));
+
+    // Delete the node while a duplicate of its fd keeps the registration alive,
+    // later events for it must not reach the deleted node
+    int fdDup = dup(fds1[0]);
+    BOOST_REQUIRE(fdDup >= 0);
+    CConnmanTest::ClearNodes();
+    CConnmanTest::AddNode(*pnode2);
+    CConnmanTest::AddSocketEvents(pnode2);
+    CConnmanTest::SocketEvents();
+    BOOST_REQUIRE(send(fds1[1], "y", 1, MSG_NOSIGNAL) == 1);
+    setNodesReady = CConnmanTest::SocketEvents();
+    BOOST_CHECK(!pnode2->fSocketReadable);
+    BOOST_CHECK(!setNodesReady.count(1));
+
+    BOOST_REQUIRE(send(fds2[1], "z", 1, MSG_NOSIGNAL) == 1);
+    setNodesReady = CConnmanTest::SocketEvents();
+    BOOST_CHECK(pnode2->fSocketReadable);
+    BOOST_CHECK(setNodesReady.count(2));
+
+    CConnmanTest::ClearNodes();
+    close(fdDup);
+    close(fds1[1]);
+    close(fds2[1]);
+}
+
+BOOST_FIXTURE_TEST_CASE(socket_events_node_lookup, TestingSetup)
+{
+    CheckSocketEventsNodeLookup(CConnman::SOCKETEVENTS_SELECT);
+#ifdef USE_EPOLL
+    CheckSocketEventsNodeLookup(CConnman::SOCKETEVENTS_EPOLL);
+#endif
+}
+#endif
+// CRYPTROX END
+
 BOOST_AUTO_TEST_SUITE_END()
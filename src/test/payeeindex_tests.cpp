@@ -0,0 +1,163 @@
+// Copyright (c) 2019 Cryptroxcoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <consensus/merkle.h>
+#include <consensus/validation.h>
+#include <index/payeeindex.h>
+#include <miner.h>
+#include <pow.h>
+#include <script/standard.h>
+#include <test/test_bitcoin.h>
+#include <utiltime.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+struct PayeeIndexTestingSetup : public TestChain100Setup {
+    CScript scriptMiner;
+
+    PayeeIndexTestingSetup()
+    {
+        scriptMiner = GetScriptForDestination(coinbaseKey.GetPubKey().GetID());
+    }
+
+    /// Mine a block on the tip whose coinbase pays the masternode payment to payee
+    CBlock CreateAndProcessPaymentBlock(const CScript& payee)
+    {
+        const CChainParams& chainparams = Params();
+        std::unique_ptr<CBlockTemplate> pblocktemplate = BlockAssembler(chainparams).CreateNewBlock(scriptMiner);
+        CBlock& block = pblocktemplate->block;
+        block.vtx.resize(1);
+
+        CMutableTransaction txCoinbase(*block.vtx[0]);
+        CAmount nMasternodePayment = GetMasternodePayment(chainActive.Height() + 1, block.vtx[0]->GetValueOut());
+        BOOST_REQUIRE(nMasternodePayment > 0);
+        txCoinbase.vout.resize(1);
+        // the regtest block reward can be below the masternode payment
+        txCoinbase.vout[0].nValue = std::max<CAmount>(0, txCoinbase.vout[0].nValue - nMasternodePayment);
+        txCoinbase.vout.emplace_back(nMasternodePayment, payee);
+        block.vtx[0] = MakeTransactionRef(txCoinbase);
+        block.hashMerkleRoot = BlockMerkleRoot(block);
+
+        while (!CheckProofOfWork(block.GetPoWHash(), block.nBits, chainparams.GetConsensus())) ++block.nNonce;
+
+        std::shared_ptr<const CBlock> shared_pblock = std::make_shared<const CBlock>(block);
+        BOOST_REQUIRE(ProcessNewBlock(chainparams, shared_pblock, true, nullptr));
+        BOOST_REQUIRE(chainActive.Tip()->GetBlockHash() == block.GetHash());
+        return block;
+    }
+
+    static void InvalidateTip()
+    {
+        CValidationState state;
+        {
+            LOCK(cs_main);
+            BOOST_REQUIRE(InvalidateBlock(state, Params(), chainActive.Tip()));
+        }
+        BOOST_REQUIRE(ActivateBestChain(state, Params()));
+    }
+};
+
+static void WaitForSync(PayeeIndex& payeeindex)
+{
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!payeeindex.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+}
+
+BOOST_FIXTURE_TEST_SUITE(payeeindex_tests, PayeeIndexTestingSetup)
+
+BOOST_AUTO_TEST_CASE(payeeindex_block_payments)
+{
+    PayeeIndex payeeindex(1 << 20, true);
+    CScript payee = CScript() << OP_TRUE << OP_1;
+    CScript payeeNeverPaid = CScript() << OP_TRUE << OP_2;
+
+    const CBlockIndex* pindexIndexed;
+    int nHeight;
+    int64_t nTime;
+    BOOST_CHECK(!payeeindex.FindLastPayment(payee, pindexIndexed, nHeight, nTime));
+
+    // a payment mined before the index started is picked up by its sync, no payment votes needed
+    CreateAndProcessPaymentBlock(payee);
+    int nHeightFirst = chainActive.Height();
+
+    BOOST_CHECK(!payeeindex.IsSynced());
+    payeeindex.Start();
+    WaitForSync(payeeindex);
+    BOOST_CHECK(payeeindex.IsSynced());
+
+    BOOST_CHECK(payeeindex.FindLastPayment(payee, pindexIndexed, nHeight, nTime));
+    BOOST_CHECK(pindexIndexed == chainActive.Tip());
+    BOOST_CHECK_EQUAL(nHeight, nHeightFirst);
+    BOOST_CHECK_EQUAL(nTime, chainActive.Tip()->GetBlockTime());
+
+    // the last payment wins
+    CreateAndProcessPaymentBlock(payee);
+    BOOST_CHECK(payeeindex.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK(payeeindex.FindLastPayment(payee, pindexIndexed, nHeight, nTime));
+    BOOST_CHECK_EQUAL(nHeight, chainActive.Height());
+
+    // a script that was never paid is known to be unpaid up to the best indexed block
+    CreateAndProcessPaymentBlock(scriptMiner);
+    BOOST_CHECK(payeeindex.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK(payeeindex.FindLastPayment(payeeNeverPaid, pindexIndexed, nHeight, nTime));
+    BOOST_CHECK(pindexIndexed == chainActive.Tip());
+    BOOST_CHECK_EQUAL(nHeight, -1);
+
+    payeeindex.Stop(); // Stop thread before calling destructor
+}
+
+BOOST_AUTO_TEST_CASE(payeeindex_reorg)
+{
+    PayeeIndex payeeindex(1 << 20, true);
+    CScript payeeA = CScript() << OP_TRUE << OP_1;
+    CScript payeeB = CScript() << OP_TRUE << OP_2;
+
+    payeeindex.Start();
+    WaitForSync(payeeindex);
+
+    int nHeightBase = chainActive.Height();
+    CreateAndProcessPaymentBlock(payeeA);
+    CreateAndProcessPaymentBlock(payeeA);
+    BOOST_CHECK(payeeindex.BlockUntilSyncedToCurrentChain());
+
+    const CBlockIndex* pindexIndexed;
+    int nHeight;
+    int64_t nTime;
+    BOOST_CHECK(payeeindex.FindLastPayment(payeeA, pindexIndexed, nHeight, nTime));
+    BOOST_CHECK_EQUAL(nHeight, nHeightBase + 2);
+
+    // the replacement of a disconnected block undoes its payments first
+    InvalidateTip();
+    BOOST_CHECK_EQUAL(chainActive.Height(), nHeightBase + 1);
+    CreateAndProcessPaymentBlock(payeeB);
+    BOOST_CHECK(payeeindex.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK(payeeindex.FindLastPayment(payeeA, pindexIndexed, nHeight, nTime));
+    BOOST_CHECK_EQUAL(nHeight, nHeightBase + 1);
+    BOOST_CHECK(payeeindex.FindLastPayment(payeeB, pindexIndexed, nHeight, nTime));
+    BOOST_CHECK_EQUAL(nHeight, nHeightBase + 2);
+
+    // a deeper reorg rolls back every stale height, payees only paid on the stale branch disappear
+    CreateAndProcessPaymentBlock(payeeB);
+    BOOST_CHECK(payeeindex.BlockUntilSyncedToCurrentChain());
+    InvalidateTip();
+    InvalidateTip();
+    InvalidateTip();
+    BOOST_CHECK_EQUAL(chainActive.Height(), nHeightBase);
+    CreateAndProcessPaymentBlock(scriptMiner);
+    BOOST_CHECK(payeeindex.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK(payeeindex.FindLastPayment(payeeA, pindexIndexed, nHeight, nTime));
+    BOOST_CHECK_EQUAL(nHeight, -1);
+    BOOST_CHECK(payeeindex.FindLastPayment(payeeB, pindexIndexed, nHeight, nTime));
+    BOOST_CHECK_EQUAL(nHeight, -1);
+
+    payeeindex.Stop(); // Stop thread before calling destructor
+}
+
+BOOST_AUTO_TEST_SUITE_END()
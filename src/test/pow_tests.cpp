@@ -4,6 +4,7 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <crypto/x16r.h>
 #include <pow.h>
 #include <random.h>
 #include <util.h>
@@ -11,6 +12,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <thread>
+
 BOOST_FIXTURE_TEST_SUITE(pow_tests, BasicTestingSetup)
 
 /* Test calculation of next difficulty target with no constraints applying */
@@ -83,4 +86,58 @@ BOOST_AUTO_TEST_CASE(GetBlockProofEquivalentTime_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(prepared_header_pow_hash)
+{
+    CBlockHeader header;
+    header.nVersion = InsecureRand32();
+    header.hashPrevBlock = InsecureRand256();
+    header.hashMerkleRoot = InsecureRand256();
+    header.nTime = InsecureRand32();
+    header.nBits = InsecureRand32();
+    header.nNonce = 0;
+
+    CX16RPreparedHeader prepared(UBEGIN(header.nVersion));
+    for (int i = 0; i < 8; i++) {
+        header.nNonce = InsecureRand32();
+        BOOST_CHECK_EQUAL(header.GetPoWHash(prepared), header.GetPoWHash());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(x16r_stats)
+{
+    CBlockHeader header;
+    header.hashPrevBlock = InsecureRand256();
+    int nExpectedHits[16] = {};
+    for (int i = 0; i < 16; i++) {
+        nExpectedHits[GetHashSelection(header.hashPrevBlock, i)]++;
+    }
+
+    // without timing only the digests and the callers are counted
+    BOOST_CHECK(!X16RTimingEnabled());
+    X16RStats before = GetX16RStats();
+    header.GetPoWHash(X16RCaller::BLOCK_READ);
+    X16RStats after = GetX16RStats();
+    BOOST_CHECK_EQUAL(after.callerHashes[static_cast<int>(X16RCaller::BLOCK_READ)], before.callerHashes[static_cast<int>(X16RCaller::BLOCK_READ)] + 1);
+    BOOST_CHECK_EQUAL(after.callerHashes[static_cast<int>(X16RCaller::OTHER)], before.callerHashes[static_cast<int>(X16RCaller::OTHER)]);
+    for (int i = 0; i < 16; i++) {
+        BOOST_CHECK_EQUAL(after.algoHits[i], before.algoHits[i] + nExpectedHits[i]);
+        BOOST_CHECK_EQUAL(after.algoNanos[i], before.algoNanos[i]);
+    }
+
+    // hashes of a thread that has exited are kept, and timed when enabled
+    X16RSetTiming(true);
+    before = after;
+    std::thread([&header] { header.GetPoWHash(X16RCaller::HEADER_SYNC); }).join();
+    X16RSetTiming(false);
+    after = GetX16RStats();
+    BOOST_CHECK_EQUAL(after.callerHashes[static_cast<int>(X16RCaller::HEADER_SYNC)], before.callerHashes[static_cast<int>(X16RCaller::HEADER_SYNC)] + 1);
+    uint64_t nNanos = 0;
+    for (int i = 0; i < 16; i++) {
+        BOOST_CHECK_EQUAL(after.algoHits[i], before.algoHits[i] + nExpectedHits[i]);
+        BOOST_CHECK(after.algoNanos[i] >= before.algoNanos[i]);
+        nNanos += after.algoNanos[i] - before.algoNanos[i];
+    }
+    BOOST_CHECK(nNanos > 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,117 @@
+// Copyright (c) 2019 Cryptroxcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <key.h>
+#include <privatesend-server.h>
+#include <script/interpreter.h>
+#include <script/standard.h>
+#include <test/test_bitcoin.h>
+
+#include <boost/test/unit_test.hpp>
+
+struct CPrivateSendServerTest {
+    static void AddEntry(CPrivateSendServer& server, const CDarkSendEntry& entry)
+    {
+        server.vecEntries.push_back(entry);
+    }
+
+    static void BuildFinalTransaction(CPrivateSendServer& server)
+    {
+        server.BuildFinalTransaction();
+    }
+
+    static bool AddScriptSigs(CPrivateSendServer& server, const std::vector<CTxIn>& vecTxIn)
+    {
+        return server.AddScriptSigs(vecTxIn);
+    }
+
+    static const CMutableTransaction& GetFinalTransaction(const CPrivateSendServer& server)
+    {
+        return server.finalMutableTransaction;
+    }
+
+    static const std::vector<CDarkSendEntry>& GetEntries(const CPrivateSendServer& server)
+    {
+        return server.vecEntries;
+    }
+};
+
+/** Sign input nIn of txTo as spending a P2PKH output of key, the way mixing clients do */
+static CTxIn SignInput(const CMutableTransaction& txTo, unsigned int nIn, const CKey& key)
+{
+    CScript scriptPubKey = GetScriptForDestination(key.GetPubKey().GetID());
+    int nHashType = SIGHASH_ALL | SIGHASH_ANYONECANPAY;
+    uint256 hash = SignatureHash(scriptPubKey, txTo, nIn, nHashType, 0, SigVersion::BASE);
+    std::vector<unsigned char> vchSig;
+    BOOST_REQUIRE(key.Sign(hash, vchSig));
+    vchSig.push_back((unsigned char)nHashType);
+
+    CTxIn txin(txTo.vin[nIn]);
+    txin.scriptSig = CScript() << vchSig << ToByteVector(key.GetPubKey());
+    return txin;
+}
+
+BOOST_FIXTURE_TEST_SUITE(privatesend_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(privatesend_add_script_sigs)
+{
+    CKey keys[3];
+    for (CKey& key : keys) {
+        key.MakeNewKey(true);
+    }
+
+    // one participant spending two outputs, and a second one
+    CPrivateSendServer server;
+    CDarkSendEntry entry1, entry2;
+    for (int i = 0; i < 3; i++) {
+        CTxIn txin(COutPoint(InsecureRand256(), i));
+        CTxDSIn txdsin(txin, GetScriptForDestination(keys[i].GetPubKey().GetID()));
+        (i < 2 ? entry1 : entry2).vecTxDSIn.push_back(txdsin);
+        (i < 2 ? entry1 : entry2).vecTxOut.emplace_back(COIN, GetScriptForDestination(keys[i].GetPubKey().GetID()));
+    }
+    CPrivateSendServerTest::AddEntry(server, entry1);
+    CPrivateSendServerTest::AddEntry(server, entry2);
+    CPrivateSendServerTest::BuildFinalTransaction(server);
+    const CMutableTransaction& txFinal = CPrivateSendServerTest::GetFinalTransaction(server);
+    BOOST_REQUIRE_EQUAL(txFinal.vin.size(), 3U);
+
+    auto sign = [&](const COutPoint& prevout, const CKey& key) {
+        for (unsigned int i = 0; i < txFinal.vin.size(); i++) {
+            if (txFinal.vin[i].prevout == prevout) return SignInput(txFinal, i, key);
+        }
+        BOOST_FAIL("input not found");
+        return CTxIn();
+    };
+    const COutPoint& prevout0 = entry1.vecTxDSIn[0].prevout;
+    const COutPoint& prevout1 = entry1.vecTxDSIn[1].prevout;
+
+    // one bad input rejects the whole set, the good one is not added either
+    std::vector<CTxIn> vecTxIn{sign(prevout0, keys[0]), sign(prevout1, keys[2])};
+    BOOST_CHECK(!CPrivateSendServerTest::AddScriptSigs(server, vecTxIn));
+    for (const CTxIn& txin : txFinal.vin) {
+        BOOST_CHECK(txin.scriptSig.empty());
+    }
+    for (const CDarkSendEntry& entry : CPrivateSendServerTest::GetEntries(server)) {
+        for (const CTxDSIn& txdsin : entry.vecTxDSIn) {
+            BOOST_CHECK(!txdsin.fHasSig);
+        }
+    }
+
+    // the same set with valid signatures is added as a whole
+    vecTxIn[1] = sign(prevout1, keys[1]);
+    BOOST_CHECK(CPrivateSendServerTest::AddScriptSigs(server, vecTxIn));
+    int nSigned = 0;
+    for (const CTxIn& txin : txFinal.vin) {
+        if (!txin.scriptSig.empty()) nSigned++;
+    }
+    BOOST_CHECK_EQUAL(nSigned, 2);
+    BOOST_CHECK(CPrivateSendServerTest::GetEntries(server)[0].vecTxDSIn[0].fHasSig);
+    BOOST_CHECK(CPrivateSendServerTest::GetEntries(server)[0].vecTxDSIn[1].fHasSig);
+    BOOST_CHECK(!CPrivateSendServerTest::GetEntries(server)[1].vecTxDSIn[0].fHasSig);
+
+    // scriptSigs are only accepted once
+    BOOST_CHECK(!CPrivateSendServerTest::AddScriptSigs(server, vecTxIn));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -6,8 +6,10 @@
 #include <rpc/client.h>
 
 #include <core_io.h>
+#include <crypto/x16r.h>
 #include <key_io.h>
 #include <netbase.h>
+#include <primitives/block.h>
 
 #include <test/test_bitcoin.h>
 
@@ -229,6 +231,32 @@ BOOST_AUTO_TEST_CASE(json_parse_errors)
     BOOST_CHECK_THROW(ParseNonRFCJSONValue("3J98t1WpEZ73CNmQviecrnyiWrnqRhWNL"), std::runtime_error);
 }
 
+BOOST_AUTO_TEST_CASE(rpc_getpowstats)
+{
+    UniValue r = CallRPC("getpowstats");
+    BOOST_CHECK_EQUAL(find_value(r.get_obj(), "timing").get_bool(), false);
+    UniValue algorithms = find_value(r.get_obj(), "algorithms");
+    BOOST_CHECK_EQUAL(algorithms.size(), 16U);
+    uint64_t nHitsBefore = 0;
+    for (int i = 0; i < 16; i++) {
+        nHitsBefore += find_value(algorithms[X16RAlgoName(i)].get_obj(), "hashes").get_int64();
+    }
+    int64_t nBlockReadBefore = find_value(find_value(r.get_obj(), "callers").get_obj(), "block_read").get_int64();
+
+    CBlockHeader header;
+    header.hashPrevBlock = InsecureRand256();
+    header.GetPoWHash(X16RCaller::BLOCK_READ);
+
+    r = CallRPC("getpowstats");
+    algorithms = find_value(r.get_obj(), "algorithms");
+    uint64_t nHitsAfter = 0;
+    for (int i = 0; i < 16; i++) {
+        nHitsAfter += find_value(algorithms[X16RAlgoName(i)].get_obj(), "hashes").get_int64();
+    }
+    BOOST_CHECK(nHitsAfter >= nHitsBefore + 16);
+    BOOST_CHECK(find_value(find_value(r.get_obj(), "callers").get_obj(), "block_read").get_int64() >= nBlockReadBefore + 1);
+}
+
 BOOST_AUTO_TEST_CASE(rpc_ban)
 {
     BOOST_CHECK_NO_THROW(CallRPC(std::string("clearbanned")));
@@ -0,0 +1,86 @@
+// Copyright (c) 2019 Cryptroxcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <shardedmap.h>
+
+#include <test/test_bitcoin.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(shardedmap_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(shardedmap_test)
+{
+    CShardedMap<int, int> map;
+    int value = 0;
+
+    BOOST_CHECK(map.Size() == 0);
+    BOOST_CHECK(!map.Contains(1));
+    BOOST_CHECK(!map.Get(1, value));
+
+    // Insert does not overwrite, Set does
+    BOOST_CHECK(map.Insert(1, 10));
+    BOOST_CHECK(!map.Insert(1, 11));
+    BOOST_CHECK(map.Get(1, value) && value == 10);
+    map.Set(1, 12);
+    BOOST_CHECK(map.Get(1, value) && value == 12);
+
+    BOOST_CHECK(map.Update(1, [](int& v) { v++; }));
+    BOOST_CHECK(map.Get(1, value) && value == 13);
+    BOOST_CHECK(!map.Update(2, [](int& v) { v++; }));
+    BOOST_CHECK(!map.Contains(2));
+
+    for (int i = 2; i < 100; i++) {
+        BOOST_CHECK(map.Insert(i, i));
+    }
+    BOOST_CHECK(map.Size() == 99);
+
+    int nSum = 0;
+    map.ForEach([&nSum](const int& k, const int& v) { nSum += k; });
+    BOOST_CHECK(nSum == 99 * 100 / 2);
+
+    map.EraseIf([](const int& k, int& v) { return k % 2 == 0; });
+    BOOST_CHECK(map.Size() == 50);
+    BOOST_CHECK(map.Contains(3) && !map.Contains(4));
+
+    BOOST_CHECK(map.Erase(3));
+    BOOST_CHECK(!map.Erase(3));
+    BOOST_CHECK(map.Size() == 49);
+
+    map.Clear();
+    BOOST_CHECK(map.Size() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(shardedmap_concurrent_test)
+{
+    CShardedMap<int, int> map;
+    std::vector<std::thread> threads;
+
+    // Each key is inserted by exactly one of the threads racing for it
+    std::atomic<int> nInserted{0};
+    std::atomic<int> nMissing{0};
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&map, &nInserted, &nMissing] {
+            for (int i = 0; i < 1000; i++) {
+                if (map.Insert(i, i))
+                    nInserted++;
+                int value;
+                if (!map.Get(i, value) || value != i)
+                    nMissing++;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    BOOST_CHECK(nInserted == 1000);
+    BOOST_CHECK(nMissing == 0);
+    BOOST_CHECK(map.Size() == 1000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -8,6 +8,9 @@
 #include <consensus/consensus.h>
 #include <consensus/validation.h>
 #include <crypto/sha256.h>
+#include <crypto/x16r.h>
+#include <governance-votedb.h>
+#include <masternode-paymentdb.h>
 #include <validation.h>
 #include <miner.h>
 #include <net_processing.h>
@@ -22,6 +25,7 @@ void CConnmanTest::AddNode(CNode& node)
 {
     LOCK(g_connman->cs_vNodes);
     g_connman->vNodes.push_back(&node);
+    g_connman->mapNodesById.emplace(node.GetId(), &node); // CRYPTROX
 }
 
 void CConnmanTest::ClearNodes()
@@ -31,8 +35,30 @@ void CConnmanTest::ClearNodes()
         delete node;
     }
     g_connman->vNodes.clear();
+    g_connman->mapNodesById.clear(); // CRYPTROX
 }
 
+// CRYPTROX BEGIN
+bool CConnmanTest::InitSocketEvents(CConnman::SocketEventsMode mode)
+{
+    g_connman->socketEventsMode = mode;
+    return g_connman->InitSocketEvents();
+}
+
+void CConnmanTest::AddSocketEvents(CNode* pnode)
+{
+    g_connman->AddSocketEvents(pnode);
+}
+
+std::set<NodeId> CConnmanTest::SocketEvents()
+{
+    std::vector<const CConnman::ListenSocket*> vListenReady;
+    std::set<NodeId> setNodesReady;
+    g_connman->SocketEvents(vListenReady, setNodesReady, 0);
+    return setNodesReady;
+}
+// CRYPTROX END
+
 uint256 insecure_rand_seed = GetRandHash();
 FastRandomContext insecure_rand_ctx(insecure_rand_seed);
 
@@ -49,6 +75,7 @@ BasicTestingSetup::BasicTestingSetup(const std::string& chainName)
     : m_path_root(fs::temp_directory_path() / "test_bitcoin" / strprintf("%lu_%i", (unsigned long)GetTime(), (int)(InsecureRandRange(1 << 30))))
 {
     SHA256AutoDetect();
+    X16RAutoDetect();
     RandomInit();
     ECC_Start();
     SetupEnvironment();
@@ -93,6 +120,10 @@ TestingSetup::TestingSetup(const std::string& chainName) : BasicTestingSetup(cha
         pblocktree.reset(new CBlockTreeDB(1 << 20, true));
         pcoinsdbview.reset(new CCoinsViewDB(1 << 23, true));
         pcoinsTip.reset(new CCoinsViewCache(pcoinsdbview.get()));
+        // CRYPTROX BEGIN
+        pGovernanceVoteDB.reset(new CGovernanceVoteDB(1 << 20, true));
+        pMasternodePaymentDB.reset(new CMasternodePaymentDB(1 << 20, true));
+        // CRYPTROX END
         if (!LoadGenesisBlock(chainparams)) {
             throw std::runtime_error("LoadGenesisBlock failed.");
         }
@@ -105,6 +136,8 @@ TestingSetup::TestingSetup(const std::string& chainName) : BasicTestingSetup(cha
         nScriptCheckThreads = 3;
         for (int i=0; i < nScriptCheckThreads-1; i++)
             threadGroup.create_thread(&ThreadScriptCheck);
+        for (int i=0; i < nScriptCheckThreads-1; i++)
+            threadGroup.create_thread(&ThreadHeaderPoWCheck);
         g_connman = std::unique_ptr<CConnman>(new CConnman(0x1337, 0x1337)); // Deterministic randomness for tests.
         connman = g_connman.get();
         peerLogic.reset(new PeerLogicValidation(connman, scheduler, /*enable_bip61=*/true));
@@ -122,6 +155,10 @@ TestingSetup::~TestingSetup()
         pcoinsTip.reset();
         pcoinsdbview.reset();
         pblocktree.reset();
+        // CRYPTROX BEGIN
+        pGovernanceVoteDB.reset();
+        pMasternodePaymentDB.reset();
+        // CRYPTROX END
 }
 
 TestChain100Setup::TestChain100Setup() : TestingSetup(CBaseChainParams::REGTEST)
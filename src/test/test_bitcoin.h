@@ -8,6 +8,7 @@
 #include <chainparamsbase.h>
 #include <fs.h>
 #include <key.h>
+#include <net.h> // CRYPTROX
 #include <pubkey.h>
 #include <random.h>
 #include <scheduler.h>
@@ -60,6 +61,12 @@ class CNode;
 struct CConnmanTest {
     static void AddNode(CNode& node);
     static void ClearNodes();
+    // CRYPTROX BEGIN
+    static bool InitSocketEvents(CConnman::SocketEventsMode mode);
+    static void AddSocketEvents(CNode* pnode);
+    /** Poll socket events once without waiting, returns the ready nodes */
+    static std::set<NodeId> SocketEvents();
+    // CRYPTROX END
 };
 
 class PeerLogicValidation;
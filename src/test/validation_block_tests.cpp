@@ -4,9 +4,11 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <arith_uint256.h>
 #include <chainparams.h>
 #include <consensus/merkle.h>
 #include <consensus/validation.h>
+#include <crypto/x16r.h>
 #include <miner.h>
 #include <pow.h>
 #include <random.h>
@@ -119,6 +121,79 @@ void BuildChain(const uint256& root, int height, const unsigned int invalid_rate
     }
 }
 
+// CRYPTROX BEGIN
+// a chain of headers on top of the tip, the header at nBad fails its proof of work
+static std::vector<CBlockHeader> MakeHeaders(size_t nCount, size_t nBad)
+{
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+    const CBlockIndex* pindexTip;
+    {
+        LOCK(cs_main);
+        pindexTip = chainActive.Tip();
+    }
+    std::vector<CBlockHeader> headers;
+    uint256 hashPrev = pindexTip->GetBlockHash();
+    for (size_t i = 0; i < nCount; i++) {
+        CBlockHeader header;
+        header.nVersion = ComputeBlockVersion(pindexTip, consensusParams);
+        header.hashPrevBlock = hashPrev;
+        header.hashMerkleRoot = InsecureRand256();
+        // spaced beyond twice the target spacing, so regtest allows the minimum difficulty
+        header.nTime = pindexTip->nTime + (i + 1) * (2 * consensusParams.nPowTargetSpacing + 1);
+        header.nBits = UintToArith256(consensusParams.powLimit).GetCompact();
+        while (CheckProofOfWork(header.GetPoWHash(), header.nBits, consensusParams) == (i == nBad)) {
+            ++header.nNonce;
+        }
+        headers.push_back(header);
+        hashPrev = header.GetHash();
+    }
+    return headers;
+}
+
+static uint64_t GetHeaderSyncHashes()
+{
+    return GetX16RStats().callerHashes[static_cast<int>(X16RCaller::HEADER_SYNC)];
+}
+
+BOOST_AUTO_TEST_CASE(processnewblockheaders_pow)
+{
+    // a valid message is accepted, every header hashed once
+    std::vector<CBlockHeader> headers = MakeHeaders(50, 50);
+    CValidationState state;
+    const CBlockIndex* pindexLast = nullptr;
+    CBlockHeader first_invalid;
+    uint64_t nHashesBefore = GetHeaderSyncHashes();
+    BOOST_CHECK(ProcessNewBlockHeaders(headers, state, Params(), &pindexLast, &first_invalid));
+    BOOST_CHECK_EQUAL(GetHeaderSyncHashes() - nHashesBefore, headers.size());
+    BOOST_CHECK(state.IsValid());
+    BOOST_CHECK(first_invalid.IsNull());
+    BOOST_REQUIRE(pindexLast);
+    BOOST_CHECK(pindexLast->GetBlockHash() == headers.back().GetHash());
+
+    // known headers are not hashed again
+    nHashesBefore = GetHeaderSyncHashes();
+    BOOST_CHECK(ProcessNewBlockHeaders(headers, state, Params(), &pindexLast));
+    BOOST_CHECK_EQUAL(GetHeaderSyncHashes() - nHashesBefore, 0U);
+
+    // a bad header in the middle stops the message there, without hashing
+    // any header a second time
+    const size_t nBad = 25;
+    headers = MakeHeaders(50, nBad);
+    nHashesBefore = GetHeaderSyncHashes();
+    BOOST_CHECK(!ProcessNewBlockHeaders(headers, state, Params(), &pindexLast, &first_invalid));
+    BOOST_CHECK(GetHeaderSyncHashes() - nHashesBefore <= headers.size());
+    int nDoS;
+    BOOST_CHECK(state.IsInvalid(nDoS));
+    BOOST_CHECK_EQUAL(nDoS, 50);
+    BOOST_CHECK_EQUAL(state.GetRejectReason(), "high-hash");
+    BOOST_CHECK(first_invalid.GetHash() == headers[nBad].GetHash());
+    LOCK(cs_main);
+    for (size_t i = 0; i < headers.size(); i++) {
+        BOOST_CHECK_EQUAL(LookupBlockIndex(headers[i].GetHash()) != nullptr, i < nBad);
+    }
+}
+// CRYPTROX END
+
 BOOST_AUTO_TEST_CASE(processnewblock_signals_ordering)
 {
 /*    // build a large-ish chain that's likely to have some forks
@@ -246,12 +246,19 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
     return true;
 }
 
-bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex)
+bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, int nCheckPoWDepth)
 {
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
 
     pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, uint256()));
 
+    // Every entry was written only after passing CheckBlockHeader, so
+    // re-hashing is a consistency check against on-disk corruption. Entries
+    // are visited in hash order, so the checks are deferred until the best
+    // stored height is known and only the requested depth is re-hashed.
+    std::vector<CBlockIndex*> vPoWToCheck;
+    int nMaxHeight = 0;
+
     // Load mapBlockIndex
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
@@ -275,10 +282,10 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
                 pindexNew->nTx            = diskindex.nTx;
 
                 // Cryptrox BEGIN
-                if (pindexNew->nHeight > consensusParams.nlastValidPowHashHeight)
+                if (nCheckPoWDepth > 0 && pindexNew->nHeight > consensusParams.nlastValidPowHashHeight)
+                    vPoWToCheck.push_back(pindexNew);
+                nMaxHeight = std::max(nMaxHeight, pindexNew->nHeight);
                 // CRYPTROX END
-                if (!CheckProofOfWork(pindexNew->GetBlockPoWHash(), pindexNew->nBits, consensusParams))
-                    return error("%s: CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
 
                 pcursor->Next();
             } else {
@@ -289,6 +296,16 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
         }
     }
 
+    // CRYPTROX BEGIN
+    for (const CBlockIndex* pindex : vPoWToCheck) {
+        if (nCheckPoWDepth > 1 && pindex->nHeight <= nMaxHeight - nCheckPoWDepth)
+            continue;
+        boost::this_thread::interruption_point();
+        if (!CheckProofOfWork(pindex->GetBlockPoWHash(X16RCaller::INDEX_LOAD), pindex->nBits, consensusParams))
+            return error("%s: CheckProofOfWork failed: %s", __func__, pindex->ToString());
+    }
+    // CRYPTROX END
+
     return true;
 }
 
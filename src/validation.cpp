@@ -179,7 +179,7 @@ public:
      * If a block header hasn't already been seen, call CheckBlockHeader on it, ensure
      * that it doesn't descend from an invalid block, and then add it to mapBlockIndex.
      */
-    bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fCheckPOW = true) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     bool AcceptBlock(const std::shared_ptr<const CBlock>& pblock, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fRequested, const CDiskBlockPos* dbp, bool* fNewBlock) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     // Block (dis)connection on a given view:
@@ -1147,7 +1147,7 @@ bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus:
     }
 
     // Check the header
-    if (!CheckProofOfWork(block.GetPoWHash(), block.nBits, consensusParams))
+    if (!CheckProofOfWork(block.GetPoWHash(X16RCaller::BLOCK_READ), block.nBits, consensusParams))
         return error("ReadBlockFromDisk: Errors in block header at %s", pos.ToString());
 
     return true;
@@ -1823,6 +1823,50 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+// CRYPTROX BEGIN
+/** Result of the batched proof of work check of one header */
+enum class HeaderPoWStatus : uint8_t {
+    UNCHECKED, //!< known already, or skipped after another header failed
+    VALID,
+    INVALID,
+};
+
+/**
+ * Closure representing the proof of work check of one block header.
+ * Note that this stores a reference to the header and to its status.
+ */
+class CHeaderPoWCheck
+{
+private:
+    const CBlockHeader* pheader;
+    const Consensus::Params* pparams;
+    HeaderPoWStatus* pstatus;
+
+public:
+    CHeaderPoWCheck(): pheader(nullptr), pparams(nullptr), pstatus(nullptr) {}
+    CHeaderPoWCheck(const CBlockHeader& headerIn, const Consensus::Params& paramsIn, HeaderPoWStatus& statusIn) : pheader(&headerIn), pparams(&paramsIn), pstatus(&statusIn) {}
+
+    bool operator()() {
+        bool fValid = CheckProofOfWork(pheader->GetPoWHash(X16RCaller::HEADER_SYNC), pheader->nBits, *pparams);
+        *pstatus = fValid ? HeaderPoWStatus::VALID : HeaderPoWStatus::INVALID;
+        return fValid;
+    }
+
+    void swap(CHeaderPoWCheck& check) {
+        std::swap(pheader, check.pheader);
+        std::swap(pparams, check.pparams);
+        std::swap(pstatus, check.pstatus);
+    }
+};
+
+static CCheckQueue<CHeaderPoWCheck> headerpowcheckqueue(16);
+
+void ThreadHeaderPoWCheck() {
+    RenameThread("cryptrox-powch");
+    headerpowcheckqueue.Thread();
+}
+// CRYPTROX END
+
 // Protected by cs_main
 VersionBitsCache versionbitscache;
 
@@ -2204,13 +2248,15 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     if (pindex->nHeight == 1)
         mnodeman.Clear(); // Clear masternode list on reindex
 
-    std::map<COutPoint, CMasternode> mapMasternodes = mnodeman.GetFullMasternodeMap();
+    CMasternodeMan::snapshot_t mapMasternodes = mnodeman.GetSnapshot();
+    // masternodes already validated as payees of this block, they can't be paid twice
+    std::set<COutPoint> setPaidMasternodes;
 
     int nNoMasternodes = 0;
     {
-        std::map<COutPoint, CMasternode>::iterator mnit = mapMasternodes.begin();
-        while (mnit != mapMasternodes.end()) {
-            if (mnit->second.IsEnabled())
+        CMasternodeMan::snapshot_map_t::const_iterator mnit = mapMasternodes->begin();
+        while (mnit != mapMasternodes->end()) {
+            if (mnit->second->IsEnabled())
             {
                 nNoMasternodes++;
             }
@@ -2245,16 +2291,18 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
                         fMasternode = true;
                     } else {
                         // check in masternode list
-                        std::map<COutPoint, CMasternode>::iterator mnit = mapMasternodes.begin();
-                        while (!fMasternode && mnit != mapMasternodes.end()) {
-                            if (tx.vout[i].scriptPubKey == GetScriptForDestination(mnit->second.pubKeyCollateralAddress.GetID()))
+                        CMasternodeMan::snapshot_map_t::const_iterator mnit = mapMasternodes->begin();
+                        while (!fMasternode && mnit != mapMasternodes->end()) {
+                            if (!setPaidMasternodes.count(mnit->first) &&
+                                tx.vout[i].scriptPubKey == GetScriptForDestination(mnit->second->pubKeyCollateralAddress.GetID()))
                             {
-                                if (mnit->second.IsEnabled())
+                                if (mnit->second->IsEnabled())
                                 {
                                     fMasternode = true;
 
-                                    // remove from list to not validate same MN multiple times
-                                    mapMasternodes.erase(mnit++);
+                                    // remember it to not validate same MN multiple times
+                                    setPaidMasternodes.insert(mnit->first);
+                                    ++mnit;
 
                                     //passed collateral check
                                     LogPrint(BCLog::ALL, "Validation pass: tx.vout[%d].scriptPubKey.ToString() = %s\n", i, addressOutput);
@@ -3409,10 +3457,10 @@ static bool FindUndoPos(CValidationState &state, int nFile, CDiskBlockPos &pos,
     return true;
 }
 
-static bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true)
+static bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true, X16RCaller caller = X16RCaller::HEADER_SYNC)
 {
     // Check proof of work matches claimed amount
-    if (fCheckPOW && !CheckProofOfWork(block.GetPoWHash(), block.nBits, consensusParams))
+    if (fCheckPOW && !CheckProofOfWork(block.GetPoWHash(caller), block.nBits, consensusParams))
         return state.DoS(50, false, REJECT_INVALID, "high-hash", false, "proof of work failed");
 
     return true;
@@ -3427,7 +3475,7 @@ bool CheckBlock(const CBlock& block, CValidationState& state, const Consensus::P
 
     // Check that the header is valid (particularly PoW).  This is mostly
     // redundant with the call in AcceptBlockHeader.
-    if (!CheckBlockHeader(block, state, consensusParams, fCheckPOW))
+    if (!CheckBlockHeader(block, state, consensusParams, fCheckPOW, X16RCaller::BLOCK_CHECK))
         return false;
 
     // Check the merkle root.
@@ -3684,7 +3732,7 @@ static bool ContextualCheckBlock(const CBlock& block, CValidationState& state, c
     return true;
 }
 
-bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex)
+bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fCheckPOW)
 {
     AssertLockHeld(cs_main);
     // Check for duplicate
@@ -3702,7 +3750,7 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
             return true;
         }
 
-        if (!CheckBlockHeader(block, state, chainparams.GetConsensus()))
+        if (!CheckBlockHeader(block, state, chainparams.GetConsensus(), fCheckPOW))
             return error("%s: Consensus::CheckBlockHeader: %s, %s", __func__, hash.ToString(), FormatStateMessage(state));
 
         // Get prev block index
@@ -3749,15 +3797,59 @@ bool CChainState::AcceptBlockHeader(const CBlockHeader& block, CValidationState&
     return true;
 }
 
+/**
+ * Verify the proof of work of all not yet known headers in parallel on the
+ * header check threads. vStatus receives the result of every header, headers
+ * after a failure may be left unchecked. Returns the index of the first header
+ * that failed, or headers.size() if none did.
+ */
+static size_t CheckBlockHeadersPoW(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams, std::vector<HeaderPoWStatus>& vStatus)
+{
+    vStatus.assign(headers.size(), HeaderPoWStatus::UNCHECKED);
+    std::vector<CHeaderPoWCheck> vChecks;
+    vChecks.reserve(headers.size());
+    {
+        LOCK(cs_main);
+        for (size_t i = 0; i < headers.size(); i++) {
+            if (!mapBlockIndex.count(headers[i].GetHash()))
+                vChecks.emplace_back(headers[i], consensusParams, vStatus[i]);
+        }
+    }
+
+    CCheckQueueControl<CHeaderPoWCheck> control(&headerpowcheckqueue);
+    control.Add(vChecks);
+    if (control.Wait())
+        return headers.size();
+    return std::find(vStatus.begin(), vStatus.end(), HeaderPoWStatus::INVALID) - vStatus.begin();
+}
+
 // Exposed wrapper for AcceptBlockHeader
 bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex, CBlockHeader *first_invalid)
 {
     if (first_invalid != nullptr) first_invalid->SetNull();
+    // CRYPTROX BEGIN
+    // X16R dominates the cost of accepting a headers message, so check the
+    // proof of work of the whole batch in parallel before the sequential
+    // contextual checks. Headers the batch did not get to are checked inline,
+    // none is hashed twice.
+    std::vector<HeaderPoWStatus> vStatus(headers.size(), HeaderPoWStatus::UNCHECKED);
+    size_t nFirstInvalid = headers.size();
+    if (headers.size() > 1)
+        nFirstInvalid = CheckBlockHeadersPoW(headers, chainparams.GetConsensus(), vStatus);
+    // CRYPTROX END
     {
         LOCK(cs_main);
-        for (const CBlockHeader& header : headers) {
+        for (size_t i = 0; i < headers.size(); i++) {
+            const CBlockHeader& header = headers[i];
+            // CRYPTROX BEGIN
+            if (i == nFirstInvalid) {
+                if (first_invalid) *first_invalid = header;
+                return state.DoS(50, error("%s: Consensus::CheckBlockHeader: %s, proof of work failed", __func__, header.GetHash().ToString()),
+                                 REJECT_INVALID, "high-hash", false, "proof of work failed");
+            }
+            // CRYPTROX END
             CBlockIndex *pindex = nullptr; // Use a temp pindex instead of ppindex to avoid a const_cast
-            if (!g_chainstate.AcceptBlockHeader(header, state, chainparams, &pindex)) {
+            if (!g_chainstate.AcceptBlockHeader(header, state, chainparams, &pindex, vStatus[i] != HeaderPoWStatus::VALID)) {
                 if (first_invalid) *first_invalid = header;
                 return false;
             }
@@ -4161,7 +4253,8 @@ CBlockIndex * CChainState::InsertBlockIndex(const uint256& hash)
 
 bool CChainState::LoadBlockIndex(const Consensus::Params& consensus_params, CBlockTreeDB& blocktree)
 {
-    if (!blocktree.LoadBlockIndexGuts(consensus_params, [this](const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) { return this->InsertBlockIndex(hash); }))
+    const int nCheckPoWDepth = gArgs.GetArg("-checkpowonload", DEFAULT_CHECKPOWONLOAD);
+    if (!blocktree.LoadBlockIndexGuts(consensus_params, [this](const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) { return this->InsertBlockIndex(hash); }, nCheckPoWDepth))
         return false;
 
     boost::this_thread::interruption_point();
@@ -12,7 +12,7 @@
  */
 
 //static const int PROTOCOL_VERSION = 70015;
-static const int PROTOCOL_VERSION = 70208;
+static const int PROTOCOL_VERSION = 70209;
 
 //! initial proto version, to be increased after version/verack negotiation
 static const int INIT_PROTO_VERSION = 209;